@@ -22,6 +22,10 @@
 //    of 32 values.
 // * UnpackScalar - an implementation that can unpack a variable number of values, using
 //   Unpack32Scalar internally.
+// * UnpackAVX2 / UnpackAVX512 - the same as UnpackScalar, but with the vectorized kernels
+//   enabled for full batches. Only run if the CPU supports the instruction set.
+//
+// The results below predate the vectorized kernels.
 //
 //
 // Machine Info: Intel(R) Core(TM) i7-7700 CPU @ 3.60GHz
@@ -447,6 +451,19 @@ void UnpackBenchmark(int batch_size, void* data) {
   }
 }
 
+/// Benchmark calling UnpackValues() with the vectorized kernels disabled.
+void UnpackScalarBenchmark(int batch_size, void* data) {
+  CpuInfo::TempDisable disable_avx512(CpuInfo::AVX512BW);
+  CpuInfo::TempDisable disable_avx2(CpuInfo::AVX2);
+  UnpackBenchmark(batch_size, data);
+}
+
+/// Benchmark calling UnpackValues() with the AVX2 kernels.
+void UnpackAVX2Benchmark(int batch_size, void* data) {
+  CpuInfo::TempDisable disable_avx512(CpuInfo::AVX512BW);
+  UnpackBenchmark(batch_size, data);
+}
+
 int main(int argc, char **argv) {
   CpuInfo::Init();
   cout << endl << Benchmark::GetMachineInfo() << endl;
@@ -460,7 +477,19 @@ int main(int argc, char **argv) {
     suite.AddBenchmark(Substitute("BitReader", bit_width), BitReaderBenchmark, &params);
     suite.AddBenchmark(
         Substitute("Unpack32Scalar", bit_width), Unpack32Benchmark, &params);
-    suite.AddBenchmark(Substitute("UnpackScalar", bit_width), UnpackBenchmark, &params);
+    suite.AddBenchmark(
+        Substitute("UnpackScalar", bit_width), UnpackScalarBenchmark, &params);
+    if (BitPacking::SupportsSimdUnpacking(bit_width)) {
+      if (CpuInfo::IsSupported(CpuInfo::AVX2)) {
+        suite.AddBenchmark(
+            Substitute("UnpackAVX2", bit_width), UnpackAVX2Benchmark, &params);
+      }
+      if (CpuInfo::IsSupported(CpuInfo::AVX512F)
+          && CpuInfo::IsSupported(CpuInfo::AVX512BW)) {
+        suite.AddBenchmark(
+            Substitute("UnpackAVX512", bit_width), UnpackBenchmark, &params);
+      }
+    }
     cout << suite.Measure() << endl;
   }
   return 0;
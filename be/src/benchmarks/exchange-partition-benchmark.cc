@@ -0,0 +1,206 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <iostream>
+#include <sstream>
+#include <boost/scoped_ptr.hpp>
+
+#include "common/init.h"
+#include "gutil/strings/substitute.h"
+#include "runtime/mem-tracker.h"
+#include "runtime/raw-value.inline.h"
+#include "runtime/row-batch.h"
+#include "runtime/string-value.h"
+#include "runtime/tuple-row.h"
+#include "service/fe-support.h"
+#include "service/frontend.h"
+#include "testutil/desc-tbl-builder.h"
+#include "util/benchmark.h"
+#include "util/cpu-info.h"
+
+#include "common/names.h"
+
+// Benchmark to measure how quickly a hash-partitioned exchange can distribute the rows
+// of a row batch to the row batches of its channels, as KrpcDataStreamSender does in
+// HashAndAddRows(). It compares the row-at-a-time partitioning, which hashes a row and
+// copies it into its channel's batch before moving on to the next row, with the
+// two-pass partitioning, which first computes the channels of all rows and orders the
+// rows by channel, and then copies the rows of one channel at a time with
+// RowBatch::DeepCopyRowsFrom(). The channel batches are reset when they are full,
+// which stands in for sending them.
+//
+// The rows have a single (bigint, int, string) tuple and are partitioned on the bigint
+// slot. The number of channels is varied, since the row-at-a-time partitioning writes
+// to the batches of all channels in turn and so touches more memory with more channels.
+
+using namespace impala;
+
+const int NUM_ROWS = 1024;
+const int MAX_STRING_LEN = 16;
+
+// Size of the row batch of each channel, as --data_stream_sender_buffer_size.
+const int CHANNEL_BUFFER_SIZE = 16 * 1024;
+
+namespace impala {
+
+// For computing tuple mem layouts.
+static scoped_ptr<Frontend> fe;
+
+class ExchangePartitionBenchmark {
+ public:
+  struct PartitionArgs {
+    RowBatch* batch;
+    const SlotDescriptor* key_slot;
+    vector<unique_ptr<RowBatch>> channel_batches;
+    vector<int> channel_ids;
+    vector<int> row_idxs;
+    vector<int> offsets;
+  };
+
+  static void FillBatch(RowBatch* batch, MemPool* mem_pool) {
+    const TupleDescriptor* tuple_desc = batch->row_desc()->tuple_descriptors()[0];
+    uint8_t* tuple_mem = mem_pool->Allocate(tuple_desc->byte_size() * NUM_ROWS);
+    for (int i = 0; i < NUM_ROWS; ++i) {
+      TupleRow* row = batch->GetRow(batch->AddRow());
+      Tuple* tuple = reinterpret_cast<Tuple*>(tuple_mem);
+      tuple->Init(tuple_desc->byte_size());
+      tuple_mem += tuple_desc->byte_size();
+      int64_t bigint_val = rand();
+      RawValue::Write(&bigint_val, tuple, tuple_desc->slots()[0], mem_pool);
+      int int_val = rand();
+      RawValue::Write(&int_val, tuple, tuple_desc->slots()[1], mem_pool);
+      char string_buf[MAX_STRING_LEN];
+      int string_len = rand() % MAX_STRING_LEN;
+      for (int j = 0; j < string_len; ++j) string_buf[j] = 'a' + rand() % 26;
+      StringValue string_val(string_buf, string_len);
+      RawValue::Write(&string_val, tuple, tuple_desc->slots()[2], mem_pool);
+      row->SetTuple(0, tuple);
+      batch->CommitLastRow();
+    }
+  }
+
+  static int GetChannel(PartitionArgs* args, TupleRow* row) {
+    const SlotDescriptor* slot = args->key_slot;
+    uint64_t hash = RawValue::GetHashValueFastHash(
+        row->GetTuple(0)->GetSlot(slot->tuple_offset()), slot->type(), 0);
+    return hash % args->channel_batches.size();
+  }
+
+  static void ResetIfFull(RowBatch* channel_batch) {
+    if (channel_batch->AtCapacity()) channel_batch->Reset();
+  }
+
+  static void TestRowAtATime(int batch_size, void* data) {
+    PartitionArgs* args = reinterpret_cast<PartitionArgs*>(data);
+    const vector<TupleDescriptor*>& descs = args->batch->row_desc()->tuple_descriptors();
+    for (int iter = 0; iter < batch_size; ++iter) {
+      FOREACH_ROW(args->batch, 0, it) {
+        TupleRow* row = it.Get();
+        RowBatch* channel_batch = args->channel_batches[GetChannel(args, row)].get();
+        ResetIfFull(channel_batch);
+        TupleRow* dest = channel_batch->GetRow(channel_batch->AddRow());
+        dest->SetTuple(0, row->GetTuple(0)->DeepCopy(
+            *descs[0], channel_batch->tuple_data_pool()));
+        channel_batch->CommitLastRow();
+      }
+    }
+  }
+
+  static void TestTwoPass(int batch_size, void* data) {
+    PartitionArgs* args = reinterpret_cast<PartitionArgs*>(data);
+    const int num_channels = args->channel_batches.size();
+    int* channel_ids = args->channel_ids.data();
+    int* row_idxs = args->row_idxs.data();
+    int* offsets = args->offsets.data();
+    for (int iter = 0; iter < batch_size; ++iter) {
+      memset(offsets, 0, num_channels * sizeof(int));
+      int row_idx = 0;
+      FOREACH_ROW(args->batch, 0, it) {
+        int channel_id = GetChannel(args, it.Get());
+        channel_ids[row_idx++] = channel_id;
+        ++offsets[channel_id];
+      }
+      int num_preceding_rows = 0;
+      for (int i = 0; i < num_channels; ++i) {
+        int count = offsets[i];
+        offsets[i] = num_preceding_rows;
+        num_preceding_rows += count;
+      }
+      for (int i = 0; i < NUM_ROWS; ++i) row_idxs[offsets[channel_ids[i]]++] = i;
+      int start = 0;
+      for (int i = 0; i < num_channels; ++i) {
+        RowBatch* channel_batch = args->channel_batches[i].get();
+        while (start < offsets[i]) {
+          ResetIfFull(channel_batch);
+          int num_copied = min(offsets[i] - start,
+              channel_batch->capacity() - channel_batch->num_rows());
+          channel_batch->DeepCopyRowsFrom(args->batch, row_idxs + start, num_copied);
+          start += num_copied;
+        }
+      }
+    }
+  }
+
+  static void Run() {
+    cout << Benchmark::GetMachineInfo() << endl;
+    MemTracker tracker;
+    MemPool mem_pool(&tracker);
+    ObjectPool obj_pool;
+    DescriptorTblBuilder builder(fe.get(), &obj_pool);
+    builder.DeclareTuple() << TYPE_BIGINT << TYPE_INT << TYPE_STRING;
+    DescriptorTbl* desc_tbl = builder.Build();
+    vector<bool> nullable_tuples(1, false);
+    vector<TTupleId> tuple_id(1, (TTupleId)0);
+    RowDescriptor row_desc(*desc_tbl, tuple_id, nullable_tuples);
+    RowBatch* batch = obj_pool.Add(new RowBatch(&row_desc, NUM_ROWS, &tracker));
+    FillBatch(batch, &mem_pool);
+    const int channel_capacity = max(1, CHANNEL_BUFFER_SIZE / row_desc.GetRowSize());
+
+    for (int num_channels : {16, 128, 512}) {
+      PartitionArgs args;
+      args.batch = batch;
+      args.key_slot = row_desc.tuple_descriptors()[0]->slots()[0];
+      for (int i = 0; i < num_channels; ++i) {
+        args.channel_batches.emplace_back(
+            new RowBatch(&row_desc, channel_capacity, &tracker));
+      }
+      args.channel_ids.resize(NUM_ROWS);
+      args.row_idxs.resize(NUM_ROWS);
+      args.offsets.resize(num_channels);
+
+      Benchmark suite(Substitute("partition $0 channels", num_channels));
+      int baseline = suite.AddBenchmark("row_at_a_time", TestRowAtATime, &args, -1);
+      suite.AddBenchmark("two_pass", TestTwoPass, &args, baseline);
+      cout << suite.Measure() << endl;
+
+      for (unique_ptr<RowBatch>& channel_batch : args.channel_batches) {
+        channel_batch->Reset();
+      }
+    }
+    mem_pool.FreeAll();
+  }
+};
+
+} // namespace impala
+
+int main(int argc, char** argv) {
+  impala::InitCommonRuntime(argc, argv, true, impala::TestInfo::BE_TEST);
+  InitFeSupport();
+  fe.reset(new Frontend());
+  ExchangePartitionBenchmark::Run();
+  return 0;
+}
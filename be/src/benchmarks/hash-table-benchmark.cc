@@ -15,6 +15,11 @@
 // specific language governing permissions and limitations
 // under the License.
 
+#include <iomanip>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
 #include <boost/scoped_ptr.hpp>
 #include "exec/hash-table.inline.h"
 #include "exprs/scalar-expr-evaluator.h"
@@ -30,6 +35,7 @@
 #include "util/benchmark.h"
 #include "util/cpu-info.h"
 #include "util/runtime-profile-counters.h"
+#include "util/stopwatch.h"
 
 using namespace impala;
 using namespace std;
@@ -41,6 +47,10 @@ using namespace std;
 // name represents the name of benchmark (probe|build|memory).
 // XX represents the number of rows in the dataset.
 // YY represents the percentage of unique values in dataset.
+// Benchmarks with the '_tagged' suffix use the tagged hash table layout. The results
+// below predate the tagged layout and the probe throughput section, which reports the
+// probes per second and the last level cache misses per probe of both layouts for
+// tables that do not fit in the cache.
 // Runtime Benchmark
 // -----------------
 // 21/06/30 08:44:20 INFO util.JvmPauseMonitor: Starting JVM pause monitor
@@ -111,9 +121,11 @@ class TestCtx {
   MemTracker tracker_;
   MemPool mem_pool_;
   int initial_num_buckets;
-  void SetUp(int num_buckets) {
+  bool tagged_probing = false;
+  void SetUp(int num_buckets, bool tagged = false) {
     CreateTestEnv();
     initial_num_buckets = num_buckets;
+    tagged_probing = tagged;
     bool ht_success = CreateHashTable();
     CHECK(ht_success) << "Creation of HashTable failed";
     RowDescriptor rd;
@@ -194,8 +206,8 @@ class TestCtx {
         pool_.Add(new Suballocator(buffer_pool, client, suballocator_buffer_len));
 
     int64_t max_num_buckets = 1L << 31;
-    hash_table_ = pool_.Add(HashTable::Create(
-        allocator, true, 1, nullptr, max_num_buckets, initial_num_buckets));
+    hash_table_ = pool_.Add(HashTable::Create(tagged_probing, allocator, true, 1,
+        nullptr, max_num_buckets, initial_num_buckets));
     status = hash_table_->Init(&success);
     if (!(status.ok() && success)) {
       std::cout << "HashTable Init failed" << std::endl;
@@ -237,6 +249,42 @@ class TestCtx {
   }
 };
 
+/// Counts the last level cache misses of the calling thread with perf_event_open().
+/// Stop() returns -1 if the counter is not available, e.g. because the kernel does not
+/// allow unprivileged access to the performance counters or there is no PMU.
+class LlcMissCounter {
+ public:
+  LlcMissCounter() {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    fd_ = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+  }
+  ~LlcMissCounter() {
+    if (fd_ >= 0) close(fd_);
+  }
+  void Start() {
+    if (fd_ < 0) return;
+    ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+    ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+  }
+  int64_t Stop() {
+    if (fd_ < 0) return -1;
+    ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+    int64_t count;
+    if (read(fd_, &count, sizeof(count)) != sizeof(count)) return -1;
+    return count;
+  }
+
+ private:
+  int fd_;
+};
+
 void Probe(TestCtx* ctx, vector<TupleRow*>& pdata) {
   HashTable* hTable = ctx->hash_table_;
   HashTableCtx* ht_ctx = ctx->hash_context_.get();
@@ -307,6 +355,40 @@ std::string ResultString(
   return ss.str();
 }
 
+/// Builds a table with 'num_tuples' unique keys with the given layout, probes it once
+/// with the keys and once with absent keys, and appends a result line for each run.
+void ProbeThroughput(int num_tuples, bool tagged, stringstream* ss) {
+  const int function_out_width = 50;
+  const int value_width = 20;
+  TestCtx ctx;
+  ctx.SetUp(HashTable::EstimateNumBuckets(num_tuples), tagged);
+  ctx.CreateDataSet(num_tuples, 100);
+  Build(&ctx, ctx.data);
+  for (bool absent : {false, true}) {
+    if (absent) ctx.CreateAbsentKeysData(num_tuples);
+    LlcMissCounter llc_misses;
+    MonotonicStopWatch sw;
+    llc_misses.Start();
+    sw.Start();
+    Probe(&ctx, ctx.data);
+    sw.Stop();
+    int64_t misses = llc_misses.Stop();
+    stringstream name;
+    name << "probe_" << num_tuples << (absent ? "_absentkeys" : "_100")
+         << (tagged ? "_tagged" : "");
+    *ss << setw(function_out_width) << name.str() << setw(value_width) << fixed
+        << setprecision(0) << ctx.data.size() * 1e9 / max<uint64_t>(sw.ElapsedTime(), 1)
+        << setw(value_width) << setprecision(2);
+    if (misses < 0) {
+      *ss << "n/a";
+    } else {
+      *ss << static_cast<double>(misses) / ctx.data.size();
+    }
+    *ss << std::endl;
+  }
+  ctx.TearDown();
+}
+
 int64_t GetMemoryBytesConsumed(HashTable* ht) {
   int empty_buckets = ht->EmptyBuckets();
   int64_t mem_size = ht->CurrentMemSize();
@@ -336,26 +418,33 @@ int main(int argc, char** argv) {
       std::stringstream bname;
       pname << "probe_" << num_tuples[num] << "_" << unique_percent[up];
       bname << "build_" << num_tuples[num] << "_" << unique_percent[up];
-      TestCtx* ctx = new TestCtx();
-      ctx->SetUp(num_tuples[num]);
-      ctxs.push_back(ctx);
-      ctx->CreateDataSet(num_tuples[num], unique_percent[up]);
-      hash_table_build.AddBenchmark(bname.str(), build::Benchmark, (void*)ctx, -1);
-      hash_table_probe.AddBenchmark(pname.str(), probe::Benchmark, (void*)ctx, -1);
+      for (bool tagged : {false, true}) {
+        TestCtx* ctx = new TestCtx();
+        ctx->SetUp(num_tuples[num], tagged);
+        ctxs.push_back(ctx);
+        ctx->CreateDataSet(num_tuples[num], unique_percent[up]);
+        string suffix = tagged ? "_tagged" : "";
+        hash_table_build.AddBenchmark(
+            bname.str() + suffix, build::Benchmark, (void*)ctx, -1);
+        hash_table_probe.AddBenchmark(
+            pname.str() + suffix, probe::Benchmark, (void*)ctx, -1);
+      }
     }
   }
 
   // Create Probe benchmark for Data not found in the table
   for (int num = 0; num < num_tuples.size(); num++) {
-    TestCtx* ctx = new TestCtx();
-    ctx->SetUp(num_tuples[num]);
-    ctxs.push_back(ctx);
-    ctx->CreateDataSet(num_tuples[num], 10);
-    Build(ctx, ctx->data);
-    ctx->CreateAbsentKeysData(num_tuples[num]);
-    std::stringstream pname;
-    pname << "probe_" << num_tuples[num] << "_absentkeys";
-    hash_table_probe.AddBenchmark(pname.str(), probe::Benchmark, (void*)ctx, -1);
+    for (bool tagged : {false, true}) {
+      TestCtx* ctx = new TestCtx();
+      ctx->SetUp(num_tuples[num], tagged);
+      ctxs.push_back(ctx);
+      ctx->CreateDataSet(num_tuples[num], 10);
+      Build(ctx, ctx->data);
+      ctx->CreateAbsentKeysData(num_tuples[num]);
+      std::stringstream pname;
+      pname << "probe_" << num_tuples[num] << "_absentkeys" << (tagged ? "_tagged" : "");
+      hash_table_probe.AddBenchmark(pname.str(), probe::Benchmark, (void*)ctx, -1);
+    }
   }
   std::cout << hash_table_build.Measure(50, 10, build::SetUp) << std::endl;
   std::cout << hash_table_probe.Measure() << std::endl;
@@ -365,6 +454,19 @@ int main(int argc, char** argv) {
     free(ct);
   }
 
+  /// Probe throughput of tables that do not fit in the last level cache.
+  std::cout << "Probe Throughput Benchmark" << std::endl;
+  std::cout << "--------------------------" << std::endl;
+  stringstream throughput;
+  std::string name("Hash Table Probe Throughput");
+  throughput << name << ":" << setw(50 - name.size() - 1) << "Function" << setw(20)
+             << "Probes/sec" << setw(20) << "LLC misses/probe" << std::endl;
+  throughput << std::string(90, '-') << std::endl;
+  for (int num : {1024 * 1024, 8 * 1024 * 1024}) {
+    for (bool tagged : {false, true}) ProbeThroughput(num, tagged, &throughput);
+  }
+  std::cout << throughput.str() << std::endl;
+
   /// Memory Benchmark
   std::cout << "Memory Benchmark" << std::endl;
   std::cout << "----------------" << std::endl;
@@ -102,6 +102,8 @@ ir_functions = [
    "_ZN6impala23PartitionedHashJoinNode17ProcessProbeBatchILi8EEEiNS_13TPrefetchMode4typeEPNS_8RowBatchEPNS_12HashTableCtxEPNS_6StatusE"],
   ["PHJ_INSERT_BATCH",
    "_ZN6impala19PhjBuilderPartition11InsertBatchENS_13TPrefetchMode4typeEPNS_12HashTableCtxEPNS_8RowBatchERKSt6vectorIPhSaIS8_EEPNS_6StatusE"],
+  ["PHJ_HASH_BATCH",
+   "_ZN6impala19PhjBuilderPartition9HashBatchEPNS_12HashTableCtxEPNS_8RowBatchEPj"],
   ["HASH_TABLE_GET_HASH_SEED",
    "_ZNK6impala12HashTableCtx11GetHashSeedEv"],
   ["HASH_TABLE_GET_BUILD_EXPR_EVALUATORS",
@@ -261,8 +263,8 @@ ir_functions = [
    "_ZN6impala19GetKuduPartitionRowEPN4kudu6client15KuduPartitionerEPNS0_14KuduPartialRowE"],
   ["TUPLE_SORTER_SORT_HELPER",
    "_ZN6impala6Sorter11TupleSorter10SortHelperENS0_13TupleIteratorES2_"],
-  ["SORTED_RUN_MERGER_HEAPIFY_HELPER",
-   "_ZN6impala15SortedRunMerger13HeapifyHelperEi"]
+  ["SORTED_RUN_MERGER_REPLAY_HELPER",
+   "_ZN6impala15SortedRunMerger12ReplayHelperEi"]
 ]
 
 enums_preamble = '\
@@ -190,6 +190,16 @@ void Aggregator::UpdateTuple(
   }
 }
 
+void Aggregator::AddRowsToGroups(AggFnEvaluator** const* row_agg_fn_evals,
+    Tuple** tuples, TupleRow** rows, int num_rows) noexcept {
+  for (int i = 0; i < agg_fns_.size(); ++i) {
+    for (int j = 0; j < num_rows; ++j) {
+      DCHECK(tuples[j] != nullptr);
+      row_agg_fn_evals[j][i]->Add(rows[j], tuples[j]);
+    }
+  }
+}
+
 Tuple* Aggregator::GetOutputTuple(
     const vector<AggFnEvaluator*>& agg_fn_evals, Tuple* tuple, MemPool* pool) {
   DCHECK(tuple != nullptr || agg_fn_evals.empty()) << tuple;
@@ -634,4 +644,110 @@ Status AggregatorConfig::CodegenUpdateTuple(LlvmCodeGen* codegen, llvm::Function
   }
   return Status::OK();
 }
+
+Status AggregatorConfig::CodegenAddRowsToGroups(
+    LlvmCodeGen* codegen, llvm::Function** fn) {
+  for (const SlotDescriptor* slot_desc : intermediate_tuple_desc_->slots()) {
+    if (slot_desc->type().type == TYPE_CHAR) {
+      return Status::Expected("Aggregator::CodegenAddRowsToGroups(): cannot "
+                              "codegen CHAR in aggregations");
+    }
+  }
+
+  llvm::StructType* tuple_struct = intermediate_tuple_desc_->GetLlvmStruct(codegen);
+  if (tuple_struct == nullptr) {
+    return Status::Expected("Aggregator::CodegenAddRowsToGroups(): failed to"
+                            " generate intermediate tuple desc");
+  }
+  llvm::PointerType* tuple_ptr = codegen->GetPtrType(tuple_struct);
+
+  // Get the types to match the AddRowsToGroups signature
+  llvm::PointerType* agg_node_ptr_type = codegen->GetStructPtrType<Aggregator>();
+  llvm::PointerType* row_evals_type =
+      codegen->GetPtrType(codegen->GetStructPtrPtrType<AggFnEvaluator>());
+  llvm::PointerType* tuples_type =
+      codegen->GetPtrType(codegen->GetStructPtrType<Tuple>());
+  llvm::PointerType* rows_type =
+      codegen->GetPtrType(codegen->GetStructPtrType<TupleRow>());
+
+  LlvmCodeGen::FnPrototype prototype(codegen, "AddRowsToGroups", codegen->void_type());
+  prototype.AddArgument(LlvmCodeGen::NamedVariable("this_ptr", agg_node_ptr_type));
+  prototype.AddArgument(LlvmCodeGen::NamedVariable("row_agg_fn_evals", row_evals_type));
+  prototype.AddArgument(LlvmCodeGen::NamedVariable("tuples", tuples_type));
+  prototype.AddArgument(LlvmCodeGen::NamedVariable("rows", rows_type));
+  prototype.AddArgument(LlvmCodeGen::NamedVariable("num_rows", codegen->i32_type()));
+
+  llvm::LLVMContext& context = codegen->context();
+  LlvmBuilder builder(context);
+  llvm::Value* args[5];
+  *fn = prototype.GeneratePrototype(&builder, &args[0]);
+  llvm::Value* row_agg_fn_evals_arg = args[1];
+  llvm::Value* tuples_arg = args[2];
+  llvm::Value* rows_arg = args[3];
+  llvm::Value* num_rows_arg = args[4];
+  llvm::Value* const_zero = codegen->GetI32Constant(0);
+  llvm::Value* const_one = codegen->GetI32Constant(1);
+
+  // Emit one loop over the rows per aggregate function. The loops run one after the
+  // other, so the updates of each group are still applied in row order.
+  int j = GetNumGroupingExprs();
+  for (int i = 0; i < aggregate_functions_.size(); ++i, ++j) {
+    SlotDescriptor* slot_desc = intermediate_tuple_desc_->slots()[j];
+    AggFn* agg_fn = aggregate_functions_[i];
+    llvm::Function* update_slot_fn = nullptr;
+    if (!agg_fn->is_count_star()) {
+      RETURN_IF_ERROR(CodegenUpdateSlot(codegen, i, slot_desc, &update_slot_fn));
+    }
+
+    llvm::BasicBlock* entry_block = builder.GetInsertBlock();
+    llvm::BasicBlock* loop_block = llvm::BasicBlock::Create(context, "agg_loop", *fn);
+    llvm::BasicBlock* exit_block =
+        llvm::BasicBlock::Create(context, "agg_loop_exit", *fn);
+    builder.CreateCondBr(
+        builder.CreateICmpSGT(num_rows_arg, const_zero), loop_block, exit_block);
+
+    builder.SetInsertPoint(loop_block);
+    llvm::PHINode* row_idx = builder.CreatePHI(codegen->i32_type(), 2, "row_idx");
+    row_idx->addIncoming(const_zero, entry_block);
+    llvm::Value* tuple_val = builder.CreateLoad(
+        builder.CreateInBoundsGEP(tuples_arg, row_idx), "tuple_val");
+    tuple_val = builder.CreateBitCast(tuple_val, tuple_ptr, "tuple");
+    if (agg_fn->is_count_star()) {
+      int field_idx = slot_desc->llvm_field_idx();
+      llvm::Value* slot_ptr =
+          builder.CreateStructGEP(nullptr, tuple_val, field_idx, "src_slot");
+      llvm::Value* slot_loaded = builder.CreateLoad(slot_ptr, "count_star_val");
+      llvm::Value* count_inc = builder.CreateAdd(
+          slot_loaded, codegen->GetI64Constant(1), "count_star_inc");
+      builder.CreateStore(count_inc, slot_ptr);
+    } else {
+      // Call UpdateSlot(row_agg_fn_evals[row_idx][i], tuple, rows[row_idx]);
+      llvm::Value* agg_fn_evals_val = builder.CreateLoad(
+          builder.CreateInBoundsGEP(row_agg_fn_evals_arg, row_idx), "agg_fn_evals");
+      llvm::Value* agg_fn_eval_val =
+          codegen->CodegenArrayAt(&builder, agg_fn_evals_val, i, "agg_fn_eval");
+      llvm::Value* row_val =
+          builder.CreateLoad(builder.CreateInBoundsGEP(rows_arg, row_idx), "row");
+      llvm::Value* update_slot_args[] = {agg_fn_eval_val, tuple_val, row_val};
+      builder.CreateCall(update_slot_fn, update_slot_args);
+    }
+    llvm::Value* next_row_idx = builder.CreateAdd(row_idx, const_one, "next_row_idx");
+    row_idx->addIncoming(next_row_idx, builder.GetInsertBlock());
+    builder.CreateCondBr(builder.CreateICmpSLT(next_row_idx, num_rows_arg), loop_block,
+        exit_block);
+    builder.SetInsertPoint(exit_block);
+  }
+  builder.CreateRetVoid();
+
+  if (aggregate_functions_.size() > LlvmCodeGen::CODEGEN_INLINE_EXPR_BATCH_THRESHOLD) {
+    codegen->SetNoInline(*fn);
+  }
+
+  *fn = codegen->FinalizeFunction(*fn);
+  if (*fn == nullptr) {
+    return Status("Aggregator::CodegenAddRowsToGroups(): codegen'd "
+                  "AddRowsToGroups() function failed verification, see log");
+  }
+  return Status::OK();
+}
 } // namespace impala
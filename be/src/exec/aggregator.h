@@ -124,6 +124,11 @@ class AggregatorConfig {
 
   /// Codegen Aggregator::UpdateTuple(). Returns non-OK status if codegen is unsuccessful.
   Status CodegenUpdateTuple(LlvmCodeGen* codegen, llvm::Function** fn) WARN_UNUSED_RESULT;
+
+  /// Codegen Aggregator::AddRowsToGroups(). Emits one loop over the rows per aggregate
+  /// function. Returns non-OK status if codegen is unsuccessful.
+  Status CodegenAddRowsToGroups(
+      LlvmCodeGen* codegen, llvm::Function** fn) WARN_UNUSED_RESULT;
 };
 
 /// Base class for aggregating rows. Used in the AggregationNode and
@@ -271,6 +276,15 @@ class Aggregator {
   void UpdateTuple(AggFnEvaluator** agg_fn_evals, Tuple* tuple, TupleRow* row,
       bool is_merge = false) noexcept;
 
+  /// Updates the intermediate tuples 'tuples[i]' with the unaggregated rows 'rows[i]'
+  /// using the evaluators 'row_agg_fn_evals[i]' for 0 <= i < 'num_rows'. Equivalent to
+  /// calling UpdateTuple() on each row in order, but iterates over the rows once per
+  /// aggregate function so that each function's update loop stays hot. Rows that belong
+  /// to the same group are applied in their original order.
+  /// This function is replaced by codegen.
+  void AddRowsToGroups(AggFnEvaluator** const* row_agg_fn_evals, Tuple** tuples,
+      TupleRow** rows, int num_rows) noexcept;
+
   /// Called on the intermediate tuple of each group after all input rows have been
   /// consumed and aggregated. Computes the final aggregate values to be returned in
   /// GetNext() using the agg fn evaluators' Serialize() or Finalize().
@@ -176,6 +176,14 @@ Status AnalyticEvalNode::Prepare(RuntimeState* state) {
   DCHECK_EQ(result_tuple_desc_->slots().size(), analytic_fns_.size());
   RETURN_IF_ERROR(AggFnEvaluator::Create(analytic_fns_, state, pool_, expr_perm_pool(),
       expr_results_pool(), &analytic_fn_evals_));
+  bool needs_remove = fn_scope_ == ROWS && window_.__isset.window_start;
+  for (AggFnEvaluator* eval : analytic_fn_evals_) {
+    if (needs_remove && !eval->agg_fn().SupportsRemove()) {
+      window_agg_fn_evals_.push_back(eval);
+    } else {
+      incremental_fn_evals_.push_back(eval);
+    }
+  }
 
   if (partition_by_eq_expr_ != nullptr) {
     RETURN_IF_ERROR(ScalarExprEvaluator::Create(*partition_by_eq_expr_, state, pool_,
@@ -193,6 +201,15 @@ Status AnalyticEvalNode::Prepare(RuntimeState* state) {
       Tuple::Create(intermediate_tuple_desc_->byte_size(), expr_perm_pool_.get());
   dummy_result_tuple_ =
       Tuple::Create(result_tuple_desc_->byte_size(), expr_perm_pool_.get());
+  if (!window_agg_fn_evals_.empty()) {
+    // Tuples of the sliding window aggregation, see RebuildWindowAggFront() and
+    // GetWindowAggValues(). They are initialized in Open().
+    window_agg_back_tuple_ =
+        Tuple::Create(intermediate_tuple_desc_->byte_size(), expr_perm_pool_.get());
+    window_agg_merge_tuple_ =
+        Tuple::Create(intermediate_tuple_desc_->byte_size(), expr_perm_pool_.get());
+    window_agg_front_pool_.reset(new MemPool(mem_tracker()));
+  }
   return Status::OK();
 }
 
@@ -244,6 +261,10 @@ Status AnalyticEvalNode::Open(RuntimeState* state) {
   // TODO: zeroing out curr_tuple_ shouldn't be strictly necessary.
   curr_tuple_->Init(intermediate_tuple_desc_->byte_size());
   AggFnEvaluator::Init(analytic_fn_evals_, curr_tuple_);
+  if (window_agg_back_tuple_ != nullptr) {
+    window_agg_back_tuple_->Init(intermediate_tuple_desc_->byte_size());
+    AggFnEvaluator::Init(window_agg_fn_evals_, window_agg_back_tuple_);
+  }
   curr_tuple_init_ = true;
   // Check for failures during AggFnEvaluator::Init().
   RETURN_IF_ERROR(state->GetQueryStatus());
@@ -349,12 +370,13 @@ inline Status AnalyticEvalNode::AddRow(int64_t stream_idx, TupleRow* row) {
   if (fn_scope_ != ROWS || !window_.__isset.window_start ||
       stream_idx - rows_start_offset_ >= curr_partition_idx_) {
     VLOG_ROW << id() << " Update idx=" << stream_idx;
-    AggFnEvaluator::Add(analytic_fn_evals_, row, curr_tuple_);
+    AggFnEvaluator::Add(incremental_fn_evals_, row, curr_tuple_);
     if (window_.__isset.window_start) {
       VLOG_ROW << id() << " Adding tuple to window at idx=" << stream_idx;
       Tuple* tuple = row->GetTuple(0)->DeepCopy(
           *child(0)->row_desc()->tuple_descriptors()[0], curr_tuple_pool_.get());
       window_tuples_.emplace_back(stream_idx, tuple);
+      AggFnEvaluator::Add(window_agg_fn_evals_, row, window_agg_back_tuple_);
     }
   }
 
@@ -386,7 +408,8 @@ Status AnalyticEvalNode::AddResultTuple(int64_t stream_idx) {
   MemPool* curr_tuple_pool = curr_tuple_pool_.get();
   Tuple* result_tuple = Tuple::Create(result_tuple_desc_->byte_size(), curr_tuple_pool);
 
-  AggFnEvaluator::GetValue(analytic_fn_evals_, curr_tuple_, result_tuple);
+  AggFnEvaluator::GetValue(incremental_fn_evals_, curr_tuple_, result_tuple);
+  if (!window_agg_fn_evals_.empty()) GetWindowAggValues(result_tuple);
   // Copy any string data in 'result_tuple' into 'curr_tuple_pool'. The var-len data
   // returned by GetValue() may be backed by an allocation from
   // 'expr_results_pool_' that will be recycled so it must be copied out.
@@ -450,11 +473,80 @@ inline void AnalyticEvalNode::TryRemoveRowsBeforeWindow(int64_t stream_idx) {
   DCHECK(!window_tuples_.empty()) << DebugStateString(true);
   DCHECK_EQ(remove_idx + max<int64_t>(rows_start_offset_, 0),
       window_tuples_.front().first) << DebugStateString(true);
+  RemoveFirstWindowTuple();
+}
+
+inline void AnalyticEvalNode::RemoveFirstWindowTuple() {
+  DCHECK(!window_tuples_.empty());
   TupleRow* remove_row = reinterpret_cast<TupleRow*>(&window_tuples_.front().second);
-  AggFnEvaluator::Remove(analytic_fn_evals_, remove_row, curr_tuple_);
+  AggFnEvaluator::Remove(incremental_fn_evals_, remove_row, curr_tuple_);
+  if (!window_agg_fn_evals_.empty()) {
+    if (window_agg_front_tuples_.empty()) RebuildWindowAggFront();
+    DCHECK_LE(window_agg_front_tuples_.size(), window_tuples_.size());
+    AggFnEvaluator::Finalize(
+        window_agg_fn_evals_, window_agg_front_tuples_.front(), dummy_result_tuple_);
+    window_agg_front_tuples_.pop_front();
+  }
   window_tuples_.pop_front();
 }
 
+void AnalyticEvalNode::RebuildWindowAggFront() {
+  DCHECK(window_agg_front_tuples_.empty());
+  VLOG_ROW << id() << " Rebuild window agg front, num_tuples=" << window_tuples_.size();
+  // All tuples of the previous front part were finalized when they were removed.
+  window_agg_front_pool_->Clear();
+  const int tuple_size = intermediate_tuple_desc_->byte_size();
+  Tuple* next_tuple = nullptr;
+  for (auto it = window_tuples_.rbegin(); it != window_tuples_.rend(); ++it) {
+    Tuple* tuple = Tuple::Create(tuple_size, window_agg_front_pool_.get());
+    TupleRow* row = reinterpret_cast<TupleRow*>(&it->second);
+    for (AggFnEvaluator* eval : window_agg_fn_evals_) {
+      eval->Init(tuple);
+      eval->Add(row, tuple);
+      if (next_tuple != nullptr) eval->Merge(next_tuple, tuple);
+    }
+    window_agg_front_tuples_.push_front(tuple);
+    next_tuple = tuple;
+  }
+  // All tuples are now in the front part, start over with an empty back part.
+  AggFnEvaluator::Finalize(window_agg_fn_evals_, window_agg_back_tuple_,
+      dummy_result_tuple_);
+  window_agg_back_tuple_->Init(tuple_size);
+  AggFnEvaluator::Init(window_agg_fn_evals_, window_agg_back_tuple_);
+}
+
+void AnalyticEvalNode::GetWindowAggValues(Tuple* result_tuple) {
+  Tuple* front_tuple =
+      window_agg_front_tuples_.empty() ? nullptr : window_agg_front_tuples_.front();
+  window_agg_merge_tuple_->Init(intermediate_tuple_desc_->byte_size());
+  for (AggFnEvaluator* eval : window_agg_fn_evals_) {
+    eval->Init(window_agg_merge_tuple_);
+    if (front_tuple != nullptr) eval->Merge(front_tuple, window_agg_merge_tuple_);
+    eval->Merge(window_agg_back_tuple_, window_agg_merge_tuple_);
+    eval->GetValue(window_agg_merge_tuple_, result_tuple);
+  }
+  // Release any allocations made for the merged values. The var-len data returned by
+  // GetValue() is copied out of 'expr_results_pool_' by the caller, so it is not
+  // affected.
+  AggFnEvaluator::Finalize(window_agg_fn_evals_, window_agg_merge_tuple_,
+      dummy_result_tuple_);
+}
+
+void AnalyticEvalNode::ResetWindowAgg(bool reinit) {
+  if (window_agg_fn_evals_.empty()) return;
+  for (Tuple* tuple : window_agg_front_tuples_) {
+    AggFnEvaluator::Finalize(window_agg_fn_evals_, tuple, dummy_result_tuple_);
+  }
+  window_agg_front_tuples_.clear();
+  window_agg_front_pool_->Clear();
+  AggFnEvaluator::Finalize(window_agg_fn_evals_, window_agg_back_tuple_,
+      dummy_result_tuple_);
+  if (reinit) {
+    window_agg_back_tuple_->Init(intermediate_tuple_desc_->byte_size());
+    AggFnEvaluator::Init(window_agg_fn_evals_, window_agg_back_tuple_);
+  }
+}
+
 inline Status AnalyticEvalNode::TryAddRemainingResults(int64_t partition_idx,
     int64_t prev_partition_idx) {
   DCHECK_LT(prev_partition_idx, partition_idx);
@@ -492,9 +584,7 @@ inline Status AnalyticEvalNode::TryAddRemainingResults(int64_t partition_idx,
       // and add the result tuple at the next index.
       VLOG_ROW << id() << " Remove window_row_idx=" << window_tuples_.front().first
                << " for result row at idx=" << next_result_idx;
-      TupleRow* remove_row = reinterpret_cast<TupleRow*>(&window_tuples_.front().second);
-      AggFnEvaluator::Remove(analytic_fn_evals_, remove_row, curr_tuple_);
-      window_tuples_.pop_front();
+      RemoveFirstWindowTuple();
     }
     RETURN_IF_ERROR(AddResultTuple(last_result_idx_ + 1));
   }
@@ -560,6 +650,7 @@ inline Status AnalyticEvalNode::InitNextPartition(RuntimeState* state,
   // Call finalize to release resources; result is not needed but the dst tuple must be
   // a tuple described by result_tuple_desc_.
   DCHECK(curr_tuple_init_);
+  ResetWindowAgg(true);
   AggFnEvaluator::Finalize(analytic_fn_evals_, curr_tuple_, dummy_result_tuple_);
   // Re-initialize curr_tuple_.
   // TODO: zeroing out curr_tuple_ shouldn't be strictly necessary.
@@ -852,6 +943,7 @@ Status AnalyticEvalNode::Reset(RuntimeState* state, RowBatch* row_batch) {
   // so we can keep evaluating them.
   if (curr_tuple_init_) {
     AggFnEvaluator::Finalize(analytic_fn_evals_, curr_tuple_, dummy_result_tuple_);
+    ResetWindowAgg(false);
     curr_tuple_init_ = false;
   }
   // The following members will be re-created in Open().
@@ -882,6 +974,7 @@ void AnalyticEvalNode::Close(RuntimeState* state) {
   // Need to make sure finalize is called in case there is any state to clean up.
   if (curr_tuple_init_)  {
     AggFnEvaluator::Finalize(analytic_fn_evals_, curr_tuple_, dummy_result_tuple_);
+    ResetWindowAgg(false);
   }
   AggFnEvaluator::Close(analytic_fn_evals_, state);
 
@@ -891,6 +984,7 @@ void AnalyticEvalNode::Close(RuntimeState* state) {
   if (curr_tuple_pool_.get() != nullptr) curr_tuple_pool_->FreeAll();
   if (prev_tuple_pool_.get() != nullptr) prev_tuple_pool_->FreeAll();
   if (prev_input_tuple_pool_.get() != nullptr) prev_input_tuple_pool_->FreeAll();
+  if (window_agg_front_pool_.get() != nullptr) window_agg_front_pool_->FreeAll();
   ExecNode::Close(state);
 }
 
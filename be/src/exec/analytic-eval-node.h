@@ -83,6 +83,17 @@ class AnalyticEvalPlanNode : public PlanNode {
 /// multiple rows have the same values for the order by exprs. The number of buffered
 /// rows may be an entire partition or even the entire input. Therefore, the output
 /// rows are buffered and may spill to disk via the BufferedTupleStream.
+///
+/// Functions over ROWS windows with a start bound that cannot undo an Add() with
+/// Remove(), i.e. min() and max(), are evaluated with a sliding window aggregation over
+/// window_tuples_ instead of incrementally in curr_tuple_. The window is split into a
+/// front and a back part. The back part is aggregated into a single intermediate tuple
+/// as rows are added. The front part keeps one intermediate tuple per row, aggregating
+/// the row and all rows after it in the front part, so that removing the first row of
+/// the window just drops its tuple. When the front part runs empty, it is rebuilt from
+/// the rows of the back part. The result for a window is the Merge() of the first
+/// tuple of the front part and the tuple of the back part. Every row is thus added and
+/// merged a constant number of times, regardless of the size of the window.
 
 class AnalyticEvalNode : public ExecNode {
  public:
@@ -181,6 +192,22 @@ class AnalyticEvalNode : public ExecNode {
   /// ProcessChildBatch().
   void TryRemoveRowsBeforeWindow(int64_t stream_idx);
 
+  /// Removes the first tuple of window_tuples_ from the window, both from curr_tuple_
+  /// and from the sliding window aggregation of 'window_agg_fn_evals_'.
+  void RemoveFirstWindowTuple();
+
+  /// Rebuilds the front part of the sliding window aggregation from all tuples in
+  /// window_tuples_, which must all be in the back part, and resets the back part.
+  void RebuildWindowAggFront();
+
+  /// Writes the results of 'window_agg_fn_evals_' over the current window into
+  /// 'result_tuple'.
+  void GetWindowAggValues(Tuple* result_tuple);
+
+  /// Finalizes all intermediate tuples of the sliding window aggregation. If 'reinit' is
+  /// true, the aggregation is re-initialized for an empty window.
+  void ResetWindowAgg(bool reinit);
+
   /// Initializes state at the start of a new partition. stream_idx is the index of the
   /// current input row from input_stream_.
   Status InitNextPartition(RuntimeState* state, int64_t stream_idx);
@@ -265,6 +292,19 @@ class AnalyticEvalNode : public ExecNode {
   const std::vector<AggFn*>& analytic_fns_;
   std::vector<AggFnEvaluator*> analytic_fn_evals_;
 
+  /// Subsets of 'analytic_fn_evals_'. 'window_agg_fn_evals_' are the evaluators that do
+  /// not support Remove() but need it because the window has a start bound. They are
+  /// evaluated with the sliding window aggregation. All other evaluators are in
+  /// 'incremental_fn_evals_' and are evaluated in curr_tuple_.
+  std::vector<AggFnEvaluator*> incremental_fn_evals_;
+  std::vector<AggFnEvaluator*> window_agg_fn_evals_;
+
+  /// Intermediate tuples of 'window_agg_fn_evals_' for the back part of the window and
+  /// for merging the front and back parts in GetWindowAggValues(). Owned by
+  /// expr_perm_pool_ and only allocated if 'window_agg_fn_evals_' is non-empty.
+  Tuple* window_agg_back_tuple_ = nullptr;
+  Tuple* window_agg_merge_tuple_ = nullptr;
+
   /// Indicates if each evaluator is the lead() fn. Used by ResetLeadFnSlots() to
   /// determine which slots need to be reset.
   std::vector<bool> is_lead_fn_;
@@ -316,6 +356,13 @@ class AnalyticEvalNode : public ExecNode {
   /// TODO: Remove and use BufferedTupleStream (needs support for multiple readers).
   std::deque<std::pair<int64_t, Tuple*>> window_tuples_;
 
+  /// Intermediate tuples of 'window_agg_fn_evals_' for the front part of the window,
+  /// one per tuple at the start of window_tuples_. The i-th tuple aggregates the i-th
+  /// and all following tuples of the front part. Owned by 'window_agg_front_pool_',
+  /// which is cleared whenever the front part is rebuilt.
+  std::deque<Tuple*> window_agg_front_tuples_;
+  boost::scoped_ptr<MemPool> window_agg_front_pool_;
+
   /// The index of the last row from input_stream_ associated with output row containing
   /// resources in prev_tuple_pool_. -1 when the pool is empty. Resources from
   /// prev_tuple_pool_ can only be transferred to an output batch once all rows containing
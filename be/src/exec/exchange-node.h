@@ -47,8 +47,8 @@ class ExchangePlanNode : public PlanNode {
   /// Config used to create a TupleRowComparator instance. Non null for merging exchange.
   TupleRowComparatorConfig* row_comparator_config_ = nullptr;
 
-  /// Codegened version of SortedRunMerger::HeapifyHelper().
-  CodegenFnPtr<SortedRunMerger::HeapifyHelperFn> codegend_heapify_helper_fn_;
+  /// Codegened version of SortedRunMerger::ReplayHelper().
+  CodegenFnPtr<SortedRunMerger::ReplayHelperFn> codegend_replay_helper_fn_;
 };
 
 /// Receiver node for data streams. The data stream receiver is created in Prepare()
@@ -52,6 +52,7 @@ Status GroupingAggregator::AddBatchImpl(RowBatch* batch,
           has_more_rows));
       expr_vals_cache->NextRow();
     }
+    if (!AGGREGATED_ROWS) FlushPendingAggUpdates();
     DCHECK(expr_vals_cache->AtEnd());
   }
   return Status::OK();
@@ -105,6 +106,7 @@ Status GroupingAggregator::ProcessRow(
   DCHECK_EQ(dst_partition->is_spilled(), hash_tbl == nullptr);
   if (hash_tbl == nullptr) {
     // This partition is already spilled, just append the row.
+    if (!AGGREGATED_ROWS) FlushPendingAggUpdates();
     return AppendSpilledRow<AGGREGATED_ROWS>(dst_partition, row);
   }
 
@@ -122,8 +124,17 @@ Status GroupingAggregator::ProcessRow(
     DCHECK(!found);
   } else if (found) {
     // Row is already in hash table. Do the aggregation and we're done.
-    UpdateTuple(
-        dst_partition->agg_fn_evals.data(), it.GetTuple<BucketType::MATCH_UNSET>(), row);
+    Tuple* intermediate_tuple = it.GetTuple<BucketType::MATCH_UNSET>();
+    if (batch_update_) {
+      // Defer the update to FlushPendingAggUpdates(). New groups are still updated
+      // right away below, so the updates of each group are applied in row order.
+      pending_agg_fn_evals_[num_pending_updates_] = dst_partition->agg_fn_evals.data();
+      pending_tuples_[num_pending_updates_] = intermediate_tuple;
+      pending_rows_[num_pending_updates_] = row;
+      ++num_pending_updates_;
+    } else {
+      UpdateTuple(dst_partition->agg_fn_evals.data(), intermediate_tuple, row);
+    }
     return Status::OK();
   }
 
@@ -151,6 +162,8 @@ Status GroupingAggregator::AddIntermediateTuple(Partition* __restrict__ partitio
     } else if (!add_batch_status_.ok()) {
       return std::move(add_batch_status_);
     }
+    // Apply the deferred updates before spilling can unpin their tuples.
+    if (!AGGREGATED_ROWS) FlushPendingAggUpdates();
 
     // If we don't need to reserve extra space for the serialize stream, restore them
     // before spilling any partitions. One case is we don't need the serialize stream at
@@ -170,6 +183,13 @@ Status GroupingAggregator::AddIntermediateTuple(Partition* __restrict__ partitio
   }
 }
 
+void GroupingAggregator::FlushPendingAggUpdates() {
+  if (num_pending_updates_ == 0) return;
+  AddRowsToGroups(pending_agg_fn_evals_.get(), pending_tuples_.get(), pending_rows_.get(),
+      num_pending_updates_);
+  num_pending_updates_ = 0;
+}
+
 Status GroupingAggregator::AddBatchStreamingImpl(int agg_idx, bool needs_serialize,
     TPrefetchMode::type prefetch_mode, RowBatch* in_batch, RowBatch* out_batch,
     HashTableCtx* __restrict__ ht_ctx, int remaining_capacity[PARTITION_FANOUT]) {
@@ -189,11 +209,15 @@ Status GroupingAggregator::AddBatchStreamingImpl(int agg_idx, bool needs_seriali
       TupleRow* in_row = in_batch_iter.Get();
       const uint32_t hash = expr_vals_cache->CurExprValuesHash();
       const uint32_t partition_idx = hash >> (32 - NUM_PARTITIONING_BITS);
+      Partition* dst_partition = hash_partitions_[partition_idx];
+      // Partitions that pass through all rows skip the hash table probe altogether.
       if (!expr_vals_cache->IsRowNull()
-          && !TryAddToHashTable(ht_ctx, hash_partitions_[partition_idx],
-                 GetHashTable(partition_idx), in_row, hash,
-                 &remaining_capacity[partition_idx], &add_batch_status_)) {
+          && (dst_partition->preagg_mode == PreaggMode::PASS_THROUGH
+              || !TryAddToHashTable(ht_ctx, dst_partition, GetHashTable(partition_idx),
+                     in_row, hash, &remaining_capacity[partition_idx],
+                     &add_batch_status_))) {
         RETURN_IF_ERROR(std::move(add_batch_status_));
+        ++dst_partition->preagg_passed_through_rows;
         // Tuple is not going into hash table, add it to the output batch.
         Tuple* intermediate_tuple = ConstructIntermediateTuple(
             agg_fn_evals_, out_batch->tuple_data_pool(), &add_batch_status_);
@@ -240,7 +264,9 @@ bool GroupingAggregator::TryAddToHashTable(HashTableCtx* __restrict__ ht_ctx,
   // This is called from ProcessBatchStreaming() so the rows are not aggregated.
   HashTable::Iterator it =
       hash_tbl->FindBuildRowBucket<BucketType::MATCH_UNSET>(ht_ctx, &found);
+  ++partition->preagg_probed_rows;
   if (found) {
+    ++partition->preagg_matched_rows;
     intermediate_tuple = it.GetTuple<BucketType::MATCH_UNSET>();
   } else if (*remaining_capacity == 0) {
     return false;
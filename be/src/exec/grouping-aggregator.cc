@@ -39,6 +39,7 @@
 #include "runtime/tuple-row.h"
 #include "runtime/tuple.h"
 #include "util/runtime-profile-counters.h"
+#include "util/stopwatch.h"
 #include "util/string-parser.h"
 
 #include "gen-cpp/PlanNodes_types.h"
@@ -117,8 +118,9 @@ Status GroupingAggregatorConfig::Init(
     needs_serialize_ |= aggregate_functions_[i]->SupportsSerialize();
   }
 
-  hash_table_config_ = state->obj_pool()->Add(new HashTableConfig(
-      build_exprs_, grouping_exprs_, true, vector<bool>(build_exprs_.size(), true)));
+  hash_table_config_ = state->obj_pool()->Add(new HashTableConfig(build_exprs_,
+      grouping_exprs_, true, vector<bool>(build_exprs_.size(), true),
+      state->query_options().hash_table_tagged_probing));
   return Status::OK();
 }
 
@@ -131,6 +133,26 @@ void GroupingAggregatorConfig::Close() {
 static const int STREAMING_HT_MIN_REDUCTION_SIZE =
     sizeof(STREAMING_HT_MIN_REDUCTION) / sizeof(STREAMING_HT_MIN_REDUCTION[0]);
 
+/// Returns the minimum reduction factor from STREAMING_HT_MIN_REDUCTION for hash tables
+/// with bucket directories of 'ht_mem' bytes in total.
+static double StreamingHtMinReduction(int64_t ht_mem) {
+  int cache_level = 0;
+  while (cache_level + 1 < STREAMING_HT_MIN_REDUCTION_SIZE
+      && ht_mem >= STREAMING_HT_MIN_REDUCTION[cache_level + 1].min_ht_mem) {
+    ++cache_level;
+  }
+  return STREAMING_HT_MIN_REDUCTION[cache_level].streaming_ht_min_reduction;
+}
+
+/// The adaptive streaming preaggregation decides the mode of a partition once it has
+/// probed ADAPTIVE_PREAGG_SAMPLE_ROWS rows in AGGREGATE or SAMPLE mode, and samples a
+/// partition again after it passed through ADAPTIVE_PREAGG_PASS_THROUGH_ROWS rows.
+static const int64_t ADAPTIVE_PREAGG_SAMPLE_ROWS = 8 * 1024;
+static const int64_t ADAPTIVE_PREAGG_PASS_THROUGH_ROWS = 128 * 1024;
+
+/// Weight of the latest batch in the moving average of the per-row cost.
+static const double ADAPTIVE_PREAGG_COST_SMOOTHING = 0.1;
+
 GroupingAggregator::GroupingAggregator(ExecNode* exec_node, ObjectPool* pool,
     const GroupingAggregatorConfig& config, int64_t estimated_input_cardinality,
     bool needUnsetLimit)
@@ -176,6 +198,18 @@ Status GroupingAggregator::Prepare(RuntimeState* state) {
         ADD_COUNTER(runtime_profile(), "ReductionFactorEstimate", TUnit::DOUBLE_VALUE);
     preagg_streaming_ht_min_reduction_ = ADD_COUNTER(
         runtime_profile(), "ReductionFactorThresholdToExpand", TUnit::DOUBLE_VALUE);
+    adaptive_preagg_ = state->query_options().adaptive_streaming_preaggregation;
+    if (adaptive_preagg_) {
+      runtime_profile()->AppendExecOption("Adaptive Streaming Preaggregation");
+      preagg_switches_to_passthrough_ = ADD_COUNTER(
+          runtime_profile(), "PartitionsSwitchedToPassThrough", TUnit::UNIT);
+      preagg_switches_to_aggregation_ = ADD_COUNTER(
+          runtime_profile(), "PartitionsSwitchedToAggregation", TUnit::UNIT);
+      preagg_passthrough_partitions_ = ADD_COUNTER(
+          runtime_profile(), "PassThroughPartitions", TUnit::UNIT);
+      preagg_probe_cost_ratio_ = ADD_COUNTER(
+          runtime_profile(), "ProbeCostRatio", TUnit::DOUBLE_VALUE);
+    }
   } else {
     num_row_repartitioned_ =
         ADD_COUNTER(runtime_profile(), "RowsRepartitioned", TUnit::UNIT);
@@ -190,6 +224,16 @@ Status GroupingAggregator::Prepare(RuntimeState* state) {
       state->fragment_hash_seed(), MAX_PARTITION_DEPTH, 1, expr_perm_pool_.get(),
       expr_results_pool_.get(), expr_results_pool_.get(), &ht_ctx_));
 
+  batch_update_ =
+      !is_streaming_preagg_ && state->query_options().grouping_agg_batch_update;
+  if (batch_update_) {
+    runtime_profile()->AppendExecOption("Batched Aggregate Update");
+    const int cache_size = ht_ctx_->expr_values_cache()->capacity();
+    pending_agg_fn_evals_.reset(new AggFnEvaluator**[cache_size]);
+    pending_tuples_.reset(new Tuple*[cache_size]);
+    pending_rows_.reset(new TupleRow*[cache_size]);
+  }
+
   reservation_tracker_.reset(new ReservationTracker);
   reservation_tracker_->InitChildTracker(runtime_profile_,
       state->instance_buffer_reservation(), exec_node_->mem_tracker(),
@@ -206,7 +250,8 @@ void GroupingAggregatorConfig::Codegen(FragmentState* state) {
   TPrefetchMode::type prefetch_mode = state->query_options().prefetch_mode;
   Status status = is_streaming_preagg_ ?
       CodegenAddBatchStreamingImpl(codegen, prefetch_mode) :
-      CodegenAddBatchImpl(codegen, prefetch_mode);
+      CodegenAddBatchImpl(codegen, prefetch_mode,
+          state->query_options().grouping_agg_batch_update);
   codegen_status_msg_ = FragmentState::GenerateCodegenMsg(status.ok(), status);
 }
 
@@ -358,13 +403,6 @@ bool GroupingAggregator::ShouldExpandPreaggHashTables() const {
   // Need some rows in tables to have valid statistics.
   if (ht_rows == 0) return true;
 
-  // Find the appropriate reduction factor in our table for the current hash table sizes.
-  int cache_level = 0;
-  while (cache_level + 1 < STREAMING_HT_MIN_REDUCTION_SIZE
-      && ht_mem >= STREAMING_HT_MIN_REDUCTION[cache_level + 1].min_ht_mem) {
-    ++cache_level;
-  }
-
   // Compare the number of rows in the hash table with the number of input rows that
   // were aggregated into it. Exclude passed through rows from this calculation since
   // they were not in hash tables.
@@ -385,14 +423,87 @@ bool GroupingAggregator::ShouldExpandPreaggHashTables() const {
   double estimated_reduction = aggregated_input_rows >= expected_input_rows ?
       current_reduction :
       1 + (expected_input_rows / aggregated_input_rows) * (current_reduction - 1);
-  double min_reduction =
-      STREAMING_HT_MIN_REDUCTION[cache_level].streaming_ht_min_reduction;
+  // Find the appropriate reduction factor in our table for the current hash table sizes.
+  double min_reduction = StreamingHtMinReduction(ht_mem);
 
   COUNTER_SET(preagg_estimated_reduction_, estimated_reduction);
   COUNTER_SET(preagg_streaming_ht_min_reduction_, min_reduction);
   return estimated_reduction > min_reduction;
 }
 
+void GroupingAggregator::AdaptPreaggPartitions(uint64_t ticks, int64_t num_probed_rows) {
+  DCHECK(adaptive_preagg_);
+  if (num_probed_rows > 0) {
+    double ticks_per_row = static_cast<double>(ticks) / num_probed_rows;
+    if (preagg_min_ticks_per_row_ == 0) {
+      preagg_min_ticks_per_row_ = ticks_per_row;
+      preagg_avg_ticks_per_row_ = ticks_per_row;
+    } else {
+      preagg_min_ticks_per_row_ = min(preagg_min_ticks_per_row_, ticks_per_row);
+      preagg_avg_ticks_per_row_ += ADAPTIVE_PREAGG_COST_SMOOTHING
+          * (ticks_per_row - preagg_avg_ticks_per_row_);
+    }
+  }
+  if (preagg_min_ticks_per_row_ == 0) return;
+
+  int64_t ht_mem = 0;
+  for (int i = 0; i < PARTITION_FANOUT; ++i) {
+    HashTable* ht = hash_partitions_[i]->hash_tbl.get();
+    if (ht != nullptr) ht_mem += ht->CurrentMemSize();
+  }
+  // The static thresholds account for the size of the hash tables relative to the
+  // caches. On top of that, every multiple of the cheapest per-row cost seen so far
+  // (e.g. because the probes now miss the caches or the groups got wider) must be paid
+  // for by aggregating one more input row into each group.
+  const double cost_ratio = preagg_avg_ticks_per_row_ / preagg_min_ticks_per_row_;
+  const double min_reduction = StreamingHtMinReduction(ht_mem) + (cost_ratio - 1);
+  COUNTER_SET(preagg_probe_cost_ratio_, cost_ratio);
+  COUNTER_SET(preagg_streaming_ht_min_reduction_, min_reduction);
+
+  int num_passthrough_partitions = 0;
+  for (int i = 0; i < PARTITION_FANOUT; ++i) {
+    Partition* partition = hash_partitions_[i];
+    if (partition->hash_tbl == nullptr) {
+      // Rows of partitions without a hash table are always passed through.
+      ++num_passthrough_partitions;
+      continue;
+    }
+    if (partition->preagg_mode == PreaggMode::PASS_THROUGH) {
+      if (partition->preagg_passed_through_rows >= ADAPTIVE_PREAGG_PASS_THROUGH_ROWS) {
+        partition->preagg_mode = PreaggMode::SAMPLE;
+        partition->preagg_probed_rows = 0;
+        partition->preagg_matched_rows = 0;
+        partition->preagg_passed_through_rows = 0;
+      } else {
+        ++num_passthrough_partitions;
+      }
+      continue;
+    }
+    if (partition->preagg_probed_rows < ADAPTIVE_PREAGG_SAMPLE_ROWS) continue;
+
+    // The reduction that the hash table achieved on the rows probed since the last
+    // decision: the rows that did not match an existing group were either inserted as
+    // new groups or passed through.
+    const int64_t unmatched_rows =
+        partition->preagg_probed_rows - partition->preagg_matched_rows;
+    const double reduction = static_cast<double>(partition->preagg_probed_rows)
+        / max<int64_t>(1, unmatched_rows);
+    const PreaggMode new_mode =
+        reduction > min_reduction ? PreaggMode::AGGREGATE : PreaggMode::PASS_THROUGH;
+    if (new_mode == PreaggMode::PASS_THROUGH) {
+      ++num_passthrough_partitions;
+      COUNTER_ADD(preagg_switches_to_passthrough_, 1);
+    } else if (partition->preagg_mode == PreaggMode::SAMPLE) {
+      COUNTER_ADD(preagg_switches_to_aggregation_, 1);
+    }
+    partition->preagg_mode = new_mode;
+    partition->preagg_probed_rows = 0;
+    partition->preagg_matched_rows = 0;
+    partition->preagg_passed_through_rows = 0;
+  }
+  COUNTER_SET(preagg_passthrough_partitions_, num_passthrough_partitions);
+}
+
 void GroupingAggregator::CleanupHashTbl(
     const vector<AggFnEvaluator*>& agg_fn_evals, HashTable::Iterator it) {
   if (!needs_finalize_ && !needs_serialize_) return;
@@ -483,6 +594,11 @@ Status GroupingAggregator::AddBatchStreaming(
   bool ht_needs_expansion = false;
   for (int i = 0; i < PARTITION_FANOUT; ++i) {
     HashTable* hash_tbl = GetHashTable(i);
+    if (hash_partitions_[i]->preagg_mode != PreaggMode::AGGREGATE) {
+      // Partitions that pass through rows or sample their reduction don't insert.
+      remaining_capacity[i] = 0;
+      continue;
+    }
     remaining_capacity[i] = hash_tbl->NumInsertsBeforeResize();
     ht_needs_expansion |= remaining_capacity[i] < child_batch->num_rows();
   }
@@ -495,6 +611,7 @@ Status GroupingAggregator::AddBatchStreaming(
   if (ht_needs_expansion && ShouldExpandPreaggHashTables()) {
     for (int i = 0; i < PARTITION_FANOUT; ++i) {
       HashTable* ht = GetHashTable(i);
+      if (hash_partitions_[i]->preagg_mode != PreaggMode::AGGREGATE) continue;
       if (remaining_capacity[i] < child_batch->num_rows()) {
         SCOPED_TIMER(ht_resize_timer_);
         bool resized;
@@ -510,6 +627,23 @@ Status GroupingAggregator::AddBatchStreaming(
   TPrefetchMode::type prefetch_mode = state->query_options().prefetch_mode;
   GroupingAggregatorConfig::AddBatchStreamingImplFn fn
       = add_batch_streaming_impl_fn_.load();
+  // The probe cost is only sampled from batches in which every partition probes its
+  // hash table: the rows of partitions that pass through are much cheaper, so counting
+  // them would lower the measured cost and keep it low while partitions pass through.
+  int64_t probed_rows_before = 0;
+  bool all_partitions_probe = adaptive_preagg_;
+  StopWatch ticks;
+  if (adaptive_preagg_) {
+    for (int i = 0; i < PARTITION_FANOUT; ++i) {
+      const Partition* partition = hash_partitions_[i];
+      if (partition->hash_tbl == nullptr
+          || partition->preagg_mode == PreaggMode::PASS_THROUGH) {
+        all_partitions_probe = false;
+      }
+      probed_rows_before += partition->preagg_probed_rows;
+    }
+    ticks.Start();
+  }
   if (fn != nullptr) {
     RETURN_IF_ERROR(fn(this, agg_idx_, needs_serialize_,
         prefetch_mode, child_batch, out_batch, ht_ctx_.get(), remaining_capacity));
@@ -518,6 +652,17 @@ Status GroupingAggregator::AddBatchStreaming(
         child_batch, out_batch, ht_ctx_.get(), remaining_capacity));
   }
   *eos = (streaming_idx_ == 0);
+  if (adaptive_preagg_) {
+    const uint64_t elapsed_ticks = ticks.ElapsedTime();
+    int64_t num_probed_rows = 0;
+    if (all_partitions_probe) {
+      for (int i = 0; i < PARTITION_FANOUT; ++i) {
+        num_probed_rows += hash_partitions_[i]->preagg_probed_rows;
+      }
+      num_probed_rows -= probed_rows_before;
+    }
+    AdaptPreaggPartitions(elapsed_ticks, num_probed_rows);
+  }
 
   num_rows_returned_ += out_batch->num_rows();
   COUNTER_SET(num_passthrough_rows_, num_rows_returned_);
@@ -1174,7 +1319,7 @@ BufferPool::ClientHandle* GroupingAggregator::buffer_pool_client() {
 }
 
 Status GroupingAggregatorConfig::CodegenAddBatchImpl(
-    LlvmCodeGen* codegen, TPrefetchMode::type prefetch_mode) {
+    LlvmCodeGen* codegen, TPrefetchMode::type prefetch_mode, bool batch_update) {
   llvm::Function* update_tuple_fn;
   RETURN_IF_ERROR(CodegenUpdateTuple(codegen, &update_tuple_fn));
 
@@ -1227,9 +1372,20 @@ Status GroupingAggregatorConfig::CodegenAddBatchImpl(
   DCHECK_GE(replaced_constants.stores_duplicates, 1);
   DCHECK_GE(replaced_constants.stores_tuples, 1);
   DCHECK_GE(replaced_constants.quadratic_probing, 1);
+  DCHECK_GE(replaced_constants.tagged_probing, 1);
 
   replaced = codegen->ReplaceCallSites(add_batch_impl_fn, update_tuple_fn, "UpdateTuple");
   DCHECK_GE(replaced, 1);
+
+  // The deferred updates are only applied if the query enables batched updates, so
+  // don't spend time on codegen'ing them otherwise.
+  if (batch_update) {
+    llvm::Function* add_rows_to_groups_fn;
+    RETURN_IF_ERROR(CodegenAddRowsToGroups(codegen, &add_rows_to_groups_fn));
+    replaced = codegen->ReplaceCallSites(
+        add_batch_impl_fn, add_rows_to_groups_fn, "AddRowsToGroups");
+    DCHECK_GE(replaced, 1);
+  }
   add_batch_impl_fn = codegen->FinalizeFunction(add_batch_impl_fn);
   if (add_batch_impl_fn == nullptr) {
     return Status("GroupingAggregator::CodegenAddBatchImpl(): codegen'd "
@@ -1303,6 +1459,7 @@ Status GroupingAggregatorConfig::CodegenAddBatchStreamingImpl(
   DCHECK_GE(replaced_constants.stores_duplicates, 1);
   DCHECK_GE(replaced_constants.stores_tuples, 1);
   DCHECK_GE(replaced_constants.quadratic_probing, 1);
+  DCHECK_GE(replaced_constants.tagged_probing, 1);
 
   DCHECK(add_batch_streaming_impl_fn != nullptr);
   add_batch_streaming_impl_fn = codegen->FinalizeFunction(add_batch_streaming_impl_fn);
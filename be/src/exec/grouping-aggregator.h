@@ -91,6 +91,11 @@ class Tuple;
 /// resources to expand its hash table. The planner decides whether a given
 /// pre-aggregation should use the streaming preaggregation algorithm or the same
 /// blocking aggregation algorithm as used in merge aggregations.
+/// With the ADAPTIVE_STREAMING_PREAGGREGATION query option, the decision is also made
+/// per partition and revisited over the lifetime of the query: a partition whose
+/// observed reduction does not justify the measured per-row cost passes all of its rows
+/// through without probing its hash table, and is periodically sampled to switch back
+/// to aggregating if its reduction recovers. See AdaptPreaggPartitions().
 /// TODO: make this less of a heuristic by factoring in the cost of the exchange vs the
 /// cost of the pre-aggregation.
 ///
@@ -179,9 +184,10 @@ class GroupingAggregatorConfig : public AggregatorConfig {
   /// This function will modify the loop subsituting the statically compiled functions
   /// with codegen'd ones. 'add_batch_impl_fn_' will be updated with the codegened
   /// function.
-  /// Assumes AGGREGATED_ROWS = false.
-  Status CodegenAddBatchImpl(
-      LlvmCodeGen* codegen, TPrefetchMode::type prefetch_mode) WARN_UNUSED_RESULT;
+  /// Assumes AGGREGATED_ROWS = false. AddRowsToGroups() is only codegen'd if
+  /// 'batch_update' is true.
+  Status CodegenAddBatchImpl(LlvmCodeGen* codegen, TPrefetchMode::type prefetch_mode,
+      bool batch_update) WARN_UNUSED_RESULT;
 
   /// Codegen the materialization loop for streaming preaggregations.
   /// 'add_batch_streaming_impl_fn_' will be updated with the codegened function.
@@ -268,6 +274,20 @@ class GroupingAggregator : public Aggregator {
   /// True if any of the evaluators require the serialize step.
   bool needs_serialize_ = false;
 
+  /// True if AddBatchImpl() defers the aggregate function updates of rows that match an
+  /// existing group and applies them with AddRowsToGroups() once per prefetch group.
+  /// Set from the GROUPING_AGG_BATCH_UPDATE query option in Prepare(). Never true for
+  /// streaming preaggregations.
+  bool batch_update_ = false;
+
+  /// The deferred updates of the current prefetch group if 'batch_update_' is true:
+  /// the evaluators of the row's partition, the group's intermediate tuple and the row.
+  /// Sized to the capacity of the expression values cache of 'ht_ctx_'.
+  std::unique_ptr<AggFnEvaluator**[]> pending_agg_fn_evals_;
+  std::unique_ptr<Tuple*[]> pending_tuples_;
+  std::unique_ptr<TupleRow*[]> pending_rows_;
+  int num_pending_updates_ = 0;
+
   /// Exprs used to evaluate input rows
   const std::vector<ScalarExpr*>& grouping_exprs_;
 
@@ -368,6 +388,28 @@ class GroupingAggregator : public Aggregator {
   /// Expose the minimum reduction factor to continue growing the hash tables.
   RuntimeProfile::Counter* preagg_streaming_ht_min_reduction_ = nullptr;
 
+  /// True if the partitions of a streaming preaggregation switch between aggregating
+  /// and passing through rows based on their observed reduction. Set from the
+  /// ADAPTIVE_STREAMING_PREAGGREGATION query option in Prepare().
+  bool adaptive_preagg_ = false;
+
+  /// Cpu ticks per row probed against the hash tables of the streaming preaggregation:
+  /// the lowest seen over any batch, which approximates the cost when the hash tables
+  /// are cache-resident, and a moving average of the recent batches. Only sampled from
+  /// batches in which no partition passes its rows through without probing. Only
+  /// maintained if 'adaptive_preagg_'.
+  double preagg_min_ticks_per_row_ = 0;
+  double preagg_avg_ticks_per_row_ = 0;
+
+  /// Adaptive streaming preaggregation counters: the number of times a partition
+  /// switched to passing through rows and back to aggregating them, the number of
+  /// partitions currently passing through rows, and the ratio of the recent per-row
+  /// cost to the lowest per-row cost.
+  RuntimeProfile::Counter* preagg_switches_to_passthrough_ = nullptr;
+  RuntimeProfile::Counter* preagg_switches_to_aggregation_ = nullptr;
+  RuntimeProfile::Counter* preagg_passthrough_partitions_ = nullptr;
+  RuntimeProfile::Counter* preagg_probe_cost_ratio_ = nullptr;
+
   /// The estimated number of input rows from the planner.
   int64_t estimated_input_cardinality_;
 
@@ -415,6 +457,13 @@ class GroupingAggregator : public Aggregator {
   /// END: Members that must be Reset()
   /////////////////////////////////////////
 
+  /// How a partition of a streaming preaggregation handles its input rows. AGGREGATE
+  /// probes the hash table and inserts new groups while there is capacity. PASS_THROUGH
+  /// passes all rows through without probing. SAMPLE probes the hash table without
+  /// inserting new groups, to measure whether the partition should aggregate again.
+  /// Partitions only leave AGGREGATE if 'adaptive_preagg_' is true.
+  enum class PreaggMode : uint8_t { AGGREGATE, PASS_THROUGH, SAMPLE };
+
   /// The hash table and streams (aggregated and unaggregated) for an individual
   /// partition. The streams of each partition always (i.e. regardless of level)
   /// initially use small buffers. Streaming pre-aggregations do not spill and do not
@@ -497,6 +546,14 @@ class GroupingAggregator : public Aggregator {
     /// Always unpinned. Has a write buffer allocated when the partition is spilled and
     /// unaggregated rows are being processed.
     std::unique_ptr<BufferedTupleStream> unaggregated_row_stream;
+
+    /// Streaming preaggregations only. The current mode of this partition, and the
+    /// number of rows probed against 'hash_tbl', matched an existing group and passed
+    /// through since the mode was last decided in AdaptPreaggPartitions().
+    PreaggMode preagg_mode = PreaggMode::AGGREGATE;
+    int64_t preagg_probed_rows = 0;
+    int64_t preagg_matched_rows = 0;
+    int64_t preagg_passed_through_rows = 0;
   };
 
   /// Stream used to store serialized spilled rows. Only used if needs_serialize_
@@ -581,6 +638,12 @@ class GroupingAggregator : public Aggregator {
       uint32_t hash, HashTable::Iterator insert_it, bool has_more_rows)
       WARN_UNUSED_RESULT;
 
+  /// Applies the updates deferred in 'pending_tuples_' with AddRowsToGroups(). Must be
+  /// called before anything that may spill a partition, since spilling invalidates the
+  /// pending intermediate tuples. Must be inlined into AddBatchImpl for codegen to
+  /// substitute function calls with codegen'd versions.
+  void IR_ALWAYS_INLINE FlushPendingAggUpdates();
+
   /// Append a row to a spilled partition. The row may be aggregated or unaggregated
   /// according to AGGREGATED_ROWS. May spill partitions if needed to append the row
   /// buffers.
@@ -602,6 +665,15 @@ class GroupingAggregator : public Aggregator {
   /// the preagg should pass through any rows it can't fit in its tables.
   bool ShouldExpandPreaggHashTables() const;
 
+  /// Called after each batch of a streaming preaggregation with 'adaptive_preagg_' set.
+  /// 'ticks' is the number of cpu ticks it took to process the batch and
+  /// 'num_probed_rows' the number of its rows that were probed against the hash tables,
+  /// or 0 if the batch should not be used to sample the probe cost. Switches partitions
+  /// that do not reduce their input enough to justify the current per-row probe cost to
+  /// PASS_THROUGH, periodically samples the partitions that pass through and switches
+  /// them back to AGGREGATE if their reduction recovers.
+  void AdaptPreaggPartitions(uint64_t ticks, int64_t num_probed_rows);
+
   /// Streaming processing of in_batch from child. Rows from child are either aggregated
   /// into the hash table or added to 'out_batch' in the intermediate tuple format.
   /// 'in_batch' is processed entirely, and 'out_batch' must have enough capacity to
@@ -71,6 +71,9 @@ class HashTableTest : public testing::Test {
   vector<ScalarExprEvaluator*> probe_expr_evals_;
   int next_query_id_ = 0;
 
+  /// If true, CreateHashTable() creates hash tables with the tagged layout.
+  bool tagged_ = false;
+
   virtual void SetUp() {
     test_env_.reset(new TestEnv());
     ASSERT_OK(test_env_->Init());
@@ -257,8 +260,8 @@ class HashTableTest : public testing::Test {
     // Initial_num_buckets must be a power of two.
     EXPECT_EQ(initial_num_buckets, BitUtil::RoundUpToPowerOfTwo(initial_num_buckets));
     int64_t max_num_buckets = 1L << 31;
-    *table = pool_.Add(new HashTable(
-        quadratic, allocator, true, 1, nullptr, max_num_buckets, initial_num_buckets));
+    *table = pool_.Add(new HashTable(quadratic, tagged_, allocator, true, 1, nullptr,
+        max_num_buckets, initial_num_buckets));
     hash_tables_.push_back(*table);
     bool success;
     Status status = (*table)->Init(&success);
@@ -715,6 +718,41 @@ TEST_F(HashTableTest, QuadraticInsertFullTest) {
   InsertFullTest(true, 65536);
 }
 
+// The tagged layout rounds small tables up to a full group of buckets.
+TEST_F(HashTableTest, TaggedSetupTest) {
+  tagged_ = true;
+  HashTable* hash_table;
+  ASSERT_TRUE(CreateHashTable(true, 1, &hash_table));
+  EXPECT_EQ(hash_table->num_buckets(), HashTable::TAG_GROUP_SIZE);
+  EXPECT_EQ(hash_table->EmptyBuckets(), HashTable::TAG_GROUP_SIZE);
+  SetupTest(true, 1024, false);
+  SetupTest(false, 65536, false);
+  SetupTest(true, 4294967296, true); // 2^32
+}
+
+TEST_F(HashTableTest, TaggedScanTest) {
+  tagged_ = true;
+  ScanTest(false, 1, 10, 5);
+  ScanTest(false, 1024, 1000, 500);
+  ScanTest(true, 1, 10, 5);
+  ScanTest(true, 1024, 1000, 5);
+  ScanTest(true, 1024, 1000, 500);
+}
+
+TEST_F(HashTableTest, TaggedGrowTableTest) {
+  tagged_ = true;
+  GrowTableTest(true);
+}
+
+TEST_F(HashTableTest, TaggedInsertFullTest) {
+  tagged_ = true;
+  InsertFullTest(false, 16);
+  InsertFullTest(false, 1024);
+  InsertFullTest(true, 16);
+  InsertFullTest(true, 64);
+  InsertFullTest(true, 65536);
+}
+
 // Test that hashing empty string updates hash value.
 TEST_F(HashTableTest, HashEmpty) {
   scoped_ptr<HashTableCtx> ht_ctx;
@@ -86,14 +86,15 @@ static_assert(sizeof(NULL_VALUE) >= ColumnType::MAX_CHAR_LENGTH,
 
 HashTableConfig::HashTableConfig(const std::vector<ScalarExpr*>& build_exprs,
     const std::vector<ScalarExpr*>& probe_exprs, const bool stores_nulls,
-    const std::vector<bool>& finds_nulls)
+    const std::vector<bool>& finds_nulls, const bool tagged_probing)
   : build_exprs(build_exprs),
     probe_exprs(probe_exprs),
     stores_nulls(stores_nulls),
     finds_nulls(finds_nulls),
     finds_some_nulls(std::accumulate(
         finds_nulls.begin(), finds_nulls.end(), false, std::logical_or<bool>())),
-    build_exprs_results_row_layout(build_exprs) {
+    build_exprs_results_row_layout(build_exprs),
+    tagged_probing(tagged_probing) {
   DCHECK_EQ(build_exprs.size(), finds_nulls.size());
   DCHECK_EQ(build_exprs.size(), probe_exprs.size());
 }
@@ -454,24 +455,30 @@ void HashTableCtx::ExprValuesCache::ResetForRead() {
 
 constexpr double HashTable::MAX_FILL_FACTOR;
 constexpr int64_t HashTable::DATA_PAGE_SIZE;
-
-HashTable* HashTable::Create(Suballocator* allocator, bool stores_duplicates,
-    int num_build_tuples, BufferedTupleStream* tuple_stream, int64_t max_num_buckets,
-    int64_t initial_num_buckets) {
-  return new HashTable(FLAGS_enable_quadratic_probing, allocator, stores_duplicates,
-      num_build_tuples, tuple_stream, max_num_buckets, initial_num_buckets);
+constexpr int64_t HashTable::TAG_GROUP_SIZE;
+constexpr int HashTable::PREFETCH_ROW_MAX_STEPS;
+constexpr uint8_t HashTable::TAG_FILLED_BIT;
+
+HashTable* HashTable::Create(bool tagged_probing, Suballocator* allocator,
+    bool stores_duplicates, int num_build_tuples, BufferedTupleStream* tuple_stream,
+    int64_t max_num_buckets, int64_t initial_num_buckets) {
+  return new HashTable(FLAGS_enable_quadratic_probing, tagged_probing, allocator,
+      stores_duplicates, num_build_tuples, tuple_stream, max_num_buckets,
+      initial_num_buckets);
 }
 
-HashTable::HashTable(bool quadratic_probing, Suballocator* allocator,
-    bool stores_duplicates, int num_build_tuples, BufferedTupleStream* stream,
-    int64_t max_num_buckets, int64_t num_buckets)
+HashTable::HashTable(bool quadratic_probing, bool tagged_probing,
+    Suballocator* allocator, bool stores_duplicates, int num_build_tuples,
+    BufferedTupleStream* stream, int64_t max_num_buckets, int64_t num_buckets)
   : allocator_(allocator),
     tuple_stream_(stream),
     stores_tuples_(num_build_tuples == 1),
     stores_duplicates_(stores_duplicates),
     quadratic_probing_(quadratic_probing),
-    max_num_buckets_(max_num_buckets),
-    num_buckets_(num_buckets),
+    tagged_probing_(tagged_probing),
+    max_num_buckets_(tagged_probing && max_num_buckets != -1 ?
+            max(max_num_buckets, TAG_GROUP_SIZE) : max_num_buckets),
+    num_buckets_(tagged_probing ? max(num_buckets, TAG_GROUP_SIZE) : num_buckets),
     num_build_tuples_(num_build_tuples) {
   DCHECK_EQ((num_buckets & (num_buckets - 1)), 0) << "num_buckets must be a power of 2";
   DCHECK_GT(num_buckets, 0) << "num_buckets must be larger than 0";
@@ -483,17 +490,26 @@ Status HashTable::Init(bool* got_memory) {
   int64_t hash_byte_size = num_buckets_ * sizeof(uint32_t);
   RETURN_IF_ERROR(allocator_->Allocate(buckets_byte_size, &bucket_allocation_));
   RETURN_IF_ERROR(allocator_->Allocate(hash_byte_size, &hash_allocation_));
-  if (bucket_allocation_ == nullptr || hash_allocation_ == nullptr) {
+  if (tagged_probing_) {
+    RETURN_IF_ERROR(allocator_->Allocate(num_buckets_, &tag_allocation_));
+  }
+  if (bucket_allocation_ == nullptr || hash_allocation_ == nullptr
+      || (tagged_probing_ && tag_allocation_ == nullptr)) {
     num_buckets_ = 0;
     *got_memory = false;
     if (bucket_allocation_ != nullptr) allocator_->Free(move(bucket_allocation_));
     if (hash_allocation_ != nullptr) allocator_->Free(move(hash_allocation_));
+    if (tag_allocation_ != nullptr) allocator_->Free(move(tag_allocation_));
     return Status::OK();
   }
   buckets_ = reinterpret_cast<Bucket*>(bucket_allocation_->data());
   memset(buckets_, 0, buckets_byte_size);
   hash_array_ = reinterpret_cast<uint32_t*>(hash_allocation_->data());
   memset(hash_array_, 0, hash_byte_size);
+  if (tagged_probing_) {
+    tags_ = tag_allocation_->data();
+    memset(tags_, 0, num_buckets_);
+  }
   *got_memory = true;
   return Status::OK();
 }
@@ -525,6 +541,8 @@ void HashTable::Close() {
   data_pages_.clear();
   if (bucket_allocation_ != nullptr) allocator_->Free(move(bucket_allocation_));
   if (hash_allocation_ != nullptr) allocator_->Free(move(hash_allocation_));
+  if (tag_allocation_ != nullptr) allocator_->Free(move(tag_allocation_));
+  tags_ = nullptr;
   ResetState();
 }
 
@@ -557,6 +575,8 @@ Status HashTable::CheckAndResize(
 
 Status HashTable::ResizeBuckets(
     int64_t num_buckets, HashTableCtx* __restrict__ ht_ctx, bool* got_memory) {
+  // Tagged hash tables consist of at least one full group.
+  if (tagged_probing_) num_buckets = max(num_buckets, TAG_GROUP_SIZE);
   DCHECK_EQ((num_buckets & (num_buckets - 1)), 0)
       << "num_buckets=" << num_buckets << " must be a power of 2";
   DCHECK_GT(num_buckets, num_filled_buckets_)
@@ -580,16 +600,23 @@ Status HashTable::ResizeBuckets(
   int64_t new_hash_size = num_buckets * sizeof(uint32_t);
   unique_ptr<Suballocation> new_allocation;
   unique_ptr<Suballocation> new_hash_allocation;
+  unique_ptr<Suballocation> new_tag_allocation;
   RETURN_IF_ERROR(allocator_->Allocate(new_size, &new_allocation));
   Status hash_allocation_status =
       allocator_->Allocate(new_hash_size, &new_hash_allocation);
+  if (hash_allocation_status.ok() && tagged_probing_) {
+    hash_allocation_status = allocator_->Allocate(num_buckets, &new_tag_allocation);
+  }
   if (!hash_allocation_status.ok()) {
     if (new_allocation != NULL) allocator_->Free(move(new_allocation));
+    if (new_hash_allocation != NULL) allocator_->Free(move(new_hash_allocation));
     return hash_allocation_status;
   }
-  if (new_allocation == NULL || new_hash_allocation == NULL) {
+  if (new_allocation == NULL || new_hash_allocation == NULL
+      || (tagged_probing_ && new_tag_allocation == NULL)) {
     if (new_allocation != NULL) allocator_->Free(move(new_allocation));
     if (new_hash_allocation != NULL) allocator_->Free(move(new_hash_allocation));
+    if (new_tag_allocation != NULL) allocator_->Free(move(new_tag_allocation));
     *got_memory = false;
     return Status::OK();
   }
@@ -597,6 +624,11 @@ Status HashTable::ResizeBuckets(
   memset(new_buckets, 0, new_size);
   uint32_t* new_hash_array = reinterpret_cast<uint32_t*>(new_hash_allocation->data());
   memset(new_hash_array, 0, new_hash_size);
+  uint8_t* new_tags = nullptr;
+  if (tagged_probing_) {
+    new_tags = new_tag_allocation->data();
+    memset(new_tags, 0, num_buckets);
+  }
 
   // Walk the old table and copy all the filled buckets to the new (resized) table.
   // We do not have to do anything with the duplicate nodes. This operation is expected
@@ -608,22 +640,26 @@ Status HashTable::ResizeBuckets(
     bool found = false;
     BucketData bd;
     int64_t bucket_idx = Probe<true, false, HashTable::BucketType::MATCH_UNSET>(
-        new_buckets, new_hash_array, num_buckets, ht_ctx, hash, &found, &bd);
+        new_buckets, new_hash_array, new_tags, num_buckets, ht_ctx, hash, &found, &bd);
     DCHECK(!found);
     DCHECK_NE(bucket_idx, Iterator::BUCKET_NOT_FOUND) << " Probe failed even though "
         " there are free buckets. " << num_buckets << " " << num_filled_buckets_;
     Bucket* dst_bucket = &new_buckets[bucket_idx];
     new_hash_array[bucket_idx] = hash;
+    if (tagged_probing_) new_tags[bucket_idx] = HashTag(hash);
     *dst_bucket = *bucket_to_copy;
   }
 
   num_buckets_ = num_buckets;
   allocator_->Free(move(bucket_allocation_));
   allocator_->Free(move(hash_allocation_));
+  if (tagged_probing_) allocator_->Free(move(tag_allocation_));
   bucket_allocation_ = move(new_allocation);
   hash_allocation_ = move(new_hash_allocation);
+  tag_allocation_ = move(new_tag_allocation);
   buckets_ = new_buckets;
   hash_array_ = new_hash_array;
+  tags_ = new_tags;
   *got_memory = true;
   return Status::OK();
 }
@@ -1339,5 +1375,7 @@ Status HashTableCtx::ReplaceHashTableConstants(LlvmCodeGen* codegen,
       fn, stores_duplicates, "stores_duplicates");
   replacement_counts->quadratic_probing = codegen->ReplaceCallSitesWithBoolConst(
       fn, FLAGS_enable_quadratic_probing, "quadratic_probing");
+  replacement_counts->tagged_probing = codegen->ReplaceCallSitesWithBoolConst(
+      fn, config.tagged_probing, "tagged_probing");
   return Status::OK();
 }
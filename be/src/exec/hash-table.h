@@ -121,7 +121,7 @@ struct HashTableConfig {
   HashTableConfig() = delete;
   HashTableConfig(const std::vector<ScalarExpr*>& build_exprs,
       const std::vector<ScalarExpr*>& probe_exprs, const bool stores_nulls,
-      const std::vector<bool>& finds_nulls);
+      const std::vector<bool>& finds_nulls, const bool tagged_probing);
 
   /// The exprs used to evaluate rows for inserting rows into hash table.
   /// Also used when matching hash table entries against probe rows. Not Owned.
@@ -142,6 +142,10 @@ struct HashTableConfig {
 
   /// The memory efficient layout for storing the results of evaluating build expressions.
   const ScalarExprsResultsRowLayout build_exprs_results_row_layout;
+
+  /// If true, the hash tables of the node are created with the tagged layout, see
+  /// HashTable::Create().
+  const bool tagged_probing;
 };
 
 /// Control block for a hash table. This class contains the logic as well as the variables
@@ -239,6 +243,7 @@ class HashTableCtx {
     int stores_tuples;
     int stores_duplicates;
     int quadratic_probing;
+    int tagged_probing;
   };
 
   /// Replace hash table parameters with constants in 'fn'. Updates 'replacement_counts'
@@ -636,6 +641,18 @@ struct HashTableStatsProfile {
 /// value, the one in the bucket. The data is either a tuple stream index or a Tuple*.
 /// This array of buckets is sparse, we are shooting for up to 3/4 fill factor (75%). The
 /// data allocated by the hash table comes from the BufferPool.
+///
+/// Tagged layout: optionally, the buckets are organized in groups of TAG_GROUP_SIZE (16)
+/// consecutive buckets and a one byte tag per bucket is kept in a separate 'tags_' array.
+/// The tag of an empty bucket is 0, the tag of a filled bucket is TAG_FILLED_BIT plus 7
+/// bits of its hash. Probing loads the 16 tags of a group into a SSE register and
+/// compares them with the tag of the probe hash and with the empty tag at once, so only
+/// the buckets whose tags match are ever touched. Since buckets are never removed, the
+/// buckets of a group are filled in order, so a group with an empty bucket ends the
+/// probe. The probing algorithm (linear or quadratic) is applied to groups instead of
+/// buckets. Compared to the default layout this costs an extra byte per bucket, but a
+/// probe for an absent key reads one cache line of tags per group instead of a bucket
+/// and a hash value per visited bucket.
 class HashTable {
  private:
   /// Rows are represented as pointers into the BufferedTupleStream data with one
@@ -795,6 +812,8 @@ class HashTable {
 
   /// Returns a newly allocated HashTable. The probing algorithm is set by the
   /// FLAG_enable_quadratic_probing.
+  ///  - tagged_probing: true if the hash table should use the tagged layout described
+  ///    in the class comment.
   ///  - allocator: allocator to allocate bucket directory and data pages from.
   ///  - stores_duplicates: true if rows with duplicate keys may be inserted into the
   ///    hash table.
@@ -806,10 +825,11 @@ class HashTable {
   ///    try to grow the number of buckets to a larger number, the inserts will fail.
   ///    -1, if it unlimited.
   ///  - initial_num_buckets: number of buckets that the hash table should be initialized
-  ///    with.
-  static HashTable* Create(Suballocator* allocator, bool stores_duplicates,
-      int num_build_tuples, BufferedTupleStream* tuple_stream, int64_t max_num_buckets,
-      int64_t initial_num_buckets);
+  ///    with. Tagged hash tables have at least TAG_GROUP_SIZE buckets, so a smaller
+  ///    value is rounded up.
+  static HashTable* Create(bool tagged_probing, Suballocator* allocator,
+      bool stores_duplicates, int num_build_tuples, BufferedTupleStream* tuple_stream,
+      int64_t max_num_buckets, int64_t initial_num_buckets);
 
   /// Allocates the initial bucket structure. Returns a non-OK status if an error is
   /// encountered. If an OK status is returned , 'got_memory' is set to indicate whether
@@ -851,6 +871,16 @@ class HashTable {
   template <const bool READ>
   void IR_ALWAYS_INLINE PrefetchBucket(uint32_t hash);
 
+  /// Second stage of prefetching for probes: prefetch the build row that a probe with
+  /// hash value 'hash' will most likely compare against. Should be called once the
+  /// bucket prefetched by PrefetchBucket() for the same hash is expected to be in the
+  /// cache. Only the first PREFETCH_ROW_MAX_STEPS buckets of the probe sequence are
+  /// looked at, to avoid stalling on buckets that were not prefetched. With the tagged
+  /// layout, where PrefetchBucket() only prefetches the tags, this prefetches the bucket
+  /// and the hash value of the first bucket with a matching tag instead.
+  /// Thread-safe for read-only hash tables.
+  void IR_ALWAYS_INLINE PrefetchBuildRow(uint32_t hash);
+
   /// Returns an iterator to the bucket that matches the probe expression results that
   /// are cached at the current position of the ExprValuesCache in 'ht_ctx'. Assumes that
   /// the ExprValuesCache was filled using EvalAndHashProbe(). Returns HashTable::End()
@@ -916,6 +946,10 @@ class HashTable {
   /// Return the size of a hash table bucket in bytes.
   static const int64_t BUCKET_SIZE = sizeof(Bucket);
 
+  /// Number of buckets in a group of the tagged layout, i.e. the number of tags that
+  /// are compared at once.
+  static constexpr int64_t TAG_GROUP_SIZE = 16;
+
   /// Returns the memory occupied by the hash table, takes into account the number of
   /// duplicates.
   /// Thread-safe for read-only hash tables.
@@ -936,7 +970,8 @@ class HashTable {
 
   /// Returns the number of bytes allocated to the hash table from the block manager.
   int64_t ByteSize() const {
-    return num_buckets_ * sizeof(Bucket) + total_data_page_size_;
+    return num_buckets_ * (sizeof(Bucket) + (tagged_probing_ ? sizeof(uint8_t) : 0))
+        + total_data_page_size_;
   }
 
   /// Returns an iterator at the beginning of the hash table.  Advancing this iterator
@@ -1073,9 +1108,9 @@ class HashTable {
   /// of calling this constructor directly.
   ///  - quadratic_probing: set to true when the probing algorithm is quadratic, as
   ///    opposed to linear.
-  HashTable(bool quadratic_probing, Suballocator* allocator, bool stores_duplicates,
-      int num_build_tuples, BufferedTupleStream* tuple_stream, int64_t max_num_buckets,
-      int64_t initial_num_buckets);
+  HashTable(bool quadratic_probing, bool tagged_probing, Suballocator* allocator,
+      bool stores_duplicates, int num_build_tuples, BufferedTupleStream* tuple_stream,
+      int64_t max_num_buckets, int64_t initial_num_buckets);
 
   /// Performs the probing operation according to the probing algorithm (linear or
   /// quadratic. Returns one of the following:
@@ -1104,11 +1139,27 @@ class HashTable {
   /// 'found' indicates that a bucket that contains an equal row is found.
   ///
   /// There are wrappers of this function that perform the Find and Insert logic.
+  ///
+  /// 'tags' is the tag array of the tagged layout, only used if tagged_probing() is
+  /// true.
   template <bool INCLUSIVE_EQUALITY, bool COMPARE_ROW, BucketType TYPE = MATCH_SET>
-  int64_t IR_ALWAYS_INLINE Probe(Bucket* buckets, uint32_t* hash_array,
+  int64_t IR_ALWAYS_INLINE Probe(Bucket* buckets, uint32_t* hash_array, uint8_t* tags,
       int64_t num_buckets, HashTableCtx* __restrict__ ht_ctx, uint32_t hash, bool* found,
       BucketData* bd);
 
+  /// Implementation of Probe() for the tagged layout.
+  template <bool INCLUSIVE_EQUALITY, bool COMPARE_ROW, BucketType TYPE>
+  int64_t IR_ALWAYS_INLINE ProbeTagged(Bucket* buckets, uint32_t* hash_array,
+      uint8_t* tags, int64_t num_buckets, HashTableCtx* __restrict__ ht_ctx,
+      uint32_t hash, bool* found, BucketData* bd);
+
+  /// Returns the tag of a bucket filled with a row with hash value 'hash'. The bits
+  /// used by the tag are above the bits used to pick the bucket of all but the largest
+  /// hash tables and below the bits used by the exec nodes to pick a partition.
+  static uint8_t ALWAYS_INLINE HashTag(uint32_t hash) {
+    return TAG_FILLED_BIT | ((hash >> 21) & 0x7f);
+  }
+
   /// Performs the insert logic. Returns the Bucket* of the bucket where the data
   /// should be inserted either in the bucket itself or in it's DuplicateNode.
   /// Returns NULL if the insert was not successful and either sets 'status' to OK
@@ -1172,6 +1223,13 @@ class HashTable {
   bool IR_NO_INLINE stores_tuples() const { return stores_tuples_; }
   bool IR_NO_INLINE stores_duplicates() const { return stores_duplicates_; }
   bool IR_NO_INLINE quadratic_probing() const { return quadratic_probing_; }
+  bool IR_NO_INLINE tagged_probing() const { return tagged_probing_; }
+
+  /// Set in the tag of every filled bucket. The tag of an empty bucket is 0.
+  static constexpr uint8_t TAG_FILLED_BIT = 0x80;
+
+  /// Maximum number of buckets of the probe sequence examined by PrefetchBuildRow().
+  static constexpr int PREFETCH_ROW_MAX_STEPS = 4;
 
   /// Load factor that will trigger growing the hash table on insert.  This is
   /// defined as the number of non-empty buckets / total_buckets
@@ -1203,6 +1261,9 @@ class HashTable {
   /// Quadratic probing enabled (as opposed to linear).
   const bool quadratic_probing_;
 
+  /// True if the hash table uses the tagged layout.
+  const bool tagged_probing_;
+
   /// Data pages for all nodes. Allocated from suballocator to reduce memory
   /// consumption of small tables.
   std::vector<std::unique_ptr<Suballocation>> data_pages_;
@@ -1235,6 +1296,13 @@ class HashTable {
   /// This is not part of struct 'Bucket' to make sure 'sizeof(Bucket)' is power of 2.
   uint32_t* hash_array_;
 
+  /// Allocation containing the tag of every bucket. Only allocated if 'tagged_probing_'.
+  std::unique_ptr<Suballocation> tag_allocation_;
+
+  /// Pointer to the tag array in 'tag_allocation_'. The ith tag corresponds to the ith
+  /// bucket in 'buckets_'. See the class comment for the tagged layout.
+  uint8_t* tags_ = nullptr;
+
   /// Total number of buckets (filled and empty).
   int64_t num_buckets_;
 
@@ -19,6 +19,7 @@
 #define IMPALA_EXEC_HASH_TABLE_INLINE_H
 
 #include "exec/hash-table.h"
+#include "util/sse-util.h"
 
 namespace impala {
 
@@ -48,12 +49,16 @@ inline void HashTableCtx::ExprValuesCache::NextRow() {
 }
 
 template <bool INCLUSIVE_EQUALITY, bool COMPARE_ROW, HashTable::BucketType TYPE>
-inline int64_t HashTable::Probe(Bucket* buckets, uint32_t* hash_array,
+inline int64_t HashTable::Probe(Bucket* buckets, uint32_t* hash_array, uint8_t* tags,
     int64_t num_buckets, HashTableCtx* __restrict__ ht_ctx, uint32_t hash, bool* found,
     BucketData* bd) {
   DCHECK(ht_ctx != nullptr);
   DCHECK(buckets != nullptr);
   DCHECK_GT(num_buckets, 0);
+  if (tagged_probing()) {
+    return ProbeTagged<INCLUSIVE_EQUALITY, COMPARE_ROW, TYPE>(
+        buckets, hash_array, tags, num_buckets, ht_ctx, hash, found, bd);
+  }
   *found = false;
   ++ht_ctx->num_probes_;
   int64_t bucket_idx = hash & (num_buckets - 1);
@@ -97,13 +102,69 @@ inline int64_t HashTable::Probe(Bucket* buckets, uint32_t* hash_array,
   return Iterator::BUCKET_NOT_FOUND;
 }
 
+template <bool INCLUSIVE_EQUALITY, bool COMPARE_ROW, HashTable::BucketType TYPE>
+inline int64_t HashTable::ProbeTagged(Bucket* buckets, uint32_t* hash_array,
+    uint8_t* tags, int64_t num_buckets, HashTableCtx* __restrict__ ht_ctx, uint32_t hash,
+    bool* found, BucketData* bd) {
+  DCHECK(tags != nullptr);
+  DCHECK_GE(num_buckets, TAG_GROUP_SIZE);
+  *found = false;
+  ++ht_ctx->num_probes_;
+  const int64_t num_groups = num_buckets / TAG_GROUP_SIZE;
+  int64_t group_idx = (hash & (num_buckets - 1)) / TAG_GROUP_SIZE;
+  const __m128i tag = _mm_set1_epi8(static_cast<char>(HashTag(hash)));
+  const __m128i empty_tag = _mm_setzero_si128();
+
+  // Counts the number of groups visited, see Probe().
+  int64_t step = 0;
+  do {
+    const int64_t group_start = group_idx * TAG_GROUP_SIZE;
+    const __m128i group_tags =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(tags + group_start));
+    uint32_t matches = _mm_movemask_epi8(_mm_cmpeq_epi8(group_tags, tag));
+    const uint32_t empty = _mm_movemask_epi8(_mm_cmpeq_epi8(group_tags, empty_tag));
+    while (matches != 0) {
+      int64_t bucket_idx = group_start + BitUtil::CountTrailingZeros(matches);
+      matches &= matches - 1;
+      if (hash == hash_array[bucket_idx]) {
+        if (COMPARE_ROW
+            && ht_ctx->Equals<INCLUSIVE_EQUALITY>(
+                   GetRow<TYPE>(&buckets[bucket_idx], ht_ctx->scratch_row_, bd))) {
+          *found = true;
+          return bucket_idx;
+        }
+        // Row equality failed, or not performed. This is a hash collision. Continue
+        // searching.
+        ++ht_ctx->num_hash_collisions_;
+      }
+    }
+    // The buckets of a group are filled in order, so the first empty bucket is where
+    // the row would have been inserted.
+    if (LIKELY(empty != 0)) return group_start + BitUtil::CountTrailingZeros(empty);
+    // Move to the next group.
+    ++step;
+    if (quadratic_probing()) {
+      group_idx = (group_idx + step) & (num_groups - 1);
+    } else {
+      group_idx = (group_idx + 1) & (num_groups - 1);
+    }
+  } while (LIKELY(step < num_groups));
+
+  ht_ctx->travel_length_ += step * TAG_GROUP_SIZE;
+
+  DCHECK_EQ(num_filled_buckets_, num_buckets)
+      << "Probing of a non-full table "
+      << "failed: " << quadratic_probing() << " " << hash;
+  return Iterator::BUCKET_NOT_FOUND;
+}
+
 inline HashTable::Bucket* HashTable::InsertInternal(
     HashTableCtx* __restrict__ ht_ctx, Status* status) {
   bool found = false;
   uint32_t hash = ht_ctx->expr_values_cache()->CurExprValuesHash();
   BucketData bd;
-  int64_t bucket_idx =
-      Probe<true, true>(buckets_, hash_array_, num_buckets_, ht_ctx, hash, &found, &bd);
+  int64_t bucket_idx = Probe<true, true>(
+      buckets_, hash_array_, tags_, num_buckets_, ht_ctx, hash, &found, &bd);
   DCHECK_NE(bucket_idx, Iterator::BUCKET_NOT_FOUND);
   if (found) {
     // We need to insert a duplicate node, note that this may fail to allocate memory.
@@ -147,16 +208,56 @@ inline void HashTable::PrefetchBucket(uint32_t hash) {
   // 'locality': 0-3. 0 means no temporal locality. 3 means high temporal locality.
   // On x86, they map to instructions prefetchnta and prefetch{2-0} respectively.
   // TODO: Reconsider the locality level with smaller prefetch batch size.
+  if (tagged_probing()) {
+    // The probe only touches the buckets whose tags match, so only prefetch the tags.
+    __builtin_prefetch(&tags_[bucket_idx & ~(TAG_GROUP_SIZE - 1)], READ ? 0 : 1, 1);
+    return;
+  }
   __builtin_prefetch(&buckets_[bucket_idx], READ ? 0 : 1, 1);
   __builtin_prefetch(&hash_array_[bucket_idx], READ ? 0 : 1, 1);
 }
 
+inline void HashTable::PrefetchBuildRow(uint32_t hash) {
+  int64_t bucket_idx = hash & (num_buckets_ - 1);
+  if (tagged_probing()) {
+    int64_t group_start = bucket_idx & ~(TAG_GROUP_SIZE - 1);
+    const __m128i group_tags =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(tags_ + group_start));
+    uint32_t matches = _mm_movemask_epi8(
+        _mm_cmpeq_epi8(group_tags, _mm_set1_epi8(static_cast<char>(HashTag(hash)))));
+    if (matches == 0) return;
+    bucket_idx = group_start + BitUtil::CountTrailingZeros(matches);
+    __builtin_prefetch(&buckets_[bucket_idx], 0, 1);
+    __builtin_prefetch(&hash_array_[bucket_idx], 0, 1);
+    return;
+  }
+  for (int step = 1; step <= PREFETCH_ROW_MAX_STEPS; ++step) {
+    Bucket* bucket = &buckets_[bucket_idx];
+    if (!bucket->IsFilled()) return;
+    if (hash == hash_array_[bucket_idx]) {
+      // Prefetch what GetRow() dereferences: the head of the duplicate list, the tuple or
+      // the flattened row in the stream.
+      if (stores_duplicates() && bucket->HasDuplicates()) {
+        __builtin_prefetch(bucket->GetDuplicate(), 0, 1);
+      } else {
+        __builtin_prefetch(bucket->GetBucketData().htdata.flat_row, 0, 1);
+      }
+      return;
+    }
+    if (quadratic_probing()) {
+      bucket_idx = (bucket_idx + step) & (num_buckets_ - 1);
+    } else {
+      bucket_idx = (bucket_idx + 1) & (num_buckets_ - 1);
+    }
+  }
+}
+
 inline HashTable::Iterator HashTable::FindProbeRow(HashTableCtx* __restrict__ ht_ctx) {
   bool found = false;
   uint32_t hash = ht_ctx->expr_values_cache()->CurExprValuesHash();
   BucketData bd;
-  int64_t bucket_idx =
-      Probe<false, true>(buckets_, hash_array_, num_buckets_, ht_ctx, hash, &found, &bd);
+  int64_t bucket_idx = Probe<false, true>(
+      buckets_, hash_array_, tags_, num_buckets_, ht_ctx, hash, &found, &bd);
   if (found) {
     return Iterator(this, ht_ctx->scratch_row(), bucket_idx,
         stores_duplicates() ? bd.duplicates : NULL);
@@ -171,7 +272,7 @@ inline HashTable::Iterator HashTable::FindBuildRowBucket(
   uint32_t hash = ht_ctx->expr_values_cache()->CurExprValuesHash();
   BucketData bd;
   int64_t bucket_idx = Probe<true, true, TYPE>(
-      buckets_, hash_array_, num_buckets_, ht_ctx, hash, found, &bd);
+      buckets_, hash_array_, tags_, num_buckets_, ht_ctx, hash, found, &bd);
   DuplicateNode* duplicates = NULL;
   if (stores_duplicates() && LIKELY(bucket_idx != Iterator::BUCKET_NOT_FOUND)) {
     duplicates = bd.duplicates;
@@ -222,6 +323,7 @@ inline void HashTable::PrepareBucketForInsert(int64_t bucket_idx, uint32_t hash)
   ++num_filled_buckets_;
   bucket->PrepareBucketForInsert();
   hash_array_[bucket_idx] = hash;
+  if (tagged_probing()) tags_[bucket_idx] = HashTag(hash);
 }
 
 inline HashTable::DuplicateNode* HashTable::AppendNextNode(Bucket* bucket) {
@@ -418,7 +520,8 @@ inline void HashTableCtx::set_level(int level) {
 }
 
 inline int64_t HashTable::CurrentMemSize() const {
-  return num_buckets_ * (sizeof(Bucket) + sizeof(uint32_t))
+  return num_buckets_
+      * (sizeof(Bucket) + sizeof(uint32_t) + (tagged_probing_ ? sizeof(uint8_t) : 0))
       + num_duplicate_nodes_ * sizeof(DuplicateNode);
 }
 
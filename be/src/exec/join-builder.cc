@@ -17,10 +17,14 @@
 
 #include "exec/join-builder.h"
 
+#include "common/atomic.h"
+#include "runtime/fragment-instance-state.h"
+#include "runtime/thread-resource-mgr.h"
 #include "service/hs2-util.h"
 #include "util/debug-util.h"
 #include "util/min-max-filter.h"
 #include "util/runtime-profile-counters.h"
+#include "util/thread.h"
 
 #include "common/names.h"
 
@@ -127,6 +131,53 @@ void JoinBuilder::HandoffToProbesAndWait(RuntimeState* build_side_state) {
   }
 }
 
+Status JoinBuilder::RunBuildTasks(RuntimeState* state, int num_tasks, int max_workers,
+    const std::function<Status(int worker_idx, int task_idx)>& task) {
+  AtomicInt32 next_task(0);
+  mutex status_lock;
+  Status status;
+  auto run_worker = [&](int worker_idx) {
+    while (true) {
+      {
+        lock_guard<mutex> l(status_lock);
+        if (!status.ok()) return;
+      }
+      int task_idx = next_task.Add(1) - 1;
+      if (task_idx >= num_tasks) return;
+      Status task_status = task(worker_idx, task_idx);
+      if (!task_status.ok()) {
+        lock_guard<mutex> l(status_lock);
+        if (status.ok()) status = task_status;
+      }
+    }
+  };
+
+  vector<unique_ptr<Thread>> workers;
+  const int num_workers = min(max_workers, num_tasks);
+  for (int worker_idx = 1; worker_idx < num_workers; ++worker_idx) {
+    if (!state->resource_pool()->TryAcquireThreadToken()) break;
+    string thread_name = Substitute("join-build-worker (finst:$0, join-node-id:$1)",
+        PrintId(state->fragment_instance_id()), join_node_id_);
+    unique_ptr<Thread> worker;
+    Status thread_status = Thread::Create(FragmentInstanceState::FINST_THREAD_GROUP_NAME,
+        thread_name, [&run_worker, worker_idx]() { run_worker(worker_idx); }, &worker,
+        true);
+    if (!thread_status.ok()) {
+      // Not fatal: the remaining workers, at least the calling thread, run all tasks.
+      VLOG(2) << "Could not start join build worker: " << thread_status.GetDetail();
+      state->resource_pool()->ReleaseThreadToken(false);
+      break;
+    }
+    workers.push_back(move(worker));
+  }
+  run_worker(0);
+  for (unique_ptr<Thread>& worker : workers) {
+    worker->Join();
+    state->resource_pool()->ReleaseThreadToken(false);
+  }
+  return status;
+}
+
 void JoinBuilder::PublishRuntimeFilters(const std::vector<FilterContext>& filter_ctxs,
     RuntimeState* runtime_state, float minmax_filter_threshold, int64_t num_build_rows) {
   VLOG(3) << name() << " publishing "
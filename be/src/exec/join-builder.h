@@ -17,6 +17,7 @@
 
 #pragma once
 
+#include <functional>
 #include <mutex>
 
 #include "exec/data-sink.h"
@@ -212,6 +213,17 @@ class JoinBuilder : public DataSink {
   /// of being blocked indefinitely.
   void HandoffToProbesAndWait(RuntimeState* build_side_state);
 
+  /// Runs 'task'(worker_idx, task_idx) for each 'task_idx' in [0, 'num_tasks') on up to
+  /// 'max_workers' workers. The calling thread is worker 0. The other workers get their
+  /// own threads, but only if an optional thread token is available for them, so this
+  /// is meant for work that the probe-side threads of a separate build are idle during.
+  /// Each worker claims tasks until none are left. A worker runs one task at a time, so
+  /// tasks can use per-worker state indexed by 'worker_idx' without synchronization.
+  /// Returns once all workers are done, i.e. acts as a barrier. Returns the first error
+  /// returned by a task; tasks that were not started yet are skipped after an error.
+  Status RunBuildTasks(RuntimeState* state, int num_tasks, int max_workers,
+      const std::function<Status(int worker_idx, int task_idx)>& task);
+
   /// Publish the runtime filters as described in 'filter_ctxs' to the fragment-local
   /// RuntimeFilterBank in 'runtime_state'. 'minmax_filter_threshold' specifies the
   /// threshold to determine the usefulness of a min/max filter. 'num_build_rows' is used
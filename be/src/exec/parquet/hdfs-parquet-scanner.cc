@@ -30,6 +30,7 @@
 #include "exec/parquet/parquet-bloom-filter-util.h"
 #include "exec/parquet/parquet-collection-column-reader.h"
 #include "exec/parquet/parquet-column-readers.h"
+#include "exec/parquet/parquet-metadata-cache.h"
 #include "exec/parquet/parquet-struct-column-reader.h"
 #include "exec/scanner-context.inline.h"
 #include "exec/scratch-tuple-batch.h"
@@ -80,8 +81,31 @@ Status HdfsParquetScanner::IssueInitialRanges(HdfsScanNodeBase* scan_node,
           file->filename, file->file_length));
     }
   }
-  return IssueFooterRanges(
-      scan_node, THdfsFileFormat::PARQUET, files, PARQUET_FOOTER_SIZE);
+  ParquetMetadataCache* metadata_cache = ExecEnv::GetInstance()->parquet_metadata_cache();
+  if (metadata_cache == nullptr) {
+    return IssueFooterRanges(
+        scan_node, THdfsFileFormat::PARQUET, files, PARQUET_FOOTER_SIZE);
+  }
+  // Only the metadata size and the magic number at the end of the file are read for
+  // files whose metadata is cached.
+  vector<HdfsFileDesc*> cached_files;
+  vector<HdfsFileDesc*> uncached_files;
+  for (HdfsFileDesc* file : files) {
+    if (metadata_cache->ContainsFileMetadata(*file)) {
+      cached_files.push_back(file);
+    } else {
+      uncached_files.push_back(file);
+    }
+  }
+  if (!cached_files.empty()) {
+    RETURN_IF_ERROR(IssueFooterRanges(scan_node, THdfsFileFormat::PARQUET, cached_files,
+        sizeof(int32_t) + sizeof(PARQUET_VERSION_NUMBER)));
+  }
+  if (!uncached_files.empty()) {
+    RETURN_IF_ERROR(IssueFooterRanges(
+        scan_node, THdfsFileFormat::PARQUET, uncached_files, PARQUET_FOOTER_SIZE));
+  }
+  return Status::OK();
 }
 
 HdfsParquetScanner::HdfsParquetScanner(HdfsScanNodeBase* scan_node, RuntimeState* state)
@@ -212,7 +236,7 @@ Status HdfsParquetScanner::Open(ScannerContext* context) {
   schema_resolver_.reset(new ParquetSchemaResolver(*scan_node_->hdfs_table(),
       state_->query_options().parquet_fallback_schema_resolution,
       state_->query_options().parquet_array_resolution));
-  RETURN_IF_ERROR(schema_resolver_->Init(&file_metadata_, filename()));
+  RETURN_IF_ERROR(schema_resolver_->Init(file_metadata_.get(), filename()));
 
   // We've processed the metadata and there are columns that need to be materialized.
   RETURN_IF_ERROR(CreateColumnReaders(
@@ -459,8 +483,8 @@ Status HdfsParquetScanner::GetNextInternal(RowBatch* row_batch) {
       if (!status.ok()) RETURN_IF_ERROR(state_->LogOrReturnError(status.msg()));
     }
     RETURN_IF_ERROR(NextRowGroup());
-    DCHECK_LE(group_idx_, file_metadata_.row_groups.size());
-    if (group_idx_ == file_metadata_.row_groups.size()) {
+    DCHECK_LE(group_idx_, file_metadata_->row_groups.size());
+    if (group_idx_ == file_metadata_->row_groups.size()) {
       eos_ = true;
       DCHECK(parse_status_.ok());
       return Status::OK();
@@ -692,7 +716,16 @@ Status HdfsParquetScanner::EvaluateOverlapForRowGroup(
       continue;
     }
 
-    if (HdfsParquetScanner::FilterAlreadyDisabledOrOverlapWithColumnStats(
+    // Top-N filters start out loose and are tightened while the scan runs, so they are
+    // never disabled based on how much they overlap with the column stats. They are
+    // only ignored while they do not carry a bound.
+    bool is_topn_filter = filter->filter_desc().is_topn_filter;
+    if (is_topn_filter) {
+      if (minmax_filter->AlwaysTrue()) {
+        filter_ctxs_[idx]->stats->IncrCounters(FilterStats::ROW_GROUPS_KEY, 1, 1, 0);
+        continue;
+      }
+    } else if (HdfsParquetScanner::FilterAlreadyDisabledOrOverlapWithColumnStats(
             filter_id, minmax_filter, idx, threshold)) {
       // The filter is already disabled or too close to the column min/max stats, ignore
       // it.
@@ -746,7 +779,14 @@ Status HdfsParquetScanner::EvaluateOverlapForRowGroup(
     /// the upper bound for the overlapping ratio. Any filter with an overlap ratio
     /// (>0.0) less than 'threshold' will undertake overlap check at the page and
     /// the row level when the filtering level control allows.
-    bool worthiness = !(minmax_filter->AlwaysTrue()) && (overlap_ratio < threshold);
+    /// Top-N filters are always worth checking at the page and the row level since the
+    /// rows they reject can never make it into the result.
+    bool worthiness = !(minmax_filter->AlwaysTrue())
+        && (is_topn_filter || overlap_ratio < threshold);
+    bool enabled_for_page =
+        (level != TMinmaxFilteringLevel::ROW_GROUP || is_topn_filter) && worthiness;
+    bool enabled_for_row =
+        (level == TMinmaxFilteringLevel::ROW || is_topn_filter) && worthiness;
 
     VLOG(3) << "The filter is available: "
             << "fid=" << filter_id
@@ -756,10 +796,9 @@ Status HdfsParquetScanner::EvaluateOverlapForRowGroup(
             << ", threshold=" << threshold
             << ", worthiness=" << worthiness
             << ", level=" << level
-            << ", enabled for page=" <<
-              ((level != TMinmaxFilteringLevel::ROW_GROUP) && worthiness)
-            << ", enabled for row=" <<
-              ((level == TMinmaxFilteringLevel::ROW) && worthiness)
+            << ", is Top-N filter=" << is_topn_filter
+            << ", enabled for page=" << enabled_for_page
+            << ", enabled for row=" << enabled_for_row
             << ", data min="
             << RawValue::PrintValue(min_slot, col_type, col_type.scale)
             << ", data max="
@@ -782,11 +821,15 @@ Status HdfsParquetScanner::EvaluateOverlapForRowGroup(
     /// FindSkipRangesForPagesWithMinMaxFilters() and rows in these pages in
     /// HdfsScanner::EvalRuntimeFilter(). The worthiness flag is ANDed into the enabled
     /// field so that the state in enabled will never go back to 1 once set to 0.
-    /// The filtering level control is considered too.
-    filter_stats_[idx].enabled_for_row &=
-        (level == TMinmaxFilteringLevel::ROW) && worthiness;
-    filter_stats_[idx].enabled_for_page &=
-        (level != TMinmaxFilteringLevel::ROW_GROUP) && worthiness;
+    /// The filtering level control is considered too. The bound of a Top-N filter only
+    /// gets tighter, so its state is re-evaluated for every row group instead.
+    if (is_topn_filter) {
+      filter_stats_[idx].enabled_for_row = enabled_for_row;
+      filter_stats_[idx].enabled_for_page = enabled_for_page;
+    } else {
+      filter_stats_[idx].enabled_for_row &= enabled_for_row;
+      filter_stats_[idx].enabled_for_page &= enabled_for_page;
+    }
 
     /// Update the row groups stats: no rejection.
     filter_ctxs_[idx]->stats->IncrCounters(FilterStats::ROW_GROUPS_KEY, 1, 1, 0);
@@ -836,7 +879,7 @@ Status HdfsParquetScanner::NextRowGroup() {
     DCHECK_EQ(0, context_->NumStreams());
 
     ++group_idx_;
-    if (group_idx_ >= file_metadata_.row_groups.size()) {
+    if (group_idx_ >= file_metadata_->row_groups.size()) {
       if (start_with_first_row_group && misaligned_row_group_skipped) {
         // We started with the first row group and skipped all the row groups because
         // they were misaligned. The execution flow won't reach this point if there is at
@@ -845,17 +888,17 @@ Status HdfsParquetScanner::NextRowGroup() {
       }
       break;
     }
-    const parquet::RowGroup& row_group = file_metadata_.row_groups[group_idx_];
-    // Also check 'file_metadata_.num_rows' to make sure 'select count(*)' and 'select *'
-    // behave consistently for corrupt files that have 'file_metadata_.num_rows == 0'
+    const parquet::RowGroup& row_group = file_metadata_->row_groups[group_idx_];
+    // Also check 'file_metadata_->num_rows' to make sure 'select count(*)' and 'select *'
+    // behave consistently for corrupt files that have 'file_metadata_->num_rows == 0'
     // but some data in row groups.
-    if (row_group.num_rows == 0 || file_metadata_.num_rows == 0) continue;
+    if (row_group.num_rows == 0 || file_metadata_->num_rows == 0) continue;
 
     // Let's find the index of the first row in this row group. It's needed to track the
     // file position of each row.
     int64_t row_group_first_row = 0;
     for (int i = 0; i < group_idx_; ++i) {
-      const parquet::RowGroup& row_group = file_metadata_.row_groups[i];
+      const parquet::RowGroup& row_group = file_metadata_->row_groups[i];
       row_group_first_row += row_group.num_rows;
     }
 
@@ -883,7 +926,7 @@ Status HdfsParquetScanner::NextRowGroup() {
     // Evaluate row group statistics with stats conjuncts.
     bool skip_row_group_on_stats;
     RETURN_IF_ERROR(
-        EvaluateStatsConjuncts(file_metadata_, row_group, &skip_row_group_on_stats));
+        EvaluateStatsConjuncts(*file_metadata_, row_group, &skip_row_group_on_stats));
     if (skip_row_group_on_stats) {
       COUNTER_ADD(num_stats_filtered_row_groups_counter_, 1);
       continue;
@@ -892,7 +935,7 @@ Status HdfsParquetScanner::NextRowGroup() {
     // Evaluate row group statistics with min/max filters.
     bool skip_row_group_on_minmax;
     RETURN_IF_ERROR(
-      EvaluateOverlapForRowGroup(file_metadata_, row_group, &skip_row_group_on_minmax));
+      EvaluateOverlapForRowGroup(*file_metadata_, row_group, &skip_row_group_on_minmax));
     if (skip_row_group_on_minmax) {
       COUNTER_ADD(num_minmax_filtered_row_groups_counter_, 1);
       continue;
@@ -1007,8 +1050,8 @@ bool HdfsParquetScanner::ReadStatFromIndex(const ColumnStatsReader& stats_reader
 }
 
 Status HdfsParquetScanner::AddToSkipRanges(void* min_slot, void* max_slot,
-    parquet::RowGroup& row_group, int page_idx, const ColumnType& col_type, int col_idx,
-    const parquet::ColumnChunk& col_chunk, vector<RowRange>* skip_ranges,
+    const parquet::RowGroup& row_group, int page_idx, const ColumnType& col_type,
+    int col_idx, const parquet::ColumnChunk& col_chunk, vector<RowRange>* skip_ranges,
     int* filtered_pages) {
   VLOG(3) << "Page " << page_idx << " was filtered out."
           << "data min=" << RawValue::PrintValue(min_slot, col_type, col_type.scale)
@@ -1126,7 +1169,7 @@ Status HdfsParquetScanner::ConvertStatsIntoInternalValuesBatch(
   return Status::OK();
 }
 
-Status HdfsParquetScanner::SkipPagesBatch(parquet::RowGroup& row_group,
+Status HdfsParquetScanner::SkipPagesBatch(const parquet::RowGroup& row_group,
     const ColumnStatsReader& stats_reader, const parquet::ColumnIndex& column_index,
     int start_page_idx, int end_page_idx, const ColumnType& col_type, int col_idx,
     const parquet::ColumnChunk& col_chunk, const MinMaxFilter* minmax_filter,
@@ -1404,7 +1447,7 @@ Status HdfsParquetScanner::FindSkipRangesForPagesWithMinMaxFilters(
   }
 
   min_max_tuple_->Init(min_max_tuple_desc->byte_size());
-  parquet::RowGroup& row_group = file_metadata_.row_groups[group_idx_];
+  const parquet::RowGroup& row_group = file_metadata_->row_groups[group_idx_];
 
   int filtered_pages = 0;
 
@@ -1443,7 +1486,7 @@ Status HdfsParquetScanner::FindSkipRangesForPagesWithMinMaxFilters(
     }
 
     ColumnStatsReader stats_reader =
-        CreateStatsReader(file_metadata_, row_group, node, slot_desc->type());
+        CreateStatsReader(*file_metadata_, row_group, node, slot_desc->type());
 
     DCHECK_LT(col_idx, row_group.columns.size());
     const parquet::ColumnChunk& col_chunk = row_group.columns[col_idx];
@@ -1507,7 +1550,7 @@ Status HdfsParquetScanner::FindSkipRangesForPagesWithMinMaxFilters(
 }
 
 Status HdfsParquetScanner::EvaluatePageIndex() {
-  parquet::RowGroup& row_group = file_metadata_.row_groups[group_idx_];
+  const parquet::RowGroup& row_group = file_metadata_->row_groups[group_idx_];
   vector<RowRange> skip_ranges;
 
   for (int i = 0; i < stats_conjunct_evals_.size(); ++i) {
@@ -1526,7 +1569,7 @@ Status HdfsParquetScanner::EvaluatePageIndex() {
     }
     int col_idx = node->col_idx;;
     ColumnStatsReader stats_reader =
-        CreateStatsReader(file_metadata_, row_group, node, slot_desc->type());
+        CreateStatsReader(*file_metadata_, row_group, node, slot_desc->type());
 
     DCHECK_LT(col_idx, row_group.columns.size());
     const parquet::ColumnChunk& col_chunk = row_group.columns[col_idx];
@@ -1597,7 +1640,7 @@ Status HdfsParquetScanner::EvaluatePageIndex() {
 Status HdfsParquetScanner::ComputeCandidatePagesForColumns() {
   if (candidate_ranges_.empty()) return Status::OK();
 
-  parquet::RowGroup& row_group = file_metadata_.row_groups[group_idx_];
+  const parquet::RowGroup& row_group = file_metadata_->row_groups[group_idx_];
   for (BaseScalarColumnReader* scalar_reader : scalar_readers_) {
     const auto& page_locations = scalar_reader->offset_index_.page_locations;
     if (!ComputeCandidatePages(page_locations, candidate_ranges_, row_group.num_rows,
@@ -2711,48 +2754,62 @@ Status HdfsParquetScanner::ProcessFooter() {
   }
   uint8_t* metadata_ptr = metadata_size_ptr - metadata_size;
 
-  // If the metadata was too big, we need to read it into a contiguous buffer before
-  // deserializing it.
-  ScopedBuffer metadata_buffer(scan_node_->mem_tracker());
+  // Footers that are in the executor-wide cache were possibly only read up to the
+  // metadata size by IssueInitialRanges(). They don't need to be read or deserialized.
+  ParquetMetadataCache* metadata_cache = ExecEnv::GetInstance()->parquet_metadata_cache();
+  const uint32_t serialized_metadata_size = metadata_size;
+  if (metadata_cache == nullptr || !metadata_cache->LookupFileMetadata(
+          *stream_->file_desc(), serialized_metadata_size, &file_metadata_)) {
+    // If the metadata was too big, we need to read it into a contiguous buffer before
+    // deserializing it.
+    ScopedBuffer metadata_buffer(scan_node_->mem_tracker());
+
+    DCHECK(metadata_range_ != nullptr);
+    if (UNLIKELY(metadata_size > remaining_bytes_buffered)) {
+      // In this case, the metadata is bigger than our guess meaning there are
+      // not enough bytes in the footer range from IssueInitialRanges().
+      // We'll just issue more ranges to the IoMgr that is the actual footer.
+      int64_t partition_id = context_->partition_descriptor()->id();
+      const HdfsFileDesc* file_desc = scan_node_->GetFileDesc(partition_id, filename());
+      DCHECK_EQ(file_desc, stream_->file_desc());
+
+      if (!metadata_buffer.TryAllocate(metadata_size)) {
+        string details = Substitute("Could not allocate buffer of $0 bytes for Parquet "
+            "metadata for file '$1'.", metadata_size, filename());
+        return scan_node_->mem_tracker()->MemLimitExceeded(
+            state_, details, metadata_size);
+      }
+      metadata_ptr = metadata_buffer.buffer();
 
-  DCHECK(metadata_range_ != nullptr);
-  if (UNLIKELY(metadata_size > remaining_bytes_buffered)) {
-    // In this case, the metadata is bigger than our guess meaning there are
-    // not enough bytes in the footer range from IssueInitialRanges().
-    // We'll just issue more ranges to the IoMgr that is the actual footer.
-    int64_t partition_id = context_->partition_descriptor()->id();
-    const HdfsFileDesc* file_desc = scan_node_->GetFileDesc(partition_id, filename());
-    DCHECK_EQ(file_desc, stream_->file_desc());
-
-    if (!metadata_buffer.TryAllocate(metadata_size)) {
-      string details = Substitute("Could not allocate buffer of $0 bytes for Parquet "
-          "metadata for file '$1'.", metadata_size, filename());
-      return scan_node_->mem_tracker()->MemLimitExceeded(state_, details, metadata_size);
+      // Read the footer into the metadata buffer. Skip HDFS caching in this case.
+      RETURN_IF_ERROR(ReadToBuffer(metadata_start, metadata_ptr, metadata_size));
     }
-    metadata_ptr = metadata_buffer.buffer();
 
-    // Read the footer into the metadata buffer. Skip HDFS caching in this case.
-    RETURN_IF_ERROR(ReadToBuffer(metadata_start, metadata_ptr, metadata_size));
-  }
-
-  // Deserialize file footer
-  // TODO: this takes ~7ms for a 1000-column table, figure out how to reduce this.
-  Status status =
-      DeserializeThriftMsg(metadata_ptr, &metadata_size, true, &file_metadata_);
-  if (!status.ok()) {
-    return Status(Substitute("File '$0' of length $1 bytes has invalid file metadata "
-        "at file offset $2, Error = $3.", filename(), file_len, metadata_start,
-        status.GetDetail()));
+    // Deserialize file footer
+    // TODO: this takes ~7ms for a 1000-column table, figure out how to reduce this.
+    auto file_metadata = make_shared<parquet::FileMetaData>();
+    Status status =
+        DeserializeThriftMsg(metadata_ptr, &metadata_size, true, file_metadata.get());
+    if (!status.ok()) {
+      return Status(Substitute("File '$0' of length $1 bytes has invalid file metadata "
+          "at file offset $2, Error = $3.", filename(), file_len, metadata_start,
+          status.GetDetail()));
+    }
+    file_metadata_ = move(file_metadata);
+    if (metadata_cache != nullptr) {
+      metadata_cache->InsertFileMetadata(
+          *stream_->file_desc(), serialized_metadata_size, file_metadata_);
+    }
   }
 
-  RETURN_IF_ERROR(ParquetMetadataUtils::ValidateFileVersion(file_metadata_, filename()));
+  RETURN_IF_ERROR(ParquetMetadataUtils::ValidateFileVersion(*file_metadata_, filename()));
 
   // IMPALA-3943: Do not throw an error for empty files for backwards compatibility.
-  if (file_metadata_.num_rows == 0) {
+  if (file_metadata_->num_rows == 0) {
     // Warn if the num_rows is inconsistent with the row group metadata.
-    if (!file_metadata_.row_groups.empty()) {
+    if (!file_metadata_->row_groups.empty()) {
       bool has_non_empty_row_group = false;
-      for (const parquet::RowGroup& row_group : file_metadata_.row_groups) {
+      for (const parquet::RowGroup& row_group : file_metadata_->row_groups) {
         if (row_group.num_rows > 0) {
           has_non_empty_row_group = true;
           break;
@@ -2768,16 +2825,16 @@ Status HdfsParquetScanner::ProcessFooter() {
   }
 
   // Parse out the created by application version string
-  if (file_metadata_.__isset.created_by) {
-    file_version_ = ParquetFileVersion(file_metadata_.created_by);
+  if (file_metadata_->__isset.created_by) {
+    file_version_ = ParquetFileVersion(file_metadata_->created_by);
   }
-  if (file_metadata_.row_groups.empty()) {
+  if (file_metadata_->row_groups.empty()) {
     return Status(
         Substitute("Invalid file. This file: $0 has no row groups", filename()));
   }
-  if (file_metadata_.num_rows < 0) {
+  if (file_metadata_->num_rows < 0) {
     return Status(Substitute("Corrupt Parquet file '$0': negative row count $1 in "
-        "file metadata", filename(), file_metadata_.num_rows));
+        "file metadata", filename(), file_metadata_->num_rows));
   }
   return Status::OK();
 }
@@ -2955,7 +3012,7 @@ Status HdfsParquetScanner::InitScalarColumns(int64_t row_group_first_row) {
   int64_t partition_id = context_->partition_descriptor()->id();
   const HdfsFileDesc* file_desc = scan_node_->GetFileDesc(partition_id, filename());
   DCHECK(file_desc != nullptr);
-  parquet::RowGroup& row_group = file_metadata_.row_groups[group_idx_];
+  const parquet::RowGroup& row_group = file_metadata_->row_groups[group_idx_];
 
   // Used to validate that the number of values in each reader in column_readers_ at the
   // same SchemaElement is the same.
@@ -3013,7 +3070,7 @@ Status HdfsParquetScanner::ValidateEndOfRowGroup(
       // These column readers materialize table-level values (vs. collection values).
       // Test if the expected number of rows from the file metadata matches the actual
       // number of rows read from the file.
-      int64_t expected_rows_in_group = file_metadata_.row_groups[row_group_idx].num_rows;
+      int64_t expected_rows_in_group = file_metadata_->row_groups[row_group_idx].num_rows;
       if (rows_read != expected_rows_in_group) {
         return Status(TErrorCode::PARQUET_GROUP_ROW_COUNT_ERROR, filename(),
             row_group_idx, expected_rows_in_group, rows_read);
@@ -396,7 +396,7 @@ class HdfsParquetScanner : public HdfsColumnarScanner {
 
  protected:
   virtual int64_t GetNumberOfRowsInFile() const override {
-    return file_metadata_.num_rows;
+    return file_metadata_->num_rows;
   }
 
  private:
@@ -438,8 +438,10 @@ class HdfsParquetScanner : public HdfsColumnarScanner {
   /// Column readers among 'column_readers_' not used for filtering
   std::vector<ParquetColumnReader*> non_filter_readers_;
 
-  /// File metadata thrift object
-  parquet::FileMetaData file_metadata_;
+  /// File metadata thrift object. Shared with the Parquet metadata cache and other
+  /// scanners of the same file if the cache is enabled, so it must not be modified after
+  /// ProcessFooter().
+  std::shared_ptr<const parquet::FileMetaData> file_metadata_;
 
   /// Version of the application that wrote this file.
   ParquetFileVersion file_version_;
@@ -660,9 +662,9 @@ class HdfsParquetScanner : public HdfsColumnarScanner {
 
   /// Construct a RowRange with the begin and end row in page 'page_idx' and store the
   /// object into 'skip_ranges'.
-  Status AddToSkipRanges(void* min_slot, void* max_slot, parquet::RowGroup& row_group,
-      int page_idx, const ColumnType& col_type, int col_idx,
-      const parquet::ColumnChunk& col_chunk, vector<RowRange>* skip_ranges,
+  Status AddToSkipRanges(void* min_slot, void* max_slot,
+      const parquet::RowGroup& row_group, int page_idx, const ColumnType& col_type,
+      int col_idx, const parquet::ColumnChunk& col_chunk, vector<RowRange>* skip_ranges,
       int* filtered_pages);
 
   /// Batch read a range ['start_page_idx', 'end_page_idx'] of min/max stats of non-null
@@ -672,7 +674,7 @@ class HdfsParquetScanner : public HdfsColumnarScanner {
   /// On return:
   ///   *skip_ranges is appended with new row ranges in those skipped pages,
   //    *filtered_pages is incremented with the number of skipped pages.
-  Status SkipPagesBatch(parquet::RowGroup& row_group,
+  Status SkipPagesBatch(const parquet::RowGroup& row_group,
       const ColumnStatsReader& stats_reader, const parquet::ColumnIndex& column_index,
       int start_page_idx, int end_page_idx, const ColumnType& col_type, int col_idx,
       const parquet::ColumnChunk& col_chunk, const MinMaxFilter* minmax_filter,
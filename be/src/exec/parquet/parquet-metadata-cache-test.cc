@@ -0,0 +1,154 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "exec/hdfs-scan-node-base.h"
+#include "exec/parquet/parquet-metadata-cache.h"
+#include "gen-cpp/parquet_types.h"
+#include "testutil/gtest-util.h"
+#include "util/metrics.h"
+
+#include "common/names.h"
+
+namespace impala {
+
+class ParquetMetadataCacheTest : public testing::Test {
+ protected:
+  virtual void SetUp() {
+    metrics_.reset(new MetricGroup("parquet-metadata-cache-test"));
+  }
+
+  virtual void TearDown() {
+    cache_.reset();
+    metrics_.reset();
+  }
+
+  void CreateCache(int64_t capacity) {
+    cache_.reset(new ParquetMetadataCache(metrics_.get()));
+    ASSERT_OK(cache_->Init(capacity));
+  }
+
+  static HdfsFileDesc MakeFileDesc(const string& filename, int64_t mtime) {
+    HdfsFileDesc file_desc(filename);
+    file_desc.file_length = 1024;
+    file_desc.mtime = mtime;
+    return file_desc;
+  }
+
+  static shared_ptr<const parquet::FileMetaData> MakeFileMetadata(int64_t num_rows) {
+    auto file_metadata = make_shared<parquet::FileMetaData>();
+    file_metadata->__set_version(1);
+    file_metadata->__set_num_rows(num_rows);
+    file_metadata->__set_created_by("parquet-metadata-cache-test");
+    return file_metadata;
+  }
+
+  void ExpectMetrics(int64_t hits, int64_t misses, int64_t evicted, int64_t in_use) {
+    EXPECT_EQ(hits, cache_->hits_->GetValue());
+    EXPECT_EQ(misses, cache_->misses_->GetValue());
+    EXPECT_EQ(evicted, cache_->entries_evicted_->GetValue());
+    EXPECT_EQ(in_use, cache_->entries_in_use_->GetValue());
+  }
+
+  scoped_ptr<MetricGroup> metrics_;
+  scoped_ptr<ParquetMetadataCache> cache_;
+};
+
+TEST_F(ParquetMetadataCacheTest, FileMetadata) {
+  CreateCache(1024 * 1024);
+  HdfsFileDesc file_desc = MakeFileDesc("/test/file1.parq", 100);
+  shared_ptr<const parquet::FileMetaData> result;
+  EXPECT_FALSE(cache_->ContainsFileMetadata(file_desc));
+  EXPECT_FALSE(cache_->LookupFileMetadata(file_desc, 50, &result));
+  ExpectMetrics(0, 1, 0, 0);
+
+  shared_ptr<const parquet::FileMetaData> inserted = MakeFileMetadata(42);
+  cache_->InsertFileMetadata(file_desc, 50, inserted);
+  EXPECT_TRUE(cache_->ContainsFileMetadata(file_desc));
+  ASSERT_TRUE(cache_->LookupFileMetadata(file_desc, 50, &result));
+  // Lookups share the cached footer instead of copying it.
+  EXPECT_EQ(inserted.get(), result.get());
+  EXPECT_EQ(42, result->num_rows);
+  EXPECT_EQ("parquet-metadata-cache-test", result->created_by);
+  ExpectMetrics(1, 1, 0, 1);
+  EXPECT_GT(cache_->entries_in_use_bytes_->GetValue(), 50);
+
+  // A footer of a different size is not the cached one.
+  EXPECT_FALSE(cache_->LookupFileMetadata(file_desc, 51, &result));
+  ExpectMetrics(1, 2, 0, 1);
+
+  // Neither is the footer of a file that was rewritten.
+  HdfsFileDesc rewritten = MakeFileDesc("/test/file1.parq", 101);
+  EXPECT_FALSE(cache_->ContainsFileMetadata(rewritten));
+  EXPECT_FALSE(cache_->LookupFileMetadata(rewritten, 50, &result));
+  ExpectMetrics(1, 3, 0, 1);
+
+  // Replacing the entry evicts the old one. Scanners that still use the old footer keep
+  // it alive.
+  shared_ptr<const parquet::FileMetaData> old_result = result;
+  cache_->InsertFileMetadata(file_desc, 50, MakeFileMetadata(43));
+  ASSERT_TRUE(cache_->LookupFileMetadata(file_desc, 50, &result));
+  EXPECT_EQ(43, result->num_rows);
+  EXPECT_EQ(42, old_result->num_rows);
+  ExpectMetrics(2, 3, 1, 1);
+
+  // Only the references outside of the cache remain after it is destroyed.
+  cache_.reset();
+  EXPECT_EQ(1, result.use_count());
+  EXPECT_EQ(2, old_result.use_count());
+}
+
+TEST_F(ParquetMetadataCacheTest, PageIndex) {
+  CreateCache(1024 * 1024);
+  HdfsFileDesc file_desc = MakeFileDesc("/test/file1.parq", 100);
+  vector<uint8_t> page_index(64);
+  for (int i = 0; i < page_index.size(); ++i) page_index[i] = i;
+  vector<uint8_t> result(page_index.size());
+
+  EXPECT_FALSE(
+      cache_->LookupPageIndex(file_desc, 0, result.data(), result.size()));
+  cache_->InsertPageIndex(file_desc, 0, page_index.data(), page_index.size());
+  ASSERT_TRUE(cache_->LookupPageIndex(file_desc, 0, result.data(), result.size()));
+  EXPECT_EQ(page_index, result);
+
+  // Other row groups and lengths do not match.
+  EXPECT_FALSE(cache_->LookupPageIndex(file_desc, 1, result.data(), result.size()));
+  EXPECT_FALSE(
+      cache_->LookupPageIndex(file_desc, 0, result.data(), result.size() - 1));
+  // Page indexes and footers of the same file are separate entries.
+  EXPECT_FALSE(cache_->ContainsFileMetadata(file_desc));
+  ExpectMetrics(1, 3, 0, 1);
+}
+
+TEST_F(ParquetMetadataCacheTest, Eviction) {
+  // The capacity is split among the shards of the cache, so only check the totals.
+  CreateCache(1024);
+  vector<uint8_t> page_index(256);
+  const int num_files = 10;
+  for (int i = 0; i < num_files; ++i) {
+    HdfsFileDesc file_desc = MakeFileDesc(Substitute("/test/file$0.parq", i), 100);
+    cache_->InsertPageIndex(file_desc, 0, page_index.data(), page_index.size());
+  }
+  EXPECT_GT(cache_->entries_evicted_->GetValue(), 0);
+  EXPECT_EQ(num_files,
+      cache_->entries_evicted_->GetValue() + cache_->entries_in_use_->GetValue());
+  // Destroying the cache releases all remaining entries.
+  cache_.reset();
+  EXPECT_EQ(0, metrics_->FindMetricForTesting<IntGauge>(
+      "impala.parquet-metadata-cache.entries-in-use")->GetValue());
+}
+
+} // namespace impala
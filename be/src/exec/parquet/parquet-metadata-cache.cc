@@ -0,0 +1,168 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "exec/parquet/parquet-metadata-cache.h"
+
+#include <cstring>
+#include <limits>
+
+#include "exec/hdfs-scan-node-base.h"
+#include "gen-cpp/parquet_types.h"
+#include "util/metrics.h"
+
+#include "common/names.h"
+
+namespace impala {
+
+void ParquetMetadataCache::EvictionCallback::EvictedEntry(Slice key, Slice value) {
+  DCHECK(!key.empty());
+  if (key[0] == FILE_METADATA) {
+    DCHECK_EQ(value.size(), sizeof(FileMetadataEntry));
+    const FileMetadataEntry* entry =
+        reinterpret_cast<const FileMetadataEntry*>(value.data());
+    delete entry->file_metadata;
+  }
+  cache_->entries_evicted_->Increment(1);
+  cache_->entries_in_use_->Increment(-1);
+  cache_->entries_in_use_bytes_->Increment(-Charge(key, value));
+}
+
+ParquetMetadataCache::ParquetMetadataCache(MetricGroup* metrics)
+  : evict_callback_(new EvictionCallback(this)),
+    hits_(metrics->AddCounter("impala.parquet-metadata-cache.hits", 0)),
+    misses_(metrics->AddCounter("impala.parquet-metadata-cache.misses", 0)),
+    entries_evicted_(
+        metrics->AddCounter("impala.parquet-metadata-cache.entries-evicted", 0)),
+    entries_in_use_(
+        metrics->AddGauge("impala.parquet-metadata-cache.entries-in-use", 0)),
+    entries_in_use_bytes_(
+        metrics->AddGauge("impala.parquet-metadata-cache.entries-in-use-bytes", 0)) {}
+
+ParquetMetadataCache::~ParquetMetadataCache() {
+  // Destroying the cache runs the eviction callback for the remaining entries.
+  cache_.reset();
+}
+
+Status ParquetMetadataCache::Init(int64_t capacity) {
+  DCHECK(cache_ == nullptr);
+  cache_.reset(
+      NewCache(Cache::EvictionPolicy::LRU, capacity, "Parquet_Metadata_Cache"));
+  return cache_->Init();
+}
+
+int64_t ParquetMetadataCache::Charge(Slice key, Slice value) {
+  int64_t charge = key.size() + value.size();
+  if (key[0] == FILE_METADATA) {
+    const FileMetadataEntry* entry =
+        reinterpret_cast<const FileMetadataEntry*>(value.data());
+    charge += FILE_METADATA_SIZE_FACTOR * entry->serialized_size;
+  }
+  return charge;
+}
+
+void ParquetMetadataCache::BuildKey(EntryType type, const HdfsFileDesc& file_desc,
+    int row_group_idx, string* key) {
+  key->clear();
+  key->reserve(1 + 2 * sizeof(int64_t) + sizeof(int32_t) + file_desc.filename.size());
+  key->push_back(static_cast<char>(type));
+  key->append(reinterpret_cast<const char*>(&file_desc.mtime), sizeof(int64_t));
+  key->append(reinterpret_cast<const char*>(&file_desc.file_length), sizeof(int64_t));
+  if (type == PAGE_INDEX) {
+    int32_t idx = row_group_idx;
+    key->append(reinterpret_cast<const char*>(&idx), sizeof(idx));
+  }
+  key->append(file_desc.filename);
+}
+
+bool ParquetMetadataCache::Insert(const string& key, const void* value, int value_len) {
+  Slice value_slice(reinterpret_cast<const uint8_t*>(value), value_len);
+  const int64_t charge = Charge(key, value_slice);
+  Cache::UniquePendingHandle pending(cache_->Allocate(key, value_len, charge));
+  if (pending == nullptr) return false;
+  memcpy(cache_->MutableValue(&pending), value, value_len);
+  // The gauges are decremented by the eviction callback, which also runs if the entry
+  // cannot be inserted.
+  entries_in_use_->Increment(1);
+  entries_in_use_bytes_->Increment(charge);
+  cache_->Insert(move(pending), evict_callback_.get());
+  return true;
+}
+
+bool ParquetMetadataCache::ContainsFileMetadata(const HdfsFileDesc& file_desc) {
+  string key;
+  BuildKey(FILE_METADATA, file_desc, -1, &key);
+  return cache_->Lookup(key, Cache::NO_UPDATE) != nullptr;
+}
+
+bool ParquetMetadataCache::LookupFileMetadata(const HdfsFileDesc& file_desc,
+    uint32_t serialized_size,
+    std::shared_ptr<const parquet::FileMetaData>* file_metadata) {
+  string key;
+  BuildKey(FILE_METADATA, file_desc, -1, &key);
+  Cache::UniqueHandle handle(cache_->Lookup(key));
+  if (handle != nullptr) {
+    const FileMetadataEntry* entry =
+        reinterpret_cast<const FileMetadataEntry*>(cache_->Value(handle).data());
+    if (entry->serialized_size == serialized_size) {
+      // The handle keeps the entry from being freed while the reference is taken.
+      *file_metadata = *entry->file_metadata;
+      hits_->Increment(1);
+      return true;
+    }
+  }
+  misses_->Increment(1);
+  return false;
+}
+
+void ParquetMetadataCache::InsertFileMetadata(const HdfsFileDesc& file_desc,
+    uint32_t serialized_size,
+    std::shared_ptr<const parquet::FileMetaData> file_metadata) {
+  DCHECK(file_metadata != nullptr);
+  string key;
+  BuildKey(FILE_METADATA, file_desc, -1, &key);
+  FileMetadataEntry entry{
+      new std::shared_ptr<const parquet::FileMetaData>(move(file_metadata)),
+      serialized_size};
+  if (!Insert(key, &entry, sizeof(entry))) delete entry.file_metadata;
+}
+
+bool ParquetMetadataCache::LookupPageIndex(const HdfsFileDesc& file_desc,
+    int row_group_idx, uint8_t* buffer, int64_t len) {
+  string key;
+  BuildKey(PAGE_INDEX, file_desc, row_group_idx, &key);
+  Cache::UniqueHandle handle(cache_->Lookup(key));
+  if (handle != nullptr) {
+    Slice value = cache_->Value(handle);
+    if (static_cast<int64_t>(value.size()) == len) {
+      memcpy(buffer, value.data(), len);
+      hits_->Increment(1);
+      return true;
+    }
+  }
+  misses_->Increment(1);
+  return false;
+}
+
+void ParquetMetadataCache::InsertPageIndex(const HdfsFileDesc& file_desc,
+    int row_group_idx, const uint8_t* buffer, int64_t len) {
+  if (len > std::numeric_limits<int>::max()) return;
+  string key;
+  BuildKey(PAGE_INDEX, file_desc, row_group_idx, &key);
+  Insert(key, buffer, len);
+}
+
+} // namespace impala
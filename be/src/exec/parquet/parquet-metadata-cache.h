@@ -0,0 +1,135 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "common/status.h"
+#include "util/cache/cache.h"
+#include "util/metrics-fwd.h"
+
+namespace parquet {
+class FileMetaData;
+}
+
+namespace impala {
+
+struct HdfsFileDesc;
+class MetricGroup;
+
+/// Process-wide cache of Parquet file metadata, shared by all scanners of a daemon.
+/// It holds two kinds of entries:
+/// - The deserialized FileMetaData of a file footer. A scanner that finds it skips
+///   reading the full footer and deserializing it.
+/// - The raw bytes of the column and offset indexes of a row group. A scanner that
+///   finds them skips reading the page index.
+/// Entries are keyed by the file name, modification time and length, so a file that was
+/// rewritten never returns stale metadata. The cache is bounded by its capacity and
+/// evicts entries in LRU order. All functions are thread-safe.
+class ParquetMetadataCache {
+ public:
+  ParquetMetadataCache(MetricGroup* metrics);
+  ~ParquetMetadataCache();
+
+  /// Creates the underlying cache with 'capacity' bytes.
+  Status Init(int64_t capacity);
+
+  /// Returns true if the footer of 'file_desc' is cached. Does not affect the eviction
+  /// order.
+  bool ContainsFileMetadata(const HdfsFileDesc& file_desc);
+
+  /// Sets 'file_metadata' to the cached footer of 'file_desc' and returns true if it is
+  /// cached and was deserialized from 'serialized_size' bytes. Returns false otherwise.
+  /// The footer is shared with the cache and other scanners, not copied, and stays
+  /// valid after the entry is evicted.
+  bool LookupFileMetadata(const HdfsFileDesc& file_desc, uint32_t serialized_size,
+      std::shared_ptr<const parquet::FileMetaData>* file_metadata);
+
+  /// Caches 'file_metadata', which was deserialized from the 'serialized_size' bytes of
+  /// the footer of 'file_desc'. The caller must not modify it afterwards.
+  void InsertFileMetadata(const HdfsFileDesc& file_desc, uint32_t serialized_size,
+      std::shared_ptr<const parquet::FileMetaData> file_metadata);
+
+  /// Copies the cached page index of row group 'row_group_idx' of 'file_desc' into the
+  /// 'len' bytes at 'buffer' and returns true if it is cached with the same length.
+  /// Returns false otherwise.
+  bool LookupPageIndex(const HdfsFileDesc& file_desc, int row_group_idx,
+      uint8_t* buffer, int64_t len);
+
+  /// Caches the 'len' bytes of the page index of row group 'row_group_idx' of
+  /// 'file_desc' at 'buffer'.
+  void InsertPageIndex(const HdfsFileDesc& file_desc, int row_group_idx,
+      const uint8_t* buffer, int64_t len);
+
+ private:
+  friend class ParquetMetadataCacheTest;
+
+  /// The first byte of each key tells the kind of entry.
+  enum EntryType : uint8_t {
+    FILE_METADATA = 0,
+    PAGE_INDEX = 1,
+  };
+
+  /// Value of a FILE_METADATA entry. The entry holds a reference to the FileMetaData,
+  /// which is dropped by the eviction callback.
+  struct FileMetadataEntry {
+    std::shared_ptr<const parquet::FileMetaData>* file_metadata;
+    uint32_t serialized_size;
+  };
+
+  /// Drops the FileMetaData reference of evicted FILE_METADATA entries and updates the
+  /// metrics.
+  class EvictionCallback : public Cache::EvictionCallback {
+   public:
+    EvictionCallback(ParquetMetadataCache* cache) : cache_(cache) {}
+    virtual void EvictedEntry(Slice key, Slice value) override;
+
+   private:
+    ParquetMetadataCache* cache_;
+  };
+
+  /// The in-memory size of a deserialized FileMetaData is estimated as this multiple of
+  /// its serialized size for the charge of FILE_METADATA entries.
+  static constexpr int64_t FILE_METADATA_SIZE_FACTOR = 4;
+
+  /// Returns the charge of an entry with 'key' and 'value'.
+  static int64_t Charge(Slice key, Slice value);
+
+  /// Builds the key of the entry of 'type' for 'file_desc' in 'key'. 'row_group_idx' is
+  /// only part of PAGE_INDEX keys.
+  static void BuildKey(EntryType type, const HdfsFileDesc& file_desc, int row_group_idx,
+      std::string* key);
+
+  /// Inserts the 'value_len' bytes at 'value' for 'key'. Returns false if the entry
+  /// could not be allocated.
+  bool Insert(const std::string& key, const void* value, int value_len);
+
+  std::unique_ptr<Cache> cache_;
+  std::unique_ptr<EvictionCallback> evict_callback_;
+
+  /// Process-wide metrics of the cache.
+  IntCounter* hits_;
+  IntCounter* misses_;
+  IntCounter* entries_evicted_;
+  IntGauge* entries_in_use_;
+  IntGauge* entries_in_use_bytes_;
+};
+
+} // namespace impala
@@ -17,9 +17,11 @@
 
 #include "common/logging.h"
 #include "exec/parquet/hdfs-parquet-scanner.h"
+#include "exec/parquet/parquet-metadata-cache.h"
 #include "exec/parquet/parquet-page-index.h"
 #include "gutil/strings/substitute.h"
 #include "rpc/thrift-util.h"
+#include "runtime/exec-env.h"
 #include "runtime/io/request-context.h"
 #include "runtime/io/request-ranges.h"
 
@@ -68,7 +70,7 @@ bool ParquetPageIndex::DeterminePageIndexRangesInRowGroup(
 Status ParquetPageIndex::ReadAll(int row_group_idx) {
   DCHECK(page_index_buffer_.buffer() == nullptr);
   bool has_page_index = DeterminePageIndexRangesInRowGroup(
-      scanner_->file_metadata_.row_groups[row_group_idx],
+      scanner_->file_metadata_->row_groups[row_group_idx],
       &column_index_base_offset_, &column_index_size_,
       &offset_index_base_offset_, &offset_index_size_);
 
@@ -93,6 +95,13 @@ Status ParquetPageIndex::ReadAll(int row_group_idx) {
         "page index for file '$1'.", buffer_size, scanner_->filename()));
   }
   int64_t partition_id = scanner_->context_->partition_descriptor()->id();
+  ParquetMetadataCache* metadata_cache = ExecEnv::GetInstance()->parquet_metadata_cache();
+  const HdfsFileDesc* file_desc =
+      scanner_->scan_node_->GetFileDesc(partition_id, scanner_->filename());
+  if (metadata_cache != nullptr && metadata_cache->LookupPageIndex(*file_desc,
+          row_group_idx, page_index_buffer_.buffer(), page_index_buffer_.Size())) {
+    return Status::OK();
+  }
   int cache_options =
       scanner_->metadata_range_->cache_options() & ~BufferOpts::USE_HDFS_CACHE;
   ScanRange* object_range = scanner_->scan_node_->AllocateScanRange(
@@ -114,6 +123,10 @@ Status ParquetPageIndex::ReadAll(int row_group_idx) {
   scanner_->AddSyncReadBytesCounter(io_buffer->len());
   object_range->ReturnBuffer(move(io_buffer));
 
+  if (metadata_cache != nullptr) {
+    metadata_cache->InsertPageIndex(*file_desc, row_group_idx,
+        page_index_buffer_.buffer(), page_index_buffer_.Size());
+  }
   return Status::OK();
 }
 
@@ -113,3 +113,22 @@ bool PhjBuilderPartition::InsertBatch(TPrefetchMode::type prefetch_mode,
   }
   return true;
 }
+
+void PhjBuilderPartition::HashBatch(
+    HashTableCtx* ht_ctx, RowBatch* batch, uint32_t* hashes) {
+  const int num_rows = batch->num_rows();
+  HashTableCtx::ExprValuesCache* expr_vals_cache = ht_ctx->expr_values_cache();
+  const int group_size = expr_vals_cache->capacity();
+  for (int group_row = 0; group_row < num_rows; group_row += group_size) {
+    int cur_row = group_row;
+    expr_vals_cache->Reset();
+    FOREACH_ROW_LIMIT(batch, cur_row, group_size, batch_iter) {
+      // Rows with NULLs that are not stored are skipped by InsertBatch() later, so
+      // any window will do for them.
+      hashes[cur_row] = ht_ctx->EvalAndHashBuild(batch_iter.Get()) ?
+          expr_vals_cache->CurExprValuesHash() : 0;
+      expr_vals_cache->NextRow();
+      ++cur_row;
+    }
+  }
+}
@@ -36,6 +36,7 @@
 #include "runtime/runtime-filter.h"
 #include "runtime/runtime-state.h"
 #include "service/hs2-util.h"
+#include "util/bit-util.h"
 #include "util/bloom-filter.h"
 #include "util/cyclic-barrier.h"
 #include "util/debug-util.h"
@@ -55,6 +56,17 @@ static const string PREPARE_FOR_READ_FAILED_ERROR_MSG =
 using namespace impala;
 using strings::Substitute;
 
+DEFINE_bool(enable_radix_hash_table_build, true, "(Advanced) If true, the rows of a "
+    "hash join partition whose hash table bucket directory is larger than "
+    "--radix_hash_table_build_min_bytes are inserted in the order of the buckets that "
+    "they hash to, which reduces cache misses when building large hash tables.");
+DEFINE_int64(radix_hash_table_build_min_bytes, 32L * 1024 * 1024, "(Advanced) "
+    "Minimum size of a hash join hash table's bucket directory for "
+    "--enable_radix_hash_table_build to apply.");
+
+constexpr int64_t PhjBuilderPartition::RADIX_BUILD_WINDOW_BYTES;
+constexpr int PhjBuilderPartition::RADIX_BUILD_MAX_WINDOWS_LOG2;
+
 DataSink* PhjBuilderConfig::CreateSink(RuntimeState* state) const {
   // We have one fragment per sink, so we can use the fragment index as the sink ID.
   TDataSinkId sink_id = state->fragment().idx;
@@ -127,7 +139,7 @@ Status PhjBuilderConfig::InitExprsAndFilters(FragmentState* state,
 
   hash_table_config_ = state->obj_pool()->Add(new HashTableConfig(build_exprs_,
       build_exprs_, PhjBuilder::HashTableStoresNulls(join_op_, is_not_distinct_from_),
-      is_not_distinct_from_));
+      is_not_distinct_from_, state->query_options().hash_table_tagged_probing));
   state->CheckAndAddCodegenDisabledMessage(codegen_status_msgs_);
   return Status::OK();
 }
@@ -177,7 +189,9 @@ PhjBuilder::PhjBuilder(
     process_build_batch_fn_(sink_config.process_build_batch_fn_),
     process_build_batch_fn_level0_(sink_config.process_build_batch_fn_level0_),
     insert_batch_fn_(sink_config.insert_batch_fn_),
-    insert_batch_fn_level0_(sink_config.insert_batch_fn_level0_) {
+    insert_batch_fn_level0_(sink_config.insert_batch_fn_level0_),
+    hash_batch_fn_(sink_config.hash_batch_fn_),
+    hash_batch_fn_level0_(sink_config.hash_batch_fn_level0_) {
   DCHECK_GT(sink_config.hash_seed_, 0);
   DCHECK(num_probe_threads_ <= 1 || !NeedToProcessUnmatchedBuildRows(join_op_))
       << "Returning rows with build partitions is not supported with shared builds";
@@ -213,7 +227,9 @@ PhjBuilder::PhjBuilder(const PhjBuilderConfig& sink_config,
     process_build_batch_fn_(sink_config.process_build_batch_fn_),
     process_build_batch_fn_level0_(sink_config.process_build_batch_fn_level0_),
     insert_batch_fn_(sink_config.insert_batch_fn_),
-    insert_batch_fn_level0_(sink_config.insert_batch_fn_level0_) {
+    insert_batch_fn_level0_(sink_config.insert_batch_fn_level0_),
+    hash_batch_fn_(sink_config.hash_batch_fn_),
+    hash_batch_fn_level0_(sink_config.hash_batch_fn_level0_) {
   DCHECK_GT(sink_config.hash_seed_, 0);
   DCHECK_EQ(1, num_probe_threads_) << "Embedded builders cannot be shared";
   for (const TRuntimeFilterDesc& filter_desc : sink_config.filter_descs_) {
@@ -240,6 +256,8 @@ Status PhjBuilder::Prepare(RuntimeState* state, MemTracker* parent_mem_tracker)
   build_hash_table_timer_ = ADD_TIMER(profile(), "HashTablesBuildTime");
   num_hash_table_builds_skipped_ =
       ADD_COUNTER(profile(), "NumHashTableBuildsSkipped", TUnit::UNIT);
+  num_radix_ordered_builds_ =
+      ADD_COUNTER(profile(), "NumRadixOrderedHashTableBuilds", TUnit::UNIT);
   repartition_timer_ = ADD_TIMER(profile(), "RepartitionTime");
 
   if (is_separate_build_) {
@@ -257,6 +275,20 @@ Status PhjBuilder::Prepare(RuntimeState* state, MemTracker* parent_mem_tracker)
       MAX_PARTITION_DEPTH, row_desc_->tuple_descriptors().size(), expr_perm_pool_.get(),
       expr_results_pool_.get(), expr_results_pool_.get(), &ht_ctx_));
 
+  if (is_separate_build_ && num_probe_threads_ > 1
+      && state->query_options().hash_join_parallel_build) {
+    num_build_workers_ = min(num_probe_threads_, PARTITION_FANOUT);
+  }
+  for (int i = 1; i < num_build_workers_; ++i) {
+    MemPool* results_pool = obj_pool_.Add(new MemPool(mem_tracker_.get()));
+    build_worker_expr_results_pools_.push_back(results_pool);
+    scoped_ptr<HashTableCtx> worker_ht_ctx;
+    RETURN_IF_ERROR(HashTableCtx::Create(&obj_pool_, state, hash_table_config_,
+        hash_seed_, MAX_PARTITION_DEPTH, row_desc_->tuple_descriptors().size(),
+        expr_perm_pool_.get(), results_pool, results_pool, &worker_ht_ctx));
+    build_worker_ht_ctxs_.push_back(obj_pool_.Add(worker_ht_ctx.release()));
+  }
+
   RETURN_IF_ERROR(DebugAction(state->query_options(), "PHJ_BUILDER_PREPARE"));
 
   DCHECK_EQ(filter_exprs_.size(), filter_ctxs_.size());
@@ -281,6 +313,9 @@ Status PhjBuilder::Open(RuntimeState* state) {
   }
 
   RETURN_IF_ERROR(ht_ctx_->Open(state));
+  for (HashTableCtx* worker_ht_ctx : build_worker_ht_ctxs_) {
+    RETURN_IF_ERROR(worker_ht_ctx->Open(state));
+  }
 
   for (const FilterContext& ctx : filter_ctxs_) {
     RETURN_IF_ERROR(ctx.expr_eval->Open(state));
@@ -446,6 +481,15 @@ void PhjBuilder::Close(RuntimeState* state) {
     ht_ctx_->Close(state);
     ht_ctx_.reset();
   }
+  for (HashTableCtx* worker_ht_ctx : build_worker_ht_ctxs_) {
+    worker_ht_ctx->StatsCountersAdd(ht_stats_profile_.get());
+    worker_ht_ctx->Close(state);
+  }
+  build_worker_ht_ctxs_.clear();
+  for (MemPool* results_pool : build_worker_expr_results_pools_) {
+    results_pool->FreeAll();
+  }
+  build_worker_expr_results_pools_.clear();
   for (const FilterContext& ctx : filter_ctxs_) {
     if (ctx.expr_eval != nullptr) ctx.expr_eval->Close(state);
   }
@@ -631,16 +675,20 @@ Status PhjBuilder::BuildHashTablesAndReserveProbeBuffers(HashJoinState next_stat
   // won't fit in memory alongside the required probe buffers.
   RETURN_IF_ERROR(ReserveProbeBuffers(next_state));
 
-  for (int i = 0; i < PARTITION_FANOUT; ++i) {
-    PhjBuilderPartition* partition = hash_partitions_[i].get();
-    if (partition->IsClosed() || partition->is_spilled()) continue;
-
-    bool built = false;
-    DCHECK(partition->build_rows()->is_pinned());
-    RETURN_IF_ERROR(partition->BuildHashTable(&built));
-    // If we did not have enough memory to build this hash table, we need to spill this
-    // partition (clean up the hash table, unpin build).
-    if (!built) RETURN_IF_ERROR(partition->Spill(BufferedTupleStream::UNPIN_ALL));
+  if (num_build_workers_ > 1) {
+    RETURN_IF_ERROR(BuildHashTablesInParallel());
+  } else {
+    for (int i = 0; i < PARTITION_FANOUT; ++i) {
+      PhjBuilderPartition* partition = hash_partitions_[i].get();
+      if (partition->IsClosed() || partition->is_spilled()) continue;
+
+      bool built = false;
+      DCHECK(partition->build_rows()->is_pinned());
+      RETURN_IF_ERROR(partition->BuildHashTable(&built));
+      // If we did not have enough memory to build this hash table, we need to spill
+      // this partition (clean up the hash table, unpin build).
+      if (!built) RETURN_IF_ERROR(partition->Spill(BufferedTupleStream::UNPIN_ALL));
+    }
   }
   // We may have spilled additional partitions while building hash tables, we need to
   // reserve memory for the probe buffers for those additional spilled partitions.
@@ -653,6 +701,31 @@ Status PhjBuilder::BuildHashTablesAndReserveProbeBuffers(HashJoinState next_stat
   return Status::OK();
 }
 
+Status PhjBuilder::BuildHashTablesInParallel() {
+  vector<PhjBuilderPartition*> partitions;
+  for (const unique_ptr<PhjBuilderPartition>& partition : hash_partitions_) {
+    if (partition->IsClosed() || partition->is_spilled()) continue;
+    DCHECK(partition->build_rows()->is_pinned());
+    partitions.push_back(partition.get());
+  }
+  // Not a vector<bool>: different workers write to adjacent elements.
+  vector<uint8_t> built(partitions.size(), false);
+  RETURN_IF_ERROR(RunBuildTasks(runtime_state_, partitions.size(), num_build_workers_,
+      [&partitions, &built](int worker_idx, int partition_idx) {
+        bool partition_built = false;
+        RETURN_IF_ERROR(
+            partitions[partition_idx]->BuildHashTable(&partition_built, worker_idx));
+        built[partition_idx] = partition_built;
+        return Status::OK();
+      }));
+  // If we did not have enough memory to build a hash table, we need to spill its
+  // partition (clean up the hash table, unpin build).
+  for (int i = 0; i < partitions.size(); ++i) {
+    if (!built[i]) RETURN_IF_ERROR(partitions[i]->Spill(BufferedTupleStream::UNPIN_ALL));
+  }
+  return Status::OK();
+}
+
 Status PhjBuilder::ReserveProbeBuffers(HashJoinState next_state) {
   DCHECK_EQ(PARTITION_FANOUT, hash_partitions_.size());
   int64_t curr_reservation = probe_stream_reservation_.GetReservation();
@@ -1215,7 +1288,7 @@ Status PhjBuilderPartition::Spill(BufferedTupleStream::UnpinMode mode) {
   return Status::OK();
 }
 
-Status PhjBuilderPartition::BuildHashTable(bool* built) {
+Status PhjBuilderPartition::BuildHashTable(bool* built, int worker_idx) {
   SCOPED_TIMER(parent_->build_hash_table_timer_);
   DCHECK(build_rows_ != nullptr);
   *built = false;
@@ -1225,11 +1298,11 @@ Status PhjBuilderPartition::BuildHashTable(bool* built) {
   if (!*built) return Status::OK();
 
   RuntimeState* state = parent_->runtime_state_;
-  HashTableCtx* ctx = parent_->ht_ctx_.get();
+  HashTableCtx* ctx = parent_->build_worker_ht_ctx(worker_idx);
+  MemPool* expr_results_pool = parent_->build_worker_expr_results_pool(worker_idx);
   ctx->set_level(level()); // Set the hash function for building the hash table.
   RowBatch batch(parent_->row_desc_, state->batch_size(), parent_->mem_tracker());
-  vector<BufferedTupleStream::FlatRowPtr> flat_rows;
-  bool eos = false;
+  int window_shift;
 
   // Allocate the partition-local hash table. Initialize the number of buckets based on
   // the number of build rows (the number of rows is known at this point). This assumes
@@ -1244,46 +1317,23 @@ Status PhjBuilderPartition::BuildHashTable(bool* built) {
   // TODO: Try to allocate the hash table before pinning the stream to avoid needlessly
   // reading all of the spilled rows from disk when we won't succeed anyway.
   int64_t estimated_num_buckets = HashTable::EstimateNumBuckets(build_rows()->num_rows());
-  hash_tbl_.reset(HashTable::Create(parent_->ht_allocator_.get(),
-      true /* store_duplicates */, parent_->row_desc_->tuple_descriptors().size(),
-      build_rows(), 1 << (32 - PhjBuilder::NUM_PARTITIONING_BITS),
-      estimated_num_buckets));
+  hash_tbl_.reset(HashTable::Create(parent_->hash_table_config_.tagged_probing,
+      parent_->ht_allocator_.get(), true /* store_duplicates */,
+      parent_->row_desc_->tuple_descriptors().size(), build_rows(),
+      1 << (32 - PhjBuilder::NUM_PARTITIONING_BITS), estimated_num_buckets));
   bool success;
   Status status = hash_tbl_->Init(&success);
   if (!status.ok() || !success) goto not_built;
-  status = build_rows_->PrepareForRead(false, &success);
-  if (!status.ok()) goto not_built;
-  DCHECK(success) << "Stream was already pinned.";
 
-  do {
-    status = build_rows_->GetNext(&batch, &eos, &flat_rows);
-    if (!status.ok()) goto not_built;
-    DCHECK_EQ(batch.num_rows(), flat_rows.size());
-    DCHECK_LE(batch.num_rows(), hash_tbl_->EmptyBuckets());
-    TPrefetchMode::type prefetch_mode = state->query_options().prefetch_mode;
-
-    InsertBatchFn insert_batch_fn;
-    if (level() == 0) {
-      insert_batch_fn = parent_->insert_batch_fn_level0_.load();
-    } else {
-      insert_batch_fn = parent_->insert_batch_fn_.load();
-    }
-
-    if (insert_batch_fn != nullptr) {
-      if (UNLIKELY(
-            !insert_batch_fn(this, prefetch_mode, ctx, &batch, flat_rows, &status))) {
-        goto not_built;
-      }
-    } else if (UNLIKELY(!InsertBatch(prefetch_mode, ctx, &batch, flat_rows, &status))) {
-      goto not_built;
-    }
-
-    RETURN_IF_CANCELLED(state);
-    RETURN_IF_ERROR(state->GetQueryStatus());
-    // Free any expr result allocations made while inserting.
-    parent_->expr_results_pool_->Clear();
-    batch.Reset();
-  } while (!eos);
+  // The number of buckets is fixed for the whole build, so the rows can be reordered by
+  // the buckets they hash to if the bucket directory is too large for the cache.
+  window_shift = RadixBuildWindowShift();
+  if (window_shift >= 0) {
+    success = InsertRadixOrder(ctx, expr_results_pool, window_shift, &batch, &status);
+  } else {
+    success = InsertStreamOrder(ctx, expr_results_pool, &batch, &status);
+  }
+  if (!success) goto not_built;
 
   // The hash table fits in memory and is built.
   DCHECK(*built);
@@ -1302,6 +1352,173 @@ not_built:
   return status;
 }
 
+bool PhjBuilderPartition::InsertBatchAnyImpl(HashTableCtx* ctx, RowBatch* batch,
+    const vector<BufferedTupleStream::FlatRowPtr>& flat_rows, Status* status) {
+  TPrefetchMode::type prefetch_mode =
+      parent_->runtime_state_->query_options().prefetch_mode;
+  InsertBatchFn insert_batch_fn;
+  if (level() == 0) {
+    insert_batch_fn = parent_->insert_batch_fn_level0_.load();
+  } else {
+    insert_batch_fn = parent_->insert_batch_fn_.load();
+  }
+  if (insert_batch_fn != nullptr) {
+    return insert_batch_fn(this, prefetch_mode, ctx, batch, flat_rows, status);
+  }
+  return InsertBatch(prefetch_mode, ctx, batch, flat_rows, status);
+}
+
+void PhjBuilderPartition::HashBatchAnyImpl(
+    HashTableCtx* ctx, RowBatch* batch, uint32_t* hashes) {
+  HashBatchFn hash_batch_fn;
+  if (level() == 0) {
+    hash_batch_fn = parent_->hash_batch_fn_level0_.load();
+  } else {
+    hash_batch_fn = parent_->hash_batch_fn_.load();
+  }
+  if (hash_batch_fn != nullptr) {
+    hash_batch_fn(this, ctx, batch, hashes);
+  } else {
+    HashBatch(ctx, batch, hashes);
+  }
+}
+
+bool PhjBuilderPartition::InsertStreamOrder(HashTableCtx* ctx,
+    MemPool* expr_results_pool, RowBatch* batch, Status* status) {
+  RuntimeState* state = parent_->runtime_state_;
+  vector<BufferedTupleStream::FlatRowPtr> flat_rows;
+  bool success;
+  *status = build_rows_->PrepareForRead(false, &success);
+  if (!status->ok()) return false;
+  DCHECK(success) << "Stream was already pinned.";
+
+  bool eos = false;
+  do {
+    *status = build_rows_->GetNext(batch, &eos, &flat_rows);
+    if (!status->ok()) return false;
+    DCHECK_EQ(batch->num_rows(), flat_rows.size());
+    DCHECK_LE(batch->num_rows(), hash_tbl_->EmptyBuckets());
+    if (UNLIKELY(!InsertBatchAnyImpl(ctx, batch, flat_rows, status))) return false;
+
+    if (UNLIKELY(state->is_cancelled())) {
+      *status = Status::CANCELLED;
+      return false;
+    }
+    *status = state->GetQueryStatus();
+    if (!status->ok()) return false;
+    // Free any expr result allocations made while inserting.
+    expr_results_pool->Clear();
+    batch->Reset();
+  } while (!eos);
+  return true;
+}
+
+int PhjBuilderPartition::RadixBuildWindowShift() const {
+  if (!FLAGS_enable_radix_hash_table_build) return -1;
+  // Right after Init() the hash table's memory consists of the bucket directory only.
+  const int64_t directory_bytes = hash_tbl_->CurrentMemSize();
+  if (directory_bytes < FLAGS_radix_hash_table_build_min_bytes) return -1;
+  const int64_t num_buckets = hash_tbl_->num_buckets();
+  DCHECK(BitUtil::IsPowerOf2(num_buckets));
+  const int num_buckets_log2 = BitUtil::Log2Floor64(num_buckets);
+  const int64_t bucket_bytes = directory_bytes / num_buckets;
+  const int64_t window_buckets = RADIX_BUILD_WINDOW_BYTES / bucket_bytes;
+  int window_shift = window_buckets > 1 ? BitUtil::Log2Floor64(window_buckets) : 0;
+  window_shift = max(window_shift, num_buckets_log2 - RADIX_BUILD_MAX_WINDOWS_LOG2);
+  // Reordering is pointless if all buckets fall into the same window.
+  return window_shift < num_buckets_log2 ? window_shift : -1;
+}
+
+bool PhjBuilderPartition::InsertRadixOrder(HashTableCtx* ctx,
+    MemPool* expr_results_pool, int window_shift, RowBatch* batch, Status* status) {
+  RuntimeState* state = parent_->runtime_state_;
+  const int64_t num_rows = build_rows_->num_rows();
+  const int num_windows = hash_tbl_->num_buckets() >> window_shift;
+  DCHECK_GT(num_windows, 1);
+  DCHECK_LE(num_windows, 1 << RADIX_BUILD_MAX_WINDOWS_LOG2);
+  // The window of each row and the rows sorted by window. The memory is only needed for
+  // the duration of the build, so fall back to inserting in stream order rather than
+  // failing the build if it is not available.
+  const int64_t sort_bytes = num_rows * (sizeof(uint16_t)
+      + sizeof(BufferedTupleStream::FlatRowPtr)) + (num_windows + 1) * sizeof(int64_t);
+  if (!parent_->mem_tracker()->TryConsume(sort_bytes)) {
+    return InsertStreamOrder(ctx, expr_results_pool, batch, status);
+  }
+  vector<uint16_t> row_windows(num_rows);
+  vector<BufferedTupleStream::FlatRowPtr> sorted_rows(num_rows);
+  vector<int64_t> window_offsets(num_windows + 1, 0);
+  vector<BufferedTupleStream::FlatRowPtr> flat_rows;
+  vector<uint32_t> hashes(batch->capacity());
+  const uint32_t bucket_mask = hash_tbl_->num_buckets() - 1;
+  bool success = false;
+
+  // Pass 1: hash every row and count the rows per window.
+  int64_t row_idx = 0;
+  bool eos = false;
+  bool pinned;
+  *status = build_rows_->PrepareForRead(false, &pinned);
+  if (!status->ok()) goto done;
+  DCHECK(pinned) << "Stream was already pinned.";
+  do {
+    *status = build_rows_->GetNext(batch, &eos, &flat_rows);
+    if (!status->ok()) goto done;
+    HashBatchAnyImpl(ctx, batch, hashes.data());
+    for (int i = 0; i < batch->num_rows(); ++i) {
+      const uint16_t window = (hashes[i] & bucket_mask) >> window_shift;
+      row_windows[row_idx++] = window;
+      ++window_offsets[window + 1];
+    }
+    expr_results_pool->Clear();
+    batch->Reset();
+  } while (!eos);
+  DCHECK_EQ(row_idx, num_rows);
+  partial_sum(window_offsets.begin(), window_offsets.end(), window_offsets.begin());
+
+  // Pass 2: scatter the rows into window order. Reading the pinned stream again is
+  // cheap: the flat rows point directly into the stream's pages.
+  row_idx = 0;
+  *status = build_rows_->PrepareForRead(false, &pinned);
+  if (!status->ok()) goto done;
+  DCHECK(pinned) << "Stream was already pinned.";
+  do {
+    *status = build_rows_->GetNext(batch, &eos, &flat_rows);
+    if (!status->ok()) goto done;
+    for (BufferedTupleStream::FlatRowPtr flat_row : flat_rows) {
+      sorted_rows[window_offsets[row_windows[row_idx++]]++] = flat_row;
+    }
+    batch->Reset();
+  } while (!eos);
+
+  // Pass 3: insert the rows in window order, a batch at a time.
+  for (int64_t start = 0; start < num_rows; start += batch->capacity()) {
+    const int n = min<int64_t>(batch->capacity(), num_rows - start);
+    flat_rows.assign(sorted_rows.begin() + start, sorted_rows.begin() + start + n);
+    for (int i = 0; i < n; ++i) {
+      build_rows_->GetTupleRow(flat_rows[i], batch->GetRow(i));
+    }
+    batch->CommitRows(n);
+    DCHECK_LE(batch->num_rows(), hash_tbl_->EmptyBuckets());
+    if (UNLIKELY(!InsertBatchAnyImpl(ctx, batch, flat_rows, status))) goto done;
+
+    if (UNLIKELY(state->is_cancelled())) {
+      *status = Status::CANCELLED;
+      goto done;
+    }
+    *status = state->GetQueryStatus();
+    if (!status->ok()) goto done;
+    // Free any expr result allocations made while inserting.
+    expr_results_pool->Clear();
+    batch->Reset();
+  }
+  COUNTER_ADD(parent_->num_radix_ordered_builds_, 1);
+  success = true;
+
+done:
+  batch->Reset();
+  parent_->mem_tracker()->Release(sort_bytes);
+  return success;
+}
+
 std::string PhjBuilderPartition::DebugString() {
   stringstream ss;
   ss << "<Partition>: ptr=" << this << " id=" << id_;
@@ -1354,6 +1571,8 @@ void PhjBuilderConfig::Codegen(FragmentState* state) {
         codegen, hash_fn, murmur_hash_fn, eval_build_row_fn, insert_filters_fn);
     insert_codegen_status = CodegenInsertBatch(
         codegen, hash_fn, murmur_hash_fn, eval_build_row_fn, prefetch_mode);
+    insert_codegen_status.MergeStatus(
+        CodegenHashBatch(codegen, hash_fn, murmur_hash_fn, eval_build_row_fn));
   } else {
     build_codegen_status = codegen_status;
     insert_codegen_status = codegen_status;
@@ -1411,6 +1630,7 @@ Status PhjBuilderConfig::CodegenProcessBuildBatch(LlvmCodeGen* codegen,
   DCHECK_EQ(replaced_constants.stores_duplicates, 0);
   DCHECK_EQ(replaced_constants.stores_tuples, 0);
   DCHECK_EQ(replaced_constants.quadratic_probing, 0);
+  DCHECK_EQ(replaced_constants.tagged_probing, 0);
 
   llvm::Value* is_null_aware_arg = codegen->GetArgument(process_build_batch_fn, 5);
   is_null_aware_arg->replaceAllUsesWith(
@@ -1477,7 +1697,7 @@ Status PhjBuilderConfig::CodegenInsertBatch(LlvmCodeGen* codegen, llvm::Function
   // Replace the parameter 'prefetch_mode' with constant.
   llvm::Value* prefetch_mode_arg = codegen->GetArgument(insert_batch_fn, 1);
   DCHECK_GE(prefetch_mode, TPrefetchMode::NONE);
-  DCHECK_LE(prefetch_mode, TPrefetchMode::HT_BUCKET);
+  DCHECK_LE(prefetch_mode, TPrefetchMode::HT_BUCKET_AND_ROW);
   prefetch_mode_arg->replaceAllUsesWith(codegen->GetI32Constant(prefetch_mode));
 
   // Use codegen'd EvalBuildRow() function
@@ -1499,6 +1719,7 @@ Status PhjBuilderConfig::CodegenInsertBatch(LlvmCodeGen* codegen, llvm::Function
   DCHECK_GE(replaced_constants.stores_duplicates, 1);
   DCHECK_GE(replaced_constants.stores_tuples, 1);
   DCHECK_GE(replaced_constants.quadratic_probing, 1);
+  DCHECK_GE(replaced_constants.tagged_probing, 1);
 
   llvm::Function* insert_batch_fn_level0 = codegen->CloneFunction(insert_batch_fn);
 
@@ -1526,6 +1747,48 @@ Status PhjBuilderConfig::CodegenInsertBatch(LlvmCodeGen* codegen, llvm::Function
   return Status::OK();
 }
 
+Status PhjBuilderConfig::CodegenHashBatch(LlvmCodeGen* codegen, llvm::Function* hash_fn,
+    llvm::Function* murmur_hash_fn, llvm::Function* eval_row_fn) {
+  llvm::Function* hash_batch_fn = codegen->GetFunction(IRFunction::PHJ_HASH_BATCH, true);
+
+  // Use codegen'd EvalBuildRow() function
+  int replaced = codegen->ReplaceCallSites(hash_batch_fn, eval_row_fn, "EvalBuildRow");
+  DCHECK_REPLACE_COUNT(replaced, 1);
+
+  // Replace hash-table parameters with constants.
+  HashTableCtx::HashTableReplacedConstants replaced_constants;
+  const bool stores_duplicates = true;
+  const int num_build_tuples = input_row_desc_->tuple_descriptors().size();
+  RETURN_IF_ERROR(HashTableCtx::ReplaceHashTableConstants(codegen, *hash_table_config_,
+      stores_duplicates, num_build_tuples, hash_batch_fn, &replaced_constants));
+  DCHECK_GE(replaced_constants.stores_nulls, 1);
+
+  llvm::Function* hash_batch_fn_level0 = codegen->CloneFunction(hash_batch_fn);
+
+  // Use codegen'd hash functions
+  replaced = codegen->ReplaceCallSites(hash_batch_fn_level0, hash_fn, "HashRow");
+  DCHECK_REPLACE_COUNT(replaced, 1);
+  replaced = codegen->ReplaceCallSites(hash_batch_fn, murmur_hash_fn, "HashRow");
+  DCHECK_REPLACE_COUNT(replaced, 1);
+
+  hash_batch_fn = codegen->FinalizeFunction(hash_batch_fn);
+  if (hash_batch_fn == nullptr) {
+    return Status(
+        "PhjBuilderConfig::CodegenHashBatch(): codegen'd "
+        "HashBatch() function failed verification, see log");
+  }
+  hash_batch_fn_level0 = codegen->FinalizeFunction(hash_batch_fn_level0);
+  if (hash_batch_fn_level0 == nullptr) {
+    return Status(
+        "PhjBuilderConfig::CodegenHashBatch(): codegen'd zero-level "
+        "HashBatch() function failed verification, see log");
+  }
+
+  codegen->AddFunctionToJit(hash_batch_fn, &hash_batch_fn_);
+  codegen->AddFunctionToJit(hash_batch_fn_level0, &hash_batch_fn_level0_);
+  return Status::OK();
+}
+
 // An example of the generated code for a query with two filters built by this node.
 //
 //  ; Function Attrs: noinline
@@ -51,6 +51,9 @@ class ScalarExprEvaluator;
 typedef bool (*InsertBatchFn)(PhjBuilderPartition*, TPrefetchMode::type, HashTableCtx*,
     RowBatch*, const std::vector<BufferedTupleStream::FlatRowPtr>&, Status*);
 
+/// Method signature of the codegened version of HashBatch().
+typedef void (*HashBatchFn)(PhjBuilderPartition*, HashTableCtx*, RowBatch*, uint32_t*);
+
 /// Partitioned Hash Join Builder Config class. This has a few extra methods to be used
 /// directly by the PartitionedHashJoinPlanNode. Since it is expected to only be created
 /// and used by PartitionedHashJoinPlanNode only, the DataSinkConfig::Init() and
@@ -119,6 +122,10 @@ class PhjBuilderConfig : public JoinBuilderConfig {
   CodegenFnPtr<InsertBatchFn> insert_batch_fn_;
   CodegenFnPtr<InsertBatchFn> insert_batch_fn_level0_;
 
+  /// Jitted Partition::HashBatch() function pointers. NULL if codegen is disabled.
+  CodegenFnPtr<HashBatchFn> hash_batch_fn_;
+  CodegenFnPtr<HashBatchFn> hash_batch_fn_level0_;
+
  protected:
   /// Initialization for separate sink.
   Status Init(const TDataSink& tsink, const RowDescriptor* input_row_desc,
@@ -153,6 +160,11 @@ class PhjBuilderConfig : public JoinBuilderConfig {
       llvm::Function* murmur_hash_fn, llvm::Function* eval_row_fn,
       TPrefetchMode::type prefetch_mode);
 
+  /// Codegen hashing batches for the radix-ordered hash table build. Identical
+  /// signature to Partition::HashBatch(). Returns non-OK if codegen was not possible.
+  Status CodegenHashBatch(LlvmCodeGen* codegen, llvm::Function* hash_fn,
+      llvm::Function* murmur_hash_fn, llvm::Function* eval_row_fn);
+
   /// Codegen inserting rows into runtime filters. Identical signature to
   /// InsertRuntimeFilters(). Returns non-OK if codegen was not possible.
   Status CodegenInsertRuntimeFilters(LlvmCodeGen* codegen,
@@ -217,8 +229,10 @@ class PhjBuilderPartition {
   /// Build rows cannot be added after calling this. If the build rows could not be
   /// pinned or the hash table could not be built due to memory pressure, sets *built
   /// to false and returns OK. Returns an error status if any other error is
-  /// encountered.
-  Status BuildHashTable(bool* built) WARN_UNUSED_RESULT;
+  /// encountered. 'worker_idx' selects the parent's hash table context and expr results
+  /// pool to use, see PhjBuilder::BuildHashTablesInParallel(). Partitions of the same
+  /// parent can be built concurrently with different 'worker_idx' values.
+  Status BuildHashTable(bool* built, int worker_idx = 0) WARN_UNUSED_RESULT;
 
   /// Spills this partition, the partition's stream is unpinned with 'mode' and
   /// its hash table is destroyed if it was built. Calling with 'mode' UNPIN_ALL
@@ -262,6 +276,47 @@ class PhjBuilderPartition {
       RowBatch* batch, const std::vector<BufferedTupleStream::FlatRowPtr>& flat_rows,
       Status* status);
 
+  /// Evaluates the build exprs of each row in 'batch' and stores its hash in 'hashes',
+  /// which must have space for all rows. The hash of rows that are not inserted into
+  /// the hash table because of NULL values is unspecified. This function may be replaced
+  /// with a codegen'd version.
+  void HashBatch(HashTableCtx* ctx, RowBatch* batch, uint32_t* hashes);
+
+  /// Calls the codegen'd InsertBatch() or HashBatch() for this partition's level if
+  /// available, or the interpreted version otherwise.
+  bool InsertBatchAnyImpl(HashTableCtx* ctx, RowBatch* batch,
+      const std::vector<BufferedTupleStream::FlatRowPtr>& flat_rows, Status* status);
+  void HashBatchAnyImpl(HashTableCtx* ctx, RowBatch* batch, uint32_t* hashes);
+
+  /// Helpers for BuildHashTable() that insert all rows of the pinned 'build_rows_' into
+  /// 'hash_tbl_'. 'batch' is a scratch batch. Expr result allocations are made from
+  /// 'expr_results_pool'. Return true on success. On failure, 'status' is set like in
+  /// InsertBatch(): OK if there was not enough reservation.
+  ///
+  /// InsertStreamOrder() inserts the rows in the order in which they are stored.
+  /// InsertRadixOrder() first counting-sorts the rows by the window of
+  /// 2^'window_shift' buckets that they hash to, then inserts them window after window
+  /// so that the bucket writes of consecutive inserts hit a cache-resident part of a
+  /// bucket directory that is much larger than the cache. Falls back to
+  /// InsertStreamOrder() if the memory for sorting could not be allocated.
+  bool InsertStreamOrder(HashTableCtx* ctx, MemPool* expr_results_pool, RowBatch* batch,
+      Status* status);
+  bool InsertRadixOrder(HashTableCtx* ctx, MemPool* expr_results_pool, int window_shift,
+      RowBatch* batch, Status* status);
+
+  /// Returns the log2 of the number of buckets per window for a radix-ordered build of
+  /// 'hash_tbl_', or -1 if the rows should be inserted in stream order. See
+  /// RADIX_BUILD_WINDOW_BYTES.
+  int RadixBuildWindowShift() const;
+
+  /// Target size in bytes of the bucket directory range (buckets, hashes and tags) that a
+  /// radix-ordered build writes to at a time. Chosen to fit comfortably in the L2 cache.
+  static constexpr int64_t RADIX_BUILD_WINDOW_BYTES = 256 * 1024;
+
+  /// Maximum number of windows of a radix-ordered build. Window indices are stored as
+  /// 16-bit values.
+  static constexpr int RADIX_BUILD_MAX_WINDOWS_LOG2 = 16;
+
   const PhjBuilder* parent_;
 
   /// Id for this partition that is unique within the builder.
@@ -647,6 +702,22 @@ class PhjBuilder : public JoinBuilder {
   /// tables, either PARTITIONING_PROBE or REPARTITIONING_PROBE.
   Status BuildHashTablesAndReserveProbeBuffers(HashJoinState next_state);
 
+  /// Builds the hash tables of the in-memory partitions in 'hash_partitions_' with
+  /// 'num_build_workers_' workers that each take the next unbuilt partition until all
+  /// are built. Partitions whose hash table could not be built because of memory
+  /// pressure are spilled after all workers are done, since spilling uses the buffer
+  /// pool client, which the workers share.
+  Status BuildHashTablesInParallel();
+
+  /// Returns the hash table context and expr results pool of build worker 'worker_idx'.
+  HashTableCtx* build_worker_ht_ctx(int worker_idx) const {
+    return worker_idx == 0 ? ht_ctx_.get() : build_worker_ht_ctxs_[worker_idx - 1];
+  }
+  MemPool* build_worker_expr_results_pool(int worker_idx) const {
+    return worker_idx == 0 ? expr_results_pool_.get() :
+                             build_worker_expr_results_pools_[worker_idx - 1];
+  }
+
   /// Ensures that 'probe_stream_reservation_' has enough reservation for a stream per
   /// spilled partition in 'hash_partitions_', plus for the input stream if the input
   /// is a spilled partition (determined by 'next_state' - either PARTITIONING_PROBE or
@@ -790,6 +861,17 @@ class PhjBuilder : public JoinBuilder {
   /// The level is set to the same level as 'hash_partitions_'.
   boost::scoped_ptr<HashTableCtx> ht_ctx_;
 
+  /// Number of workers that build the hash tables of the partitions in parallel. More
+  /// than one only for a separate build shared by multiple probe-side fragment instances
+  /// with the HASH_JOIN_PARALLEL_BUILD query option. Set in Prepare().
+  int num_build_workers_ = 1;
+
+  /// Hash table contexts and expr results pools of the build workers other than worker
+  /// 0, which uses 'ht_ctx_' and 'expr_results_pool_'. Entry i is used by worker i + 1.
+  /// Owned by 'obj_pool_'.
+  std::vector<HashTableCtx*> build_worker_ht_ctxs_;
+  std::vector<MemPool*> build_worker_expr_results_pools_;
+
   /// Counters and profile objects for HashTable stats
   std::unique_ptr<HashTableStatsProfile> ht_stats_profile_;
 
@@ -819,6 +901,10 @@ class PhjBuilder : public JoinBuilder {
   /// hash table.
   RuntimeProfile::Counter* num_hash_table_builds_skipped_ = nullptr;
 
+  /// Number of hash tables whose rows were inserted in bucket order because the bucket
+  /// directory was larger than --radix_hash_table_build_min_bytes.
+  RuntimeProfile::Counter* num_radix_ordered_builds_ = nullptr;
+
   /// Time spent repartitioning and building hash tables of any resulting partitions
   /// that were not spilled.
   RuntimeProfile::Counter* repartition_timer_ = nullptr;
@@ -900,6 +986,10 @@ class PhjBuilder : public JoinBuilder {
   /// Jitted Partition::InsertBatch() function pointers. NULL if codegen is disabled.
   const CodegenFnPtr<InsertBatchFn>& insert_batch_fn_;
   const CodegenFnPtr<InsertBatchFn>& insert_batch_fn_level0_;
+
+  /// Jitted Partition::HashBatch() function pointers. NULL if codegen is disabled.
+  const CodegenFnPtr<HashBatchFn>& hash_batch_fn_;
+  const CodegenFnPtr<HashBatchFn>& hash_batch_fn_level0_;
 };
 } // namespace impala
 #endif
@@ -363,6 +363,20 @@ void IR_ALWAYS_INLINE PartitionedHashJoinNode::EvalAndHashProbePrefetchGroup(
   expr_vals_cache->ResetForRead();
 }
 
+void IR_ALWAYS_INLINE PartitionedHashJoinNode::PrefetchProbeGroupBuildRows(
+    HashTableCtx* ht_ctx) {
+  HashTableCtx::ExprValuesCache* expr_vals_cache = ht_ctx->expr_values_cache();
+  for (; !expr_vals_cache->AtEnd(); expr_vals_cache->NextRow()) {
+    if (expr_vals_cache->IsRowNull()) continue;
+    uint32_t hash = expr_vals_cache->CurExprValuesHash();
+    const uint32_t partition_idx = hash >> (32 - NUM_PARTITIONING_BITS);
+    HashTable* hash_tbl = hash_tbls_[partition_idx];
+    if (LIKELY(hash_tbl != NULL)) hash_tbl->PrefetchBuildRow(hash);
+  }
+  // Rewind for the probe pass. The end of the group stays where it is.
+  expr_vals_cache->ResetForRead();
+}
+
 // CreateOutputRow, EvalOtherJoinConjuncts, and EvalConjuncts are replaced by codegen.
 template <int const JoinOp>
 int PartitionedHashJoinNode::ProcessProbeBatch(TPrefetchMode::type prefetch_mode,
@@ -400,8 +414,14 @@ int PartitionedHashJoinNode::ProcessProbeBatch(TPrefetchMode::type prefetch_mode
     // group is partially full (e.g. we returned before the current prefetch group was
     // exhausted in the previous iteration), we will proceed with the remaining items in
     // the values cache.
+    // With HT_BUCKET_AND_ROW, the group is processed in stages: evaluate, hash and
+    // prefetch the buckets of all rows, then prefetch the build rows of all rows, then
+    // probe and emit each row.
     if (expr_vals_cache->AtEnd()) {
       EvalAndHashProbePrefetchGroup(prefetch_mode, ht_ctx);
+      if (prefetch_mode == TPrefetchMode::HT_BUCKET_AND_ROW) {
+        PrefetchProbeGroupBuildRows(ht_ctx);
+      }
     }
     // Process the prefetch group.
     do {
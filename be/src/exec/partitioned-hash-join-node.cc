@@ -81,7 +81,7 @@ Status PartitionedHashJoinPlanNode::Init(
 
   hash_table_config_ = state->obj_pool()->Add(new HashTableConfig(build_exprs_,
       probe_exprs_, PhjBuilder::HashTableStoresNulls(join_op_, is_not_distinct_from_),
-      is_not_distinct_from_));
+      is_not_distinct_from_, state->query_options().hash_table_tagged_probing));
 
   // Create the config always. It is only used if UseSeparateBuild() is true, but in
   // Init(), IsInSubplan() isn't available yet.
@@ -1452,7 +1452,7 @@ Status PartitionedHashJoinPlanNode::CodegenProcessProbeBatch(
   // Replace the parameter 'prefetch_mode' with constant.
   llvm::Value* prefetch_mode_arg = codegen->GetArgument(process_probe_batch_fn, 1);
   DCHECK_GE(prefetch_mode, TPrefetchMode::NONE);
-  DCHECK_LE(prefetch_mode, TPrefetchMode::HT_BUCKET);
+  DCHECK_LE(prefetch_mode, TPrefetchMode::HT_BUCKET_AND_ROW);
   prefetch_mode_arg->replaceAllUsesWith(codegen->GetI32Constant(prefetch_mode));
 
   // Codegen HashTable::Equals
@@ -1532,6 +1532,7 @@ Status PartitionedHashJoinPlanNode::CodegenProcessProbeBatch(
   DCHECK_GE(replaced_constants.stores_duplicates, 1);
   DCHECK_GE(replaced_constants.stores_tuples, 1);
   DCHECK_GE(replaced_constants.quadratic_probing, 1);
+  DCHECK_GE(replaced_constants.tagged_probing, 1);
 
   llvm::Function* process_probe_batch_fn_level0 =
       codegen->CloneFunction(process_probe_batch_fn);
@@ -389,6 +389,14 @@ class PartitionedHashJoinNode : public BlockingJoinNode {
   void EvalAndHashProbePrefetchGroup(TPrefetchMode::type prefetch_mode,
       HashTableCtx* ctx);
 
+  /// Second pass over the prefetch group that was just filled by
+  /// EvalAndHashProbePrefetchGroup(), used with the HT_BUCKET_AND_ROW prefetch mode. By
+  /// now the buckets of the group are expected to be in the cache, so this prefetches
+  /// the build rows that the probe rows of the group will be compared against. The rows
+  /// are then probed and the output is emitted one row at a time as usual, without
+  /// waiting on a cache miss for every build row.
+  void PrefetchProbeGroupBuildRows(HashTableCtx* ctx);
+
   /// Find the next probe row. Returns true if a probe row is found. In which case,
   /// 'current_probe_row_' and 'hash_tbl_iterator_' have been set up to point to the
   /// next probe row and its corresponding partition. 'status' may be updated if
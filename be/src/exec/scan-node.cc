@@ -215,6 +215,9 @@ bool ScanNode::WaitForRuntimeFilters() {
   int32_t max_arrival_delay = 0;
   int64_t start = MonotonicMillis();
   for (auto& ctx: filter_ctxs_) {
+    // Top-N filters are produced from the rows returned by this scan, so waiting for
+    // them would only delay the scan. They are picked up whenever they arrive.
+    if (ctx.filter->is_topn_filter()) continue;
     string filter_id = Substitute("$0", ctx.filter->id());
     if (ctx.filter->WaitForArrival(wait_time_ms)) {
       arrived_filter_ids.push_back(filter_id);
@@ -227,7 +230,7 @@ bool ScanNode::WaitForRuntimeFilters() {
   const string& wait_time = PrettyPrinter::Print(end - start, TUnit::TIME_MS);
   const string& arrival_delay = PrettyPrinter::Print(max_arrival_delay, TUnit::TIME_MS);
 
-  if (arrived_filter_ids.size() == filter_ctxs_.size()) {
+  if (missing_filter_ids.empty()) {
     runtime_profile()->AddInfoString("Runtime filters",
         Substitute("All filters arrived. Waited $0. Maximum arrival delay: $1.",
                                          wait_time, arrival_delay));
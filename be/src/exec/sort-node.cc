@@ -81,7 +81,7 @@ Status SortNode::Prepare(RuntimeState* state) {
   sorter_.reset(new Sorter(tuple_row_comparator_config_, sort_tuple_exprs_,
       &row_descriptor_, mem_tracker(), buffer_pool_client(),
       resource_profile_.spillable_buffer_size, runtime_profile(), state, label(), true,
-      pnode.codegend_sort_helper_fn_, pnode.codegend_heapify_helper_fn_,
+      pnode.codegend_sort_helper_fn_, pnode.codegend_replay_helper_fn_,
       ComputeInputSizeEstimate()));
   RETURN_IF_ERROR(sorter_->Prepare(pool_));
   DCHECK_GE(resource_profile_.min_reservation, sorter_->ComputeMinReservation());
@@ -118,7 +118,7 @@ void SortPlanNode::Codegen(FragmentState* state) {
   }
   if (codegen_status.ok()) {
     codegen_status =
-        SortedRunMerger::Codegen(state, compare_fn, &codegend_heapify_helper_fn_);
+        SortedRunMerger::Codegen(state, compare_fn, &codegend_replay_helper_fn_);
   }
   AddCodegenStatus(codegen_status);
 }
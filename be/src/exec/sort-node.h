@@ -48,8 +48,8 @@ class SortPlanNode : public PlanNode {
   /// Codegened version of Sorter::TupleSorter::SortHelper().
   CodegenFnPtr<Sorter::SortHelperFn> codegend_sort_helper_fn_;
 
-  /// Codegened version of SortedRunMerger::HeapifyHelper().
-  CodegenFnPtr<SortedRunMerger::HeapifyHelperFn> codegend_heapify_helper_fn_;
+  /// Codegened version of SortedRunMerger::ReplayHelper().
+  CodegenFnPtr<SortedRunMerger::ReplayHelperFn> codegend_replay_helper_fn_;
 };
 
 /// Node that implements a full sort of its input with a fixed memory budget, spilling
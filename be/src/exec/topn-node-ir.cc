@@ -19,6 +19,7 @@
 
 #include "common/compiler-util.h"
 #include "util/debug-util.h"
+#include "util/sort-key-normalizer.h"
 
 #include "common/names.h"
 
@@ -57,21 +58,48 @@ int TopNNode::Heap::InsertTupleRow(TopNNode* node, TupleRow* input_row) {
   Tuple* top_tuple = priority_queue_.Top();
   node->tmp_tuple_->MaterializeExprs<false, true>(input_row, tuple_desc,
       node->output_tuple_expr_evals_, nullptr);
+  // A tuple whose normalized key is greater than the key of the top tuple is greater
+  // than the top tuple, so it can be rejected without invoking the comparator.
+  int key_cmp = CompareWithThresholdKey(node, node->tmp_tuple_);
+  if (key_cmp > 0) {
+    ++node->num_key_threshold_rejected_;
+    return 0;
+  }
   if (include_ties()) {
     return InsertTupleWithTieHandling(*node->order_cmp_, node, node->tmp_tuple_);
   } else {
-    if (node->order_cmp_->Less(node->tmp_tuple_, top_tuple)) {
+    if (key_cmp == 0 && key_normalizer_ != nullptr && key_normalizer_->is_complete()) {
+      // Equal complete keys imply a tie with the top tuple.
+      ++node->num_key_threshold_rejected_;
+      return 0;
+    }
+    if (key_cmp < 0 || node->order_cmp_->Less(node->tmp_tuple_, top_tuple)) {
       // Pop off the old head, and replace with the new tuple. Deep copy into 'top_tuple'
       // to reuse the fixed-length memory of 'top_tuple'.
       node->tmp_tuple_->DeepCopy(top_tuple, tuple_desc, node->tuple_pool_.get());
       // Re-heapify from the top element and down.
       priority_queue_.HeapifyFromTop();
+      threshold_key_valid_ = false;
       return 1;
     }
     return 0;
   }
 }
 
+int TopNNode::Heap::CompareWithThresholdKey(
+    TopNNode* node, const Tuple* materialized_tuple) {
+  if (key_normalizer_ == nullptr) return 0;
+  DCHECK_EQ(capacity_, priority_queue_.Size());
+  int key_len = key_normalizer_->key_len();
+  if (UNLIKELY(!threshold_key_valid_)) {
+    key_normalizer_->Encode(priority_queue_.Top(), threshold_key_.data());
+    threshold_key_valid_ = true;
+  }
+  uint8_t* key = node->tmp_key_.data();
+  key_normalizer_->Encode(materialized_tuple, key);
+  return SortKeyNormalizer::Compare(key, threshold_key_.data(), key_len);
+}
+
 int TopNNode::Heap::InsertTupleWithTieHandling(
     const TupleRowComparator& cmp, TopNNode* node, Tuple* materialized_tuple) {
   DCHECK(include_ties());
@@ -98,6 +126,7 @@ int TopNNode::Heap::InsertTupleWithTieHandling(
     // 'materialized_tuple' needs to be added. Figure out which other tuples, if any,
     // need to be removed from the heap.
     DCHECK_LT(cmp_result, 0);
+    threshold_key_valid_ = false;
     // Pop off the head.
     priority_queue_.Pop();
 
@@ -139,7 +168,8 @@ void TopNNode::InsertBatchPartitioned(RuntimeState* state, RowBatch* batch) {
       // Allocate the heap here, but insert in into partition_heaps_ later once we've
       // initialized the tuple that will be the key.
       new_heap =
-          new Heap(*intra_partition_order_cmp_, per_partition_limit(), include_ties());
+          new Heap(*intra_partition_order_cmp_, per_partition_limit(), include_ties(),
+              key_normalizer_);
       heap = new_heap;
       COUNTER_ADD(in_mem_heap_created_counter_, 1);
     } else {
@@ -172,15 +202,28 @@ void TopNNode::Heap::InsertMaterializedTuple(
   // we need to insert this row into the heap.
   DCHECK(!priority_queue_.Empty());
   Tuple* top_tuple = priority_queue_.Top();
+  int key_cmp = CompareWithThresholdKey(node, materialized_tuple);
+  if (key_cmp > 0) {
+    ++num_tuples_discarded_;
+    ++node->num_key_threshold_rejected_;
+    return;
+  }
   if (!include_ties()) {
     ++num_tuples_discarded_; // One of the tuples will be discarded.
-    int cmp_result =
-        node->intra_partition_order_cmp_->Compare(materialized_tuple, top_tuple);
-    if (cmp_result >= 0) return;
+    if (key_cmp == 0 && key_normalizer_ != nullptr && key_normalizer_->is_complete()) {
+      ++node->num_key_threshold_rejected_;
+      return;
+    }
+    if (key_cmp == 0) {
+      int cmp_result =
+          node->intra_partition_order_cmp_->Compare(materialized_tuple, top_tuple);
+      if (cmp_result >= 0) return;
+    }
     // Pop off the old head, and replace with the new tuple. Reuse the fixed-length
     // memory of 'top_tuple' to reduce allocations.
     materialized_tuple->DeepCopy(top_tuple, tuple_desc, node->tuple_pool_.get());
     priority_queue_.HeapifyFromTop();
+    threshold_key_valid_ = false;
     return;
   }
   num_tuples_discarded_ += InsertTupleWithTieHandling(
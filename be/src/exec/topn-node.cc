@@ -29,14 +29,18 @@
 #include "runtime/fragment-state.h"
 #include "runtime/mem-pool.h"
 #include "runtime/mem-tracker.h"
+#include "runtime/raw-value.h"
 #include "runtime/row-batch.h"
+#include "runtime/runtime-filter-bank.h"
 #include "runtime/runtime-state.h"
 #include "runtime/sorter.h"
 #include "runtime/sorter-internal.h" // For TupleSorter
 #include "runtime/tuple-row.h"
 #include "runtime/tuple.h"
 #include "util/debug-util.h"
+#include "util/min-max-filter.h"
 #include "util/runtime-profile-counters.h"
+#include "util/sort-key-normalizer.h"
 #include "util/tuple-row-compare.h"
 
 #include "gen-cpp/Exprs_types.h"
@@ -59,6 +63,14 @@ DEFINE_int64(partitioned_topn_soft_limit_bytes, 64L * 1024L * 1024L, "(Experimen
     "Soft limit on the number of in-memory partitions in an instance of the "
     "partitioned top-n operator.");
 
+DEFINE_bool(enable_topn_key_threshold, true, "(Advanced) If true, full top-n heaps keep "
+    "the normalized key of their top tuple and reject input tuples with greater keys "
+    "without invoking the comparator.");
+
+// Upper bound on the number of input batches between two publications of the Top-N
+// filters of a node.
+static const int64_t MAX_TOPN_FILTER_PUBLISH_INTERVAL = 64;
+
 Status TopNPlanNode::Init(const TPlanNode& tnode, FragmentState* state) {
   const TSortInfo& tsort_info = tnode.sort_node.sort_info;
   RETURN_IF_ERROR(PlanNode::Init(tnode, state));
@@ -100,17 +112,45 @@ Status TopNPlanNode::Init(const TPlanNode& tnode, FragmentState* state) {
       RETURN_IF_ERROR(slot_ref->Init(*row_descriptor_, true, state));
     }
   }
+  if (!is_partitioned() && tnode.__isset.runtime_filters) {
+    RETURN_IF_ERROR(InitTopNFilters(tnode, state));
+  }
   DCHECK_EQ(conjuncts_.size(), 0) << "TopNNode should never have predicates to evaluate.";
   state->CheckAndAddCodegenDisabledMessage(codegen_status_msgs_);
   return Status::OK();
 }
 
+Status TopNPlanNode::InitTopNFilters(const TPlanNode& tnode, FragmentState* state) {
+  // Skip over filters that are not produced by the instances of this node. We can pick
+  // any instance since the filters produced are the same for all instances.
+  const vector<const TPlanFragmentInstanceCtx*>& instance_ctxs = state->instance_ctxs();
+  if (instance_ctxs.empty()) return Status::OK();
+  const vector<TRuntimeFilterSource>& filters_produced =
+      instance_ctxs[0]->filters_produced;
+  for (const TRuntimeFilterDesc& filter_desc : tnode.runtime_filters) {
+    DCHECK(filter_desc.is_topn_filter);
+    DCHECK_EQ(filter_desc.type, TRuntimeFilterType::MIN_MAX);
+    auto it = std::find_if(filters_produced.begin(), filters_produced.end(),
+        [&tnode, &filter_desc](const TRuntimeFilterSource& f) {
+          return f.src_node_id == tnode.node_id && f.filter_id == filter_desc.filter_id;
+        });
+    if (it == filters_produced.end()) continue;
+    filter_descs_.push_back(filter_desc);
+    ScalarExpr* filter_expr = nullptr;
+    RETURN_IF_ERROR(
+        ScalarExpr::Create(filter_desc.src_expr, *row_descriptor_, state, &filter_expr));
+    filter_exprs_.push_back(filter_expr);
+  }
+  return Status::OK();
+}
+
 void TopNPlanNode::Close() {
   ScalarExpr::Close(ordering_exprs_);
   ScalarExpr::Close(partition_exprs_);
   ScalarExpr::Close(intra_partition_ordering_exprs_);
   ScalarExpr::Close(output_tuple_exprs_);
   ScalarExpr::Close(noop_tuple_exprs_);
+  ScalarExpr::Close(filter_exprs_);
   PlanNode::Close();
 }
 
@@ -189,6 +229,17 @@ Status TopNNode::Prepare(RuntimeState* state) {
 
   // Set up heaps and sorters for the partitioned and non-partitioned cases.
   const TopNPlanNode& pnode = static_cast<const TopNPlanNode&>(plan_node_);
+  if (FLAGS_enable_topn_key_threshold) {
+    key_normalizer_ = SortKeyNormalizer::Create(is_partitioned() ?
+            *pnode.intra_partition_comparator_config_ :
+            *pnode.ordering_comparator_config_,
+        Sorter::TupleSorter::MAX_NORMALIZED_KEY_LEN, true, pool_);
+  }
+  if (key_normalizer_ != nullptr) {
+    tmp_key_.resize(key_normalizer_->key_len());
+    key_threshold_rejected_counter_ = ADD_COUNTER(runtime_profile(),
+        "RowsRejectedByKeyThreshold", TUnit::UNIT);
+  }
   if (is_partitioned()) {
     DCHECK_GT(per_partition_limit(), 0)
         << "Planner should not generate partitioned top-n with 0 limit";
@@ -200,7 +251,19 @@ Status TopNNode::Prepare(RuntimeState* state) {
     RETURN_IF_ERROR(sorter_->Prepare(pool_));
     DCHECK_GE(resource_profile_.min_reservation, sorter_->ComputeMinReservation());
   } else {
-    heap_.reset(new Heap(*order_cmp_, pnode.heap_capacity(), pnode.include_ties()));
+    heap_.reset(new Heap(*order_cmp_, pnode.heap_capacity(), pnode.include_ties(),
+        key_normalizer_));
+    for (int i = 0; i < pnode.filter_exprs_.size(); ++i) {
+      filter_ctxs_.emplace_back();
+      FilterContext& ctx = filter_ctxs_.back();
+      ctx.filter = state->filter_bank()->RegisterProducer(pnode.filter_descs_[i]);
+      RETURN_IF_ERROR(ScalarExprEvaluator::Create(*pnode.filter_exprs_[i], state, pool_,
+          expr_perm_pool(), expr_results_pool(), &ctx.expr_eval));
+    }
+    if (!filter_ctxs_.empty()) {
+      topn_filter_updates_counter_ =
+          ADD_COUNTER(runtime_profile(), "TopNFilterUpdates", TUnit::UNIT);
+    }
   }
   return Status::OK();
 }
@@ -320,6 +383,9 @@ Status TopNNode::Open(RuntimeState* state) {
   RETURN_IF_ERROR(
       order_cmp_->Open(pool_, state, expr_perm_pool(), expr_results_pool()));
   RETURN_IF_ERROR(ScalarExprEvaluator::Open(output_tuple_expr_evals_, state));
+  for (const FilterContext& ctx : filter_ctxs_) {
+    RETURN_IF_ERROR(ctx.expr_eval->Open(state));
+  }
   if (is_partitioned()) {
     // Set up state required by partitioned top-N implementation. Claim reservation
     // after the child has been opened to reduce the peak reservation requirement.
@@ -355,7 +421,12 @@ Status TopNNode::Open(RuntimeState* state) {
         } else {
           InsertBatchUnpartitioned(state, &batch);
         }
+        if (num_key_threshold_rejected_ != 0) {
+          COUNTER_ADD(key_threshold_rejected_counter_, num_key_threshold_rejected_);
+          num_key_threshold_rejected_ = 0;
+        }
         DCHECK(is_partitioned() || heap_->DCheckConsistency());
+        if (!filter_ctxs_.empty()) PublishTopNFilters(state);
         if (is_partitioned()) {
           if (partition_heaps_.size() > FLAGS_partitioned_topn_in_mem_partitions_limit ||
             tuple_pool_->total_reserved_bytes() >
@@ -530,9 +601,49 @@ void TopNNode::Close(RuntimeState* state) {
   if (sorter_ != nullptr) sorter_->Close(state);
   sort_out_batch_.reset();
   ScalarExprEvaluator::Close(output_tuple_expr_evals_, state);
+  for (const FilterContext& ctx : filter_ctxs_) {
+    if (ctx.expr_eval != nullptr) ctx.expr_eval->Close(state);
+  }
   ExecNode::Close(state);
 }
 
+void TopNNode::PublishTopNFilters(RuntimeState* state) {
+  DCHECK(!is_partitioned());
+  if (heap_->num_tuples() < heap_->heap_capacity()) return;
+  if (--batches_until_filter_publish_ > 0) return;
+  Tuple* top_tuple = const_cast<Tuple*>(heap_->top());
+  TupleRow* top_row = reinterpret_cast<TupleRow*>(&top_tuple);
+  bool published = false;
+  for (FilterContext& ctx : filter_ctxs_) {
+    const void* value = ctx.expr_eval->GetValue(top_row);
+    // Top-N filters are only planned for orderings with NULLS LAST, so a NULL top means
+    // that there is no bound yet.
+    if (value == nullptr) continue;
+    const ColumnType& type = ctx.expr_eval->root().type();
+    bool is_le = ctx.filter->getCompareOp() == extdatasource::TComparisonOp::LE;
+    DCHECK(is_le || ctx.filter->getCompareOp() == extdatasource::TComparisonOp::GE);
+    const MinMaxFilter* last_filter = ctx.local_min_max_filter;
+    if (last_filter != nullptr && !last_filter->AlwaysTrue()) {
+      int cmp = RawValue::Compare(
+          value, is_le ? last_filter->GetMax() : last_filter->GetMin(), type);
+      if (is_le ? cmp >= 0 : cmp <= 0) continue;
+    }
+    MinMaxFilter* filter =
+        state->filter_bank()->AllocateScratchMinMaxFilter(ctx.filter->id(), type);
+    if (filter == nullptr) continue;
+    ctx.local_min_max_filter = filter;
+    ctx.InsertPerCompareOp(top_row);
+    state->filter_bank()->PublishTopNFilterFromLocal(ctx.filter->id(), filter);
+    COUNTER_ADD(topn_filter_updates_counter_, 1);
+    published = true;
+  }
+  if (published) {
+    filter_publish_interval_ =
+        min(2 * filter_publish_interval_, MAX_TOPN_FILTER_PUBLISH_INTERVAL);
+  }
+  batches_until_filter_publish_ = filter_publish_interval_;
+}
+
 Status TopNNode::EvictPartitions(RuntimeState* state, bool evict_final) {
   DCHECK(is_partitioned());
   vector<unique_ptr<Heap>> heaps_to_evict;
@@ -744,12 +855,17 @@ void TopNNode::DebugString(int indentation_level, stringstream* out) const {
   *out << ")";
 }
 
-TopNNode::Heap::Heap(const TupleRowComparator& c, int64_t capacity, bool include_ties) :
-    capacity_(capacity), include_ties_(include_ties), priority_queue_(c) {}
+TopNNode::Heap::Heap(const TupleRowComparator& c, int64_t capacity, bool include_ties,
+    const SortKeyNormalizer* key_normalizer) :
+    capacity_(capacity), include_ties_(include_ties), key_normalizer_(key_normalizer),
+    priority_queue_(c) {
+  if (key_normalizer_ != nullptr) threshold_key_.resize(key_normalizer_->key_len());
+}
 
 void TopNNode::Heap::Reset() {
   priority_queue_.Clear();
   overflowed_ties_.clear();
+  threshold_key_valid_ = false;
 }
 
 void TopNNode::Heap::Close() {
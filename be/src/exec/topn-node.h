@@ -19,10 +19,12 @@
 
 #include <memory>
 #include <queue>
+#include <vector>
 
 #include "codegen/codegen-fn-ptr.h"
 #include "codegen/impala-ir.h"
 #include "exec/exec-node.h"
+#include "exec/filter-context.h"
 #include "runtime/descriptors.h"  // for TupleId
 #include "runtime/sorter.h"
 #include "util/tuple-row-compare.h"
@@ -32,6 +34,7 @@ namespace impala {
 
 class MemPool;
 class RuntimeState;
+class SortKeyNormalizer;
 class Sorter;
 class TopNNode;
 class Tuple;
@@ -97,6 +100,11 @@ class TopNPlanNode : public PlanNode {
   /// no-ops. Non-empty if this is a partitioned top N.
   std::vector<ScalarExpr*> noop_tuple_exprs_;
 
+  /// Top-N filters produced by this node and the exprs over the output tuple that they
+  /// are built from, one per filter. Only non-empty for unpartitioned Top-N.
+  std::vector<TRuntimeFilterDesc> filter_descs_;
+  std::vector<ScalarExpr*> filter_exprs_;
+
   /// Config used to create a TupleRowComparator instance for 'ordering_exprs_'.
   TupleRowComparatorConfig* ordering_comparator_config_ = nullptr;
 
@@ -108,6 +116,10 @@ class TopNPlanNode : public PlanNode {
   /// 'intra_partition_ordering_exprs_'.
   TupleRowComparatorConfig* intra_partition_comparator_config_ = nullptr;
 
+  /// Initializes 'filter_descs_' and 'filter_exprs_' from the runtime filters in
+  /// 'tnode' that the instances of this node produce.
+  Status InitTopNFilters(const TPlanNode& tnode, FragmentState* state);
+
   /// Codegened version of TopNNode::InsertBatchUnpartitioned() or
   /// InsertBatchPartitioned().
   typedef void (*InsertBatchFn)(TopNNode*, RuntimeState*, RowBatch*);
@@ -170,6 +182,15 @@ class TopNPlanNode : public PlanNode {
 /// threshold, which indicates that enough unused memory may have accumulated to
 /// be worth reclaiming.
 ///
+/// Top-N Filters
+/// =============
+/// Once the heap of an unpartitioned Top-N is full, no input row that sorts after its
+/// top can make it into the output. If the planner assigned Top-N filters to this node,
+/// the value of the leading ordering expr of the top tuple is published as a min/max
+/// filter to the scans in the same fragment, which use it to skip row groups, pages and
+/// rows. The filter is republished whenever the bound tightens, at most once every
+/// 'filter_publish_interval_' input batches.
+///
 /// In partitioned mode, reclamation is triggered by a memory threshold, after which
 /// some in-memory heaps are evicted and the remaining heaps reclaimed. The reclamation
 /// thus serves two purposes: to support spilling-to-disk where we can't fit all
@@ -247,6 +268,11 @@ class TopNNode : public ExecNode {
   /// initializes 'get_next_iter_' to point to the first row.
   Status PrepareForOutput(RuntimeState* state);
 
+  /// Publishes the value of each filter expr on the top of 'heap_' as the bound of the
+  /// corresponding Top-N filter, if the heap is full and the bound is tighter than the
+  /// one published last. Used for unpartitioned Top-N only.
+  void PublishTopNFilters(RuntimeState* state);
+
   /// Re-materialize all tuples that reference 'tuple_pool_' and release 'tuple_pool_',
   /// replacing it with a new pool.
   Status ReclaimTuplePool(RuntimeState* state);
@@ -318,6 +344,41 @@ class TopNNode : public ExecNode {
   /// Only initialized for partitioned Top-N.
   RuntimeProfile::Counter* in_mem_heap_rows_filtered_counter_ = nullptr;
 
+  /// Number of rows that a full heap rejected by comparing normalized keys only.
+  /// Only initialized if 'key_normalizer_' is non-NULL.
+  RuntimeProfile::Counter* key_threshold_rejected_counter_ = nullptr;
+
+  /// Encodes normalized keys of the ordering exprs used by the heaps, i.e. the
+  /// intra-partition ordering exprs for partitioned Top-N. Full heaps compare the key
+  /// of an input tuple with the key of their top tuple before invoking the comparator.
+  /// NULL if --enable_topn_key_threshold is false or the leading ordering expr cannot
+  /// be normalized. Owned by 'pool_'.
+  const SortKeyNormalizer* key_normalizer_ = nullptr;
+
+  /// Buffer of the normalized key of 'tmp_tuple_'. Sized in Prepare().
+  std::vector<uint8_t> tmp_key_;
+
+  /// Number of rows rejected by key since 'key_threshold_rejected_counter_' was last
+  /// updated.
+  int64_t num_key_threshold_rejected_ = 0;
+
+  /// Contexts of the Top-N filters produced by this node, one per expr in
+  /// TopNPlanNode::filter_exprs_. 'local_min_max_filter' of each context is the filter
+  /// published last, or NULL if none was published yet.
+  std::vector<FilterContext> filter_ctxs_;
+
+  /// Number of input batches inserted between two publications of the Top-N filters.
+  /// Doubles after every publication, up to a limit, so that the number of filters
+  /// allocated stays small when the bound tightens with every batch.
+  int64_t filter_publish_interval_ = 1;
+
+  /// Number of input batches to insert until the Top-N filters are published next.
+  int64_t batches_until_filter_publish_ = 1;
+
+  /// Number of times a tighter bound was published for a Top-N filter.
+  /// Only initialized if 'filter_ctxs_' is non-empty.
+  RuntimeProfile::Counter* topn_filter_updates_counter_ = nullptr;
+
   /////////////////////////////////////////
   /// BEGIN: Members that must be Reset()
 
@@ -364,7 +425,8 @@ class TopNNode : public ExecNode {
 /// up to 'capacity' tuples.
 class TopNNode::Heap {
  public:
-  Heap(const TupleRowComparator& c, int64_t capacity, bool include_ties);
+  Heap(const TupleRowComparator& c, int64_t capacity, bool include_ties,
+      const SortKeyNormalizer* key_normalizer);
 
   void Reset();
   void Close();
@@ -437,6 +499,14 @@ private:
   int IR_ALWAYS_INLINE InsertTupleWithTieHandling(
       const TupleRowComparator& cmp, TopNNode* node, Tuple* materialized_tuple);
 
+  /// Compares the normalized key of 'materialized_tuple' with 'threshold_key_', the
+  /// key of the top of the full heap, re-encoding the latter first if it is stale.
+  /// Returns a negative or positive value if the keys order 'materialized_tuple'
+  /// before or after the top tuple, and 0 if the keys are equal or there is no
+  /// normalizer. Equal keys only imply equal tuples if the keys are complete.
+  int IR_ALWAYS_INLINE CompareWithThresholdKey(
+      TopNNode* node, const Tuple* materialized_tuple);
+
   /// Limit on capacity of 'priority_queue_'. If inserting a tuple into the queue
   /// would exceed this, a tuple is popped off the queue.
   const int64_t capacity_;
@@ -453,6 +523,9 @@ private:
   /// partitioned Top-N.
   int64_t num_tuples_at_last_eviction_ = 0;
 
+  /// Normalizer of the keys compared by CompareWithThresholdKey(), or NULL.
+  const SortKeyNormalizer* const key_normalizer_;
+
   /////////////////////////////////////////
   /// BEGIN: Members that must be Reset()
 
@@ -467,6 +540,12 @@ private:
   /// Only used when 'include_ties_' is true.
   std::vector<Tuple*> overflowed_ties_;
 
+  /// Normalized key of the top of 'priority_queue_'. Only valid if
+  /// 'threshold_key_valid_' is true, which is reset whenever the top of the full heap
+  /// changes.
+  std::vector<uint8_t> threshold_key_;
+  bool threshold_key_valid_ = false;
+
   /// END: Members that must be Reset()
   /////////////////////////////////////////
 };
@@ -51,6 +51,7 @@ Status Suballocator::Allocate(int64_t bytes, unique_ptr<Suballocation>* result)
                              "supported of $1 bytes",
         bytes, MAX_ALLOCATION_BYTES));
   }
+  lock_guard<mutex> l(lock_);
   unique_ptr<Suballocation> free_node;
   bytes = max(bytes, MIN_ALLOCATION_BYTES);
   const int target_list_idx = ComputeListIndex(bytes);
@@ -153,6 +154,7 @@ Status Suballocator::SplitToSize(unique_ptr<Suballocation> free_node,
 void Suballocator::Free(unique_ptr<Suballocation> allocation) {
   if (allocation == nullptr) return;
 
+  lock_guard<mutex> l(lock_);
   DCHECK(allocation->in_use_);
   allocation->in_use_ = false;
   allocated_ -= allocation->len_;
@@ -20,6 +20,7 @@
 
 #include <cstdint>
 #include <memory>
+#include <mutex>
 
 #include "runtime/bufferpool/buffer-pool.h"
 
@@ -41,7 +42,9 @@ class Suballocation;
 /// overhead per allocation is not paramount, e.g. bucket directories of hash tables.
 /// All allocations less than MIN_ALLOCATION_BYTES are rounded up to that amount.
 ///
-/// Methods of Suballocator are not thread safe.
+/// Allocate() and Free() are thread safe, so that multiple threads can build hash
+/// tables from the same suballocator. The caller must make sure that the buffer pool
+/// client is not otherwise used concurrently with them.
 ///
 /// Implementation:
 /// ---------------
@@ -133,6 +136,10 @@ class Suballocator {
   std::unique_ptr<Suballocation> CoalesceBuddies(
       std::unique_ptr<Suballocation> b1, std::unique_ptr<Suballocation> b2);
 
+  /// Serializes Allocate() and Free(). Protects all members below and the use of
+  /// 'client_'.
+  std::mutex lock_;
+
   /// The pool and corresponding client to allocate buffers from.
   BufferPool* pool_;
   BufferPool::ClientHandle* client_;
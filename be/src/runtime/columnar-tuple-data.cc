@@ -0,0 +1,355 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "runtime/columnar-tuple-data.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+#include "runtime/descriptors.h"
+#include "util/bit-stream-utils.inline.h"
+#include "util/bit-util.h"
+
+#include "common/names.h"
+
+namespace impala {
+
+const int ColumnarTupleData::MAX_DICT_SIZE;
+
+/// Loads the 'width' bytes at 'src' into the low bytes of a zero-extended value.
+static inline uint64_t LoadValue(const uint8_t* src, int width) {
+  uint64_t v = 0;
+  memcpy(&v, src, width);
+  return v;
+}
+
+/// Stores the low 'width' bytes of 'v' at 'dst'.
+static inline void StoreValue(uint64_t v, int width, uint8_t* dst) {
+  memcpy(dst, &v, width);
+}
+
+/// Returns the number of bits needed to store values up to 'v'.
+static inline int RequiredBits(uint64_t v) {
+  return v == 0 ? 0 : BitUtil::Log2Floor64(v) + 1;
+}
+
+static inline int64_t BitPackedLen(int64_t num_values, int bit_width) {
+  return BitUtil::Ceil(num_values * bit_width, 8);
+}
+
+static Status CorruptDataError() {
+  return Status("Corrupt columnar row batch data");
+}
+
+vector<ColumnarTupleData::Column> ColumnarTupleData::GetColumns(
+    const TupleDescriptor& desc) {
+  const int byte_size = desc.byte_size();
+  // Split the tuple at the start and end of every slot. The gaps between slots hold
+  // null indicator bytes and padding.
+  vector<int> boundaries{0, byte_size};
+  for (const SlotDescriptor* slot : desc.slots()) {
+    boundaries.push_back(min(slot->tuple_offset(), byte_size));
+    boundaries.push_back(min(slot->tuple_offset() + slot->slot_size(), byte_size));
+  }
+  sort(boundaries.begin(), boundaries.end());
+  boundaries.erase(unique(boundaries.begin(), boundaries.end()), boundaries.end());
+
+  vector<Column> columns;
+  for (int i = 0; i + 1 < boundaries.size(); ++i) {
+    int offset = boundaries[i];
+    while (offset < boundaries[i + 1]) {
+      int remaining = boundaries[i + 1] - offset;
+      int width = remaining >= 8 ? 8 : remaining >= 4 ? 4 : remaining >= 2 ? 2 : 1;
+      columns.push_back({offset, width});
+      offset += width;
+    }
+  }
+  return columns;
+}
+
+void ColumnarTupleData::CollectTuples(const RowDescriptor& row_desc,
+    const int32_t* tuple_offsets, int num_tuples, vector<TupleGroup>* groups,
+    vector<TupleExtent>* tuples) {
+  const vector<TupleDescriptor*>& descs = row_desc.tuple_descriptors();
+  const int num_tuples_per_row = descs.size();
+  groups->resize(num_tuples_per_row);
+  for (int j = 0; j < num_tuples_per_row; ++j) {
+    (*groups)[j].desc = descs[j];
+    (*groups)[j].columns = GetColumns(*descs[j]);
+    (*groups)[j].offsets.clear();
+  }
+  // A tuple that is serialized for the first time has a higher offset than all tuples
+  // before it. Repeated tuples reuse the offset of their first occurrence. The only
+  // exception are zero-length tuples, which share their offset with the next tuple. A
+  // tuple at the offset of a zero-length tuple is therefore always treated as a new
+  // tuple, which is harmless if it is a repeated zero-length tuple.
+  int32_t last_offset = -1;
+  int last_fixed_len = 0;
+  for (int i = 0; i < num_tuples; ++i) {
+    int32_t offset = tuple_offsets[i];
+    if (offset < 0) continue;
+    if (offset < last_offset || (offset == last_offset && last_fixed_len > 0)) continue;
+    TupleGroup* group = &(*groups)[i % num_tuples_per_row];
+    group->offsets.push_back(offset);
+    last_offset = offset;
+    last_fixed_len = group->desc->byte_size();
+    tuples->push_back({offset, last_fixed_len});
+  }
+}
+
+void ColumnarTupleData::EncodeColumn(
+    const vector<uint64_t>& values, int width, TrackedString* out) {
+  const int64_t num_values = values.size();
+  DCHECK_GT(num_values, 0);
+  // Sign-extend the values for frame of reference encoding so that small negative values
+  // pack as well as small positive values.
+  const int shift = 64 - width * 8;
+  int64_t min_value = numeric_limits<int64_t>::max();
+  int64_t max_value = numeric_limits<int64_t>::min();
+  for (uint64_t v : values) {
+    int64_t s = static_cast<int64_t>(v << shift) >> shift;
+    min_value = min(min_value, s);
+    max_value = max(max_value, s);
+  }
+  const int for_bit_width = RequiredBits(
+      static_cast<uint64_t>(max_value) - static_cast<uint64_t>(min_value));
+  const int64_t for_len =
+      sizeof(int64_t) + 1 + BitPackedLen(num_values, for_bit_width);
+
+  // Build a dictionary with a small open-addressing hash table, giving up once the
+  // column has too many distinct values.
+  const int HASH_TABLE_SIZE = MAX_DICT_SIZE * 2;
+  uint64_t hash_values[HASH_TABLE_SIZE];
+  int16_t hash_indices[HASH_TABLE_SIZE];
+  memset(hash_indices, -1, sizeof(hash_indices));
+  vector<uint64_t> dict;
+  vector<uint8_t> indices(num_values);
+  for (int64_t i = 0; i < num_values; ++i) {
+    uint64_t v = values[i];
+    int bucket = (v * 0x9E3779B97F4A7C15ULL) >> 55;
+    while (hash_indices[bucket] != -1 && hash_values[bucket] != v) {
+      bucket = (bucket + 1) % HASH_TABLE_SIZE;
+    }
+    if (hash_indices[bucket] == -1) {
+      if (dict.size() == MAX_DICT_SIZE) {
+        dict.clear();
+        break;
+      }
+      hash_values[bucket] = v;
+      hash_indices[bucket] = dict.size();
+      dict.push_back(v);
+    }
+    indices[i] = hash_indices[bucket];
+  }
+  const int dict_bit_width = dict.size() <= 1 ? 0 : BitUtil::Log2Ceiling(dict.size());
+  const int64_t dict_len = dict.empty() ? numeric_limits<int64_t>::max() :
+      sizeof(uint16_t) + dict.size() * width + 1
+          + BitPackedLen(num_values, dict_bit_width);
+
+  const int64_t plain_len = num_values * width;
+  int64_t pos = out->size();
+  if (plain_len <= for_len && plain_len <= dict_len) {
+    out->resize(pos + 1 + plain_len);
+    uint8_t* dst = reinterpret_cast<uint8_t*>(&(*out)[pos]);
+    *dst++ = PLAIN;
+    for (uint64_t v : values) {
+      StoreValue(v, width, dst);
+      dst += width;
+    }
+  } else if (for_len <= dict_len) {
+    out->resize(pos + 1 + for_len);
+    uint8_t* dst = reinterpret_cast<uint8_t*>(&(*out)[pos]);
+    *dst++ = FOR;
+    memcpy(dst, &min_value, sizeof(min_value));
+    dst += sizeof(min_value);
+    *dst++ = for_bit_width;
+    if (for_bit_width == 0) return;
+    BitWriter writer(dst, BitPackedLen(num_values, for_bit_width));
+    // The values are zero-extended, so the difference to the sign-extended minimum is
+    // only correct in its low 'for_bit_width' bits.
+    const uint64_t mask = for_bit_width == 64 ? ~0ULL : (1ULL << for_bit_width) - 1;
+    for (uint64_t v : values) {
+      bool success = writer.PutValue((v - static_cast<uint64_t>(min_value)) & mask,
+          for_bit_width);
+      DCHECK(success);
+    }
+    writer.Flush();
+  } else {
+    out->resize(pos + 1 + dict_len);
+    uint8_t* dst = reinterpret_cast<uint8_t*>(&(*out)[pos]);
+    *dst++ = DICT;
+    uint16_t dict_size = dict.size();
+    memcpy(dst, &dict_size, sizeof(dict_size));
+    dst += sizeof(dict_size);
+    for (uint64_t v : dict) {
+      StoreValue(v, width, dst);
+      dst += width;
+    }
+    *dst++ = dict_bit_width;
+    if (dict_bit_width == 0) return;
+    BitWriter writer(dst, BitPackedLen(num_values, dict_bit_width));
+    for (uint8_t index : indices) {
+      bool success = writer.PutValue(index, dict_bit_width);
+      DCHECK(success);
+    }
+    writer.Flush();
+  }
+}
+
+Status ColumnarTupleData::DecodeColumn(const uint8_t** input, const uint8_t* input_end,
+    int width, vector<uint64_t>* values) {
+  const uint8_t* src = *input;
+  const int64_t num_values = values->size();
+  if (src >= input_end) return CorruptDataError();
+  uint8_t encoding = *src++;
+  switch (encoding) {
+    case PLAIN: {
+      if (input_end - src < num_values * width) return CorruptDataError();
+      for (uint64_t& v : *values) {
+        v = LoadValue(src, width);
+        src += width;
+      }
+      break;
+    }
+    case FOR: {
+      if (input_end - src < sizeof(int64_t) + 1) return CorruptDataError();
+      int64_t min_value;
+      memcpy(&min_value, src, sizeof(min_value));
+      src += sizeof(min_value);
+      int bit_width = *src++;
+      if (bit_width > BatchedBitReader::MAX_BITWIDTH) return CorruptDataError();
+      int64_t packed_len = BitPackedLen(num_values, bit_width);
+      if (input_end - src < packed_len) return CorruptDataError();
+      if (bit_width == 0) {
+        fill(values->begin(), values->end(), 0);
+      } else {
+        BatchedBitReader reader(src, packed_len);
+        if (reader.UnpackBatch(bit_width, num_values, values->data()) != num_values) {
+          return CorruptDataError();
+        }
+      }
+      for (uint64_t& v : *values) v += static_cast<uint64_t>(min_value);
+      src += packed_len;
+      break;
+    }
+    case DICT: {
+      if (input_end - src < sizeof(uint16_t)) return CorruptDataError();
+      uint16_t dict_size;
+      memcpy(&dict_size, src, sizeof(dict_size));
+      src += sizeof(dict_size);
+      if (dict_size == 0 || dict_size > MAX_DICT_SIZE) return CorruptDataError();
+      if (input_end - src < dict_size * width + 1) return CorruptDataError();
+      uint64_t dict[MAX_DICT_SIZE];
+      for (int i = 0; i < dict_size; ++i) {
+        dict[i] = LoadValue(src, width);
+        src += width;
+      }
+      int bit_width = *src++;
+      if (bit_width > 8) return CorruptDataError();
+      int64_t packed_len = BitPackedLen(num_values, bit_width);
+      if (input_end - src < packed_len) return CorruptDataError();
+      if (bit_width == 0) {
+        fill(values->begin(), values->end(), dict[0]);
+      } else {
+        BatchedBitReader reader(src, packed_len);
+        if (reader.UnpackBatch(bit_width, num_values, values->data()) != num_values) {
+          return CorruptDataError();
+        }
+        for (uint64_t& v : *values) {
+          if (v >= dict_size) return CorruptDataError();
+          v = dict[v];
+        }
+      }
+      src += packed_len;
+      break;
+    }
+    default:
+      return CorruptDataError();
+  }
+  *input = src;
+  return Status::OK();
+}
+
+Status ColumnarTupleData::Encode(const RowDescriptor& row_desc,
+    const int32_t* tuple_offsets, int num_tuples, const uint8_t* tuple_data,
+    int64_t size, TrackedString* output) {
+  vector<TupleGroup> groups;
+  vector<TupleExtent> tuples;
+  CollectTuples(row_desc, tuple_offsets, num_tuples, &groups, &tuples);
+
+  output->clear();
+  vector<uint64_t> values;
+  for (const TupleGroup& group : groups) {
+    if (group.offsets.empty()) continue;
+    values.resize(group.offsets.size());
+    for (const Column& col : group.columns) {
+      for (int i = 0; i < group.offsets.size(); ++i) {
+        values[i] = LoadValue(tuple_data + group.offsets[i] + col.offset, col.width);
+      }
+      EncodeColumn(values, col.width, output);
+    }
+  }
+
+  // Append the variable-length data that follows each tuple.
+  for (int i = 0; i < tuples.size(); ++i) {
+    int64_t start = tuples[i].offset + tuples[i].fixed_len;
+    int64_t end = i + 1 < tuples.size() ? tuples[i + 1].offset : size;
+    DCHECK_LE(start, end);
+    if (start == end) continue;
+    output->append(reinterpret_cast<const char*>(tuple_data + start), end - start);
+  }
+  return Status::OK();
+}
+
+Status ColumnarTupleData::Decode(const RowDescriptor& row_desc,
+    const int32_t* tuple_offsets, int num_tuples, const uint8_t* input,
+    int64_t input_len, uint8_t* tuple_data, int64_t size) {
+  vector<TupleGroup> groups;
+  vector<TupleExtent> tuples;
+  CollectTuples(row_desc, tuple_offsets, num_tuples, &groups, &tuples);
+  for (int i = 0; i < tuples.size(); ++i) {
+    int64_t end = i + 1 < tuples.size() ? tuples[i + 1].offset : size;
+    if (tuples[i].offset + tuples[i].fixed_len > end) return CorruptDataError();
+  }
+
+  const uint8_t* input_end = input + input_len;
+  vector<uint64_t> values;
+  for (const TupleGroup& group : groups) {
+    if (group.offsets.empty()) continue;
+    values.resize(group.offsets.size());
+    for (const Column& col : group.columns) {
+      RETURN_IF_ERROR(DecodeColumn(&input, input_end, col.width, &values));
+      for (int i = 0; i < group.offsets.size(); ++i) {
+        StoreValue(values[i], col.width, tuple_data + group.offsets[i] + col.offset);
+      }
+    }
+  }
+
+  for (int i = 0; i < tuples.size(); ++i) {
+    int64_t start = tuples[i].offset + tuples[i].fixed_len;
+    int64_t end = i + 1 < tuples.size() ? tuples[i + 1].offset : size;
+    if (start == end) continue;
+    if (input_end - input < end - start) return CorruptDataError();
+    memcpy(tuple_data + start, input, end - start);
+    input += end - start;
+  }
+  if (input != input_end) return CorruptDataError();
+  return Status::OK();
+}
+
+} // namespace impala
@@ -0,0 +1,114 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "common/status.h"
+#include "runtime/mem-tracker.h"
+
+namespace impala {
+
+class RowDescriptor;
+class TupleDescriptor;
+
+/// Converts the serialized tuple data of a row batch (see RowBatch::Serialize()) from
+/// its row-wise layout into a columnar layout and back. The columnar layout compresses
+/// much better than the row-wise layout, in particular for wide tuples, because values
+/// of the same slot are stored next to each other and are encoded with lightweight
+/// encodings before any general-purpose compression is applied.
+///
+/// The distinct tuples of each tuple descriptor of the row are transposed into columns.
+/// A column is a byte range of the tuple layout of at most 8 bytes: the slots are split
+/// into 8, 4, 2 and 1 byte ranges and the null indicator bytes and padding form columns
+/// of their own, so the whole fixed-length part of the tuples is covered. Each column
+/// is stored with the smallest of the following encodings:
+///   PLAIN: the values as they are.
+///   FOR: frame of reference. The minimum of the sign-extended values followed by the
+///        bit-packed differences to the minimum. Constant columns, e.g. null indicator
+///        bytes of a column without NULLs, take no space beyond the minimum.
+///   DICT: up to 256 distinct values followed by their bit-packed indices. Null
+///         indicator bytes usually end up as null bitmaps of one or two bits per tuple.
+/// The variable-length data of all tuples follows the columns in tuple order.
+///
+/// The layout of the row-wise data is recovered from the tuple offsets, which are not
+/// part of the columnar data: distinct tuples are serialized in increasing offset order
+/// and each tuple's variable-length data directly follows its fixed-length part.
+class ColumnarTupleData {
+ public:
+  /// Encodes the 'size' bytes of row-wise tuple data at 'tuple_data' with the
+  /// 'num_tuples' tuple offsets at 'tuple_offsets' of rows of 'row_desc' and stores the
+  /// result in 'output'.
+  static Status Encode(const RowDescriptor& row_desc, const int32_t* tuple_offsets,
+      int num_tuples, const uint8_t* tuple_data, int64_t size,
+      TrackedString* output) WARN_UNUSED_RESULT;
+
+  /// Decodes the 'input_len' bytes of columnar data at 'input' that were produced by
+  /// Encode() back into the 'size' bytes of row-wise tuple data at 'tuple_data'.
+  /// Returns an error if the input is corrupt.
+  static Status Decode(const RowDescriptor& row_desc, const int32_t* tuple_offsets,
+      int num_tuples, const uint8_t* input, int64_t input_len, uint8_t* tuple_data,
+      int64_t size) WARN_UNUSED_RESULT;
+
+ private:
+  /// The encoding of a column, stored in the byte preceding the column's data.
+  enum Encoding : uint8_t { PLAIN = 0, FOR = 1, DICT = 2 };
+
+  /// Maximum number of distinct values of a dictionary-encoded column.
+  static const int MAX_DICT_SIZE = 256;
+
+  /// A byte range of the fixed-length part of a tuple.
+  struct Column {
+    int offset;
+    int width;
+  };
+
+  /// A distinct tuple in the row-wise tuple data.
+  struct TupleExtent {
+    int32_t offset;
+    int fixed_len;
+  };
+
+  /// The distinct tuples of a tuple descriptor, with their offsets into the row-wise
+  /// tuple data.
+  struct TupleGroup {
+    const TupleDescriptor* desc;
+    std::vector<Column> columns;
+    std::vector<int32_t> offsets;
+  };
+
+  /// Returns the columns that cover the fixed-length part of tuples of 'desc'.
+  static std::vector<Column> GetColumns(const TupleDescriptor& desc);
+
+  /// Groups the distinct tuples in 'tuple_offsets' by the tuple index in the row into
+  /// 'groups' and appends all distinct tuples in the order of their offsets to 'tuples'.
+  static void CollectTuples(const RowDescriptor& row_desc, const int32_t* tuple_offsets,
+      int num_tuples, std::vector<TupleGroup>* groups, std::vector<TupleExtent>* tuples);
+
+  /// Appends the encoding of the 'values.size()' values of 'width' bytes to 'out'.
+  static void EncodeColumn(
+      const std::vector<uint64_t>& values, int width, TrackedString* out);
+
+  /// Decodes the column at '*input', which ends at 'input_end', into 'values' and
+  /// advances '*input' past it.
+  static Status DecodeColumn(const uint8_t** input, const uint8_t* input_end,
+      int width, std::vector<uint64_t>* values) WARN_UNUSED_RESULT;
+};
+
+} // namespace impala
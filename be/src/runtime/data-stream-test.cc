@@ -278,6 +278,10 @@ class DataStreamTest : public testing::Test {
   // Only used for KRPC. Not owned.
   NetworkAddressPB krpc_address_;
 
+  // If true, the receivers are given the address of 'exec_env_' so that the senders
+  // hand the row batches to them without RPCs.
+  bool local_exchange_ = false;
+
   // The test service implementation. Owned by this class.
   unique_ptr<ImpalaKRPCTestBackend> test_service_;
 
@@ -328,7 +332,9 @@ class DataStreamTest : public testing::Test {
     *dest->mutable_fragment_instance_id() = next_instance_id_;
     *dest->mutable_address() = MakeNetworkAddressPB("localhost", FLAGS_port, backend_id_,
         exec_env_->rpc_mgr()->GetUdsAddressUniqueId());
-    *dest->mutable_krpc_backend() = krpc_address_;
+    // Receivers at the address of this process are sent to without RPCs.
+    *dest->mutable_krpc_backend() =
+        local_exchange_ ? exec_env_->krpc_address() : krpc_address_;
     UniqueIdPBToTUniqueId(next_instance_id_, instance_id);
     next_instance_id_.set_lo(next_instance_id_.lo() + 1);
   }
@@ -449,11 +455,11 @@ class DataStreamTest : public testing::Test {
 
   void ReadStreamMerging(ReceiverInfo* info, RuntimeProfile* profile,
       TupleRowComparator* less_than_comparator) {
-    /// Note that codegend_heapify_helper_fn currently stores a nullptr.
+    /// Note that codegend_replay_helper_fn currently stores a nullptr.
     /// The codegened case of this function is covered in end-to-end tests.
-    CodegenFnPtr<SortedRunMerger::HeapifyHelperFn> codegend_heapify_helper_fn;
+    CodegenFnPtr<SortedRunMerger::ReplayHelperFn> codegend_replay_helper_fn;
     info->status = info->stream_recvr->CreateMerger(
-        *less_than_comparator, codegend_heapify_helper_fn);
+        *less_than_comparator, codegend_replay_helper_fn);
     if (info->status.IsCancelled()) return;
     RowBatch batch(row_desc_, 1024, &tracker_);
     VLOG_QUERY << "start reading merging";
@@ -696,6 +702,20 @@ class DataStreamTestShortServiceQueue : public DataStreamTest {
   }
 };
 
+// A separate test class in which the senders and receivers are in the same process,
+// so that the row batches are exchanged without RPCs.
+class DataStreamTestLocalExchange : public DataStreamTest {
+ protected:
+  virtual void SetUp() {
+    local_exchange_ = true;
+    DataStreamTest::SetUp();
+  }
+
+  virtual void TearDown() {
+    DataStreamTest::TearDown();
+  }
+};
+
 TEST_F(DataStreamTest, UnknownSenderSmallResult) {
   // starting a sender w/o a corresponding receiver results in an error. No bytes should
   // be sent.
@@ -824,6 +844,31 @@ TEST_F(DataStreamTestShortServiceQueue, TestLargePayload) {
       TPartitionType::UNPARTITIONED, 4, 1, SHORT_SERVICE_QUEUE_MEM_LIMIT * 2, false);
 }
 
+TEST_F(DataStreamTestLocalExchange, UnknownSender) {
+  // A local sender without a receiver times out like a remote one.
+  TUniqueId dummy_id;
+  GetNextInstanceId(&dummy_id);
+  StartSender();
+  JoinSenders();
+  EXPECT_EQ(sender_info_[0]->status.code(), TErrorCode::DATASTREAM_SENDER_TIMEOUT);
+}
+
+TEST_F(DataStreamTestLocalExchange, BasicTest) {
+  // The small buffer size makes the senders block on full receiver queues.
+  TPartitionType::type stream_types[] =
+      {TPartitionType::UNPARTITIONED, TPartitionType::RANDOM,
+          TPartitionType::HASH_PARTITIONED};
+  int buffer_sizes[] = {1024, 1024 * 1024};
+  bool merging[] = {false, true};
+  for (TPartitionType::type stream_type : stream_types) {
+    for (int buffer_size : buffer_sizes) {
+      for (bool is_merging : merging) {
+        TestStream(stream_type, 4, 4, buffer_size, is_merging);
+      }
+    }
+  }
+}
+
 // TODO: more tests:
 // - test case for transmission error in last batch
 // - receivers getting created concurrently
@@ -582,6 +582,7 @@ class DescriptorTbl {
   // The friend classes use CreateInternal().
   friend class DescriptorTblBuilder;
   friend class DataStreamTest;
+  friend class SortedRunMergerTest;
   typedef std::unordered_map<TableId, TableDescriptor*> TableDescriptorMap;
   typedef std::unordered_map<TupleId, TupleDescriptor*> TupleDescriptorMap;
   typedef std::unordered_map<SlotId, SlotDescriptor*> SlotDescriptorMap;
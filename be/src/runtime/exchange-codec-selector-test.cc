@@ -0,0 +1,126 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <map>
+
+#include "runtime/exchange-codec-selector.h"
+#include "testutil/gtest-util.h"
+
+#include "common/names.h"
+
+namespace impala {
+
+class ExchangeCodecSelectorTest : public testing::Test {
+ protected:
+  static const int64_t BATCH_SIZE = 1024 * 1024;
+
+  /// Compression ratio and compression time per byte of a codec.
+  struct CodecModel {
+    double ratio;
+    double time_per_byte;
+  };
+
+  ExchangeCodecSelectorTest() : selector_(1) {
+    codecs_[CompressionTypePB::NONE] = {1.0, 0};
+    codecs_[CompressionTypePB::LZ4] = {0.5, 1};
+    codecs_[CompressionTypePB::ZSTD] = {0.3, 4};
+  }
+
+  /// Sends 'num_batches' batches over a link that takes 'network_time_per_byte' per
+  /// byte sent and counts the batches compressed with each codec in 'counts', if not
+  /// null.
+  void SendBatches(int num_batches, double network_time_per_byte,
+      map<CompressionTypePB, int>* counts = nullptr) {
+    for (int i = 0; i < num_batches; ++i) {
+      CompressionTypePB codec = selector_.NextCodec();
+      if (counts != nullptr) ++(*counts)[codec];
+      const CodecModel& model = codecs_[codec];
+      int64_t output_bytes = BATCH_SIZE * model.ratio;
+      selector_.UpdateCompression(
+          codec, BATCH_SIZE, output_bytes, BATCH_SIZE * model.time_per_byte);
+      selector_.UpdateNetwork(output_bytes, output_bytes * network_time_per_byte);
+      selector_.UpdateBacklog(output_bytes, 0);
+    }
+  }
+
+  ExchangeCodecSelector selector_;
+  map<CompressionTypePB, CodecModel> codecs_;
+};
+
+// The compressed codecs are measured first. The current codec is kept until the network
+// time is known.
+TEST_F(ExchangeCodecSelectorTest, InitialCodecs) {
+  EXPECT_EQ(CompressionTypePB::LZ4, selector_.NextCodec());
+  EXPECT_EQ(CompressionTypePB::LZ4, selector_.NextCodec());
+  selector_.UpdateCompression(CompressionTypePB::LZ4, BATCH_SIZE, BATCH_SIZE / 2, 1000);
+  EXPECT_EQ(CompressionTypePB::ZSTD, selector_.NextCodec());
+  selector_.UpdateCompression(CompressionTypePB::ZSTD, BATCH_SIZE, BATCH_SIZE / 4, 1000);
+  EXPECT_EQ(CompressionTypePB::LZ4, selector_.NextCodec());
+  EXPECT_DOUBLE_EQ(0.5, selector_.ratio(CompressionTypePB::LZ4));
+  EXPECT_DOUBLE_EQ(0.25, selector_.ratio(CompressionTypePB::ZSTD));
+  EXPECT_DOUBLE_EQ(1.0, selector_.ratio(CompressionTypePB::NONE));
+}
+
+// A fast link is not worth compressing for.
+TEST_F(ExchangeCodecSelectorTest, FastNetwork) {
+  SendBatches(10, 0.1);
+  EXPECT_EQ(CompressionTypePB::NONE, selector_.current_codec());
+}
+
+// A link of medium speed is worth compressing for with a fast codec.
+TEST_F(ExchangeCodecSelectorTest, MediumNetwork) {
+  SendBatches(10, 4);
+  EXPECT_EQ(CompressionTypePB::LZ4, selector_.current_codec());
+}
+
+// A slow link is worth compressing for with the strongest codec.
+TEST_F(ExchangeCodecSelectorTest, SlowNetwork) {
+  SendBatches(10, 20);
+  EXPECT_EQ(CompressionTypePB::ZSTD, selector_.current_codec());
+  EXPECT_LT(selector_.EstimatedCost(CompressionTypePB::ZSTD),
+      selector_.EstimatedCost(CompressionTypePB::LZ4));
+  EXPECT_LT(selector_.EstimatedCost(CompressionTypePB::LZ4),
+      selector_.EstimatedCost(CompressionTypePB::NONE));
+}
+
+// Time the sender spends blocked on the preceding RPC counts as network time.
+TEST_F(ExchangeCodecSelectorTest, Backlog) {
+  SendBatches(10, 0.1);
+  EXPECT_EQ(CompressionTypePB::NONE, selector_.current_codec());
+  for (int i = 0; i < 10; ++i) selector_.UpdateBacklog(BATCH_SIZE, BATCH_SIZE * 20);
+  EXPECT_EQ(CompressionTypePB::ZSTD, selector_.NextCodec());
+}
+
+// The other compressed codecs are probed periodically, so a change of the link is
+// picked up.
+TEST_F(ExchangeCodecSelectorTest, Probing) {
+  SendBatches(10, 0.1);
+  EXPECT_EQ(CompressionTypePB::NONE, selector_.current_codec());
+  map<CompressionTypePB, int> counts;
+  SendBatches(64, 0.1, &counts);
+  EXPECT_EQ(60, counts[CompressionTypePB::NONE]);
+  EXPECT_EQ(2, counts[CompressionTypePB::LZ4]);
+  EXPECT_EQ(2, counts[CompressionTypePB::ZSTD]);
+
+  // The link slows down.
+  codecs_[CompressionTypePB::ZSTD].ratio = 0.2;
+  SendBatches(64, 20);
+  EXPECT_EQ(CompressionTypePB::ZSTD, selector_.current_codec());
+  EXPECT_NEAR(0.2, selector_.ratio(CompressionTypePB::ZSTD), 0.01);
+}
+
+} // namespace impala
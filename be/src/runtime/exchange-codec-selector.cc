@@ -0,0 +1,126 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "runtime/exchange-codec-selector.h"
+
+#include <algorithm>
+#include <mutex>
+
+#include "common/logging.h"
+
+#include "common/names.h"
+
+namespace impala {
+
+const CompressionTypePB ExchangeCodecSelector::CODECS[NUM_CODECS] = {
+    CompressionTypePB::NONE, CompressionTypePB::LZ4, CompressionTypePB::ZSTD};
+const int ExchangeCodecSelector::NUM_CODECS;
+const int ExchangeCodecSelector::PROBE_INTERVAL;
+constexpr double ExchangeCodecSelector::ALPHA;
+constexpr double ExchangeCodecSelector::SWITCH_THRESHOLD;
+
+ExchangeCodecSelector::ExchangeCodecSelector(int zstd_level)
+  : zstd_level_(zstd_level), current_(Index(CompressionTypePB::LZ4)) {
+  // Not compressing needs no measurements.
+  codecs_[Index(CompressionTypePB::NONE)].measured = true;
+}
+
+int ExchangeCodecSelector::Index(CompressionTypePB codec) {
+  for (int i = 0; i < NUM_CODECS; ++i) {
+    if (CODECS[i] == codec) return i;
+  }
+  DCHECK(false) << "Unexpected codec: " << codec;
+  return 0;
+}
+
+void ExchangeCodecSelector::UpdateAverage(double sample, bool first, double* avg) {
+  *avg = first ? sample : ALPHA * sample + (1 - ALPHA) * *avg;
+}
+
+CompressionTypePB ExchangeCodecSelector::NextCodec() {
+  ++num_batches_;
+  // Measure every codec once before making a choice.
+  for (int i = 0; i < NUM_CODECS; ++i) {
+    if (!codecs_[i].measured) return CODECS[i];
+  }
+  if (num_batches_ % PROBE_INTERVAL == 0) {
+    int oldest = -1;
+    for (int i = 0; i < NUM_CODECS; ++i) {
+      if (i == current_ || CODECS[i] == CompressionTypePB::NONE) continue;
+      if (oldest == -1 || codecs_[i].last_measured < codecs_[oldest].last_measured) {
+        oldest = i;
+      }
+    }
+    if (oldest != -1) return CODECS[oldest];
+  }
+  // Without a network estimate the costs of the codecs cannot be compared.
+  if (NetworkTimePerByte() < 0) return CODECS[current_];
+  const double current_cost = EstimatedCost(CODECS[current_]);
+  int best = current_;
+  double best_cost = current_cost;
+  for (int i = 0; i < NUM_CODECS; ++i) {
+    double cost = EstimatedCost(CODECS[i]);
+    if (cost < best_cost) {
+      best = i;
+      best_cost = cost;
+    }
+  }
+  if (best_cost < current_cost * SWITCH_THRESHOLD) current_ = best;
+  return CODECS[current_];
+}
+
+void ExchangeCodecSelector::UpdateCompression(CompressionTypePB codec,
+    int64_t input_bytes, int64_t output_bytes, int64_t compression_time_ns) {
+  if (codec == CompressionTypePB::NONE || input_bytes <= 0) return;
+  CodecStats* stats = &codecs_[Index(codec)];
+  // The output is sent uncompressed if compression does not make it smaller.
+  double ratio = min(1.0, static_cast<double>(output_bytes) / input_bytes);
+  UpdateAverage(ratio, !stats->measured, &stats->ratio);
+  UpdateAverage(static_cast<double>(compression_time_ns) / input_bytes, !stats->measured,
+      &stats->time_per_byte);
+  stats->measured = true;
+  stats->last_measured = num_batches_;
+}
+
+void ExchangeCodecSelector::UpdateNetwork(int64_t bytes, int64_t network_time_ns) {
+  if (bytes <= 0) return;
+  std::lock_guard<SpinLock> l(lock_);
+  UpdateAverage(static_cast<double>(network_time_ns) / bytes,
+      network_time_per_byte_ < 0, &network_time_per_byte_);
+}
+
+void ExchangeCodecSelector::UpdateBacklog(int64_t bytes, int64_t wait_time_ns) {
+  if (bytes <= 0) return;
+  std::lock_guard<SpinLock> l(lock_);
+  UpdateAverage(static_cast<double>(wait_time_ns) / bytes,
+      backlog_time_per_byte_ < 0, &backlog_time_per_byte_);
+}
+
+double ExchangeCodecSelector::NetworkTimePerByte() const {
+  std::lock_guard<SpinLock> l(lock_);
+  if (network_time_per_byte_ < 0) return -1;
+  return network_time_per_byte_ + max(0.0, backlog_time_per_byte_);
+}
+
+double ExchangeCodecSelector::EstimatedCost(CompressionTypePB codec) const {
+  const CodecStats& stats = codecs_[Index(codec)];
+  double network_time_per_byte = max(0.0, NetworkTimePerByte());
+  // Compression of a batch overlaps with the transmission of the preceding batch.
+  return max(stats.time_per_byte, stats.ratio * network_time_per_byte);
+}
+
+} // namespace impala
@@ -0,0 +1,130 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <cstdint>
+
+#include "gen-cpp/common.pb.h"
+#include "util/spinlock.h"
+
+namespace impala {
+
+/// Chooses the codec that row batches sent over an exchange channel are compressed
+/// with, out of NONE, LZ4 and ZSTD at a low compression level.
+///
+/// Sending a batch is modelled as a pipeline of compressing it on the sender thread and
+/// transmitting it over the network, so the cost of a codec per uncompressed byte is the
+/// larger of its compression time and the time to transmit its output. The selector
+/// keeps moving averages of the compression ratio and compression time of each codec,
+/// and of the network time per byte sent. The network time includes the time RPCs spend
+/// queued in KRPC and the time the sender is blocked on the preceding RPC of the channel,
+/// so congested links favour stronger codecs while fast links skip compression.
+///
+/// To keep the estimates of the codecs that are not in use current, a batch is
+/// compressed with the codec with the oldest estimate every PROBE_INTERVAL batches.
+///
+/// UpdateNetwork() may be called concurrently with the other functions, e.g. from KRPC
+/// reactor threads. The other functions must be called from a single thread.
+class ExchangeCodecSelector {
+ public:
+  ExchangeCodecSelector(int zstd_level);
+
+  /// Returns the codec to compress the next row batch with. Must be followed by a call to
+  /// UpdateCompression() for the batch.
+  CompressionTypePB NextCodec();
+
+  /// Returns the compression level to use for 'codec'.
+  int compression_level(CompressionTypePB codec) const {
+    return codec == CompressionTypePB::ZSTD ? zstd_level_ : 0;
+  }
+
+  /// Records that a batch of 'input_bytes' was compressed with 'codec' into
+  /// 'output_bytes' in 'compression_time_ns'.
+  void UpdateCompression(CompressionTypePB codec, int64_t input_bytes,
+      int64_t output_bytes, int64_t compression_time_ns);
+
+  /// Records that an RPC transmitted 'bytes' in 'network_time_ns'.
+  void UpdateNetwork(int64_t bytes, int64_t network_time_ns);
+
+  /// Records that the sender was blocked for 'wait_time_ns' on the preceding RPC before
+  /// it could send a batch of 'bytes'.
+  void UpdateBacklog(int64_t bytes, int64_t wait_time_ns);
+
+  /// The codec that is chosen for batches that are not used for probing.
+  CompressionTypePB current_codec() const { return CODECS[current_]; }
+
+  /// Returns the estimated ratio of output to input bytes of 'codec'.
+  double ratio(CompressionTypePB codec) const { return codecs_[Index(codec)].ratio; }
+
+  /// Returns the estimated cost of sending a byte of input with 'codec' in nanoseconds.
+  /// Exposed for testing.
+  double EstimatedCost(CompressionTypePB codec) const;
+
+ private:
+  static const int NUM_CODECS = 3;
+  static const CompressionTypePB CODECS[NUM_CODECS];
+
+  /// Number of batches between two batches that probe another codec.
+  static const int PROBE_INTERVAL = 16;
+
+  /// Weight of a new sample in the moving averages.
+  static constexpr double ALPHA = 0.25;
+
+  /// Only switch to another codec if its estimated cost is lower than this fraction of
+  /// the cost of the current codec, to avoid flapping between similar codecs.
+  static constexpr double SWITCH_THRESHOLD = 0.9;
+
+  struct CodecStats {
+    /// Output bytes per input byte.
+    double ratio = 1;
+    /// Compression time in nanoseconds per input byte.
+    double time_per_byte = 0;
+    /// True if the codec was measured at least once.
+    bool measured = false;
+    /// The value of 'num_batches_' when the codec was last measured.
+    int64_t last_measured = 0;
+  };
+
+  static int Index(CompressionTypePB codec);
+
+  /// Returns the network time per byte, including backlog.
+  double NetworkTimePerByte() const;
+
+  /// Moves 'avg' towards 'sample', or sets it to 'sample' if 'first' is true.
+  static void UpdateAverage(double sample, bool first, double* avg);
+
+  const int zstd_level_;
+
+  CodecStats codecs_[NUM_CODECS];
+
+  /// Index into CODECS of the codec chosen for regular batches.
+  int current_;
+
+  /// Number of batches for which NextCodec() was called.
+  int64_t num_batches_ = 0;
+
+  /// Protects the network estimates below.
+  mutable SpinLock lock_;
+
+  /// Moving averages of the network time and the backlog time per byte sent. Negative
+  /// until the first sample.
+  double network_time_per_byte_ = -1;
+  double backlog_time_per_byte_ = -1;
+};
+
+} // namespace impala
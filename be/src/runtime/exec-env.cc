@@ -28,6 +28,7 @@
 #include "common/logging.h"
 #include "common/object-pool.h"
 #include "exec/kudu/kudu-util.h"
+#include "exec/parquet/parquet-metadata-cache.h"
 #include "kudu/rpc/service_if.h"
 #include "rpc/rpc-mgr.h"
 #include "runtime/bufferpool/buffer-pool.h"
@@ -102,6 +103,9 @@ DEFINE_int32(admission_control_slots, 0,
     "value for dedicated coordinators).");
 DEFINE_string(codegen_cache_capacity, "1GB",
     "Specify the capacity of the codegen cache. If set to 0, codegen cache is disabled.");
+DEFINE_string(parquet_metadata_cache_capacity, "0",
+    "Specify the capacity of the cache of Parquet file footers and page indexes that is "
+    "shared by all queries on this executor. If set to 0, the cache is disabled.");
 
 DEFINE_bool(use_local_catalog, false,
     "Use the on-demand metadata feature in coordinators. If this is set, coordinators "
@@ -349,6 +353,23 @@ Status ExecEnv::Init() {
     LOG(INFO) << "CodeGen Cache is disabled.";
   }
 
+  int64_t parquet_metadata_cache_capacity =
+      ParseUtil::ParseMemSpec(FLAGS_parquet_metadata_cache_capacity, &is_percent, 0);
+  if (parquet_metadata_cache_capacity > 0) {
+    DCHECK(!is_percent);
+    parquet_metadata_cache_.reset(new ParquetMetadataCache(metrics_.get()));
+    RETURN_IF_ERROR(parquet_metadata_cache_->Init(parquet_metadata_cache_capacity));
+    LOG(INFO) << "Parquet Metadata Cache initialized with capacity "
+              << PrettyPrinter::Print(parquet_metadata_cache_capacity, TUnit::BYTES);
+    // Preserve the memory for the cache.
+    admit_mem_limit_ -= parquet_metadata_cache_capacity;
+    if (admit_mem_limit_ <= 0) {
+      return Status(Substitute("Invalid --parquet_metadata_cache_capacity $0, which "
+          "must be smaller than the memory available for admission",
+          FLAGS_parquet_metadata_cache_capacity));
+    }
+  }
+
   LOG(INFO) << "Admit memory limit: "
             << PrettyPrinter::Print(admit_mem_limit_, TUnit::BYTES);
 
@@ -70,6 +70,7 @@ class ThreadResourceMgr;
 class TmpFileMgr;
 class Webserver;
 class CodeGenCache;
+class ParquetMetadataCache;
 
 namespace io {
   class DiskIoMgr;
@@ -155,6 +156,11 @@ class ExecEnv {
   CodeGenCache* codegen_cache() const { return codegen_cache_.get(); }
   bool codegen_cache_enabled() const { return codegen_cache_ != nullptr; }
 
+  /// Returns the cache of Parquet file metadata or nullptr if it is disabled.
+  ParquetMetadataCache* parquet_metadata_cache() const {
+    return parquet_metadata_cache_.get();
+  }
+
   const TNetworkAddress& configured_backend_address() const {
     return configured_backend_address_;
   }
@@ -237,6 +243,7 @@ class ExecEnv {
 
   /// Singleton cache for codegen functions.
   boost::scoped_ptr<CodeGenCache> codegen_cache_;
+  boost::scoped_ptr<ParquetMetadataCache> parquet_metadata_cache_;
 
   /// Not owned by this class
   ImpalaServer* impala_server_ = nullptr;
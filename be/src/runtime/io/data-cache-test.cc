@@ -38,6 +38,8 @@
 #include "util/counting-barrier.h"
 #include "util/disk-info.h"
 #include "util/filesystem-util.h"
+#include "util/impalad-metrics.h"
+#include "util/metrics.h"
 #include "util/simple-logger.h"
 #include "util/thread.h"
 
@@ -72,6 +74,8 @@ DECLARE_int32(max_data_cache_trace_file_size);
 DECLARE_int32(data_cache_trace_percentage);
 DECLARE_int32(data_cache_num_async_write_threads);
 DECLARE_string(data_cache_async_write_buffer_limit);
+DECLARE_string(data_cache_admission_policy);
+DECLARE_int32(data_cache_eviction_headroom_percent);
 
 namespace impala {
 namespace io {
@@ -108,6 +112,12 @@ class DataCacheBaseTest : public testing::Test {
     }
   }
 
+  /// Waits until the space of all evicted entries has been reclaimed by the evictor
+  /// threads of all partitions.
+  static void WaitForPendingEvictions(const DataCache& cache) {
+    for (auto& partition : cache.partitions_) partition->WaitForPendingEvictions();
+  }
+
   //
   // Use multiple threads to insert and read back a set of ranges from test_buffer().
   // Depending on the setting, the working set may or may not fit in the cache.
@@ -869,6 +879,193 @@ TEST_P(DataCacheTest, OutOfWriteBufferLimit) {
   EXPECT_LT(count, NUM_CACHE_ENTRIES_NO_EVICT);
 }
 
+// Verifies that the admission policies only insert an entry once it has been looked up
+// repeatedly.
+TEST_P(DataCacheTest, AdmissionPolicy) {
+  for (const string& policy : {"SECOND_HIT", "TINYLFU"}) {
+    FLAGS_data_cache_admission_policy = policy;
+    const int64_t cache_size = DEFAULT_CACHE_SIZE;
+    DataCache cache(Substitute("$0:$1", data_cache_dirs()[0], std::to_string(cache_size)),
+        FLAGS_data_cache_num_async_write_threads);
+    ASSERT_OK(cache.Init());
+    IntCounter* rejected_entries =
+        ImpaladMetrics::IO_MGR_REMOTE_DATA_CACHE_ADMISSION_REJECTED_ENTRIES;
+    const int64_t rejected_before = rejected_entries->GetValue();
+
+    // An entry which was never looked up is not admitted.
+    uint8_t buffer[TEMP_BUFFER_SIZE];
+    ASSERT_FALSE(cache.Store(FNAME, MTIME, 0, test_buffer(), TEMP_BUFFER_SIZE));
+
+    // Neither is an entry on its first lookup, as a one-off scan would do. Entries are
+    // admitted on their second lookup.
+    for (int64_t offset = 0; offset < 10; ++offset) {
+      ASSERT_EQ(0, cache.Lookup(FNAME, MTIME, offset, TEMP_BUFFER_SIZE, buffer));
+      ASSERT_FALSE(cache.Store(FNAME, MTIME, offset, test_buffer() + offset,
+          TEMP_BUFFER_SIZE));
+      ASSERT_EQ(0, cache.Lookup(FNAME, MTIME, offset, TEMP_BUFFER_SIZE, buffer));
+      ASSERT_TRUE(cache.Store(FNAME, MTIME, offset, test_buffer() + offset,
+          TEMP_BUFFER_SIZE));
+    }
+    WaitForAsyncWrite(cache);
+    for (int64_t offset = 0; offset < 10; ++offset) {
+      ASSERT_EQ(TEMP_BUFFER_SIZE,
+          cache.Lookup(FNAME, MTIME, offset, TEMP_BUFFER_SIZE, buffer));
+      ASSERT_EQ(0, memcmp(buffer, test_buffer() + offset, TEMP_BUFFER_SIZE));
+    }
+    EXPECT_EQ(rejected_before + 11, rejected_entries->GetValue());
+    ASSERT_OK(cache.CloseFilesAndVerifySizes());
+  }
+}
+
+// Verifies that reclaiming the space of evicted entries in the background doesn't let
+// the backing files exceed the capacity of the cache.
+TEST_P(DataCacheTest, EvictionHeadroom) {
+  FLAGS_data_cache_eviction_headroom_percent = 25;
+  const int64_t cache_size = DEFAULT_CACHE_SIZE;
+  DataCache cache(Substitute("$0:$1", data_cache_dirs()[0], std::to_string(cache_size)),
+      FLAGS_data_cache_num_async_write_threads);
+  ASSERT_OK(cache.Init());
+
+  // Insert twice as many entries as the cache can hold.
+  const int64_t num_entries = 2 * NUM_CACHE_ENTRIES;
+  for (int64_t offset = 0; offset < num_entries; ++offset) {
+    cache.Store(FNAME, MTIME, offset, test_buffer() + offset % 1024, TEMP_BUFFER_SIZE);
+    WaitForAsyncWrite(cache);
+  }
+  WaitForPendingEvictions(cache);
+  EXPECT_EQ(0,
+      ImpaladMetrics::IO_MGR_REMOTE_DATA_CACHE_PENDING_EVICTION_BYTES->GetValue());
+
+  // The headroom is not used for cached data.
+  uint8_t buffer[TEMP_BUFFER_SIZE];
+  int hit_count = 0;
+  for (int64_t offset = 0; offset < num_entries; ++offset) {
+    if (cache.Lookup(FNAME, MTIME, offset, TEMP_BUFFER_SIZE, buffer) > 0) ++hit_count;
+  }
+  EXPECT_GT(hit_count, 0);
+  EXPECT_LE(hit_count, NUM_CACHE_ENTRIES * 3 / 4);
+
+  // Verify the backing files don't exceed size limits.
+  ASSERT_OK(cache.CloseFilesAndVerifySizes());
+}
+
+// Verifies that entries evicted from the first tier are demoted to the second tier and
+// that entries hit repeatedly in the second tier are promoted back to the first tier.
+TEST_P(DataCacheTest, Tiers) {
+  // Demotion is done by the evictor threads.
+  FLAGS_data_cache_eviction_headroom_percent = 25;
+  const int64_t cache_size = DEFAULT_CACHE_SIZE;
+  DataCache cache(Substitute("$0:$2;$1:$2", data_cache_dirs()[0], data_cache_dirs()[1],
+      std::to_string(cache_size)), FLAGS_data_cache_num_async_write_threads);
+  ASSERT_OK(cache.Init());
+  MetricGroup* metrics = ImpaladMetrics::IO_MGR_METRICS;
+  IntCounter* demoted_entries = metrics->FindMetricForTesting<IntCounter>(
+      "impala-server.io-mgr.remote-data-cache-tier-1.demoted-entries");
+  IntCounter* promoted_entries = metrics->FindMetricForTesting<IntCounter>(
+      "impala-server.io-mgr.remote-data-cache-tier-0.promoted-entries");
+  IntCounter* tier0_hit_bytes = metrics->FindMetricForTesting<IntCounter>(
+      "impala-server.io-mgr.remote-data-cache-tier-0.hit-bytes");
+  ASSERT_TRUE(demoted_entries != nullptr);
+  ASSERT_TRUE(promoted_entries != nullptr);
+  ASSERT_TRUE(tier0_hit_bytes != nullptr);
+  const int64_t demoted_before = demoted_entries->GetValue();
+  const int64_t promoted_before = promoted_entries->GetValue();
+
+  // Insert more entries than the first tier can hold without its headroom.
+  for (int64_t offset = 0; offset < NUM_CACHE_ENTRIES; ++offset) {
+    cache.Store(FNAME, MTIME, offset, test_buffer() + offset, TEMP_BUFFER_SIZE);
+    WaitForAsyncWrite(cache);
+    WaitForPendingEvictions(cache);
+  }
+  EXPECT_GT(demoted_entries->GetValue(), demoted_before);
+
+  if (FLAGS_data_cache_eviction_policy == "LRU") {
+    // The oldest entries were demoted to the second tier so every entry is still cached.
+    EXPECT_EQ(demoted_before + NUM_CACHE_ENTRIES / 4, demoted_entries->GetValue());
+    uint8_t buffer[TEMP_BUFFER_SIZE];
+    for (int64_t offset = 0; offset < NUM_CACHE_ENTRIES; ++offset) {
+      ASSERT_EQ(TEMP_BUFFER_SIZE,
+          cache.Lookup(FNAME, MTIME, offset, TEMP_BUFFER_SIZE, buffer));
+      ASSERT_EQ(0, memcmp(buffer, test_buffer() + offset, TEMP_BUFFER_SIZE));
+    }
+    EXPECT_EQ(promoted_before, promoted_entries->GetValue());
+
+    // The second hit of a demoted entry promotes it to the first tier.
+    ASSERT_EQ(TEMP_BUFFER_SIZE, cache.Lookup(FNAME, MTIME, 0, TEMP_BUFFER_SIZE, buffer));
+    WaitForPendingEvictions(cache);
+    EXPECT_EQ(promoted_before + 1, promoted_entries->GetValue());
+    const int64_t tier0_hit_bytes_before = tier0_hit_bytes->GetValue();
+    ASSERT_EQ(TEMP_BUFFER_SIZE, cache.Lookup(FNAME, MTIME, 0, TEMP_BUFFER_SIZE, buffer));
+    ASSERT_EQ(0, memcmp(buffer, test_buffer(), TEMP_BUFFER_SIZE));
+    EXPECT_EQ(tier0_hit_bytes_before + TEMP_BUFFER_SIZE, tier0_hit_bytes->GetValue());
+  }
+
+  // Verify the backing files don't exceed size limits.
+  ASSERT_OK(cache.CloseFilesAndVerifySizes());
+}
+
+// Verifies that entries can be mapped into memory and that the hole of an entry evicted
+// while being mapped is only punched once all its mappings are released.
+TEST_P(DataCacheTest, MappedLookup) {
+  const int64_t cache_size = DEFAULT_CACHE_SIZE;
+  DataCache cache(Substitute("$0:$1", data_cache_dirs()[0], std::to_string(cache_size)),
+      FLAGS_data_cache_num_async_write_threads);
+  ASSERT_OK(cache.Init());
+  // Returns the number of bytes allocated for the backing files of the cache.
+  auto allocated_bytes = [this]() {
+    vector<string> entries;
+    EXPECT_OK(FileSystemUtil::Directory::GetEntryNames(data_cache_dirs()[0], &entries,
+        0, FileSystemUtil::Directory::EntryType::DIR_ENTRY_REG));
+    int64_t total = 0;
+    for (const string& entry : entries) {
+      struct stat st;
+      EXPECT_EQ(0, stat((path(data_cache_dirs()[0]) / entry).c_str(), &st));
+      total += st.st_blocks * 512;
+    }
+    return total;
+  };
+
+  ASSERT_TRUE(cache.Store(FNAME, MTIME, 0, test_buffer(), TEMP_BUFFER_SIZE));
+  WaitForAsyncWrite(cache);
+
+  // Misses and entries shorter than the requested range are not mapped.
+  unique_ptr<DataCache::MappedBuffer> buffer;
+  EXPECT_EQ(0, cache.LookupMapped(FNAME, MTIME, 1, TEMP_BUFFER_SIZE, &buffer));
+  EXPECT_EQ(0, cache.LookupMapped(FNAME, MTIME, 0, TEMP_BUFFER_SIZE + 1, &buffer));
+  EXPECT_TRUE(buffer == nullptr);
+
+  ASSERT_EQ(TEMP_BUFFER_SIZE,
+      cache.LookupMapped(FNAME, MTIME, 0, TEMP_BUFFER_SIZE, &buffer));
+  ASSERT_TRUE(buffer != nullptr);
+  ASSERT_EQ(TEMP_BUFFER_SIZE, buffer->len());
+  ASSERT_EQ(0, memcmp(buffer->data(), test_buffer(), TEMP_BUFFER_SIZE));
+  // A prefix of an entry can be mapped too.
+  unique_ptr<DataCache::MappedBuffer> prefix;
+  ASSERT_EQ(100, cache.LookupMapped(FNAME, MTIME, 0, 100, &prefix));
+  ASSERT_EQ(0, memcmp(prefix->data(), test_buffer(), 100));
+
+  // Evict the mapped entry by replacing it with a longer one.
+  ASSERT_TRUE(cache.Store(FNAME, MTIME, 0, test_buffer(), TEST_BUFFER_SIZE));
+  WaitForAsyncWrite(cache);
+  uint8_t read_buffer[TEST_BUFFER_SIZE];
+  ASSERT_EQ(TEST_BUFFER_SIZE,
+      cache.Lookup(FNAME, MTIME, 0, TEST_BUFFER_SIZE, read_buffer));
+  ASSERT_EQ(0, memcmp(read_buffer, test_buffer(), TEST_BUFFER_SIZE));
+
+  // The mappings of the evicted entry still see its data.
+  ASSERT_EQ(0, memcmp(buffer->data(), test_buffer(), TEMP_BUFFER_SIZE));
+  const int64_t allocated_before = allocated_bytes();
+  prefix.reset();
+  EXPECT_EQ(allocated_before, allocated_bytes());
+  ASSERT_EQ(0, memcmp(buffer->data(), test_buffer(), TEMP_BUFFER_SIZE));
+  // The hole is punched once the last mapping is released.
+  buffer.reset();
+  EXPECT_LT(allocated_bytes(), allocated_before);
+
+  // Verify the backing files don't exceed size limits.
+  ASSERT_OK(cache.CloseFilesAndVerifySizes());
+}
+
 } // namespace io
 } // namespace impala
 
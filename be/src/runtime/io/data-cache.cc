@@ -17,10 +17,12 @@
 
 #include "runtime/io/data-cache.h"
 
+#include <atomic>
 #include <errno.h>
 #include <fcntl.h>
 #include <mutex>
 #include <string.h>
+#include <sys/mman.h>
 #include <unistd.h>
 #include <sstream>
 
@@ -37,6 +39,7 @@
 #include "runtime/io/data-cache-trace.h"
 #include "util/bit-util.h"
 #include "util/cache/cache.h"
+#include "util/collection-metrics.h"
 #include "util/disk-info.h"
 #include "util/error-util.h"
 #include "util/filesystem-util.h"
@@ -47,6 +50,7 @@
 #include "util/parse-util.h"
 #include "util/pretty-printer.h"
 #include "util/scope-exit-trigger.h"
+#include "util/stopwatch.h"
 #include "util/test-info.h"
 #include "util/uid-util.h"
 
@@ -119,6 +123,22 @@ DEFINE_string(data_cache_eviction_policy, "LRU",
 DEFINE_string(data_cache_async_write_buffer_limit, "1GB",
     "(Experimental) Limit of the total buffer size used by asynchronous store tasks.");
 
+DEFINE_string(data_cache_admission_policy, "ALL",
+    "(Advanced) The policy deciding which ranges are inserted into the data cache. "
+    "Either 'ALL' (default) which inserts every range, 'SECOND_HIT' which inserts a "
+    "range on its second lookup or 'TINYLFU' which inserts a range once its estimated "
+    "lookup frequency is at least 2.");
+DEFINE_int32(data_cache_eviction_headroom_percent, 0,
+    "(Advanced) Percentage of the capacity of each data cache partition reserved for "
+    "evicted entries whose space is reclaimed by a background thread. If 0, the space "
+    "is reclaimed synchronously by the thread inserting into the cache. Must be "
+    "between 0 and 50.");
+DEFINE_bool(data_cache_mmap_reads, false,
+    "(Experimental) If true, scan ranges which are entirely cached in the data cache "
+    "are read from a read-only mapping of the cache's backing file instead of being "
+    "copied into I/O buffers. The space of an evicted entry is reclaimed once the scan "
+    "ranges reading it are done with it.");
+
 namespace impala {
 namespace io {
 
@@ -130,6 +150,17 @@ const int MAX_FILE_DELETER_QUEUE_SIZE = 500;
 // on the queue are bound by --data_cache_async_write_bufer_limit.
 const int MAX_STORE_TASK_QUEUE_SIZE = 1 << 20;
 
+// Holes are punched inline once this many are queued, so the queue never blocks the
+// thread evicting from the metadata cache. The total size of the queued holes is bound
+// by the eviction headroom of the partition.
+const int MAX_PENDING_HOLE_QUEUE_SIZE = 1 << 20;
+
+// The admission policies track about one key per this many bytes of cache capacity,
+// clamped to the range below.
+static const int64_t ADMISSION_POLICY_BYTES_PER_KEY = 64L * 1024;
+static const int64_t ADMISSION_POLICY_MIN_KEYS = 1L << 16;
+static const int64_t ADMISSION_POLICY_MAX_KEYS = 1L << 22;
+
 static const char* PARTITION_PATH_METRIC_KEY_TEMPLATE =
     "impala-server.io-mgr.remote-data-cache-partition-$0.path";
 static const char* PARTITION_READ_LATENCY_METRIC_KEY_TEMPLATE =
@@ -138,6 +169,16 @@ static const char* PARTITION_WRITE_LATENCY_METRIC_KEY_TEMPLATE =
     "impala-server.io-mgr.remote-data-cache-partition-$0.write-latency";
 static const char* PARTITION_EVICTION_LATENCY_METRIC_KEY_TEMPLATE =
     "impala-server.io-mgr.remote-data-cache-partition-$0.eviction-latency";
+static const char* TIER_HIT_RATIO_METRIC_KEY_TEMPLATE =
+    "impala-server.io-mgr.remote-data-cache-tier-$0.hit-ratio";
+static const char* TIER_HIT_BYTES_METRIC_KEY_TEMPLATE =
+    "impala-server.io-mgr.remote-data-cache-tier-$0.hit-bytes";
+static const char* TIER_READ_TIME_METRIC_KEY_TEMPLATE =
+    "impala-server.io-mgr.remote-data-cache-tier-$0.read-time";
+static const char* TIER_PROMOTED_ENTRIES_METRIC_KEY_TEMPLATE =
+    "impala-server.io-mgr.remote-data-cache-tier-$0.promoted-entries";
+static const char* TIER_DEMOTED_ENTRIES_METRIC_KEY_TEMPLATE =
+    "impala-server.io-mgr.remote-data-cache-tier-$0.demoted-entries";
 
 
 /// This class is an implementation of backing files in a cache partition.
@@ -165,9 +206,15 @@ static const char* PARTITION_EVICTION_LATENCY_METRIC_KEY_TEMPLATE =
 /// entry which references a deleted file will either be lazily erased on Read() or
 /// evicted due to inactivity.
 ///
+/// Entries can also be mapped into memory via Map(). The mappings are made through a
+/// separate read-only file descriptor and outlive the closing and deletion of the file.
+/// The number of mappings of each entry is tracked and punching the hole of an entry
+/// which is still mapped is deferred until its last mapping is released via Unmap().
+///
 class DataCache::CacheFile {
  public:
   ~CacheFile() {
+    DCHECK(mapped_regions_.empty()) << "Cache file " << path_ << " is still mapped.";
     // Close file if it's not closed already.
     DeleteFile();
   }
@@ -194,6 +241,12 @@ class DataCache::CacheFile {
     }
     file_.reset();
     allow_append_ = false;
+    // Existing mappings stay valid after closing the descriptor they were made through.
+    std::lock_guard<std::mutex> map_lock(map_lock_);
+    if (map_fd_ >= 0) {
+      close(map_fd_);
+      map_fd_ = -1;
+    }
   }
 
   // Close the underlying file and delete it from the filesystem.
@@ -265,6 +318,55 @@ class DataCache::CacheFile {
     return true;
   }
 
+  // Maps 'len' bytes of the entry at byte offset 'offset' into memory. Returns the
+  // start of the entry in the mapping or NULL on error or if the file is already closed.
+  // The hole of the entry won't be punched until the mapping is released via Unmap().
+  // Entries are aligned to PAGE_SIZE, which may be smaller than the page size of the
+  // system, so the mapping may start up to a system page before the entry.
+  uint8_t* Map(int64_t offset, int64_t len) {
+    DCHECK_EQ(offset % PAGE_SIZE, 0);
+    const int64_t delta = MapDelta(offset);
+    void* data;
+    {
+      // Hold the lock in shared mode to check if 'file_' is not closed already.
+      kudu::shared_lock<rw_spinlock> lock(lock_.get_lock());
+      if (UNLIKELY(!file_)) return nullptr;
+      DCHECK_LE(offset + len, current_offset_.Load());
+      int fd;
+      {
+        std::lock_guard<std::mutex> map_lock(map_lock_);
+        if (map_fd_ < 0) {
+          map_fd_ = open(path_.c_str(), O_RDONLY | O_CLOEXEC);
+          if (UNLIKELY(map_fd_ < 0)) {
+            LOG(ERROR) << Substitute("Failed to open $0 for mapping: $1", path_,
+                GetStrErrMsg());
+            return nullptr;
+          }
+        }
+        fd = map_fd_;
+        ++mapped_regions_[offset].num_mappings;
+      }
+      // 'fd' can't be closed while the lock is held.
+      data = mmap(nullptr, len + delta, PROT_READ, MAP_SHARED, fd, offset - delta);
+      if (LIKELY(data != MAP_FAILED)) return reinterpret_cast<uint8_t*>(data) + delta;
+      LOG(ERROR) << Substitute("Failed to map $0 at offset $1 for $2 bytes: $3", path_,
+          offset, PrettyPrinter::PrintBytes(len), GetStrErrMsg());
+    }
+    ReleaseRegion(offset);
+    return nullptr;
+  }
+
+  // Releases the mapping 'data' of 'len' bytes returned by Map(offset, len). Punches
+  // the hole of the entry if it was evicted and this was its last mapping.
+  void Unmap(int64_t offset, uint8_t* data, int64_t len) {
+    const int64_t delta = MapDelta(offset);
+    if (UNLIKELY(munmap(data - delta, len + delta) != 0)) {
+      LOG(DFATAL) << Substitute("Failed to unmap $0 at offset $1 for $2 bytes: $3",
+          path_, offset, PrettyPrinter::PrintBytes(len), GetStrErrMsg());
+    }
+    ReleaseRegion(offset);
+  }
+
   void PunchHole(int64_t offset, int64_t hole_size) {
     DCHECK_EQ(offset % PAGE_SIZE, 0);
     DCHECK_EQ(hole_size % PAGE_SIZE, 0);
@@ -272,6 +374,15 @@ class DataCache::CacheFile {
     kudu::shared_lock<rw_spinlock> lock(lock_.get_lock());
     if (UNLIKELY(!file_)) return;
     DCHECK_LE(offset + hole_size, current_offset_.Load());
+    {
+      // Leave the hole to the last Unmap() of the entry if it's still mapped.
+      std::lock_guard<std::mutex> map_lock(map_lock_);
+      auto it = mapped_regions_.find(offset);
+      if (it != mapped_regions_.end()) {
+        it->second.pending_hole_size = hole_size;
+        return;
+      }
+    }
     kudu::Status status = file_->PunchHole(offset, hole_size);
     if (UNLIKELY(!status.ok())) {
       LOG(DFATAL) << Substitute("Failed to punch hole in $0 at offset $1 for $2 $3",
@@ -282,6 +393,23 @@ class DataCache::CacheFile {
   const string& path() const { return path_; }
 
  private:
+  /// Returns the distance of the entry at 'offset' from the start of the system page it
+  /// is in, where mappings of the entry have to start.
+  static int64_t MapDelta(int64_t offset) {
+    static const int64_t system_page_size = sysconf(_SC_PAGESIZE);
+    return offset % system_page_size;
+  }
+
+  /// An entry which is mapped into memory.
+  struct MappedRegion {
+    /// The number of mappings of the entry which haven't been released.
+    int num_mappings = 0;
+
+    /// The size of the hole to punch once the last mapping is released. 0 if the entry
+    /// hasn't been evicted.
+    int64_t pending_hole_size = 0;
+  };
+
   /// Full path of the backing file in the local storage.
   const string path_;
 
@@ -302,9 +430,34 @@ class DataCache::CacheFile {
   /// punched after it has been closed. The only operation allowed is to deletion.
   percpu_rwlock lock_;
 
+  /// Protects the fields below.
+  std::mutex map_lock_;
+
+  /// Read-only descriptor of the file used for mapping entries. Opened on the first
+  /// Map() and closed by Close(). -1 if not open.
+  int map_fd_ = -1;
+
+  /// The mapped entries keyed by their offsets in the file.
+  std::unordered_map<int64_t, MappedRegion> mapped_regions_;
+
   /// C'tor of CacheFile to be called by Create() only.
   explicit CacheFile(std::string path) : path_(move(path)) { }
 
+  /// Drops a mapping of the entry at 'offset' and punches its pending hole if that was
+  /// the last mapping.
+  void ReleaseRegion(int64_t offset) {
+    int64_t hole_size;
+    {
+      std::lock_guard<std::mutex> map_lock(map_lock_);
+      auto it = mapped_regions_.find(offset);
+      DCHECK(it != mapped_regions_.end());
+      if (--it->second.num_mappings > 0) return;
+      hole_size = it->second.pending_hole_size;
+      mapped_regions_.erase(it);
+    }
+    if (hole_size > 0) PunchHole(offset, hole_size);
+  }
+
   DISALLOW_COPY_AND_ASSIGN(CacheFile);
 };
 
@@ -354,6 +507,11 @@ struct DataCache::CacheKey {
     key_.append(filename);
   }
 
+  // Reconstructs a cache key from its encoding returned by ToSlice().
+  explicit CacheKey(const Slice& key) : key_(key.size()) {
+    key_.append(key.data(), key.size());
+  }
+
   int64_t Hash() const {
     return HashUtil::FastHash64(key_.data(), key_.size(), 0);
   }
@@ -412,6 +570,193 @@ class DataCache::StoreTask {
   DataCache* cache_;
 };
 
+/// Decides which entries are inserted into the cache based on how often their keys
+/// have been looked up. Every lookup in a partition is recorded via RecordAccess() and
+/// a store is only attempted if Admit() returns true for its key. Keys are identified
+/// by a 64-bit hash only, so a hash collision may occasionally admit a key early.
+///
+/// RecordAccess() and Admit() are called concurrently without any locks. The state is
+/// kept in relaxed atomics so racing updates of the same slot may occasionally be lost,
+/// which only makes the policy slightly more conservative.
+class DataCache::AdmissionPolicy {
+ public:
+  virtual ~AdmissionPolicy() {}
+
+  /// Creates the admission policy named 'policy' for a partition of 'capacity' bytes.
+  /// Returns nullptr for 'ALL', in which case all entries are admitted.
+  static unique_ptr<AdmissionPolicy> Create(const string& policy, int64_t capacity);
+
+  /// Returns true iff 'policy' is a valid value of --data_cache_admission_policy.
+  static bool IsValidPolicy(const string& policy) {
+    return policy == "ALL" || policy == "SECOND_HIT" || policy == "TINYLFU";
+  }
+
+  /// Computes the hash identifying the cache key 'key'. A different seed from the one
+  /// used for choosing the partition is used so all bits of the hash are useful.
+  static uint64_t Hash(const Slice& key) {
+    return HashUtil::FastHash64(key.data(), key.size(), 0xadd1c7ed);
+  }
+
+  /// Records a lookup of the key with hash 'hash'.
+  virtual void RecordAccess(uint64_t hash) = 0;
+
+  /// Returns true iff the key with hash 'hash' should be inserted into the cache.
+  virtual bool Admit(uint64_t hash) const = 0;
+
+ protected:
+  /// Returns the number of keys tracked for a partition of 'capacity' bytes. Always a
+  /// power of 2.
+  static int64_t NumKeys(int64_t capacity) {
+    int64_t num_keys = capacity / ADMISSION_POLICY_BYTES_PER_KEY;
+    num_keys = max(ADMISSION_POLICY_MIN_KEYS, min(ADMISSION_POLICY_MAX_KEYS, num_keys));
+    return BitUtil::RoundUpToPowerOfTwo(num_keys);
+  }
+
+ private:
+  class SecondHit;
+  class TinyLfu;
+};
+
+/// Admits a key on its second lookup. The hashes of recently looked up keys are kept in
+/// a direct-mapped ghost table. The lowest bit of a slot is set once the key in it has
+/// been looked up again. A key is forgotten once another key maps to the same slot.
+class DataCache::AdmissionPolicy::SecondHit : public DataCache::AdmissionPolicy {
+ public:
+  explicit SecondHit(int64_t capacity)
+    : mask_(NumKeys(capacity) - 1), slots_(new std::atomic<uint64_t>[mask_ + 1]) {
+    for (int64_t i = 0; i <= mask_; ++i) slots_[i].store(0, std::memory_order_relaxed);
+  }
+
+  void RecordAccess(uint64_t hash) override {
+    std::atomic<uint64_t>& slot = slots_[hash & mask_];
+    const uint64_t fingerprint = hash & ~SEEN_TWICE;
+    const uint64_t current = slot.load(std::memory_order_relaxed);
+    slot.store((current & ~SEEN_TWICE) == fingerprint ? fingerprint | SEEN_TWICE :
+        fingerprint, std::memory_order_relaxed);
+  }
+
+  bool Admit(uint64_t hash) const override {
+    return slots_[hash & mask_].load(std::memory_order_relaxed) == (hash | SEEN_TWICE);
+  }
+
+ private:
+  static constexpr uint64_t SEEN_TWICE = 1;
+  const int64_t mask_;
+  const unique_ptr<std::atomic<uint64_t>[]> slots_;
+};
+
+/// Admits a key once its estimated lookup frequency reaches ADMIT_THRESHOLD. The
+/// frequencies are estimated by a count-min sketch of counters saturating at MAX_COUNT
+/// with NUM_ROWS rows, updated conservatively (i.e. only the smallest counters of a key
+/// are incremented). Every counter is halved once per 10 lookups per counter in a row so
+/// the sketch reflects recent accesses. The halving is done incrementally, one segment of
+/// AGE_SEGMENT_SIZE counters at a time, so that no single lookup pays for halving the
+/// whole sketch. Unlike SecondHit, a small fraction of the
+/// keys of a scan much larger than the sketch may be admitted on their first lookup
+/// due to collisions, but keys which are looked up repeatedly are remembered for longer.
+class DataCache::AdmissionPolicy::TinyLfu : public DataCache::AdmissionPolicy {
+ public:
+  explicit TinyLfu(int64_t capacity)
+    : mask_(NumKeys(capacity) - 1),
+      num_counters_(NUM_ROWS * (mask_ + 1)),
+      num_age_segments_(max<int64_t>(1, num_counters_ / AGE_SEGMENT_SIZE)),
+      age_interval_(10 * (mask_ + 1) / num_age_segments_),
+      counters_(new std::atomic<uint8_t>[num_counters_]) {
+    DCHECK_EQ(num_counters_ % num_age_segments_, 0);
+    for (int64_t i = 0; i < num_counters_; ++i) {
+      counters_[i].store(0, std::memory_order_relaxed);
+    }
+  }
+
+  void RecordAccess(uint64_t hash) override {
+    const int estimate = Estimate(hash);
+    if (estimate < MAX_COUNT) {
+      for (int row = 0; row < NUM_ROWS; ++row) {
+        std::atomic<uint8_t>& counter = Counter(hash, row);
+        if (counter.load(std::memory_order_relaxed) == estimate) {
+          counter.store(estimate + 1, std::memory_order_relaxed);
+        }
+      }
+    }
+    if (num_accesses_.Add(1) % age_interval_ == 0) AgeSegment();
+  }
+
+  bool Admit(uint64_t hash) const override { return Estimate(hash) >= ADMIT_THRESHOLD; }
+
+ private:
+  static constexpr int NUM_ROWS = 4;
+  static constexpr int MAX_COUNT = 15;
+  static constexpr int ADMIT_THRESHOLD = 2;
+  static constexpr int64_t AGE_SEGMENT_SIZE = 4096;
+
+  const int64_t mask_;
+  const int64_t num_counters_;
+
+  /// The counters are aged in 'num_age_segments_' segments of equal size, one segment
+  /// per 'age_interval_' calls to RecordAccess().
+  const int64_t num_age_segments_;
+  const int64_t age_interval_;
+
+  /// NUM_ROWS rows of (mask_ + 1) counters each.
+  const unique_ptr<std::atomic<uint8_t>[]> counters_;
+
+  /// Number of calls to RecordAccess(). Used for deciding when to age the counters.
+  AtomicInt64 num_accesses_{0};
+
+  /// Number of calls to AgeSegment(). Used for picking the next segment to age.
+  AtomicInt64 num_aged_segments_{0};
+
+  /// Returns the counter in 'row' for the key with hash 'hash'. Uses double hashing
+  /// on the two halves of 'hash' to pick a different counter in each row.
+  std::atomic<uint8_t>& Counter(uint64_t hash, int row) const {
+    const uint64_t idx = (static_cast<uint32_t>(hash) + row * (hash >> 32)) & mask_;
+    return counters_[row * (mask_ + 1) + idx];
+  }
+
+  int Estimate(uint64_t hash) const {
+    int estimate = MAX_COUNT;
+    for (int row = 0; row < NUM_ROWS; ++row) {
+      estimate = min<int>(estimate, Counter(hash, row).load(std::memory_order_relaxed));
+    }
+    return estimate;
+  }
+
+  /// Halves the counters of the next segment in round-robin order.
+  void AgeSegment() {
+    const int64_t segment_size = num_counters_ / num_age_segments_;
+    const int64_t segment = (num_aged_segments_.Add(1) - 1) % num_age_segments_;
+    for (int64_t i = segment * segment_size; i < (segment + 1) * segment_size; ++i) {
+      counters_[i].store(counters_[i].load(std::memory_order_relaxed) >> 1,
+          std::memory_order_relaxed);
+    }
+  }
+};
+
+unique_ptr<DataCache::AdmissionPolicy> DataCache::AdmissionPolicy::Create(
+    const string& policy, int64_t capacity) {
+  DCHECK(IsValidPolicy(policy)) << policy;
+  if (policy == "SECOND_HIT") return make_unique<SecondHit>(capacity);
+  if (policy == "TINYLFU") return make_unique<TinyLfu>(capacity);
+  return nullptr;
+}
+
+/// A region of a backing file to be reclaimed by the evictor thread of a partition.
+/// The backing files of a partition stay valid until the partition is closed, which
+/// happens only after its evictor thread has been joined.
+struct DataCache::Partition::PendingHole {
+  CacheFile* file;
+  int64_t offset;
+  int64_t len;
+
+  /// The length and checksum of the evicted entry's data.
+  int64_t data_len;
+  uint64_t checksum;
+
+  /// The encoded cache key of the evicted entry if it should be demoted to the next
+  /// tier. Empty otherwise.
+  std::string key;
+};
+
 static Cache::EvictionPolicy GetCacheEvictionPolicy(const std::string& policy_string) {
   Cache::EvictionPolicy policy = Cache::ParseEvictionPolicy(policy_string);
   if (policy != Cache::EvictionPolicy::LRU && policy != Cache::EvictionPolicy::LIRS) {
@@ -446,16 +791,23 @@ static int32_t DeviceWriteConcurrency(const string& path) {
   return write_concurrency;
 }
 
-DataCache::Partition::Partition(
-    int32_t index, const string& path, int64_t capacity, int max_opened_files,
-    bool trace_replay)
-  : index_(index),
+DataCache::Partition::Partition(DataCache* cache, int32_t index, int tier,
+    const string& path, int64_t capacity, int max_opened_files, bool trace_replay)
+  : cache_(cache),
+    index_(index),
+    tier_(tier),
     path_(path),
     capacity_(max<int64_t>(capacity, PAGE_SIZE)),
     max_opened_files_(max_opened_files),
+    eviction_headroom_(BitUtil::RoundDown(
+        capacity_ * FLAGS_data_cache_eviction_headroom_percent / 100, PAGE_SIZE)),
     trace_replay_(trace_replay),
     meta_cache_(NewCache(GetCacheEvictionPolicy(FLAGS_data_cache_eviction_policy),
-        capacity_, path_)) {}
+        capacity_ - eviction_headroom_, path_)),
+    // Only the first tier takes new entries so the other tiers need no admission policy.
+    admission_policy_(tier_ == 0 ?
+        AdmissionPolicy::Create(FLAGS_data_cache_admission_policy, capacity_) :
+        nullptr) {}
 
 DataCache::Partition::~Partition() {
   if (!closed_) ReleaseResources();
@@ -549,6 +901,15 @@ Status DataCache::Partition::Init() {
   // Create metrics for this partition
   InitMetrics();
 
+  // Starts a thread which reclaims the space of evicted entries so that the threads
+  // inserting into the cache don't need to wait for the holes to be punched.
+  if (eviction_headroom_ > 0) {
+    evictor_pool_.reset(new ThreadPool<PendingHole>("data-cache",
+        Substitute("data-cache-evictor-$0", index_), 1, MAX_PENDING_HOLE_QUEUE_SIZE,
+        bind<void>(&DataCache::Partition::PunchPendingHole, this, _1, _2)));
+    RETURN_IF_ERROR(evictor_pool_->Init());
+  }
+
   // Create a backing file for the partition.
   RETURN_IF_ERROR(CreateCacheFile());
   oldest_opened_file_ = 0;
@@ -624,7 +985,13 @@ Status DataCache::Partition::CloseFilesAndVerifySizes() {
   return Status::OK();
 }
 
+void DataCache::Partition::DrainPendingEvictions() {
+  if (evictor_pool_ != nullptr) evictor_pool_->DrainAndShutdown();
+}
+
 void DataCache::Partition::ReleaseResources() {
+  // Finish reclaiming the space of evicted entries before closing the backing files.
+  DrainPendingEvictions();
   std::unique_lock<SpinLock> partition_lock(lock_);
   if (closed_) return;
   closed_ = true;
@@ -635,20 +1002,33 @@ void DataCache::Partition::ReleaseResources() {
 }
 
 int64_t DataCache::Partition::Lookup(const CacheKey& cache_key, int64_t bytes_to_read,
-    uint8_t* buffer) {
+    uint8_t* buffer, unique_ptr<MappedBuffer>* mapped, int64_t* entry_len) {
   DCHECK(!closed_);
-  DCHECK(trace_replay_ ? buffer == nullptr : buffer != nullptr);
+  DCHECK(trace_replay_ ? buffer == nullptr && mapped == nullptr :
+      (buffer == nullptr) != (mapped == nullptr));
   Slice key = cache_key.ToSlice();
+  // A mapped lookup is only accounted for if the entry gets mapped.
+  if (admission_policy_ != nullptr && mapped == nullptr) {
+    admission_policy_->RecordAccess(AdmissionPolicy::Hash(key));
+  }
   Cache::UniqueHandle handle(meta_cache_->Lookup(key));
 
   if (handle.get() == nullptr) {
-    Trace(trace::EventType::MISS, cache_key, bytes_to_read, /*entry_len=*/-1);
+    if (mapped == nullptr) {
+      Trace(trace::EventType::MISS, cache_key, bytes_to_read, /*entry_len=*/-1);
+    }
     return 0;
   }
 
   // Read from the backing file.
   CacheEntry entry(meta_cache_->Value(handle));
 
+  if (mapped != nullptr) {
+    if (entry.len() < bytes_to_read) return 0;
+    if (admission_policy_ != nullptr) {
+      admission_policy_->RecordAccess(AdmissionPolicy::Hash(key));
+    }
+  }
   Trace(trace::EventType::HIT, cache_key, bytes_to_read, entry.len());
 
   bytes_to_read = min(entry.len(), bytes_to_read);
@@ -657,26 +1037,55 @@ int64_t DataCache::Partition::Lookup(const CacheKey& cache_key, int64_t bytes_to
     CacheFile* cache_file = entry.file();
     VLOG(3) << Substitute("Reading file $0 offset $1 len $2 checksum $3 bytes_to_read $4",
         cache_file->path(), entry.offset(), entry.len(), entry.checksum(), bytes_to_read);
-    bool read_success;
-    {
-      ScopedHistogramTimer read_timer(read_latency_);
-      read_success = cache_file->Read(entry.offset(), buffer, bytes_to_read);
-    }
-    if (UNLIKELY(!read_success)) {
-      meta_cache_->Erase(key);
-      return 0;
+    const uint8_t* data = buffer;
+    if (mapped == nullptr) {
+      bool read_success;
+      {
+        ScopedHistogramTimer read_timer(read_latency_);
+        read_success = cache_file->Read(entry.offset(), buffer, bytes_to_read);
+      }
+      if (UNLIKELY(!read_success)) {
+        meta_cache_->Erase(key);
+        return 0;
+      }
+    } else {
+      // The handle keeps the entry from being evicted until the mapping is registered
+      // with the backing file.
+      uint8_t* mapped_data;
+      {
+        ScopedHistogramTimer read_timer(read_latency_);
+        mapped_data = cache_file->Map(entry.offset(), bytes_to_read);
+      }
+      // Leave it to Lookup() to erase the entry if the file is closed.
+      if (UNLIKELY(mapped_data == nullptr)) return 0;
+      mapped->reset(
+          new MappedBuffer(cache_file, entry.offset(), mapped_data, bytes_to_read));
+      data = mapped_data;
     }
 
     // Verify checksum if enabled. Delete entry on checksum mismatch.
     if (FLAGS_data_cache_checksum && bytes_to_read == entry.len() &&
-        !VerifyChecksum("read", entry, buffer, bytes_to_read)) {
+        !VerifyChecksum("read", entry, data, bytes_to_read)) {
+      if (mapped != nullptr) mapped->reset();
       meta_cache_->Erase(key);
       return 0;
     }
   }
+  *entry_len = entry.len();
   return bytes_to_read;
 }
 
+bool DataCache::Partition::Contains(const CacheKey& cache_key) {
+  DCHECK(!closed_);
+  Cache::UniqueHandle handle(meta_cache_->Lookup(cache_key.ToSlice(), Cache::NO_UPDATE));
+  return handle.get() != nullptr;
+}
+
+void DataCache::Partition::Erase(const CacheKey& cache_key) {
+  DCHECK(!closed_);
+  meta_cache_->Erase(cache_key.ToSlice());
+}
+
 bool DataCache::Partition::HandleExistingEntry(const Slice& key,
     const Cache::UniqueHandle& handle, const uint8_t* buffer, int64_t buffer_len) {
   // Unpack the cache entry.
@@ -758,7 +1167,7 @@ bool DataCache::Partition::Store(const CacheKey& cache_key, const uint8_t* buffe
   *start_reclaim = false;
   Slice key = cache_key.ToSlice();
   const int64_t charge_len = BitUtil::RoundUp(buffer_len, PAGE_SIZE);
-  if (charge_len > capacity_) return false;
+  if (charge_len > capacity_ - eviction_headroom_) return false;
 
   // Check for existing entry.
   {
@@ -829,6 +1238,20 @@ bool DataCache::Partition::Store(const CacheKey& cache_key, const uint8_t* buffe
   return insert_success;
 }
 
+bool DataCache::Partition::Admit(const CacheKey& cache_key, int64_t buffer_len) {
+  DCHECK(!closed_);
+  if (admission_policy_ == nullptr) return true;
+  if (admission_policy_->Admit(AdmissionPolicy::Hash(cache_key.ToSlice()))) return true;
+  // Trace replays do not keep metrics
+  if (LIKELY(!trace_replay_)) {
+    ImpaladMetrics::IO_MGR_REMOTE_DATA_CACHE_ADMISSION_REJECTED_BYTES->Increment(
+        buffer_len);
+    ImpaladMetrics::IO_MGR_REMOTE_DATA_CACHE_ADMISSION_REJECTED_ENTRIES->Increment(1);
+  }
+  Trace(trace::EventType::STORE_FAILED, cache_key, /*lookup_len=*/-1, buffer_len);
+  return false;
+}
+
 void DataCache::Partition::DeleteOldFiles() {
   std::unique_lock<SpinLock> partition_lock(lock_);
   DCHECK_GE(oldest_opened_file_, 0);
@@ -841,14 +1264,74 @@ void DataCache::Partition::DeleteOldFiles() {
 void DataCache::Partition::EvictedEntry(Slice key, Slice value) {
   if (closed_) return;
   if (UNLIKELY(trace_replay_)) return;
-  ScopedHistogramTimer eviction_timer(eviction_latency_);
   // Unpack the cache entry.
   CacheEntry entry(value);
   int64_t eviction_len = BitUtil::RoundUp(entry.len(), PAGE_SIZE);
   DCHECK_EQ(entry.offset() % PAGE_SIZE, 0);
-  entry.file()->PunchHole(entry.offset(), eviction_len);
   ImpaladMetrics::IO_MGR_REMOTE_DATA_CACHE_TOTAL_BYTES->Increment(-eviction_len);
   ImpaladMetrics::IO_MGR_REMOTE_DATA_CACHE_NUM_ENTRIES->Increment(-1);
+
+  // Leave the hole to the evictor thread if the bytes waiting to be reclaimed still fit
+  // in the headroom. The metadata cache never holds more than 'capacity_' minus the
+  // headroom so the backing files never exceed 'capacity_'. The evictor thread also
+  // demotes the entry if this isn't the last tier.
+  if (evictor_pool_ != nullptr) {
+    int64_t pending_bytes = pending_eviction_bytes_.Add(eviction_len);
+    const bool demote = tier_ + 1 < static_cast<int>(cache_->tiers_.size());
+    if (pending_bytes <= eviction_headroom_ &&
+        evictor_pool_->Offer(PendingHole{entry.file(), entry.offset(), eviction_len,
+            entry.len(), entry.checksum(), demote ? key.ToString() : string()},
+            /*timeout_millis=*/0)) {
+      ImpaladMetrics::IO_MGR_REMOTE_DATA_CACHE_PENDING_EVICTION_BYTES->Increment(
+          eviction_len);
+      return;
+    }
+    pending_eviction_bytes_.Add(-eviction_len);
+  }
+  ScopedHistogramTimer eviction_timer(eviction_latency_);
+  entry.file()->PunchHole(entry.offset(), eviction_len);
+}
+
+void DataCache::Partition::PunchPendingHole(uint32_t thread_id,
+    const PendingHole& hole) {
+  if (!hole.key.empty()) DemoteEntry(hole);
+  {
+    ScopedHistogramTimer eviction_timer(eviction_latency_);
+    hole.file->PunchHole(hole.offset, hole.len);
+  }
+  pending_eviction_bytes_.Add(-hole.len);
+  DCHECK_GE(pending_eviction_bytes_.Load(), 0);
+  ImpaladMetrics::IO_MGR_REMOTE_DATA_CACHE_PENDING_EVICTION_BYTES->Increment(-hole.len);
+}
+
+void DataCache::Partition::DemoteEntry(const PendingHole& hole) {
+  const CacheKey cache_key{Slice(hole.key)};
+  // Don't demote an entry which was erased after being promoted to a faster tier.
+  for (int tier = 0; tier < tier_; ++tier) {
+    if (cache_->partitions_[cache_->PartitionIndex(tier, cache_key)]->Contains(
+            cache_key)) {
+      return;
+    }
+  }
+  unique_ptr<uint8_t[]> buffer(new uint8_t[hole.data_len]);
+  {
+    ScopedHistogramTimer read_timer(read_latency_);
+    if (!hole.file->Read(hole.offset, buffer.get(), hole.data_len)) return;
+  }
+  if (FLAGS_data_cache_checksum && !VerifyChecksum("demote",
+          CacheEntry(hole.file, hole.offset, hole.data_len, hole.checksum), buffer.get(),
+          hole.data_len)) {
+    return;
+  }
+  if (cache_->StoreInternal(cache_key, buffer.get(), hole.data_len, tier_ + 1)) {
+    cache_->tiers_[tier_ + 1].demoted_entries->Increment(1);
+  }
+}
+
+void DataCache::Partition::WaitForPendingEvictions() {
+  while (pending_eviction_bytes_.Load() != 0) {
+    usleep(500);
+  }
 }
 
 // TODO: Switch to using CRC32 once we fix the TODO in hash-util.h
@@ -890,44 +1373,88 @@ Status DataCache::Init() {
         "Must be at least 0; 0 uses a device-specific default.",
         FLAGS_data_cache_write_concurrency));
   }
+  if (!AdmissionPolicy::IsValidPolicy(FLAGS_data_cache_admission_policy)) {
+    return Status(Substitute("Misconfigured --data_cache_admission_policy: $0. Must be "
+        "one of ALL, SECOND_HIT or TINYLFU.", FLAGS_data_cache_admission_policy));
+  }
+  if (FLAGS_data_cache_eviction_headroom_percent < 0 ||
+      FLAGS_data_cache_eviction_headroom_percent > 50) {
+    return Status(Substitute("Misconfigured --data_cache_eviction_headroom_percent: $0. "
+        "Must be between 0 and 50.", FLAGS_data_cache_eviction_headroom_percent));
+  }
 
-  // The expected form of the configuration string is: dir1,dir2,..,dirN:capacity
-  // Example: /tmp/data1,/tmp/data2:1TB
-  vector<string> all_cache_configs = Split(config_, ":", SkipEmpty());
-  if (all_cache_configs.size() != 2) {
+  // The expected form of the configuration string is a list of tiers separated by ';',
+  // fastest tier first. Each tier is of the form: dir1,dir2,..,dirN:capacity
+  // Example: /mnt/pmem:16GB;/tmp/data1,/tmp/data2:1TB
+  vector<string> tier_configs = Split(config_, ";", SkipEmpty());
+  if (tier_configs.empty()) {
     return Status(Substitute("Malformed data cache configuration $0", config_));
   }
+  if (UNLIKELY(trace_replay_) && tier_configs.size() > 1) {
+    return Status("Data cache does not support multiple tiers when doing trace replay.");
+  }
+  vector<set<string>> tier_dirs(tier_configs.size());
+  vector<int64_t> tier_capacities(tier_configs.size());
+  set<string> all_cache_dirs;
+  for (int tier = 0; tier < tier_configs.size(); ++tier) {
+    vector<string> all_cache_configs = Split(tier_configs[tier], ":", SkipEmpty());
+    if (all_cache_configs.size() != 2) {
+      return Status(Substitute("Malformed data cache configuration $0", config_));
+    }
+
+    // Parse the capacity string to make sure it's well-formed.
+    bool is_percent;
+    tier_capacities[tier] =
+        ParseUtil::ParseMemSpec(all_cache_configs[1], &is_percent, 0);
+    if (is_percent) {
+      return Status(Substitute("Malformed data cache capacity configuration $0",
+          all_cache_configs[1]));
+    }
+    if (tier_capacities[tier] < PAGE_SIZE) {
+      return Status(Substitute("Configured data cache capacity $0 is too small",
+          all_cache_configs[1]));
+    }
 
-  // Parse the capacity string to make sure it's well-formed.
-  bool is_percent;
-  per_partition_capacity_ = ParseUtil::ParseMemSpec(all_cache_configs[1], &is_percent, 0);
-  if (is_percent) {
-    return Status(Substitute("Malformed data cache capacity configuration $0",
-        all_cache_configs[1]));
+    SplitStringToSetUsing(all_cache_configs[0], ",", &tier_dirs[tier]);
+    for (const string& dir_path : tier_dirs[tier]) {
+      if (!all_cache_dirs.insert(dir_path).second) {
+        return Status(Substitute("Data cache directory $0 is configured more than once",
+            dir_path));
+      }
+    }
   }
-  if (per_partition_capacity_ < PAGE_SIZE) {
-    return Status(Substitute("Configured data cache capacity $0 is too small",
-        all_cache_configs[1]));
+  per_partition_capacity_ = tier_capacities[0];
+  if (tier_configs.size() > 1 && FLAGS_data_cache_eviction_headroom_percent == 0) {
+    LOG(WARNING) << "Entries evicted from the data cache will not be demoted to slower "
+                 << "tiers as --data_cache_eviction_headroom_percent is 0.";
   }
 
-  set<string> cache_dirs;
-  SplitStringToSetUsing(all_cache_configs[0], ",", &cache_dirs);
   int max_opened_files_per_partition =
-      FLAGS_data_cache_max_opened_files / cache_dirs.size();
+      FLAGS_data_cache_max_opened_files / all_cache_dirs.size();
   if (max_opened_files_per_partition < 1) {
     return Status(Substitute("Misconfigured --data_cache_max_opened_files: $0. Must be "
-        "at least $1.", FLAGS_data_cache_max_opened_files, cache_dirs.size()));
+        "at least $1.", FLAGS_data_cache_max_opened_files, all_cache_dirs.size()));
   }
   int32_t partition_idx = 0;
-  for (const string& dir_path : cache_dirs) {
-    LOG(INFO) << "Adding partition " << dir_path << " with capacity "
-              << PrettyPrinter::PrintBytes(per_partition_capacity_);
-    std::unique_ptr<Partition> partition =
-        make_unique<Partition>(partition_idx, dir_path, per_partition_capacity_,
-            max_opened_files_per_partition, trace_replay_);
-    RETURN_IF_ERROR(partition->Init());
-    partitions_.emplace_back(move(partition));
-    ++partition_idx;
+  tiers_.resize(tier_configs.size());
+  for (int tier = 0; tier < tier_configs.size(); ++tier) {
+    tiers_[tier].first_partition = partition_idx;
+    tiers_[tier].num_partitions = tier_dirs[tier].size();
+    for (const string& dir_path : tier_dirs[tier]) {
+      LOG(INFO) << "Adding partition " << dir_path << " to tier " << tier
+                << " with capacity " << PrettyPrinter::PrintBytes(tier_capacities[tier]);
+      std::unique_ptr<Partition> partition =
+          make_unique<Partition>(this, partition_idx, tier, dir_path,
+              tier_capacities[tier], max_opened_files_per_partition, trace_replay_);
+      RETURN_IF_ERROR(partition->Init());
+      partitions_.emplace_back(move(partition));
+      ++partition_idx;
+    }
+    if (tier > 0) {
+      tiers_[tier].promotion_filter =
+          AdmissionPolicy::Create("SECOND_HIT", tier_capacities[tier]);
+    }
+    if (LIKELY(!trace_replay_)) InitTierMetrics(tier);
   }
   CHECK_GT(partitions_.size(), 0);
 
@@ -976,12 +1503,73 @@ void DataCache::ReleaseResources() {
     storer_pool_->Shutdown();
     storer_pool_->Join();
   }
+  // Drain the evictor threads of all partitions before closing any of them as they may
+  // look up faster tiers and demote entries into slower tiers. Going from the fastest
+  // tier to the slowest ensures no more demotions are queued for a drained partition.
+  for (auto& partition : partitions_) partition->DrainPendingEvictions();
   if (file_deleter_pool_) file_deleter_pool_->Shutdown();
   for (auto& partition : partitions_) partition->ReleaseResources();
 }
 
+int DataCache::PartitionIndex(int tier, const CacheKey& key) const {
+  DCHECK_LT(tier, tiers_.size());
+  const Tier& t = tiers_[tier];
+  return t.first_partition + key.Hash() % t.num_partitions;
+}
+
+void DataCache::InitTierMetrics(int tier) {
+  const string& i_string = Substitute("$0", tier);
+  Tier* t = &tiers_[tier];
+  MetricGroup* metrics = ImpaladMetrics::IO_MGR_METRICS;
+  // Backend tests may instantiate the data cache more than once. If the metrics already
+  // exist, then we just need to look them up.
+  if (TestInfo::is_test() && metrics->FindMetricForTesting<IntCounter>(
+          Substitute(TIER_HIT_BYTES_METRIC_KEY_TEMPLATE, i_string)) != nullptr) {
+    t->hit_ratio = metrics->FindMetricForTesting<StatsMetric<uint64_t, StatsType::MEAN>>(
+        Substitute(TIER_HIT_RATIO_METRIC_KEY_TEMPLATE, i_string));
+    t->hit_bytes = metrics->FindMetricForTesting<IntCounter>(
+        Substitute(TIER_HIT_BYTES_METRIC_KEY_TEMPLATE, i_string));
+    t->read_time = metrics->FindMetricForTesting<IntCounter>(
+        Substitute(TIER_READ_TIME_METRIC_KEY_TEMPLATE, i_string));
+    t->promoted_entries = metrics->FindMetricForTesting<IntCounter>(
+        Substitute(TIER_PROMOTED_ENTRIES_METRIC_KEY_TEMPLATE, i_string));
+    t->demoted_entries = metrics->FindMetricForTesting<IntCounter>(
+        Substitute(TIER_DEMOTED_ENTRIES_METRIC_KEY_TEMPLATE, i_string));
+    DCHECK(t->hit_ratio != nullptr);
+    DCHECK(t->read_time != nullptr);
+    DCHECK(t->promoted_entries != nullptr);
+    DCHECK(t->demoted_entries != nullptr);
+    return;
+  }
+  t->hit_ratio = StatsMetric<uint64_t, StatsType::MEAN>::CreateAndRegister(metrics,
+      TIER_HIT_RATIO_METRIC_KEY_TEMPLATE, i_string);
+  t->hit_bytes = metrics->AddCounter(TIER_HIT_BYTES_METRIC_KEY_TEMPLATE, 0, i_string);
+  t->read_time = metrics->AddCounter(TIER_READ_TIME_METRIC_KEY_TEMPLATE, 0, i_string);
+  t->promoted_entries =
+      metrics->AddCounter(TIER_PROMOTED_ENTRIES_METRIC_KEY_TEMPLATE, 0, i_string);
+  t->demoted_entries =
+      metrics->AddCounter(TIER_DEMOTED_ENTRIES_METRIC_KEY_TEMPLATE, 0, i_string);
+}
+
+DataCache::MappedBuffer::~MappedBuffer() {
+  file_->Unmap(offset_, data_, len_);
+}
+
 int64_t DataCache::Lookup(const string& filename, int64_t mtime, int64_t offset,
     int64_t bytes_to_read, uint8_t* buffer) {
+  return LookupInternal(filename, mtime, offset, bytes_to_read, buffer, nullptr);
+}
+
+int64_t DataCache::LookupMapped(const string& filename, int64_t mtime, int64_t offset,
+    int64_t bytes_to_read, unique_ptr<MappedBuffer>* buffer) {
+  DCHECK(!trace_replay_);
+  DCHECK(buffer != nullptr);
+  DCHECK_GT(bytes_to_read, 0);
+  return LookupInternal(filename, mtime, offset, bytes_to_read, nullptr, buffer);
+}
+
+int64_t DataCache::LookupInternal(const string& filename, int64_t mtime, int64_t offset,
+    int64_t bytes_to_read, uint8_t* buffer, unique_ptr<MappedBuffer>* mapped) {
   DCHECK(!partitions_.empty());
   // Bail out early for uncacheable ranges or invalid requests.
   if (mtime < 0 || offset < 0 || bytes_to_read < 0) {
@@ -991,12 +1579,44 @@ int64_t DataCache::Lookup(const string& filename, int64_t mtime, int64_t offset,
   }
 
   // Construct a cache key. The cache key is also hashed to compute the partition index.
+  // Probe the tiers from the fastest to the slowest.
   const CacheKey key(filename, mtime, offset);
-  int idx = key.Hash() % partitions_.size();
-  int64_t bytes_read = partitions_[idx]->Lookup(key, bytes_to_read, buffer);
+  int64_t bytes_read = 0;
+  int hit_tier = -1;
+  for (int tier = 0; tier < tiers_.size(); ++tier) {
+    Tier* t = &tiers_[tier];
+    int64_t entry_len;
+    MonotonicStopWatch read_timer;
+    read_timer.Start();
+    bytes_read = partitions_[PartitionIndex(tier, key)]->Lookup(
+        key, bytes_to_read, buffer, mapped, &entry_len);
+    read_timer.Stop();
+    if (bytes_read == 0) continue;
+    hit_tier = tier;
+    // Trace replays do not keep metrics
+    if (LIKELY(!trace_replay_)) {
+      t->hit_bytes->Increment(bytes_read);
+      t->read_time->Increment(read_timer.ElapsedTime());
+    }
+    // Only entries which were read in full can be moved to another tier.
+    if (tier > 0 && bytes_read == entry_len) {
+      MaybePromote(tier, key, mapped == nullptr ? buffer : (*mapped)->data(),
+          bytes_read);
+    }
+    break;
+  }
+  // A mapped lookup which misses is followed by a lookup which copies the data. Leave
+  // the hit ratios to that one.
+  if (LIKELY(!trace_replay_) && (hit_tier >= 0 || mapped == nullptr)) {
+    for (int tier = 0; tier < tiers_.size(); ++tier) {
+      tiers_[tier].hit_ratio->Update(tier == hit_tier ? 1 : 0);
+      if (tier == hit_tier) break;
+    }
+  }
   if (VLOG_IS_ON(3)) {
     stringstream ss;
-    ss << std::hex << reinterpret_cast<int64_t>(buffer);
+    ss << std::hex << reinterpret_cast<int64_t>(
+        mapped != nullptr && *mapped != nullptr ? (*mapped)->data() : buffer);
     LOG(INFO) << Substitute("Looking up $0 mtime: $1 offset: $2 bytes_to_read: $3 "
         "buffer: 0x$4 bytes_read: $5", filename, mtime, offset, bytes_to_read,
         ss.str(), bytes_read);
@@ -1014,14 +1634,17 @@ bool DataCache::Store(const string& filename, int64_t mtime, int64_t offset,
     return false;
   }
 
+  // Construct a cache key. The cache key is also hashed to compute the partition index.
+  // Consult the admission policy first so rejected entries are never copied into a
+  // store task. New entries always go to the first tier.
+  const CacheKey key(filename, mtime, offset);
+  if (!partitions_[PartitionIndex(0, key)]->Admit(key, buffer_len)) return false;
+
   // If the storer thread pool is available, data will be stored asynchronously.
   if (num_async_write_threads_ > 0) {
     return SubmitStoreTask(filename, mtime, offset, buffer, buffer_len);
   }
-
-  // Construct a cache key. The cache key is also hashed to compute the partition index.
-  const CacheKey key(filename, mtime, offset);
-  return StoreInternal(key, buffer, buffer_len);
+  return StoreInternal(key, buffer, buffer_len, /*tier=*/0);
 }
 
 Status DataCache::CloseFilesAndVerifySizes() {
@@ -1083,12 +1706,26 @@ void DataCache::CompleteStoreTask(const StoreTask& task) {
 }
 
 void DataCache::HandleStoreTask(uint32_t thread_id, const StoreTaskHandle& task) {
-    StoreInternal(task->key(), task->buffer(), task->buffer_len());
+    StoreInternal(task->key(), task->buffer(), task->buffer_len(), /*tier=*/0);
 }
 
-bool DataCache::StoreInternal(const CacheKey& key, const uint8_t* buffer,
+void DataCache::MaybePromote(int tier, const CacheKey& key, const uint8_t* buffer,
     int64_t buffer_len) {
-  int idx = key.Hash() % partitions_.size();
+  DCHECK_GT(tier, 0);
+  AdmissionPolicy* promotion_filter = tiers_[tier].promotion_filter.get();
+  const uint64_t hash = AdmissionPolicy::Hash(key.ToSlice());
+  promotion_filter->RecordAccess(hash);
+  if (!promotion_filter->Admit(hash)) return;
+  if (!StoreInternal(key, buffer, buffer_len, tier - 1)) return;
+  if (LIKELY(!trace_replay_)) tiers_[tier - 1].promoted_entries->Increment(1);
+  // Free up the space in the slower tier. The entry won't be demoted back as it's in
+  // a faster tier now.
+  partitions_[PartitionIndex(tier, key)]->Erase(key);
+}
+
+bool DataCache::StoreInternal(const CacheKey& key, const uint8_t* buffer,
+    int64_t buffer_len, int tier) {
+  int idx = PartitionIndex(tier, key);
   bool start_reclaim;
   bool stored = partitions_[idx]->Store(key, buffer, buffer_len, &start_reclaim);
   if (VLOG_IS_ON(3)) {
@@ -25,6 +25,7 @@
 #include <gtest/gtest_prod.h>
 
 #include "common/status.h"
+#include "gutil/macros.h"
 #include "util/cache/cache.h"
 #include "util/metrics-fwd.h"
 #include "util/spinlock.h"
@@ -80,12 +81,42 @@
 /// requires more investigation for other file formats and workloads.
 ///
 /// To probe for cached data in the cache, the interface Lookup() is used; To insert
-/// data into the cache, the interface Store() is used. Write to the backing file and
-/// eviction from it happen synchronously. Currently, Store() is limited to the
-/// concurrency of one thread per partition to prevent slowing down the caller in case
-/// the cache is thrashing and it becomes IO bound. The write concurrency can be tuned
-/// via the knob --data_cache_write_concurrency. Also, Store() has a minimum granularity
-/// of 4KB so any data inserted will be rounded up to the nearest multiple of 4KB.
+/// data into the cache, the interface Store() is used. Write to the backing file happens
+/// synchronously unless --data_cache_num_async_write_threads is set. Currently, Store()
+/// is limited to the concurrency of one thread per partition to prevent slowing down the
+/// caller in case the cache is thrashing and it becomes IO bound. The write concurrency
+/// can be tuned via the knob --data_cache_write_concurrency. Also, Store() has a minimum
+/// granularity of 4KB so any data inserted will be rounded up to the nearest multiple
+/// of 4KB.
+///
+/// By default, every stored range is admitted into the cache, so a single large scan
+/// can flush the working set. --data_cache_admission_policy selects a filter which only
+/// admits a range once it has been looked up repeatedly. 'SECOND_HIT' remembers the
+/// hashes of recently looked up keys in a ghost table and admits a key on its second
+/// lookup. 'TINYLFU' estimates the access frequency of keys with a count-min sketch
+/// which is periodically halved to age out old accesses, and admits keys whose
+/// estimated frequency is at least 2. Neither filter compares the candidate against
+/// the entry it would evict as the metadata cache doesn't expose its victims.
+///
+/// Eviction from the metadata cache happens inline in Store(). Reclaiming the space of
+/// evicted entries by punching holes in the backing files happens inline too unless
+/// --data_cache_eviction_headroom_percent is set. In that case, the metadata cache of a
+/// partition is sized to leave that much of the partition's capacity as headroom, and
+/// holes are punched by a background thread as long as the bytes waiting to be
+/// reclaimed fit in the headroom. The storage consumed by a partition therefore never
+/// exceeds its capacity.
+///
+/// The partitions may be grouped into tiers on different kinds of storage media, ordered
+/// from the fastest (e.g. a tmpfs or persistent memory mount) to the slowest (e.g. SATA
+/// SSD). New entries are always inserted into the first tier. An entry which is hit
+/// repeatedly in a slower tier is promoted to the next faster tier, and an entry
+/// evicted from a tier is demoted to the next slower tier instead of being dropped.
+/// Promotion happens synchronously in Lookup(). Demotion happens in the evictor thread
+/// of a partition, so it requires --data_cache_eviction_headroom_percent to be set;
+/// entries evicted while the headroom is used up are dropped. A promoted entry is
+/// erased from the slower tier so the tiers mostly hold disjoint sets of keys. The hit
+/// ratio and the bytes and time spent reading hits in each tier are exported as
+/// metrics.
 ///
 /// The number of backing files in all partitions is bound by
 /// --data_cache_max_opened_files. Once the number of files exceeds that set limit, files
@@ -93,15 +124,15 @@
 /// entries which reference deleted files are erased lazily upon the next access or
 /// indirectly via eviction.
 ///
+/// With --data_cache_mmap_reads, a hit can also be served by LookupMapped() which maps
+/// the cached content into memory instead of copying it out, similar to HDFS caching.
+/// The returned MappedBuffer pins the region of the backing file: if the entry is
+/// evicted while the buffer is alive, punching the hole is deferred until the buffer is
+/// destroyed. The storage consumed by a partition may therefore exceed its capacity by
+/// the size of the evicted entries which are still mapped.
+///
 /// Future work:
 /// - investigate the overlapping ranges support
-/// - be more selective on what to cache
-/// - asynchronous eviction
-/// - better data placement: put on hot data on faster media and lukewarm data in not
-///   so fast storage media
-/// - evaluate the option of exposing the cache via mmap() and pinning similar to HDFS
-///   caching. This has the advantage of not needing to copy out the data but pinning
-///   may complicate the code.
 ///
 
 namespace impala {
@@ -119,10 +150,12 @@ class DataCache {
   /// in which <dir1>, <dirN> are part of a list of directories for storing cached data
   /// and each directory corresponds to a cache partition. <quota> is the storage quota
   /// for each directory. Impala daemons running on the same host will not share any
-  /// caching directories. If 'trace_replay' is set to true, the cache operates in a
-  /// an optimized mode that skips all file operations and only does the metadata
-  /// operations. This is used to replay the access trace and compare different cache
-  /// configurations. See data-cache-trace.h
+  /// caching directories. Multiple tiers can be configured by separating their
+  /// configuration strings with ';', fastest tier first, e.g.
+  /// /mnt/pmem:16GB;/mnt/nvme0,/mnt/nvme1:1TB. If 'trace_replay' is set to true, the
+  /// cache operates in an optimized mode that skips all file operations and only does
+  /// the metadata operations. This is used to replay the access trace and compare
+  /// different cache configurations. See data-cache-trace.h
   explicit DataCache(const std::string config, int32_t num_async_write_threads = 0,
       bool trace_replay = false);
 
@@ -152,6 +185,20 @@ class DataCache {
   int64_t Lookup(const std::string& filename, int64_t mtime, int64_t offset,
       int64_t bytes_to_read, uint8_t* buffer);
 
+  /// A read-only view of cached content which is mapped into memory by LookupMapped().
+  class MappedBuffer;
+
+  /// Same as Lookup() except that on a hit, the cached content is mapped into memory
+  /// and returned in 'buffer' instead of being copied. Only entries which cover all of
+  /// the 'bytes_to_read' bytes are mapped; the caller is expected to fall back to
+  /// Lookup() otherwise. A lookup which doesn't map the entry isn't accounted for in the
+  /// metrics, the access trace or the admission policy, so that falling back to Lookup()
+  /// counts the access once. Not supported for trace replay.
+  ///
+  /// Returns the number of bytes mapped, which is either 'bytes_to_read' or 0.
+  int64_t LookupMapped(const std::string& filename, int64_t mtime, int64_t offset,
+      int64_t bytes_to_read, std::unique_ptr<MappedBuffer>* buffer);
+
   /// Inserts a new cache entry by copying the content in 'buffer' into the cache.
   /// (filename, mtime, offset) together forms a cache key. Insertion involves writing
   /// to the backing file and potentially evicting entries synchronously so callers
@@ -175,6 +222,7 @@ class DataCache {
   /// - an entry with the given cache key already exists unless 'buffer_len' is larger
   ///   than the existing entry, in which case, the entry will be replaced with the
   ///   new data.
+  /// - the admission policy (via --data_cache_admission_policy) rejects the entry.
   /// - a pending entry with the same key is already being installed.
   /// - the maximum write concurrency (via --data_cache_write_concurrency) is reached.
   /// - IO error when writing to the backing file.
@@ -197,6 +245,7 @@ class DataCache {
   FRIEND_TEST(DataCacheTest, NonRotationalDisk);
   FRIEND_TEST(DataCacheTest, InvalidDisk);
 
+  class AdmissionPolicy;
   class CacheFile;
   struct CacheKey;
   class CacheEntry;
@@ -206,12 +255,12 @@ class DataCache {
   /// cache keys in a LRU cache.
   class Partition : public Cache::EvictionCallback {
    public:
-    /// Creates a partition at the given directory 'path' with quota 'capacity' in bytes.
-    /// 'max_opened_files' is the maximum number of opened files allowed per partition.
-    /// If 'trace_replay' is true, this only performs metadata operations for the
-    /// access trace functionality.
-    Partition(int32_t index, const std::string& path, int64_t capacity,
-        int max_opened_files, bool trace_replay);
+    /// Creates a partition of 'cache' in tier 'tier' at the given directory 'path' with
+    /// quota 'capacity' in bytes. 'max_opened_files' is the maximum number of opened
+    /// files allowed per partition. If 'trace_replay' is true, this only performs
+    /// metadata operations for the access trace functionality.
+    Partition(DataCache* cache, int32_t index, int tier, const std::string& path,
+        int64_t capacity, int max_opened_files, bool trace_replay);
 
     ~Partition();
 
@@ -229,11 +278,27 @@ class DataCache {
     /// the memory held by the metadata cache.
     void ReleaseResources();
 
+    /// Waits for the evictor thread to process all queued evictions and stops it.
+    void DrainPendingEvictions();
+
     /// Looks up in the meta-data cache with key 'cache_key'. If found, try copying
     /// 'bytes_to_read' bytes from the backing file into 'buffer'. If trace_replay
     /// is enabled, the buffer is null and no bytes are copied. Returns number
-    /// of bytes read from the cache. Returns 0 if there is a cache miss.
-    int64_t Lookup(const CacheKey& cache_key, int64_t bytes_to_read, uint8_t* buffer);
+    /// of bytes read from the cache. Returns 0 if there is a cache miss. On a cache
+    /// hit, 'entry_len' is set to the length of the cached entry.
+    ///
+    /// If 'mapped' is not NULL, 'buffer' must be NULL and the bytes are mapped into
+    /// memory and returned in 'mapped' instead. That's only done if the entry covers
+    /// all of the 'bytes_to_read' bytes. See DataCache::LookupMapped().
+    int64_t Lookup(const CacheKey& cache_key, int64_t bytes_to_read, uint8_t* buffer,
+        std::unique_ptr<MappedBuffer>* mapped, int64_t* entry_len);
+
+    /// Returns true iff an entry with key 'cache_key' is in the meta-data cache. Doesn't
+    /// update the recency of the entry.
+    bool Contains(const CacheKey& cache_key);
+
+    /// Removes the entry with key 'cache_key' from the meta-data cache if present.
+    void Erase(const CacheKey& cache_key);
 
     /// Inserts a entry with key 'cache_key' and data in 'buffer' into the cache.
     /// 'buffer' is nullptr for trace replay. 'buffer_len' is the length of buffer.
@@ -242,11 +307,21 @@ class DataCache {
     bool Store(const CacheKey& cache_key, const uint8_t* buffer, int64_t buffer_len,
         bool* start_reclaim);
 
+    /// Consults the admission policy of this partition on whether an entry with key
+    /// 'cache_key' of length 'buffer_len' should be inserted into the cache. Always
+    /// returns true if no admission policy is configured. Rejected entries are
+    /// accounted for in the metrics and the access trace.
+    bool Admit(const CacheKey& cache_key, int64_t buffer_len);
+
     /// Callback invoked when evicting an entry from the cache. 'key' is the cache key
     /// of the entry being evicted and 'value' contains the cache entry which is the
     /// meta-data of where the cached data is stored.
     virtual void EvictedEntry(kudu::Slice key, kudu::Slice value) override;
 
+    /// Utility function to wait until the space of all evicted entries has been
+    /// reclaimed from the backing files. Used by test only.
+    void WaitForPendingEvictions();
+
     /// Utility function to verify that the backing files don't exceed the capacity
     /// of the partition. Used by test only.
     ///
@@ -271,10 +346,16 @@ class DataCache {
     FRIEND_TEST(DataCacheTest, NonRotationalDisk);
     FRIEND_TEST(DataCacheTest, InvalidDisk);
 
+    /// The cache this partition belongs to.
+    DataCache* const cache_;
+
     /// Index of this partition. This is used for naming metrics or other items that
     /// need separate values for each partition. It does not impact cache behavior.
     int32_t index_;
 
+    /// Index of the tier this partition belongs to.
+    const int tier_;
+
     /// The directory path which this partition stores cached data in.
     const std::string path_;
 
@@ -284,6 +365,11 @@ class DataCache {
     /// Maximum number of opened files allowed in a partition.
     const int max_opened_files_;
 
+    /// The number of bytes of 'capacity_' kept free in the metadata cache for evicted
+    /// entries whose space is reclaimed asynchronously. 0 if holes are punched inline.
+    /// See --data_cache_eviction_headroom_percent.
+    const int64_t eviction_headroom_;
+
     /// Device-specific write concurrency
     int32_t data_cache_write_concurrency_ = 1;
 
@@ -327,6 +413,21 @@ class DataCache {
     /// content. Please see comments at CachedEntry for details.
     std::unique_ptr<Cache> meta_cache_;
 
+    /// The filter deciding which entries are admitted into the cache. NULL if all
+    /// entries are admitted.
+    std::unique_ptr<AdmissionPolicy> admission_policy_;
+
+    /// A region of a backing file to be reclaimed by 'evictor_pool_'.
+    struct PendingHole;
+
+    /// Thread pool for punching holes for evicted entries asynchronously. Only created
+    /// if 'eviction_headroom_' is non-zero. There is only one thread in this pool.
+    std::unique_ptr<ThreadPool<PendingHole>> evictor_pool_;
+
+    /// Total bytes of evicted entries queued in 'evictor_pool_'. Never exceeds
+    /// 'eviction_headroom_'.
+    AtomicInt64 pending_eviction_bytes_{0};
+
     std::unique_ptr<trace::Tracer> tracer_;
 
     /// Metrics to track performance of the underlying filesystem for the data cache
@@ -344,6 +445,13 @@ class DataCache {
     /// error on failure.
     Status CreateCacheFile();
 
+    /// Thread function called by the thread in 'evictor_pool_' for reclaiming the space
+    /// of an evicted entry. Demotes the entry to the next tier first if there is one.
+    void PunchPendingHole(uint32_t thread_id, const PendingHole& hole);
+
+    /// Reads the data of the evicted entry 'hole' and stores it in the next tier.
+    void DemoteEntry(const PendingHole& hole);
+
     /// Utility function to delete cache files left over from previous runs of Impala.
     /// Returns error on failure.
     Status DeleteExistingFiles() const;
@@ -391,16 +499,53 @@ class DataCache {
   /// The configuration string for the data cache.
   const std::string config_;
 
-  /// The capacity in bytes of one partition.
+  /// The capacity in bytes of one partition of the first tier.
   int64_t per_partition_capacity_;
 
   /// Set to true if this is only doing trace replay. Trace replay does only metadata
   /// operations, and no filesystem operations are required.
   bool trace_replay_;
 
-  /// The set of all cache partitions.
+  /// The set of all cache partitions, ordered by tier.
   std::vector<std::unique_ptr<Partition>> partitions_;
 
+  /// A tier groups the partitions on one kind of storage media.
+  struct Tier {
+    /// Range of the partitions of this tier in 'partitions_'.
+    int first_partition = 0;
+    int num_partitions = 0;
+
+    /// Remembers the keys hit in this tier to promote them on their second hit. NULL
+    /// for the first tier.
+    std::unique_ptr<AdmissionPolicy> promotion_filter;
+
+    /// Metrics of this tier. NULL for trace replay.
+    StatsMetric<uint64_t, StatsType::MEAN>* hit_ratio = nullptr;
+    IntCounter* hit_bytes = nullptr;
+    IntCounter* read_time = nullptr;
+    IntCounter* promoted_entries = nullptr;
+    IntCounter* demoted_entries = nullptr;
+  };
+
+  /// The tiers of the cache ordered from the fastest to the slowest storage media.
+  std::vector<Tier> tiers_;
+
+  /// Implements Lookup() if 'mapped' is NULL and LookupMapped() otherwise.
+  int64_t LookupInternal(const std::string& filename, int64_t mtime, int64_t offset,
+      int64_t bytes_to_read, uint8_t* buffer, std::unique_ptr<MappedBuffer>* mapped);
+
+  /// Returns the index into 'partitions_' of the partition in tier 'tier' which 'key'
+  /// maps to.
+  int PartitionIndex(int tier, const CacheKey& key) const;
+
+  /// Initializes the metrics of tier 'tier'.
+  void InitTierMetrics(int tier);
+
+  /// Moves the entry with key 'key' which was just read from tier 'tier' into 'buffer'
+  /// of length 'buffer_len' to the next faster tier if it was hit in 'tier' before.
+  void MaybePromote(int tier, const CacheKey& key, const uint8_t* buffer,
+      int64_t buffer_len);
+
   /// Thread pool for deleting old files from partitions to keep the number of opened
   /// files within --date_cache_max_opened_files. This allows deletion requests
   /// to be queued for deferred processing. There is only one thread in this pool.
@@ -436,9 +581,38 @@ class DataCache {
   /// Total buffer size currently used by all asynchronous store tasks.
   AtomicInt64 current_buffer_size_{0};
 
-  /// Call the corresponding cache partition for storing.
-  bool StoreInternal(const CacheKey& key, const uint8_t* buffer, int64_t buffer_len);
+  /// Call the corresponding cache partition in tier 'tier' for storing.
+  bool StoreInternal(const CacheKey& key, const uint8_t* buffer, int64_t buffer_len,
+      int tier);
+
+};
+
+/// A read-only view of cached content which is mapped into memory by
+/// DataCache::LookupMapped(). The view stays valid until it's destroyed, even if the
+/// entry is evicted or its backing file is deleted in the meantime. All views must be
+/// destroyed before the cache releases its resources.
+class DataCache::MappedBuffer {
+ public:
+  ~MappedBuffer();
+
+  const uint8_t* data() const { return data_; }
+  int64_t len() const { return len_; }
+
+ private:
+  friend class Partition;
+
+  MappedBuffer(CacheFile* file, int64_t offset, uint8_t* data, int64_t len)
+    : file_(file), offset_(offset), data_(data), len_(len) {}
+
+  /// The backing file and the offset in it of the mapped entry.
+  CacheFile* const file_;
+  const int64_t offset_;
+
+  /// The start and length of the mapping.
+  uint8_t* const data_;
+  const int64_t len_;
 
+  DISALLOW_COPY_AND_ASSIGN(MappedBuffer);
 };
 
 } // namespace io
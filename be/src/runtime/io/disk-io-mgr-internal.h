@@ -53,6 +53,7 @@ namespace impala {
 class HistogramMetric;
 
 namespace io {
+class IoUring;
 
 // Indicates if file handle caching should be used
 static inline bool is_file_handle_caching_enabled() {
@@ -72,6 +73,8 @@ class DiskQueue {
   /// Disk worker thread loop. This function retrieves the next range to process on
   /// the disk queue and invokes ScanRange::DoRead() or Write() depending on the type
   /// of Range. There can be multiple threads per disk running this loop.
+  /// If --disk_io_use_io_uring is set, threads of local disks run
+  /// AsyncDiskThreadLoop() instead.
   void DiskThreadLoop(DiskIoMgr* io_mgr);
 
   /// Enqueue the request context to the disk queue.
@@ -124,8 +127,18 @@ class DiskQueue {
   /// Called from the disk thread to get the next range to process. Wait until a scan
   /// is available to process, a write range is available, or 'shut_down_' is set to
   /// true. Returns the range to process and the RequestContext that the range belongs
-  /// to. Only returns NULL if the disk thread should be shut down.
-  RequestRange* GetNextRequestRange(RequestContext** request_context);
+  /// to. Only returns NULL if the disk thread should be shut down, or if 'wait' is false
+  /// and no range is available right away.
+  RequestRange* GetNextRequestRange(RequestContext** request_context, bool wait = true);
+
+  /// Processes 'range' of 'request_context' synchronously on the calling disk thread.
+  void ProcessRequestRange(RequestContext* request_context, RequestRange* range);
+
+  /// Variant of DiskThreadLoop() that keeps up to ring->queue_depth() reads of local
+  /// files in flight in 'ring' and processes their completions as they arrive. Other
+  /// ranges are processed synchronously. Only blocks waiting for new ranges when no read
+  /// is in flight.
+  void AsyncDiskThreadLoop(IoUring* ring);
 
   /// Disk id (0-based)
   const int disk_id_;
@@ -26,6 +26,7 @@
 #include "runtime/io/disk-io-mgr-internal.h"
 #include "runtime/io/disk-io-mgr-stress.h"
 #include "runtime/io/disk-io-mgr.h"
+#include "runtime/io/io-uring.h"
 #include "runtime/io/local-file-system-with-fault-injection.h"
 #include "runtime/io/request-context.h"
 #include "runtime/test-env.h"
@@ -38,6 +39,7 @@
 #include "util/debug-util.h"
 #include "util/filesystem-util.h"
 #include "util/histogram-metric.h"
+#include "util/runtime-profile-counters.h"
 #include "util/thread.h"
 #include "util/time.h"
 
@@ -48,6 +50,8 @@ using std::uniform_int_distribution;
 using std::uniform_real_distribution;
 
 DECLARE_int64(min_buffer_size);
+DECLARE_bool(disk_io_use_io_uring);
+DECLARE_int32(disk_io_uring_queue_depth);
 DECLARE_int32(num_remote_hdfs_io_threads);
 DECLARE_int32(num_s3_io_threads);
 DECLARE_int32(num_adls_io_threads);
@@ -65,6 +69,8 @@ DECLARE_int32(num_obs_io_threads);
 DECLARE_int32(stress_disk_read_delay_ms);
 #endif
 
+DECLARE_string(data_cache);
+DECLARE_bool(data_cache_mmap_reads);
 DECLARE_string(remote_tmp_file_size);
 DECLARE_string(remote_tmp_file_block_size);
 
@@ -319,8 +325,10 @@ class DiskIoMgrTest : public testing::Test {
   void AddWriteRange(int num_of_writes, int32_t* data, const string& tmp_file, int offset,
       RequestContext* writer, const string& expected_output, TmpFileGroup* file_group);
 
+  /// If 'num_async_reads' is not null, the number of reads that were submitted through
+  /// io_uring is added to it.
   void SingleReaderTestBody(const char* data, const char* expected_result,
-      vector<ScanRange::SubRange> sub_ranges = {});
+      vector<ScanRange::SubRange> sub_ranges = {}, int64_t* num_async_reads = nullptr);
 
   void CachedReadsTestBody(const char* data, const char* expected,
       bool fake_cache, vector<ScanRange::SubRange> sub_ranges = {});
@@ -681,7 +689,7 @@ TEST_F(DiskIoMgrTest, SingleWriterCancel) {
 }
 
 void DiskIoMgrTest::SingleReaderTestBody(const char* data, const char* expected_result,
-    vector<ScanRange::SubRange> sub_ranges) {
+    vector<ScanRange::SubRange> sub_ranges, int64_t* num_async_reads) {
   const char* tmp_file = "/tmp/disk_io_mgr_test.txt";
   int data_len = strlen(data);
   int expected_result_len = strlen(expected_result);
@@ -727,6 +735,7 @@ void DiskIoMgrTest::SingleReaderTestBody(const char* data, const char* expected_
         threads.join_all();
 
         EXPECT_EQ(num_ranges_processed.Load(), ranges.size());
+        if (num_async_reads != nullptr) *num_async_reads += reader->num_async_reads();
         io_mgr.UnregisterContext(reader.get());
         EXPECT_EQ(read_client.GetUsedReservation(), 0);
         buffer_pool()->DeregisterClient(&read_client);
@@ -753,6 +762,27 @@ TEST_F(DiskIoMgrTest, SingleReaderSubRanges) {
   SingleReaderTestBody(data, "bceflm", {{1, 2}, {4, 2}, {11, 2}});
 }
 
+// Same as SingleReader, but the disk threads submit the reads through io_uring. Reads of
+// sub-ranges take the blocking path.
+TEST_F(DiskIoMgrTest, SingleReaderIoUring) {
+  unique_ptr<IoUring> ring;
+  Status status = IoUring::Create(4, &ring);
+  if (!status.ok()) GTEST_SKIP() << "io_uring is not available: " << status.GetDetail();
+  ring.reset();
+
+  InitRootReservation(LARGE_RESERVATION_LIMIT);
+  auto use_io_uring = ScopedFlagSetter<bool>::Make(&FLAGS_disk_io_use_io_uring, true);
+  auto queue_depth = ScopedFlagSetter<int32_t>::Make(&FLAGS_disk_io_uring_queue_depth, 4);
+  const char* data = "abcdefghijklm";
+  int64_t num_async_reads = 0;
+  SingleReaderTestBody(data, data, {}, &num_async_reads);
+  EXPECT_GT(num_async_reads, 0);
+
+  num_async_reads = 0;
+  SingleReaderTestBody(data, "abdef", {{0, 2}, {3, 3}}, &num_async_reads);
+  EXPECT_EQ(num_async_reads, 0);
+}
+
 // This test issues adding additional scan ranges while there are some still in flight.
 TEST_F(DiskIoMgrTest, AddScanRangeTest) {
   InitRootReservation(LARGE_RESERVATION_LIMIT);
@@ -1146,6 +1176,136 @@ TEST_F(DiskIoMgrTest, CachedReadsSubRanges) {
   }
 }
 
+// Test reads of a remote file with --data_cache_mmap_reads. A range which is entirely
+// in the data cache is returned as a single buffer mapped from the cache. Partial hits,
+// ranges with sub-ranges and ranges reading into a client buffer go through the normal
+// read path instead.
+TEST_F(DiskIoMgrTest, MappedDataCacheReads) {
+  InitRootReservation(LARGE_RESERVATION_LIMIT);
+  const string cache_dir = "/tmp/disk-io-mgr-test-data-cache";
+  ASSERT_OK(FileSystemUtil::RemoveAndCreateDirectory(cache_dir));
+  auto data_cache =
+      ScopedFlagSetter<string>::Make(&FLAGS_data_cache, cache_dir + ":16MB");
+  auto mmap_reads = ScopedFlagSetter<bool>::Make(&FLAGS_data_cache_mmap_reads, true);
+
+  // The data cache is only used for remote files.
+  const int data_len = 16 * 1024;
+  const int range_len = 5000;
+  string data(data_len, 0);
+  for (int i = 0; i < data_len; ++i) data[i] = 'a' + i % 26;
+  string remote_file_path = remote_url_ + "/disk_io_mgr_data_cache_test.txt";
+  hdfsFS hdfs_conn = hdfsConnect("default", 0);
+  hdfsFile file =
+      hdfsOpenFile(hdfs_conn, remote_file_path.c_str(), O_WRONLY | O_CREAT, 0, 0, 0);
+  ASSERT_TRUE(file != nullptr);
+  ASSERT_EQ(data_len, hdfsWrite(hdfs_conn, file, data.data(), data_len));
+  ASSERT_EQ(0, hdfsCloseFile(hdfs_conn, file));
+  // Bogus value
+  int64_t mtime = 100000;
+
+  scoped_ptr<DiskIoMgr> io_mgr(new DiskIoMgr(1, 1, 1, MIN_BUFFER_SIZE, data_len));
+  ASSERT_OK(io_mgr->Init());
+  ASSERT_TRUE(io_mgr->remote_data_cache() != nullptr);
+  BufferPool::ClientHandle read_client;
+  RegisterBufferPoolClient(
+      LARGE_RESERVATION_LIMIT, LARGE_INITIAL_RESERVATION, &read_client);
+  unique_ptr<RequestContext> reader = io_mgr->RegisterContext();
+  RuntimeProfile* profile = NewProfile();
+  RuntimeProfile::Counter* hit_counter =
+      ADD_COUNTER(profile, "DataCacheHitCount", TUnit::UNIT);
+  RuntimeProfile::Counter* partial_hit_counter =
+      ADD_COUNTER(profile, "DataCachePartialHitCount", TUnit::UNIT);
+  RuntimeProfile::Counter* miss_counter =
+      ADD_COUNTER(profile, "DataCacheMissCount", TUnit::UNIT);
+  reader->set_data_cache_hit_counter(hit_counter);
+  reader->set_data_cache_partial_hit_counter(partial_hit_counter);
+  reader->set_data_cache_miss_counter(miss_counter);
+  reader->set_data_cache_hit_bytes_counter(
+      ADD_COUNTER(profile, "DataCacheHitBytes", TUnit::BYTES));
+  reader->set_data_cache_miss_bytes_counter(
+      ADD_COUNTER(profile, "DataCacheMissBytes", TUnit::BYTES));
+
+  auto new_range = [&](int64_t len, const BufferOpts& buffer_opts,
+      vector<ScanRange::SubRange> sub_ranges = {}) {
+    ScanRange* range = pool_.Add(new ScanRange);
+    range->Reset(ScanRange::FileInfo{remote_file_path.c_str(), hdfs_conn, mtime}, len,
+        0, 0, false, buffer_opts, move(sub_ranges));
+    return range;
+  };
+  // Starts 'range' and returns its only buffer in 'buffer' after checking its content.
+  auto read_range = [&](ScanRange* range, const string& expected,
+      unique_ptr<BufferDescriptor>* buffer) {
+    bool needs_buffers;
+    ASSERT_OK(reader->StartScanRange(range, &needs_buffers));
+    if (needs_buffers) {
+      ASSERT_OK(io_mgr->AllocateBuffersForRange(&read_client, range, data_len));
+    }
+    ASSERT_OK(range->GetNext(buffer));
+    ASSERT_TRUE(*buffer != nullptr);
+    ASSERT_TRUE((*buffer)->eosr());
+    int64_t expected_len = expected.size();
+    ASSERT_EQ(expected_len, (*buffer)->len());
+    ASSERT_EQ(0, memcmp((*buffer)->buffer(), expected.data(), expected_len));
+  };
+  const BufferOpts use_data_cache(BufferOpts::USE_DATA_CACHE);
+  unique_ptr<BufferDescriptor> buffer;
+
+  // The first read misses and inserts the range into the cache.
+  ScanRange* range = new_range(range_len, use_data_cache);
+  read_range(range, data.substr(0, range_len), &buffer);
+  EXPECT_FALSE(buffer->is_cached());
+  EXPECT_EQ(1, miss_counter->value());
+  range->ReturnBuffer(move(buffer));
+
+  // The second read is a whole-range hit which is returned as a single mapped buffer.
+  ScanRange* mapped_range = new_range(range_len, use_data_cache);
+  unique_ptr<BufferDescriptor> mapped_buffer;
+  read_range(mapped_range, data.substr(0, range_len), &mapped_buffer);
+  EXPECT_TRUE(mapped_buffer->is_cached());
+  EXPECT_EQ(1, hit_counter->value());
+
+  // Ranges reading into a client buffer are copied from the cache into the buffer.
+  vector<uint8_t> client_buffer(range_len);
+  range = new_range(range_len,
+      BufferOpts::ReadInto(client_buffer.data(), range_len, BufferOpts::USE_DATA_CACHE));
+  read_range(range, data.substr(0, range_len), &buffer);
+  EXPECT_FALSE(buffer->is_cached());
+  EXPECT_EQ(client_buffer.data(), buffer->buffer());
+  EXPECT_EQ(2, hit_counter->value());
+  range->ReturnBuffer(move(buffer));
+
+  // Ranges with sub-ranges are never mapped either.
+  range = new_range(range_len, use_data_cache, {{0, 2000}, {3000, 2000}});
+  read_range(range, data.substr(0, 2000) + data.substr(3000, 2000), &buffer);
+  EXPECT_FALSE(buffer->is_cached());
+  range->ReturnBuffer(move(buffer));
+
+  // A range which is only partially cached falls back to the normal read path. The
+  // longer entry it inserts evicts the entry which is still mapped by 'mapped_range'.
+  range = new_range(data_len, use_data_cache);
+  read_range(range, data, &buffer);
+  EXPECT_FALSE(buffer->is_cached());
+  EXPECT_EQ(1, partial_hit_counter->value());
+  range->ReturnBuffer(move(buffer));
+
+  // The mapping stays valid until the buffer is returned and the range is closed.
+  EXPECT_EQ(0, memcmp(mapped_buffer->buffer(), data.data(), range_len));
+  mapped_range->ReturnBuffer(move(mapped_buffer));
+
+  // A prefix of the new entry can be mapped.
+  range = new_range(range_len, use_data_cache);
+  read_range(range, data.substr(0, range_len), &buffer);
+  EXPECT_TRUE(buffer->is_cached());
+  EXPECT_EQ(3, hit_counter->value());
+  range->ReturnBuffer(move(buffer));
+
+  io_mgr->UnregisterContext(reader.get());
+  buffer_pool()->DeregisterClient(&read_client);
+  io_mgr.reset();
+  hdfsDelete(hdfs_conn, remote_file_path.c_str(), 1);
+  ASSERT_OK(FileSystemUtil::RemovePaths({cache_dir}));
+}
+
 TEST_F(DiskIoMgrTest, MultipleReaderWriter) {
   InitRootReservation(LARGE_RESERVATION_LIMIT);
   const int ITERATIONS = 1;
@@ -28,6 +28,7 @@
 #include "runtime/io/error-converter.h"
 #include "runtime/io/file-writer.h"
 #include "runtime/io/handle-cache.inline.h"
+#include "runtime/io/io-uring.h"
 
 #include <boost/algorithm/string.hpp>
 #include <boost/filesystem.hpp>
@@ -72,8 +73,10 @@ DEFINE_string(data_cache, "", "The configuration string for IO data cache. "
     "Default to be an empty string so it's disabled. The configuration string is "
     "expected to be a list of directories, separated by ',', followed by a ':' and "
     "a capacity quota per directory. For example /data/0,/data/1:1TB means the cache "
-    "may use up to 2TB, with 1TB max in /data/0 and /data/1 respectively. Please note "
-    "that each Impala daemon on a host must have a unique caching directory.");
+    "may use up to 2TB, with 1TB max in /data/0 and /data/1 respectively. Multiple tiers "
+    "on different storage media can be configured by separating them with ';', fastest "
+    "tier first, e.g. /mnt/pmem:16GB;/data/0,/data/1:1TB. Please note that each Impala "
+    "daemon on a host must have a unique caching directory.");
 DEFINE_int32(data_cache_num_async_write_threads, 0,
     "(Experimental) Number of data cache async write threads. Write threads will write "
     "the cache asynchronously after IO thread read data, so IO thread will return more "
@@ -105,6 +108,15 @@ static const string num_io_threads_per_solid_state_disk_help_msg = Substitute("N
 DEFINE_int32(num_io_threads_per_solid_state_disk, 0,
     num_io_threads_per_solid_state_disk_help_msg.c_str());
 
+DEFINE_bool(disk_io_use_io_uring, false, "(Experimental) If true, reads of local files "
+    "on local disks are submitted asynchronously through io_uring. Each I/O thread of a "
+    "local disk then keeps up to --disk_io_uring_queue_depth reads in flight, so far "
+    "fewer threads per disk (--num_io_threads_per_solid_state_disk) are needed to reach "
+    "the queue depth of fast disks. Falls back to blocking reads if the kernel does not "
+    "support io_uring.");
+DEFINE_int32(disk_io_uring_queue_depth, 32, "Maximum number of asynchronous reads in "
+    "flight per I/O thread of a local disk if --disk_io_use_io_uring is true.");
+
 // The maximum number of remote HDFS I/O threads.  HDFS access that are expected to be
 // remote are placed on a separate remote disk queue.  This is the queue depth for that
 // queue.  If 0, then the remote queue is not used and instead ranges are round-robined
@@ -779,13 +791,15 @@ int64_t DiskIoMgr::ComputeIdealBufferReservation(int64_t scan_range_len) {
 //  - A ScanRange with a buffer available, or
 //  - A WriteRange in unstarted_write_ranges_ or
 //  - A RemoteOperRange in unstarted_remote_file_op_ranges_.
-RequestRange* DiskQueue::GetNextRequestRange(RequestContext** request_context) {
+RequestRange* DiskQueue::GetNextRequestRange(
+    RequestContext** request_context, bool wait) {
   // This loops returns either with work to do or when the disk IoMgr shuts down.
   while (true) {
     *request_context = nullptr;
     {
       unique_lock<mutex> disk_lock(lock_);
       while (!shut_down_ && request_contexts_.empty()) {
+        if (!wait) return nullptr;
         // wait if there are no readers on the queue
         work_available_.Wait(disk_lock);
       }
@@ -812,6 +826,16 @@ RequestRange* DiskQueue::GetNextRequestRange(RequestContext** request_context) {
 }
 
 void DiskQueue::DiskThreadLoop(DiskIoMgr* io_mgr) {
+  if (FLAGS_disk_io_use_io_uring && disk_id_ < io_mgr->num_local_disks()) {
+    unique_ptr<IoUring> ring;
+    Status status = IoUring::Create(FLAGS_disk_io_uring_queue_depth, &ring);
+    if (status.ok()) {
+      AsyncDiskThreadLoop(ring.get());
+      return;
+    }
+    LOG_FIRST_N(WARNING, 1) << "Could not use io_uring, local disks are read with "
+                            << "blocking reads: " << status.GetDetail();
+  }
   // The thread waits until there is work or the queue is shut down. If there is work,
   // performs the read or write requested. Locks are not taken when reading from or
   // writing to disk.
@@ -822,53 +846,121 @@ void DiskQueue::DiskThreadLoop(DiskIoMgr* io_mgr) {
       DCHECK(shut_down_);
       return;
     }
-    // We are now working on behalf of a query, so set thread state appropriately.
-    // See also IMPALA-6254 and IMPALA-6417.
-    ScopedThreadContext tdi_scope(GetThreadDebugInfo(), worker_context->query_id(),
-        worker_context->instance_id());
-
-    switch (range->request_type()) {
-      case RequestType::READ: {
-        ScanRange* scan_range = static_cast<ScanRange*>(range);
-        ReadOutcome outcome = scan_range->DoRead(this, disk_id_);
-        worker_context->ReadDone(disk_id_, outcome, scan_range);
-        break;
+    ProcessRequestRange(worker_context, range);
+  }
+}
+
+void DiskQueue::ProcessRequestRange(RequestContext* worker_context, RequestRange* range) {
+  // We are now working on behalf of a query, so set thread state appropriately.
+  // See also IMPALA-6254 and IMPALA-6417.
+  ScopedThreadContext tdi_scope(GetThreadDebugInfo(), worker_context->query_id(),
+      worker_context->instance_id());
+
+  switch (range->request_type()) {
+    case RequestType::READ: {
+      ScanRange* scan_range = static_cast<ScanRange*>(range);
+      ReadOutcome outcome = scan_range->DoRead(this, disk_id_);
+      worker_context->ReadDone(disk_id_, outcome, scan_range);
+      break;
+    }
+    case RequestType::WRITE: {
+      WriteRange* write_range = static_cast<WriteRange*>(range);
+      Status status = write_range->DoWrite();
+      worker_context->OperDone(write_range, status);
+      break;
+    }
+    case RequestType::FILE_UPLOAD: {
+      RemoteOperRange* oper_range = static_cast<RemoteOperRange*>(range);
+      int64_t size = oper_range->block_size();
+      // Use malloc to get the memory in case there is no available space
+      // in the buffer pool because spilling to disk happens when scarcity
+      // of memory in the buffer pool. Be better to preserve memory than
+      // malloc.
+      uint8_t* buffer = static_cast<uint8_t*>(malloc(size));
+      if (UNLIKELY(buffer == nullptr)) {
+        worker_context->OperDone(oper_range,
+            Status(Substitute("Couldn't allocate memory for remote file operations, "
+                              "block size: '$0'",
+                size)));
+      } else {
+        Status oper_status = oper_range->DoUpload(buffer, size);
+        worker_context->OperDone(oper_range, oper_status);
+        free(buffer);
       }
-      case RequestType::WRITE: {
-        WriteRange* write_range = static_cast<WriteRange*>(range);
-        Status status = write_range->DoWrite();
-        worker_context->OperDone(write_range, status);
-        break;
+      break;
+    }
+    case RequestType::FILE_FETCH: {
+      RemoteOperRange* oper_range = static_cast<RemoteOperRange*>(range);
+      Status oper_status = oper_range->DoFetch();
+      worker_context->OperDone(oper_range, oper_status);
+      break;
+    }
+    default:
+      DCHECK(false) << "Invalid request type: " << range->request_type();
+  }
+}
+
+void DiskQueue::AsyncDiskThreadLoop(IoUring* ring) {
+  // A read in flight in 'ring'. The index of its slot in 'reads' is the user data of
+  // the read.
+  struct AsyncRead {
+    RequestContext* context;
+    ScanRange* range;
+    int64_t start_time;
+  };
+  vector<AsyncRead> reads(ring->queue_depth());
+  vector<int> free_slots;
+  for (int i = ring->queue_depth() - 1; i >= 0; --i) free_slots.push_back(i);
+
+  auto finish_read = [&](uint64_t slot, int64_t result) {
+    AsyncRead* read = &reads[slot];
+    read_latency_->Update(MonotonicNanos() - read->start_time);
+    ScopedThreadContext tdi_scope(GetThreadDebugInfo(), read->context->query_id(),
+        read->context->instance_id());
+    ReadOutcome outcome = read->range->FinishAsyncRead(this, result);
+    read->context->ReadDone(disk_id_, outcome, read->range);
+    free_slots.push_back(slot);
+  };
+
+  while (true) {
+    // Start reads while there is room in the ring. Only wait for new ranges if no read
+    // is in flight, otherwise go on to process completions.
+    while (!free_slots.empty()) {
+      bool idle = free_slots.size() == reads.size();
+      RequestContext* worker_context = nullptr;
+      RequestRange* range = GetNextRequestRange(&worker_context, idle);
+      if (range == nullptr) {
+        if (!idle) break;
+        DCHECK(shut_down_);
+        return;
       }
-      case RequestType::FILE_UPLOAD: {
-        RemoteOperRange* oper_range = static_cast<RemoteOperRange*>(range);
-        int64_t size = oper_range->block_size();
-        // Use malloc to get the memory in case there is no available space
-        // in the buffer pool because spilling to disk happens when scarcity
-        // of memory in the buffer pool. Be better to preserve memory than
-        // malloc.
-        uint8_t* buffer = static_cast<uint8_t*>(malloc(size));
-        if (UNLIKELY(buffer == nullptr)) {
-          worker_context->OperDone(oper_range,
-              Status(Substitute("Couldn't allocate memory for remote file operations, "
-                                "block size: '$0'",
-                  size)));
-        } else {
-          Status oper_status = oper_range->DoUpload(buffer, size);
-          worker_context->OperDone(oper_range, oper_status);
-          free(buffer);
-        }
-        break;
+      if (range->request_type() != RequestType::READ) {
+        ProcessRequestRange(worker_context, range);
+        continue;
       }
-      case RequestType::FILE_FETCH: {
-        RemoteOperRange* oper_range = static_cast<RemoteOperRange*>(range);
-        Status oper_status = oper_range->DoFetch();
-        worker_context->OperDone(oper_range, oper_status);
-        break;
+      ScopedThreadContext tdi_scope(GetThreadDebugInfo(), worker_context->query_id(),
+          worker_context->instance_id());
+      ScanRange* scan_range = static_cast<ScanRange*>(range);
+      int slot = free_slots.back();
+      ReadOutcome outcome;
+      if (scan_range->StartAsyncRead(this, disk_id_, ring, slot, &outcome)) {
+        reads[slot] = {worker_context, scan_range, MonotonicNanos()};
+        free_slots.pop_back();
+        worker_context->num_async_reads_.Add(1);
+      } else {
+        worker_context->ReadDone(disk_id_, outcome, scan_range);
       }
-      default:
-        DCHECK(false) << "Invalid request type: " << range->request_type();
     }
+    // All ranges may have been processed synchronously.
+    if (free_slots.size() == reads.size()) continue;
+
+    Status status = ring->SubmitAndWait(1);
+    if (!status.ok()) {
+      LOG(WARNING) << "Failing reads that could not be submitted: "
+                   << status.GetDetail();
+      ring->DiscardUnsubmitted([&](uint64_t slot) { finish_read(slot, -EIO); });
+    }
+    ring->ReapCompletions(finish_read);
   }
 }
 
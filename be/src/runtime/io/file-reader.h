@@ -58,6 +58,16 @@ public:
   /// When unsuccessful, 'data' is set to nullptr.
   virtual void CachedFile(uint8_t** data, int64_t* length) = 0;
 
+  /// ***Currently only for HDFS***
+  /// Looks up the whole scan range in the remote data cache and maps the cached data
+  /// into memory instead of copying it. When successful, sets 'data' to the mapped data
+  /// and 'length' to its length. The mapping is released in Close(). Does not require
+  /// Open(). When unsuccessful, 'data' is set to nullptr.
+  virtual void MappedDataCacheFile(uint8_t** data, int64_t* length) {
+    *data = nullptr;
+    *length = 0;
+  }
+
   /// Closes the file associated with 'scan_range_'. It doesn't have effect on other
   /// scan ranges.
   virtual void Close() = 0;
@@ -55,6 +55,7 @@ namespace io {
 HdfsFileReader::~HdfsFileReader() {
   DCHECK(exclusive_hdfs_fh_ == nullptr) << "File was not closed.";
   DCHECK(cached_buffer_ == nullptr) << "Cached buffer was not released.";
+  DCHECK(mapped_buffer_ == nullptr) << "Mapped data cache buffer was not released.";
 }
 
 Status HdfsFileReader::Open() {
@@ -328,23 +329,48 @@ void HdfsFileReader::CachedFile(uint8_t** data, int64_t* length) {
   *length = hadoopRzBufferLength(cached_buffer_);
 }
 
+void HdfsFileReader::MappedDataCacheFile(uint8_t** data, int64_t* length) {
+  DataCache* remote_data_cache = scan_range_->io_mgr_->remote_data_cache();
+  DCHECK(remote_data_cache != nullptr);
+  const int64_t bytes_to_read = scan_range_->len();
+  {
+    unique_lock<SpinLock> hdfs_lock(lock_);
+    DCHECK(mapped_buffer_ == nullptr);
+    remote_data_cache->LookupMapped(*scan_range_->file_string(), scan_range_->mtime(),
+        scan_range_->offset(), bytes_to_read, &mapped_buffer_);
+  }
+  if (mapped_buffer_ == nullptr) {
+    *data = nullptr;
+    *length = 0;
+    return;
+  }
+  DCHECK_EQ(mapped_buffer_->len(), bytes_to_read);
+  UpdateDataCacheHitMetrics(bytes_to_read, bytes_to_read);
+  // The mapping is read-only. Clients never write into cached buffers.
+  *data = const_cast<uint8_t*>(mapped_buffer_->data());
+  *length = mapped_buffer_->len();
+}
+
 int64_t HdfsFileReader::ReadDataCache(DataCache* remote_data_cache, int64_t file_offset,
     uint8_t* buffer, int64_t bytes_to_read) {
   int64_t cached_read = remote_data_cache->Lookup(*scan_range_->file_string(),
       scan_range_->mtime(), file_offset, bytes_to_read, buffer);
-  if (LIKELY(cached_read > 0)) {
-    scan_range_->reader_->data_cache_hit_bytes_counter_->Add(cached_read);
-    if (LIKELY(cached_read == bytes_to_read)) {
-      scan_range_->reader_->data_cache_hit_counter_->Add(1);
-    } else {
-      scan_range_->reader_->data_cache_partial_hit_counter_->Add(1);
-    }
-    ImpaladMetrics::IO_MGR_REMOTE_DATA_CACHE_HIT_BYTES->Increment(cached_read);
-    ImpaladMetrics::IO_MGR_REMOTE_DATA_CACHE_HIT_COUNT->Increment(1);
-  }
+  if (LIKELY(cached_read > 0)) UpdateDataCacheHitMetrics(cached_read, bytes_to_read);
   return cached_read;
 }
 
+void HdfsFileReader::UpdateDataCacheHitMetrics(int64_t cached_read,
+    int64_t bytes_to_read) {
+  scan_range_->reader_->data_cache_hit_bytes_counter_->Add(cached_read);
+  if (LIKELY(cached_read == bytes_to_read)) {
+    scan_range_->reader_->data_cache_hit_counter_->Add(1);
+  } else {
+    scan_range_->reader_->data_cache_partial_hit_counter_->Add(1);
+  }
+  ImpaladMetrics::IO_MGR_REMOTE_DATA_CACHE_HIT_BYTES->Increment(cached_read);
+  ImpaladMetrics::IO_MGR_REMOTE_DATA_CACHE_HIT_COUNT->Increment(1);
+}
+
 void HdfsFileReader::WriteDataCache(DataCache* remote_data_cache, int64_t file_offset,
     const uint8_t* buffer, int64_t buffer_len, int64_t bytes_missed) {
   // Intentionally leave out the return value as cache insertion is opportunistic.
@@ -360,7 +386,11 @@ void HdfsFileReader::WriteDataCache(DataCache* remote_data_cache, int64_t file_o
 }
 
 void HdfsFileReader::Close() {
+  // Releasing the mapping may punch the hole of an evicted entry, so it's destroyed
+  // after 'lock_' is released.
+  unique_ptr<DataCache::MappedBuffer> mapped_buffer;
   unique_lock<SpinLock> hdfs_lock(lock_);
+  mapped_buffer = move(mapped_buffer_);
   if (exclusive_hdfs_fh_ != nullptr) {
     GetHdfsStatistics(exclusive_hdfs_fh_->file(), false);
 
@@ -18,13 +18,12 @@
 #pragma once
 
 #include "common/hdfs.h"
+#include "runtime/io/data-cache.h"
 #include "runtime/io/file-reader.h"
 
 namespace impala {
 namespace io {
 
-class DataCache;
-
 /// File reader class for HDFS.
 class HdfsFileReader : public FileReader {
 public:
@@ -50,6 +49,10 @@ public:
   /// relies on HDFS caching. For remote reads, this interface is not used.
   virtual void CachedFile(uint8_t** data, int64_t* length) override;
 
+  /// Maps the whole scan range from the remote data cache. On success, 'mapped_buffer_'
+  /// holds the mapping until Close().
+  virtual void MappedDataCacheFile(uint8_t** data, int64_t* length) override;
+
 private:
 
   /// Performs the actual work of opening a file handle. When using a file handle or data
@@ -65,6 +68,10 @@ private:
   int64_t ReadDataCache(DataCache* remote_data_cache, int64_t file_offset,
       uint8_t* buffer, int64_t bytes_to_read);
 
+  /// Updates the cache metrics for a hit of 'cached_read' bytes in the remote data
+  /// cache out of the 'bytes_to_read' bytes requested.
+  void UpdateDataCacheHitMetrics(int64_t cached_read, int64_t bytes_to_read);
+
   /// Inserts into 'remote_data_cache' with 'buffer' which contains the data read
   /// from a file at 'file_offset'. 'buffer_len' is the length of the buffer in bytes.
   /// The file's name and mtime are stored in 'scan_range_'. 'cached_bytes_missed' is
@@ -121,6 +128,10 @@ private:
   /// Non-NULL if a cached read succeeded. Then all the bytes for the file are in
   /// this buffer.
   hadoopRzBuffer* cached_buffer_ = nullptr;
+
+  /// Non-NULL if a mapped read from the remote data cache succeeded. Then all the bytes
+  /// of the scan range are in this buffer.
+  std::unique_ptr<DataCache::MappedBuffer> mapped_buffer_;
 };
 
 }
@@ -0,0 +1,307 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "runtime/io/io-uring.h"
+
+#include <errno.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <limits>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#endif
+
+#include "gutil/strings/substitute.h"
+#include "util/debug-util.h"
+#include "util/error-util.h"
+#include "util/time.h"
+
+#include "common/names.h"
+
+// IORING_OP_READ needs Linux 5.6. IORING_FEAT_FAST_POLL, added in 5.7, is the first
+// feature flag that implies it, so it is used both to check the headers at build time
+// and the kernel at runtime.
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter) \
+    && defined(IORING_FEAT_FAST_POLL)
+#define IMPALA_HAVE_IO_URING 1
+#endif
+
+namespace impala {
+namespace io {
+
+#ifdef IMPALA_HAVE_IO_URING
+
+struct IoUring::Rings {
+  ~Rings() {
+    if (sqes != nullptr) munmap(sqes, sqes_size);
+    if (cq_ptr != nullptr && cq_ptr != sq_ptr) munmap(cq_ptr, cq_size);
+    if (sq_ptr != nullptr) munmap(sq_ptr, sq_size);
+  }
+
+  /// Returns true if there are completions that were not reaped yet.
+  bool HasCompletions() const {
+    return __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE) != *cq_head;
+  }
+
+  void* sq_ptr = nullptr;
+  size_t sq_size = 0;
+  void* cq_ptr = nullptr;
+  size_t cq_size = 0;
+  io_uring_sqe* sqes = nullptr;
+  size_t sqes_size = 0;
+
+  /// Submission queue. The kernel advances 'sq_head', this thread advances 'sq_tail'.
+  unsigned* sq_head = nullptr;
+  unsigned* sq_tail = nullptr;
+  unsigned sq_mask = 0;
+  unsigned* sq_array = nullptr;
+
+  /// Completion queue. The kernel advances 'cq_tail', this thread advances 'cq_head'.
+  unsigned* cq_head = nullptr;
+  unsigned* cq_tail = nullptr;
+  unsigned cq_mask = 0;
+  io_uring_cqe* cqes = nullptr;
+};
+
+static Status IoUringError(const string& what) {
+  return Status(TErrorCode::DISK_IO_ERROR, GetBackendString(),
+      Substitute("$0: $1", what, GetStrErrMsg()));
+}
+
+Status IoUring::Create(int queue_depth, unique_ptr<IoUring>* ring) {
+  DCHECK_GT(queue_depth, 0);
+  io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  int ring_fd = syscall(__NR_io_uring_setup, queue_depth, &params);
+  if (ring_fd < 0) {
+    return IoUringError(Substitute("Could not set up io_uring with $0 entries",
+        queue_depth));
+  }
+  if ((params.features & IORING_FEAT_FAST_POLL) == 0) {
+    close(ring_fd);
+    return Status("The io_uring of this kernel does not support IORING_OP_READ.");
+  }
+
+  unique_ptr<Rings> rings(new Rings());
+  rings->sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  rings->cq_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if (single_mmap) {
+    rings->sq_size = max(rings->sq_size, rings->cq_size);
+    rings->cq_size = rings->sq_size;
+  }
+  void* ptr = mmap(nullptr, rings->sq_size, PROT_READ | PROT_WRITE,
+      MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+  if (ptr == MAP_FAILED) {
+    Status status = IoUringError("Could not map io_uring submission queue");
+    close(ring_fd);
+    return status;
+  }
+  rings->sq_ptr = ptr;
+  if (single_mmap) {
+    rings->cq_ptr = rings->sq_ptr;
+  } else {
+    ptr = mmap(nullptr, rings->cq_size, PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_CQ_RING);
+    if (ptr == MAP_FAILED) {
+      Status status = IoUringError("Could not map io_uring completion queue");
+      close(ring_fd);
+      return status;
+    }
+    rings->cq_ptr = ptr;
+  }
+  rings->sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+  ptr = mmap(nullptr, rings->sqes_size, PROT_READ | PROT_WRITE,
+      MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES);
+  if (ptr == MAP_FAILED) {
+    Status status = IoUringError("Could not map io_uring submission queue entries");
+    close(ring_fd);
+    return status;
+  }
+  rings->sqes = static_cast<io_uring_sqe*>(ptr);
+
+  uint8_t* sq = static_cast<uint8_t*>(rings->sq_ptr);
+  rings->sq_head = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+  rings->sq_tail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+  rings->sq_mask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+  rings->sq_array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+  uint8_t* cq = static_cast<uint8_t*>(rings->cq_ptr);
+  rings->cq_head = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+  rings->cq_tail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+  rings->cq_mask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+  rings->cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+  // The kernel may round the number of entries up. Requests are bounded by the
+  // requested depth, which leaves the completion queue (twice as large) room to spare.
+  DCHECK_GE(params.sq_entries, static_cast<unsigned>(queue_depth));
+  ring->reset(new IoUring(ring_fd, queue_depth, move(rings)));
+  return Status::OK();
+}
+
+IoUring::IoUring(int ring_fd, int queue_depth, unique_ptr<Rings> rings)
+  : ring_fd_(ring_fd), queue_depth_(queue_depth), rings_(move(rings)) {}
+
+IoUring::~IoUring() {
+  DCHECK_EQ(num_unsubmitted_, 0);
+  rings_.reset();
+  close(ring_fd_);
+}
+
+void IoUring::PrepareRead(int fd, uint8_t* buffer, int64_t len, int64_t offset,
+    uint64_t user_data) {
+  DCHECK_LT(num_unsubmitted_, queue_depth_);
+  DCHECK_GE(len, 0);
+  DCHECK_LE(len, numeric_limits<uint32_t>::max());
+  Rings* r = rings_.get();
+  unsigned tail = *r->sq_tail;
+  unsigned index = tail & r->sq_mask;
+  io_uring_sqe* sqe = &r->sqes[index];
+  memset(sqe, 0, sizeof(*sqe));
+  sqe->opcode = IORING_OP_READ;
+  sqe->fd = fd;
+  sqe->addr = reinterpret_cast<uint64_t>(buffer);
+  sqe->len = static_cast<uint32_t>(len);
+  sqe->off = offset;
+  sqe->user_data = user_data;
+  r->sq_array[index] = index;
+  // Publish the entry before the kernel can see the new tail.
+  __atomic_store_n(r->sq_tail, tail + 1, __ATOMIC_RELEASE);
+  ++num_unsubmitted_;
+}
+
+Status IoUring::SubmitAndWait(int min_completions) {
+  unsigned flags = min_completions > 0 ? IORING_ENTER_GETEVENTS : 0;
+  int num_retries = 0;
+  while (true) {
+    int ret = syscall(__NR_io_uring_enter, ring_fd_, num_unsubmitted_, min_completions,
+        flags, nullptr, 0);
+    if (ret >= 0) {
+      DCHECK_LE(ret, num_unsubmitted_);
+      num_unsubmitted_ -= ret;
+      num_in_flight_ += ret;
+      if (num_unsubmitted_ == 0) return Status::OK();
+      continue;
+    }
+    if (errno == EINTR) continue;
+    if (errno == EAGAIN || errno == EBUSY) {
+      // The kernel is short of resources or the completion queue is full. Reaping
+      // completions makes room, so return once one is available. The remaining requests
+      // are submitted by the next call.
+      if (rings_->HasCompletions()) return Status::OK();
+      if (num_in_flight_ > 0) return WaitForCompletion();
+      // Nothing is in flight that could free up resources when it completes. The
+      // shortage is expected to be transient, so back off and retry.
+      if (num_retries < MAX_SUBMIT_RETRIES) {
+        SleepForMs(1 << num_retries);
+        ++num_retries;
+        continue;
+      }
+    }
+    return IoUringError(Substitute("Could not submit $0 io_uring requests",
+        num_unsubmitted_));
+  }
+}
+
+Status IoUring::WaitForCompletion() {
+  while (true) {
+    int ret = syscall(__NR_io_uring_enter, ring_fd_, 0, 1, IORING_ENTER_GETEVENTS,
+        nullptr, 0);
+    if (ret >= 0) return Status::OK();
+    if (errno == EINTR) continue;
+    return IoUringError("Could not wait for io_uring completions");
+  }
+}
+
+int IoUring::ReapCompletions(const std::function<void(uint64_t, int64_t)>& fn) {
+  Rings* r = rings_.get();
+  int num_reaped = 0;
+  unsigned head = *r->cq_head;
+  while (head != __atomic_load_n(r->cq_tail, __ATOMIC_ACQUIRE)) {
+    const io_uring_cqe* cqe = &r->cqes[head & r->cq_mask];
+    uint64_t user_data = cqe->user_data;
+    int64_t result = cqe->res;
+    // Release the entry before calling 'fn', which may queue new requests.
+    ++head;
+    __atomic_store_n(r->cq_head, head, __ATOMIC_RELEASE);
+    fn(user_data, result);
+    ++num_reaped;
+  }
+  num_in_flight_ -= num_reaped;
+  DCHECK_GE(num_in_flight_, 0);
+  return num_reaped;
+}
+
+int IoUring::DiscardUnsubmitted(const std::function<void(uint64_t)>& fn) {
+  Rings* r = rings_.get();
+  // The kernel only consumes entries in io_uring_enter(), so the entries after the
+  // submitted ones can be taken back by moving the tail.
+  unsigned tail = *r->sq_tail - num_unsubmitted_;
+  for (int i = 0; i < num_unsubmitted_; ++i) {
+    unsigned index = r->sq_array[(tail + i) & r->sq_mask];
+    fn(r->sqes[index].user_data);
+  }
+  __atomic_store_n(r->sq_tail, tail, __ATOMIC_RELEASE);
+  int num_discarded = num_unsubmitted_;
+  num_unsubmitted_ = 0;
+  return num_discarded;
+}
+
+#else
+
+struct IoUring::Rings {};
+
+Status IoUring::Create(int queue_depth, unique_ptr<IoUring>* ring) {
+  return Status("io_uring is not supported by this build of Impala.");
+}
+
+IoUring::IoUring(int ring_fd, int queue_depth, unique_ptr<Rings> rings)
+  : ring_fd_(ring_fd), queue_depth_(queue_depth), rings_(move(rings)) {}
+
+IoUring::~IoUring() {}
+
+void IoUring::PrepareRead(int fd, uint8_t* buffer, int64_t len, int64_t offset,
+    uint64_t user_data) {
+  DCHECK(false);
+}
+
+Status IoUring::SubmitAndWait(int min_completions) {
+  DCHECK(false);
+  return Status::OK();
+}
+
+Status IoUring::WaitForCompletion() {
+  DCHECK(false);
+  return Status::OK();
+}
+
+int IoUring::ReapCompletions(const std::function<void(uint64_t, int64_t)>& fn) {
+  DCHECK(false);
+  return 0;
+}
+
+int IoUring::DiscardUnsubmitted(const std::function<void(uint64_t)>& fn) {
+  DCHECK(false);
+  return 0;
+}
+
+#endif
+} // namespace io
+} // namespace impala
@@ -0,0 +1,99 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+
+#include "common/status.h"
+
+namespace impala {
+namespace io {
+
+/// Minimal wrapper around a Linux io_uring instance that is used to read local files
+/// asynchronously. Requests are queued with PrepareRead() and handed to the kernel in
+/// batches by SubmitAndWait(), so a single thread can keep many reads in flight with
+/// one system call per batch. Completions are returned by ReapCompletions() together
+/// with the 'user_data' of their request.
+///
+/// The ring is set up through the raw system calls, so it does not depend on liburing.
+/// An IoUring must only be used by a single thread.
+class IoUring {
+ public:
+  ~IoUring();
+
+  /// Creates a ring in 'ring' that holds up to 'queue_depth' requests. Returns an error
+  /// if io_uring is not supported by the kernel or by the headers Impala was built with.
+  static Status Create(int queue_depth, std::unique_ptr<IoUring>* ring);
+
+  /// Queues a read of 'len' bytes at 'offset' of 'fd' into 'buffer'. The request is not
+  /// handed to the kernel before the next SubmitAndWait(). 'buffer' and 'fd' must stay
+  /// valid until the completion of the request was reaped. The caller must make sure
+  /// that no more than queue_depth() requests are queued or in flight.
+  void PrepareRead(int fd, uint8_t* buffer, int64_t len, int64_t offset,
+      uint64_t user_data);
+
+  /// Submits all queued requests to the kernel and waits until at least
+  /// 'min_completions' completions can be reaped. If the kernel is temporarily out of
+  /// resources or the completion queue is full, it returns once a completion can be
+  /// reaped and leaves the remaining requests queued for the next call. If no request is
+  /// in flight, it retries with a backoff instead. Returns an error if the requests could
+  /// not be submitted. In that case the requests that were not submitted can be removed
+  /// with DiscardUnsubmitted().
+  Status SubmitAndWait(int min_completions);
+
+  /// Calls 'fn' with the user data and result of each available completion and returns
+  /// the number of completions. The result is the number of bytes read or -errno.
+  int ReapCompletions(const std::function<void(uint64_t, int64_t)>& fn);
+
+  /// Removes the requests that were queued but not submitted to the kernel and calls
+  /// 'fn' with their user data. Returns the number of removed requests.
+  int DiscardUnsubmitted(const std::function<void(uint64_t)>& fn);
+
+  int queue_depth() const { return queue_depth_; }
+
+ private:
+  struct Rings;
+
+  /// Number of times SubmitAndWait() retries a submission that failed for lack of
+  /// resources while no request was in flight. The backoff doubles from 1ms.
+  static constexpr int MAX_SUBMIT_RETRIES = 10;
+
+  IoUring(int ring_fd, int queue_depth, std::unique_ptr<Rings> rings);
+
+  /// Waits until at least one completion can be reaped.
+  Status WaitForCompletion();
+
+  /// File descriptor of the ring.
+  const int ring_fd_;
+
+  /// Maximum number of requests that are queued or in flight.
+  const int queue_depth_;
+
+  /// The memory-mapped submission and completion queues.
+  std::unique_ptr<Rings> rings_;
+
+  /// Number of requests queued by PrepareRead() that were not submitted yet.
+  int num_unsubmitted_ = 0;
+
+  /// Number of submitted requests whose completions were not reaped yet.
+  int num_in_flight_ = 0;
+};
+} // namespace io
+} // namespace impala
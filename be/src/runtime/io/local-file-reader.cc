@@ -19,6 +19,7 @@
 #include <stdio.h>
 
 #include "runtime/io/disk-io-mgr-internal.h"
+#include "runtime/io/io-uring.h"
 #include "runtime/io/local-file-reader.h"
 #include "runtime/io/request-ranges.h"
 #include "util/histogram-metric.h"
@@ -96,6 +97,45 @@ Status LocalFileReader::ReadFromPos(DiskQueue* queue, int64_t file_offset,
   return Status::OK();
 }
 
+Status LocalFileReader::StartAsyncRead(IoUring* ring, int64_t file_offset,
+    uint8_t* buffer, int64_t bytes_to_read, uint64_t user_data) {
+  DCHECK(scan_range_->read_in_flight());
+  DCHECK_GE(bytes_to_read, 0);
+  unique_lock<SpinLock> fs_lock(lock_);
+  RETURN_IF_ERROR(scan_range_->cancel_status_);
+  DCHECK(file_ != nullptr);
+  DCHECK(!async_read_in_flight_);
+  async_read_in_flight_ = true;
+  ring->PrepareRead(fileno(file_), buffer, bytes_to_read, file_offset, user_data);
+  return Status::OK();
+}
+
+Status LocalFileReader::FinishAsyncRead(DiskQueue* queue, int64_t result,
+    int64_t file_offset, int64_t bytes_to_read, int64_t* bytes_read, bool* eof) {
+  unique_lock<SpinLock> fs_lock(lock_);
+  DCHECK(async_read_in_flight_);
+  async_read_in_flight_ = false;
+  if (close_pending_) {
+    close_pending_ = false;
+    fclose(file_);
+    file_ = nullptr;
+    ImpaladMetrics::IO_MGR_NUM_OPEN_FILES->Increment(-1L);
+  }
+  *eof = false;
+  *bytes_read = 0;
+  if (result < 0) {
+    return Status(TErrorCode::DISK_IO_ERROR, GetBackendString(),
+        Substitute("Error reading from $0 at byte offset: $1: $2",
+            *scan_range_->file_string(), file_offset, GetStrErrMsg(-result)));
+  }
+  DCHECK_LE(result, bytes_to_read);
+  *bytes_read = result;
+  queue->read_size()->Update(*bytes_read);
+  // Like pread(), short reads of regular files only happen at the end of the file.
+  if (*bytes_read < bytes_to_read) *eof = true;
+  return Status::OK();
+}
+
 void LocalFileReader::CachedFile(uint8_t** data, int64_t* length) {
   *data = nullptr;
   *length = 0;
@@ -104,6 +144,10 @@ void LocalFileReader::CachedFile(uint8_t** data, int64_t* length) {
 void LocalFileReader::Close() {
   unique_lock<SpinLock> fs_lock(lock_);
   if (file_ == nullptr) return;
+  if (async_read_in_flight_) {
+    close_pending_ = true;
+    return;
+  }
   fclose(file_);
   file_ = nullptr;
   ImpaladMetrics::IO_MGR_NUM_OPEN_FILES->Increment(-1L);
@@ -22,6 +22,8 @@
 namespace impala {
 namespace io {
 
+class IoUring;
+
 /// File reader class for the local file system.
 /// It uses the standard C APIs from stdio.h
 class LocalFileReader : public FileReader {
@@ -34,11 +36,31 @@ class LocalFileReader : public FileReader {
       int64_t bytes_to_read, int64_t* bytes_read, bool* eof) override;
   /// We don't cache files of the local file system.
   virtual void CachedFile(uint8_t** data, int64_t* length) override;
+  /// If an asynchronous read is in flight, the file is closed when it finishes.
   virtual void Close() override;
 
+  /// Queues an asynchronous read of 'bytes_to_read' bytes at 'file_offset' into 'buffer'
+  /// in 'ring' with 'user_data'. The file must be open. FinishAsyncRead() must be called
+  /// with the result of the read once it completed.
+  Status StartAsyncRead(IoUring* ring, int64_t file_offset, uint8_t* buffer,
+      int64_t bytes_to_read, uint64_t user_data);
+
+  /// Called with the 'result' of the read started by StartAsyncRead(), i.e. the number
+  /// of bytes read or -errno. Sets 'bytes_read' and 'eof' like ReadFromPos().
+  /// 'bytes_to_read' and 'file_offset' must be the arguments of StartAsyncRead().
+  Status FinishAsyncRead(DiskQueue* queue, int64_t result, int64_t file_offset,
+      int64_t bytes_to_read, int64_t* bytes_read, bool* eof);
+
  private:
   /// Points to a C FILE object between calls to Open() and Close(), otherwise nullptr.
   FILE* file_ = nullptr;
+
+  /// True between StartAsyncRead() and FinishAsyncRead(). The kernel reads from the
+  /// descriptor of 'file_' in the meantime, so Close() must not close it.
+  bool async_read_in_flight_ = false;
+
+  /// Set if Close() was called while an asynchronous read was in flight.
+  bool close_pending_ = false;
 };
 
 }
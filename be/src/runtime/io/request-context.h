@@ -65,6 +65,8 @@ enum class ScheduleMode {
 /// 1 -> 2 -> 3 -> (4 -> 3)*
 ///
 /// In the case of a cached scan range, the range is immediately put in 'cached_ranges_'.
+/// Ranges which may be mapped from the remote data cache (see
+/// ScanRange::UseMappedDataCache()) are treated as cached ranges too.
 /// When the caller asks for the next range to process, we first pull ranges from
 /// the 'cache_ranges_' queue. If the range was cached, the range is removed and
 /// done (ranges are either entirely cached or not at all). If the cached read attempt
@@ -162,6 +164,7 @@ class RequestContext {
   int64_t bytes_read_ec() const { return bytes_read_ec_.Load(); }
   int num_remote_ranges() const { return num_remote_ranges_.Load(); }
   int64_t unexpected_remote_bytes() const { return unexpected_remote_bytes_.Load(); }
+  int64_t num_async_reads() const { return num_async_reads_.Load(); }
 
   int cached_file_handles_hit_count() const {
     return cached_file_handles_hit_count_.Load();
@@ -410,6 +413,9 @@ class RequestContext {
   /// Total number of bytes from remote reads that were expected to be local.
   AtomicInt64 unexpected_remote_bytes_{0};
 
+  /// Total number of reads that were submitted through io_uring.
+  AtomicInt64 num_async_reads_{0};
+
   /// The number of scan ranges that required a remote read, updated at the end of each
   /// range scan. Only used for diagnostics.
   AtomicInt32 num_remote_ranges_{0};
@@ -458,7 +464,8 @@ class RequestContext {
   /// disks with ranges).
   int num_disks_with_ranges_ = 0;
 
-  /// This is the list of ranges that are expected to be cached on the DN.
+  /// This is the list of ranges that are expected to be cached on the DN or in the
+  /// remote data cache.
   /// When the reader asks for a new range (GetNextScanRange()), we first
   /// return ranges from this list.
   InternalList<ScanRange> cached_ranges_;
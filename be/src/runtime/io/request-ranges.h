@@ -40,6 +40,7 @@ class DiskQueue;
 class ExclusiveHdfsFileHandle;
 class FileReader;
 class FileWriter;
+class IoUring;
 class RequestContext;
 class ScanRange;
 
@@ -324,6 +325,11 @@ class ScanRange : public RequestRange {
   int cache_options() const { return cache_options_; }
   bool UseHdfsCache() const { return (cache_options_ & BufferOpts::USE_HDFS_CACHE) != 0; }
   bool UseDataCache() const { return (cache_options_ & BufferOpts::USE_DATA_CACHE) != 0; }
+
+  /// Returns true if a hit in the remote data cache for the whole range can be returned
+  /// to the client as a single buffer mapping the cached data instead of being copied.
+  /// See --data_cache_mmap_reads. Only valid after InitInternal().
+  bool UseMappedDataCache() const;
   bool read_in_flight() const { return read_in_flight_; }
   bool expected_local() const { return expected_local_; }
   int64_t bytes_to_read() const { return bytes_to_read_; }
@@ -399,9 +405,18 @@ class ScanRange : public RequestRange {
   /// If the data is not cached, returns ok() and *read_succeeded is set to false.
   /// Returns a non-ok status if it ran into a non-continuable error.
   /// The reader lock must be held by the caller.
+  /// The data is read from the HDFS cache if UseHdfsCache() is true and from a mapping
+  /// of the remote data cache otherwise.
   Status ReadFromCache(const std::unique_lock<std::mutex>& reader_lock,
       bool* read_succeeded) WARN_UNUSED_RESULT;
 
+  /// Implements ReadFromCache() for the remote data cache.
+  Status ReadFromMappedDataCache(bool* read_succeeded) WARN_UNUSED_RESULT;
+
+  /// Enqueues a single buffer holding the whole range from 'cache_'. The memory of the
+  /// buffer is owned by the file reader, not the Impala backend.
+  void EnqueueCachedBuffer();
+
   /// Add buffers for the range to read data into and schedule the range if blocked.
   /// If 'returned' is true, the buffers returned from GetNext() that are being recycled
   /// via ReturnBuffer(). Otherwise the buffers are newly allocated buffers to be added.
@@ -424,6 +439,30 @@ class ScanRange : public RequestRange {
       bool use_mem_buffer,
       boost::shared_lock<boost::shared_mutex>* local_file_lock = nullptr);
 
+  /// Called from a disk I/O thread that reads through 'ring'. If the next read of this
+  /// range is a plain read of a local file, queues it in 'ring' with 'user_data' and
+  /// returns true. FinishAsyncRead() must be called with the result of the read once it
+  /// completed. Otherwise returns false and sets 'outcome' to the outcome of the read,
+  /// which is either done synchronously with DoRead() or could not be started.
+  bool StartAsyncRead(DiskQueue* queue, int disk_id, IoUring* ring, uint64_t user_data,
+      ReadOutcome* outcome);
+
+  /// Completes the read started by StartAsyncRead(). 'result' is the number of bytes
+  /// read or -errno. Returns the outcome of the read like DoRead().
+  ReadOutcome FinishAsyncRead(DiskQueue* queue, int64_t result);
+
+  /// Helpers for DoReadInternal() and the asynchronous reads.
+  /// StartRead() gets the buffer for the next read and the reader to read with. Returns
+  /// false and sets 'outcome' if the range cannot be read now. Otherwise marks the read
+  /// as in flight and returns true.
+  bool StartRead(bool use_local_buffer, bool use_mem_buffer,
+      std::unique_ptr<BufferDescriptor>* buffer_desc, FileReader** file_reader,
+      ReadOutcome* outcome);
+  /// FinishRead() enqueues 'buffer_desc' filled by the read that returned 'read_status',
+  /// or cancels the range if the read failed. Returns the outcome of the read.
+  ReadOutcome FinishRead(const Status& read_status,
+      std::unique_ptr<BufferDescriptor> buffer_desc, bool eof, FileReader* file_reader);
+
   /// Whether to use file handle caching for the current file.
   bool FileHandleCacheEnabled() const;
 
@@ -554,7 +593,8 @@ class ScanRange : public RequestRange {
     int64_t len = 0;
   } client_buffer_;
 
-  /// Valid if reading file contents from cache was successful.
+  /// Valid if reading file contents from the HDFS cache or mapping them from the remote
+  /// data cache was successful.
   struct {
     /// Pointer to the contents of the file.
     uint8_t* data = nullptr;
@@ -596,6 +636,10 @@ class ScanRange : public RequestRange {
   /// Number of bytes read by this scan range.
   int64_t bytes_read_ = 0;
 
+  /// The buffer of the read started by StartAsyncRead(), until FinishAsyncRead() is
+  /// called. Only accessed by the disk thread that owns the read.
+  std::unique_ptr<BufferDescriptor> async_read_buffer_;
+
   /// Polymorphic object that is responsible for doing file operations.
   std::unique_ptr<FileReader> file_reader_;
 
@@ -35,6 +35,7 @@ DECLARE_bool(cache_remote_file_handles);
 DECLARE_bool(cache_s3_file_handles);
 DECLARE_bool(cache_abfs_file_handles);
 DECLARE_bool(cache_ozone_file_handles);
+DECLARE_bool(data_cache_mmap_reads);
 
 // Implementation of the ScanRange functionality. Each ScanRange contains a queue
 // of ready buffers. For each ScanRange, there is only a single producer and
@@ -148,8 +149,9 @@ bool ScanRange::FileHandleCacheEnabled() const {
   return false;
 }
 
-ReadOutcome ScanRange::DoReadInternal(DiskQueue* queue, int disk_id, bool use_local_buff,
-    bool use_mem_buffer, shared_lock<shared_mutex>* local_file_lock) {
+bool ScanRange::StartRead(bool use_local_buff, bool use_mem_buffer,
+    unique_ptr<BufferDescriptor>* buffer_desc_out, FileReader** file_reader_out,
+    ReadOutcome* outcome) {
   int64_t bytes_remaining = bytes_to_read_ - bytes_read_;
   DCHECK_GT(bytes_remaining, 0);
   // Can't be set to true together.
@@ -160,7 +162,10 @@ ReadOutcome ScanRange::DoReadInternal(DiskQueue* queue, int disk_id, bool use_lo
   {
     unique_lock<mutex> lock(lock_);
     DCHECK(!read_in_flight_);
-    if (!cancel_status_.ok()) return ReadOutcome::CANCELLED;
+    if (!cancel_status_.ok()) {
+      *outcome = ReadOutcome::CANCELLED;
+      return false;
+    }
 
     if (buffer_manager_->is_client_buffer()) {
       buffer_desc = unique_ptr<BufferDescriptor>(new BufferDescriptor(
@@ -174,7 +179,8 @@ ReadOutcome ScanRange::DoReadInternal(DiskQueue* queue, int disk_id, bool use_lo
       if (buffer_desc == nullptr) {
         // No buffer available - the range will be rescheduled when a buffer is added.
         blocked_on_buffer_ = true;
-        return ReadOutcome::BLOCKED_ON_BUFFER;
+        *outcome = ReadOutcome::BLOCKED_ON_BUFFER;
+        return false;
       }
       buffer_manager_->add_iomgr_buffer_cumulative_bytes_used(buffer_desc->buffer_len());
     }
@@ -190,6 +196,19 @@ ReadOutcome ScanRange::DoReadInternal(DiskQueue* queue, int disk_id, bool use_lo
       use_local_buffer_ = use_local_buff;
     }
   }
+  *buffer_desc_out = move(buffer_desc);
+  *file_reader_out = file_reader;
+  return true;
+}
+
+ReadOutcome ScanRange::DoReadInternal(DiskQueue* queue, int disk_id, bool use_local_buff,
+    bool use_mem_buffer, shared_lock<shared_mutex>* local_file_lock) {
+  unique_ptr<BufferDescriptor> buffer_desc;
+  FileReader* file_reader = nullptr;
+  ReadOutcome outcome;
+  if (!StartRead(use_local_buff, use_mem_buffer, &buffer_desc, &file_reader, &outcome)) {
+    return outcome;
+  }
 
   bool eof = false;
   Status read_status = Status::OK();
@@ -253,7 +272,11 @@ ReadOutcome ScanRange::DoReadInternal(DiskQueue* queue, int disk_id, bool use_lo
       }
     }
   }
+  return FinishRead(read_status, move(buffer_desc), eof, file_reader);
+}
 
+ReadOutcome ScanRange::FinishRead(const Status& read_status,
+    unique_ptr<BufferDescriptor> buffer_desc, bool eof, FileReader* file_reader) {
   DCHECK(buffer_desc->buffer_ != nullptr);
   DCHECK(!buffer_desc->is_cached())
       << "Pure HDFS cache reads don't go through this code path.";
@@ -331,6 +354,52 @@ ReadOutcome ScanRange::DoRead(DiskQueue* queue, int disk_id) {
   return DoReadInternal(queue, disk_id, use_local_buffer, use_mem_buffer);
 }
 
+bool ScanRange::StartAsyncRead(DiskQueue* queue, int disk_id, IoUring* ring,
+    uint64_t user_data, ReadOutcome* outcome) {
+  // Only plain reads of local files are submitted asynchronously. Reads from the local
+  // buffers of remote scratch files and reads of sub-ranges take the blocking path.
+  LocalFileReader* local_reader = dynamic_cast<LocalFileReader*>(file_reader_.get());
+  if (local_reader == nullptr || !sub_ranges_.empty() || cache_.data != nullptr
+      || (disk_file_ != nullptr && disk_file_->disk_type() != DiskFileType::LOCAL)) {
+    *outcome = DoRead(queue, disk_id);
+    return false;
+  }
+  unique_ptr<BufferDescriptor> buffer_desc;
+  FileReader* file_reader = nullptr;
+  if (!StartRead(false, false, &buffer_desc, &file_reader, outcome)) return false;
+  DCHECK_EQ(file_reader, local_reader);
+
+  Status read_status = local_reader->Open();
+  if (read_status.ok()) {
+    int64_t bytes_to_read = min(bytes_to_read_ - bytes_read_, buffer_desc->buffer_len_);
+    read_status = local_reader->StartAsyncRead(ring, offset_ + bytes_read_,
+        buffer_desc->buffer_, bytes_to_read, user_data);
+  }
+  if (!read_status.ok()) {
+    *outcome = FinishRead(read_status, move(buffer_desc), false, local_reader);
+    return false;
+  }
+  COUNTER_ADD_IF_NOT_NULL(reader_->active_read_thread_counter_, 1L);
+  COUNTER_BITOR_IF_NOT_NULL(reader_->disks_accessed_bitmap_, 1LL << disk_id);
+  DCHECK(async_read_buffer_ == nullptr);
+  async_read_buffer_ = move(buffer_desc);
+  return true;
+}
+
+ReadOutcome ScanRange::FinishAsyncRead(DiskQueue* queue, int64_t result) {
+  DCHECK(async_read_buffer_ != nullptr);
+  unique_ptr<BufferDescriptor> buffer_desc = move(async_read_buffer_);
+  LocalFileReader* local_reader = static_cast<LocalFileReader*>(file_reader_.get());
+  int64_t file_offset = offset_ + bytes_read_;
+  int64_t bytes_to_read = min(bytes_to_read_ - bytes_read_, buffer_desc->buffer_len_);
+  bool eof = false;
+  Status read_status = local_reader->FinishAsyncRead(queue, result, file_offset,
+      bytes_to_read, &buffer_desc->len_, &eof);
+  COUNTER_ADD_IF_NOT_NULL(reader_->bytes_read_counter_, buffer_desc->len_);
+  COUNTER_ADD_IF_NOT_NULL(reader_->active_read_thread_counter_, -1L);
+  return FinishRead(read_status, move(buffer_desc), eof, local_reader);
+}
+
 Status ScanRange::ReadSubRanges(
     DiskQueue* queue, BufferDescriptor* buffer_desc, bool* eof, FileReader* file_reader) {
   buffer_desc->len_ = 0;
@@ -607,12 +676,22 @@ void ScanRange::SetFileReader(unique_ptr<FileReader> file_reader) {
   file_reader_ = move(file_reader);
 }
 
+bool ScanRange::UseMappedDataCache() const {
+  DCHECK(io_mgr_ != nullptr);
+  // The HDFS cache takes precedence. The range is returned as a single buffer, so there
+  // must be no sub-ranges or client buffer to copy the data into.
+  return FLAGS_data_cache_mmap_reads && UseDataCache() && !UseHdfsCache()
+      && fs_ != nullptr && io_mgr_->remote_data_cache() != nullptr
+      && sub_ranges_.empty() && buffer_manager_->is_internal_buffer();
+}
+
 Status ScanRange::ReadFromCache(
     const unique_lock<mutex>& reader_lock, bool* read_succeeded) {
   DCHECK(reader_lock.mutex() == &reader_->lock_ && reader_lock.owns_lock());
-  DCHECK(UseHdfsCache());
+  DCHECK(UseHdfsCache() || UseMappedDataCache());
   DCHECK_EQ(bytes_read_, 0);
   *read_succeeded = false;
+  if (!UseHdfsCache()) return ReadFromMappedDataCache(read_succeeded);
   Status status = file_reader_->Open();
   if (!status.ok()) return status;
 
@@ -648,18 +727,44 @@ Status ScanRange::ReadFromCache(
   if (HasSubRanges()) return Status::OK();
 
   DCHECK(!buffer_manager_->is_client_buffer());
+  // The memory is owned by the HDFS java client.
+  EnqueueCachedBuffer();
+  return Status::OK();
+}
+
+Status ScanRange::ReadFromMappedDataCache(bool* read_succeeded) {
+  // Check cancel status.
+  {
+    unique_lock<mutex> lock(lock_);
+    RETURN_IF_ERROR(cancel_status_);
+  }
+
+  // Unlike the HDFS cache, the file doesn't need to be opened for reading from the data
+  // cache.
+  file_reader_->MappedDataCacheFile(&cache_.data, &cache_.len);
+  // The range isn't entirely cached. The caller will fall back to the normal read path,
+  // which also reads any partial hit from the data cache.
+  if (cache_.data == nullptr) return Status::OK();
+  DCHECK_EQ(cache_.len, len());
+
+  *read_succeeded = true;
+  // The memory is a mapping of a backing file of the data cache.
+  EnqueueCachedBuffer();
+  return Status::OK();
+}
+
+void ScanRange::EnqueueCachedBuffer() {
+  DCHECK(cache_.data != nullptr);
   buffer_manager_->set_cached_buffer();
   bytes_read_ = cache_.len;
 
   // Create a single buffer desc for the entire scan range and enqueue that.
-  // The memory is owned by the HDFS java client, not the Impala backend.
   unique_ptr<BufferDescriptor> desc = unique_ptr<BufferDescriptor>(new BufferDescriptor(
       this, cache_.data, 0));
   desc->len_ = cache_.len;
   desc->eosr_ = true;
   EnqueueReadyBuffer(move(desc));
   COUNTER_ADD_IF_NOT_NULL(reader_->bytes_read_counter_, cache_.len);
-  return Status::OK();
 }
 
 Status ScanRange::AllocateBuffersForRange(
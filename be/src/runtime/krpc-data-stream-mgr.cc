@@ -17,6 +17,7 @@
 
 #include "runtime/krpc-data-stream-mgr.h"
 
+#include <chrono>
 #include <iostream>
 #include <mutex>
 #include <boost/functional/hash.hpp>
@@ -134,6 +135,7 @@ shared_ptr<KrpcDataStreamRecvr> KrpcDataStreamMgr::CreateRecvr(
       early_senders_map_.erase(it);
     }
   }
+  recvr_created_cv_.notify_all();
 
   // Let the receiver take over the RPC payloads of early senders and process them
   // asynchronously.
@@ -248,6 +250,67 @@ void KrpcDataStreamMgr::AddData(const TransmitDataRequestPB* request,
   service_mem_tracker_->Release(transfer_size);
 }
 
+Status KrpcDataStreamMgr::FindLocalRecvr(RuntimeState* sender_state,
+    const TUniqueId& finst_id, PlanNodeId dest_node_id,
+    shared_ptr<KrpcDataStreamRecvr>* recvr) {
+  const int64_t start_time_ms = MonotonicMillis();
+  bool waited = false;
+  Status status;
+  unique_lock<mutex> l(lock_);
+  while (true) {
+    bool already_unregistered = false;
+    *recvr = FindRecvr(finst_id, dest_node_id, &already_unregistered);
+    if (*recvr != nullptr || already_unregistered) break;
+    if (!waited) {
+      waited = true;
+      num_senders_waiting_->Increment(1);
+      total_senders_waited_->Increment(1);
+    }
+    if (sender_state->is_cancelled()) {
+      status = Status::CANCELLED;
+      break;
+    }
+    if (MonotonicMillis() - start_time_ms > FLAGS_datastream_sender_timeout_ms) {
+      ErrorMsg msg(TErrorCode::DATASTREAM_SENDER_TIMEOUT, " (local)", PrintId(finst_id),
+          dest_node_id);
+      VLOG_QUERY << msg.msg();
+      num_senders_timedout_->Increment(1);
+      status = Status::Expected(msg);
+      break;
+    }
+    recvr_created_cv_.wait_for(l, std::chrono::milliseconds(50));
+  }
+  if (waited) num_senders_waiting_->Increment(-1);
+  return status;
+}
+
+Status KrpcDataStreamMgr::AddLocalData(RuntimeState* sender_state,
+    const TUniqueId& finst_id, PlanNodeId dest_node_id, int sender_id, RowBatch* batch,
+    bool acquire, int64_t* batch_size) {
+  VLOG_ROW << "AddLocalData(): fragment_instance_id=" << PrintId(finst_id)
+           << " node_id=" << dest_node_id << " #rows=" << batch->num_rows()
+           << " sender_id=" << sender_id;
+  *batch_size = 0;
+  shared_ptr<KrpcDataStreamRecvr> recvr;
+  RETURN_IF_ERROR(FindLocalRecvr(sender_state, finst_id, dest_node_id, &recvr));
+  if (recvr == nullptr) {
+    return Status::Expected(
+        TErrorCode::DATASTREAM_RECVR_CLOSED, PrintId(finst_id), dest_node_id);
+  }
+  return recvr->AddLocalBatch(sender_state, sender_id, batch, acquire, batch_size);
+}
+
+Status KrpcDataStreamMgr::CloseLocalSender(RuntimeState* sender_state,
+    const TUniqueId& finst_id, PlanNodeId dest_node_id, int sender_id) {
+  VLOG_ROW << "CloseLocalSender(): fragment_instance_id=" << PrintId(finst_id)
+           << " node_id=" << dest_node_id << " sender_id=" << sender_id;
+  shared_ptr<KrpcDataStreamRecvr> recvr;
+  RETURN_IF_ERROR(FindLocalRecvr(sender_state, finst_id, dest_node_id, &recvr));
+  // As in CloseSender(), a receiver that was unregistered already needs no notice.
+  if (LIKELY(recvr != nullptr)) recvr->RemoveSender(sender_id);
+  return Status::OK();
+}
+
 void KrpcDataStreamMgr::EnqueueDeserializeTask(const TUniqueId& finst_id,
     PlanNodeId dest_node_id, int sender_id, int num_requests) {
   for (int i = 0; i < num_requests; ++i) {
@@ -17,6 +17,7 @@
 
 #pragma once
 
+#include <condition_variable>
 #include <list>
 #include <mutex>
 #include <queue>
@@ -280,6 +281,26 @@ class KrpcDataStreamMgr : public CacheLineAligned {
   void CloseSender(const EndDataStreamRequestPB* request,
       EndDataStreamResponsePB* response, kudu::rpc::RpcContext* context);
 
+  /// Fast path of AddData() for a sender running in this process. Hands the rows of
+  /// 'batch' to the receiver identified by 'finst_id' and 'dest_node_id' without
+  /// serializing them. If 'acquire' is true, the receiver takes over the tuple data of
+  /// 'batch', which must not have attached buffers and is left empty; otherwise the
+  /// rows are deep copied. Blocks until the receiver is created and has buffer space
+  /// for the batch, so that a local sender is flow-controlled like a remote one whose
+  /// RPC is deferred. 'sender_state' is the sender's RuntimeState; the wait ends with
+  /// CANCELLED when it is cancelled. Returns DATASTREAM_SENDER_TIMEOUT if the receiver
+  /// doesn't show up within FLAGS_datastream_sender_timeout_ms, and
+  /// DATASTREAM_RECVR_CLOSED if it was closed already. Sets 'batch_size' to the number of
+  /// bytes buffered by the receiver.
+  Status AddLocalData(RuntimeState* sender_state, const TUniqueId& finst_id,
+      PlanNodeId dest_node_id, int sender_id, RowBatch* batch, bool acquire,
+      int64_t* batch_size);
+
+  /// Fast path of CloseSender() for a sender running in this process. Waits for the
+  /// receiver to be created like AddLocalData().
+  Status CloseLocalSender(RuntimeState* sender_state, const TUniqueId& finst_id,
+      PlanNodeId dest_node_id, int sender_id);
+
   /// Cancels all receivers registered for 'query_id' immediately. The receivers will not
   /// accept any row batches after being cancelled. Any buffered row batches will not be
   /// freed until Close() is called on the receivers.
@@ -341,6 +362,10 @@ class KrpcDataStreamMgr : public CacheLineAligned {
   /// protects all fields below
   std::mutex lock_;
 
+  /// Signaled when a receiver is created. Senders in this process that arrive before
+  /// their receiver wait on it, instead of being queued in 'early_senders_map_'.
+  std::condition_variable recvr_created_cv_;
+
   /// Map from hash value of fragment instance id/node id pair to stream receivers;
   /// Ownership of the stream revcr is shared between this instance and the caller of
   /// CreateRecvr().
@@ -466,6 +491,12 @@ class KrpcDataStreamMgr : public CacheLineAligned {
   std::shared_ptr<KrpcDataStreamRecvr> FindRecvr(const TUniqueId& fragment_instance_id,
       PlanNodeId dest_node_id, bool* already_unregistered);
 
+  /// Looks up the receiver for a sender in this process, waiting for it to be created if
+  /// it doesn't exist yet. Sets 'recvr' to an empty shared_ptr if the receiver was closed
+  /// already. See AddLocalData() for the errors returned.
+  Status FindLocalRecvr(RuntimeState* sender_state, const TUniqueId& finst_id,
+      PlanNodeId dest_node_id, std::shared_ptr<KrpcDataStreamRecvr>* recvr);
+
   /// Remove receiver for fragment_instance_id/dest_node_id from the map. Will also
   /// cancel all the sender queues of the receiver.
   Status DeregisterRecvr(const TUniqueId& fragment_instance_id, PlanNodeId dest_node_id);
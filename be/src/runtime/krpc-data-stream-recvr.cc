@@ -17,6 +17,7 @@
 
 #include "runtime/krpc-data-stream-recvr.h"
 
+#include <chrono>
 #include <condition_variable>
 #include <mutex>
 #include <queue>
@@ -81,6 +82,11 @@ class KrpcDataStreamRecvr::SenderQueue {
   void AddBatch(const TransmitDataRequestPB* request, TransmitDataResponsePB* response,
       RpcContext* context);
 
+  // Adds the rows of 'src' from a sender in this process to this sender queue. See
+  // KrpcDataStreamRecvr::AddLocalBatch().
+  Status AddLocalBatch(
+      RuntimeState* sender_state, RowBatch* src, bool acquire, int64_t* batch_size);
+
   // Tries inserting the front of 'deferred_rpcs_' queue into 'batch_queue_' if possible.
   // On success, the first entry of 'deferred_rpcs_' is removed and the sender of the RPC
   // will be responded to. If the serialized row batch fails to be extracted from the
@@ -192,6 +198,13 @@ class KrpcDataStreamRecvr::SenderQueue {
   // Signal the arrival of new batch or the eos/cancelled condition.
   condition_variable_any data_arrival_cv_;
 
+  // Signals senders in this process blocked in AddLocalBatch() that a batch was
+  // dequeued or that the queue was cancelled.
+  condition_variable_any local_space_cv_;
+
+  // Number of senders in this process blocked in AddLocalBatch().
+  int num_local_senders_waiting_ = 0;
+
   // Queue of (batch length, batch) pairs. The SenderQueue owns the memory to these
   // batches until they are handed off to the callers of GetBatch().
   typedef list<pair<int, std::unique_ptr<RowBatch>>> RowBatchQueue;
@@ -291,6 +304,7 @@ Status KrpcDataStreamRecvr::SenderQueue::GetBatch(RowBatch** next_batch) {
     COUNTER_ADD(recvr_->bytes_dequeued_counter_, batch_size);
     recvr_->num_buffered_bytes_.Add(-batch_size);
     batch_queue_.pop_front();
+    if (num_local_senders_waiting_ > 0) local_space_cv_.notify_all();
     VLOG_ROW << "fetched #rows=" << result->num_rows();
     current_batch_.reset(result);
     *next_batch = current_batch_.get();
@@ -486,6 +500,64 @@ void KrpcDataStreamRecvr::SenderQueue::AddBatch(const TransmitDataRequestPB* req
   DataStreamService::RespondRpc(status, response, rpc_context);
 }
 
+Status KrpcDataStreamRecvr::SenderQueue::AddLocalBatch(
+    RuntimeState* sender_state, RowBatch* src, bool acquire, int64_t* batch_size) {
+  // The queued batch holds the tuple pointers for the capacity of 'src' and either the
+  // tuple data of 'src' or a copy of its rows. The size of a copy is only known once it
+  // is made, so the fixed-length size of the rows is reserved until then.
+  const int64_t tuple_ptrs_size =
+      src->capacity() * src->num_tuples_per_row() * sizeof(Tuple*);
+  *batch_size = tuple_ptrs_size + (acquire ?
+      src->tuple_data_pool()->total_reserved_bytes() :
+      src->num_rows() * src->row_desc()->GetRowSize());
+  COUNTER_ADD(recvr_->total_received_batches_counter_, 1);
+  COUNTER_ADD(recvr_->total_local_batches_counter_, 1);
+
+  unique_lock<SpinLock> l(lock_);
+  DCHECK_GT(num_remaining_senders_, 0);
+  // Wait for space in the queue like a deferred RPC would. The sender is not blocked on
+  // the deferred RPCs of other senders, which only wait for the deserialization threads.
+  ++num_local_senders_waiting_;
+  while (!is_cancelled_ && !CanEnqueue(*batch_size, l)) {
+    if (sender_state->is_cancelled()) {
+      --num_local_senders_waiting_;
+      return Status::CANCELLED;
+    }
+    local_space_cv_.wait_for(l, std::chrono::milliseconds(50));
+  }
+  --num_local_senders_waiting_;
+  if (UNLIKELY(is_cancelled_)) {
+    return Status::Expected(TErrorCode::DATASTREAM_RECVR_CLOSED,
+        PrintId(recvr_->fragment_instance_id()), recvr_->dest_node_id());
+  }
+
+  // Reserve queue space and drop the lock while the batch is created, like
+  // AddBatchWork().
+  recvr_->num_buffered_bytes_.Add(*batch_size);
+  ++num_pending_enqueue_;
+  l.unlock();
+  unique_ptr<RowBatch> batch = make_unique<RowBatch>(
+      recvr_->row_desc(), src->capacity(), recvr_->parent_tracker());
+  if (acquire) {
+    batch->AcquireState(src);
+  } else {
+    src->DeepCopyTo(batch.get());
+    int64_t copy_size =
+        tuple_ptrs_size + batch->tuple_data_pool()->total_reserved_bytes();
+    recvr_->num_buffered_bytes_.Add(copy_size - *batch_size);
+    *batch_size = copy_size;
+  }
+  l.lock();
+
+  DCHECK_GT(num_pending_enqueue_, 0);
+  --num_pending_enqueue_;
+  VLOG_ROW << "added local #rows=" << batch->num_rows() << " batch_size=" << *batch_size;
+  COUNTER_ADD(recvr_->total_enqueued_batches_counter_, 1);
+  batch_queue_.emplace_back(*batch_size, move(batch));
+  data_arrival_cv_.notify_one();
+  return Status::OK();
+}
+
 void KrpcDataStreamRecvr::SenderQueue::ProcessDeferredRpc() {
   // Owns the first entry of 'deferred_rpcs_' if it ends up being popped.
   std::unique_ptr<TransmitDataCtx> ctx;
@@ -618,6 +690,7 @@ void KrpcDataStreamRecvr::SenderQueue::Cancel() {
   // Wake up all threads waiting to produce/consume batches. They will all
   // notice that the stream is cancelled and handle it.
   data_arrival_cv_.notify_all();
+  local_space_cv_.notify_all();
   PeriodicCounterUpdater::StopTimeSeriesCounter(
       recvr_->bytes_received_time_series_counter_);
 }
@@ -640,7 +713,7 @@ void KrpcDataStreamRecvr::SenderQueue::Close() {
 }
 
 Status KrpcDataStreamRecvr::CreateMerger(const TupleRowComparator& less_than,
-    const CodegenFnPtr<SortedRunMerger::HeapifyHelperFn>& codegend_heapify_helper_fn) {
+    const CodegenFnPtr<SortedRunMerger::ReplayHelperFn>& codegend_replay_helper_fn) {
   DCHECK(is_merging_);
   DCHECK(TestInfo::is_test() || FragmentInstanceState::IsFragmentExecThread());
   vector<SortedRunMerger::RunBatchSupplierFn> input_batch_suppliers;
@@ -648,7 +721,7 @@ Status KrpcDataStreamRecvr::CreateMerger(const TupleRowComparator& less_than,
 
   // Create the merger that will a single stream of sorted rows.
   merger_.reset(new SortedRunMerger(less_than, row_desc_, profile_, false,
-      codegend_heapify_helper_fn));
+      codegend_replay_helper_fn));
 
   for (SenderQueue* queue: sender_queues_) {
     input_batch_suppliers.push_back(
@@ -730,6 +803,8 @@ KrpcDataStreamRecvr::KrpcDataStreamRecvr(KrpcDataStreamMgr* stream_mgr,
       ADD_COUNTER(enqueue_profile_, "TotalEarlySenders", TUnit::UNIT);
   total_received_batches_counter_ =
       ADD_COUNTER(enqueue_profile_, "TotalBatchesReceived", TUnit::UNIT);
+  total_local_batches_counter_ =
+      ADD_COUNTER(enqueue_profile_, "TotalLocalBatchesReceived", TUnit::UNIT);
   total_enqueued_batches_counter_ =
       ADD_COUNTER(enqueue_profile_, "TotalBatchesEnqueued", TUnit::UNIT);
   total_deferred_rpcs_counter_ =
@@ -759,6 +834,14 @@ void KrpcDataStreamRecvr::AddBatch(const TransmitDataRequestPB* request,
   sender_queues_[use_sender_id]->AddBatch(request, response, rpc_context);
 }
 
+Status KrpcDataStreamRecvr::AddLocalBatch(RuntimeState* sender_state, int sender_id,
+    RowBatch* src, bool acquire, int64_t* batch_size) {
+  int use_sender_id = is_merging_ ? sender_id : 0;
+  // Add all batches to the same queue if is_merging_ is false.
+  return sender_queues_[use_sender_id]->AddLocalBatch(
+      sender_state, src, acquire, batch_size);
+}
+
 void KrpcDataStreamRecvr::ProcessDeferredRpc(int sender_id) {
   int use_sender_id = is_merging_ ? sender_id : 0;
   // Add all batches to the same queue if is_merging_ is false.
@@ -105,7 +105,7 @@ class KrpcDataStreamRecvr {
   /// queues. The exprs used in less_than must have already been prepared and opened.
   /// Called from fragment instance execution threads only.
   Status CreateMerger(const TupleRowComparator& less_than,
-      const CodegenFnPtr<SortedRunMerger::HeapifyHelperFn>& codegend_heapify_helper_fn);
+      const CodegenFnPtr<SortedRunMerger::ReplayHelperFn>& codegend_replay_helper_fn);
 
   /// Fill output_batch with the next batch of rows obtained by merging the per-sender
   /// input streams. Must only be called if is_merging_ is true. Called from fragment
@@ -145,6 +145,18 @@ class KrpcDataStreamRecvr {
   void AddBatch(const TransmitDataRequestPB* request, TransmitDataResponsePB* response,
       kudu::rpc::RpcContext* context);
 
+  /// Adds the rows of 'src', sent by the sender 'sender_id' running in this process, to
+  /// the appropriate sender queue without serializing them. If 'acquire' is true, the
+  /// queued batch acquires the tuple pointers and resources of 'src', which must only
+  /// hold tuple data in its MemPool and is left with no resources. Otherwise the rows are
+  /// deep copied. Blocks while the batch cannot be added without exceeding the buffer
+  /// limit, like a deferred RPC. 'sender_state' is the RuntimeState of the sender, whose
+  /// cancellation ends the wait. Sets 'batch_size' to the number of bytes queued.
+  /// Returns DATASTREAM_RECVR_CLOSED if the receiver is cancelled, in which case the
+  /// rows are dropped. Called from the sender's fragment instance execution thread.
+  Status AddLocalBatch(RuntimeState* sender_state, int sender_id, RowBatch* src,
+      bool acquire, int64_t* batch_size);
+
   /// Tries adding the first entry of 'deferred_rpcs_' queue for the sender queue
   /// identified by 'sender_id'. If is_merging_ is false, it always defaults to
   /// queue 0; If is_merging_ is true, the sender queue is identified by 'sender_id_'.
@@ -283,6 +295,9 @@ class KrpcDataStreamRecvr {
   /// Total number of serialized row batches received.
   RuntimeProfile::Counter* total_received_batches_counter_;
 
+  /// Total number of row batches received from senders in this process.
+  RuntimeProfile::Counter* total_local_batches_counter_;
+
   /// Total number of deserialized row batches enqueued into the row batch queues.
   RuntimeProfile::Counter* total_enqueued_batches_counter_;
 
@@ -29,21 +29,23 @@ ScalarExprEvaluator* KrpcDataStreamSender::GetPartitionExprEvaluator(int i) {
 Status KrpcDataStreamSender::HashAndAddRows(RowBatch* batch) {
   const int num_rows = batch->num_rows();
   const int num_channels = GetNumChannels();
-  int channel_ids[RowBatch::HASH_BATCH_SIZE];
+  if (UNLIKELY(partition_channel_ids_.size() < num_rows)) {
+    partition_channel_ids_.resize(num_rows);
+    partition_row_idxs_.resize(num_rows);
+    partition_hashes_.resize(num_rows);
+  }
+  int* channel_ids = partition_channel_ids_.data();
+  uint64_t* hashes = partition_hashes_.data();
+
+  // Compute the hash partition of each row, then add the rows to the channels.
   int row_idx = 0;
-  while (row_idx < num_rows) {
-    int row_count = 0;
-    FOREACH_ROW_LIMIT(batch, row_idx, RowBatch::HASH_BATCH_SIZE, row_batch_iter) {
-      TupleRow* row = row_batch_iter.Get();
-      channel_ids[row_count++] = HashRow(row, exchange_hash_seed_) % num_channels;
-    }
-    row_count = 0;
-    FOREACH_ROW_LIMIT(batch, row_idx, RowBatch::HASH_BATCH_SIZE, row_batch_iter) {
-      RETURN_IF_ERROR(AddRowToChannel(channel_ids[row_count++], row_batch_iter.Get()));
-    }
-    row_idx += row_count;
+  FOREACH_ROW(batch, 0, row_batch_iter) {
+    uint64_t hash = HashRow(row_batch_iter.Get(), exchange_hash_seed_);
+    hashes[row_idx] = hash;
+    channel_ids[row_idx++] = hash % num_channels;
   }
-  return Status::OK();
+  if (UNLIKELY(skew_fanout_ > 1)) return AddSkewedRowsToChannels(batch);
+  return AddRowsToChannels(batch);
 }
 
-}
+} // namespace impala
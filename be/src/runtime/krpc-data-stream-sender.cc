@@ -39,6 +39,7 @@
 #include "runtime/descriptors.h"
 #include "runtime/exec-env.h"
 #include "runtime/fragment-state.h"
+#include "runtime/krpc-data-stream-mgr.h"
 #include "runtime/mem-tracker.h"
 #include "runtime/raw-value.inline.h"
 #include "runtime/row-batch.h"
@@ -46,9 +47,12 @@
 #include "runtime/tuple-row.h"
 #include "service/data-stream-service.h"
 #include "util/aligned-new.h"
+#include "util/bit-util.h"
+#include "util/container-util.h"
 #include "util/debug-util.h"
 #include "util/network-util.h"
 #include "util/pretty-printer.h"
+#include "util/uid-util.h"
 
 #include "gen-cpp/data_stream_service.pb.h"
 #include "gen-cpp/data_stream_service.proxy.h"
@@ -59,6 +63,19 @@
 DEFINE_int64(data_stream_sender_buffer_size, 16 * 1024,
     "(Advanced) Max size in bytes which a row batch in a data stream sender's channel "
     "can accumulate before the row batch is sent over the wire.");
+DEFINE_int32(exchange_adaptive_zstd_level, 1,
+    "(Advanced) Compression level of ZSTD when the codec of row batches sent by "
+    "exchanges is chosen adaptively with the ADAPTIVE_EXCHANGE_COMPRESSION query "
+    "option.");
+DEFINE_int32(hash_join_skew_detection_rows, 16 * 1024,
+    "(Advanced) Number of rows the probe-side exchanges of a skew-tolerant partitioned "
+    "hash join (see the HASH_JOIN_SKEW_FANOUT query option) send before deciding "
+    "which join keys are hot. A key is hot if it accounts for at least the share of "
+    "rows of one receiver in these rows.");
+DEFINE_bool(datastream_local_exchange, true,
+    "(Advanced) If true, data stream senders hand row batches for receivers in the same "
+    "impalad directly to the receiver's queue, without serializing them and sending "
+    "them with RPCs.");
 
 using std::condition_variable_any;
 using namespace apache::thrift;
@@ -175,12 +192,25 @@ class KrpcDataStreamSender::Channel : public CacheLineAligned {
   // parameters failed or if the preceding RPC failed. Returns OK otherwise.
   Status TransmitData(const OutboundRowBatch* outbound_batch);
 
+  // Hands the rows of 'batch' to the receiver in this process. If 'acquire' is true,
+  // the receiver takes over the tuple data of 'batch', which must be this channel's own
+  // row batch. Otherwise the rows are deep copied. May block while the receiver's queue
+  // is full. Returns error status if the receiver could not be reached. Only used if
+  // is_local() is true.
+  Status SendLocalBatch(RowBatch* batch, bool acquire);
+
   // Copies a single row into this channel's row batch and flushes the row batch once
   // it reaches capacity. This call may block if the row batch's capacity is reached
   // and the preceding RPC is still in progress. Returns error status if serialization
   // failed or if the preceding RPC failed. Return OK otherwise.
   Status ALWAYS_INLINE AddRow(TupleRow* row);
 
+  // Deep copies the 'num_rows' rows of 'batch' with the indices in 'row_idxs' into this
+  // channel's row batch, flushing the row batch whenever it reaches capacity. May block
+  // like AddRow(). Returns error status if serialization failed or if the preceding RPC
+  // failed. Return OK otherwise.
+  Status AddRows(RowBatch* batch, const int* row_idxs, int num_rows);
+
   // Shutdowns the channel and frees the row batch allocation. Any in-flight RPC will
   // be cancelled. It's expected that clients normally call FlushBatches(), SendEosAsync()
   // and WaitForRpc() before calling Teardown() to flush all buffered row batches to
@@ -203,6 +233,18 @@ class KrpcDataStreamSender::Channel : public CacheLineAligned {
   // Returns OK otherwise. This should be only called from a fragment executor thread.
   Status WaitForRpc();
 
+  // Sets the adaptive codec selection that batches serialized by this channel are
+  // compressed with and that RPCs of this channel report their network time to.
+  void set_adaptive_codec(AdaptiveCodec* adaptive_codec) {
+    adaptive_codec_ = adaptive_codec;
+  }
+
+  const UniqueIdPB& fragment_instance_id() const { return fragment_instance_id_; }
+
+  // True if the receiver runs in this process and row batches are handed to it directly.
+  // Set in Init().
+  bool is_local() const { return is_local_; }
+
   // The type for a RPC worker function.
   typedef boost::function<Status()> DoRpcFn;
 
@@ -220,6 +262,13 @@ class KrpcDataStreamSender::Channel : public CacheLineAligned {
   const UniqueIdPB fragment_instance_id_;
   const PlanNodeId dest_node_id_;
 
+  // See is_local().
+  bool is_local_ = false;
+
+  // The adaptive codec selection of this channel. Nullptr if the query option
+  // ADAPTIVE_EXCHANGE_COMPRESSION is not set. Owned by the parent sender.
+  AdaptiveCodec* adaptive_codec_ = nullptr;
+
   // The row batch for accumulating rows copied from AddRow().
   // Only used if the partitioning scheme is "KUDU" or "HASH_PARTITIONED".
   scoped_ptr<RowBatch> batch_;
@@ -305,8 +354,10 @@ class KrpcDataStreamSender::Channel : public CacheLineAligned {
       const string& err_msg);
 
   // Same as WaitForRpc() except expects to be called with 'lock_' held and
-  // may drop the lock while waiting for the RPC to complete.
-  Status WaitForRpcLocked(std::unique_lock<SpinLock>* lock);
+  // may drop the lock while waiting for the RPC to complete. If 'wait_time_ns' is not
+  // null, it is set to the time spent waiting.
+  Status WaitForRpcLocked(
+      std::unique_lock<SpinLock>* lock, int64_t* wait_time_ns = nullptr);
 
   // A callback function called from KRPC reactor thread to retry an RPC which failed
   // previously due to remote server being too busy. This will re-arm the request
@@ -373,6 +424,11 @@ Status KrpcDataStreamSender::Channel::Init(
       max(1, parent_->per_channel_buffer_size_ / max(row_desc_->GetRowSize(), 1));
   batch_.reset(new RowBatch(row_desc_, capacity, parent_->mem_tracker()));
 
+  // A receiver in this process doesn't need the RPC proxy or the serialization buffers.
+  is_local_ = FLAGS_datastream_local_exchange
+      && address_ == ExecEnv::GetInstance()->krpc_address();
+  if (is_local_) return Status::OK();
+
   // Create a DataStreamService proxy to the destination.
   RETURN_IF_ERROR(DataStreamService::GetProxy(address_, hostname_, &proxy_));
 
@@ -418,7 +474,8 @@ Status KrpcDataStreamSender::Channel::WaitForRpc() {
   return WaitForRpcLocked(&l);
 }
 
-Status KrpcDataStreamSender::Channel::WaitForRpcLocked(std::unique_lock<SpinLock>* lock) {
+Status KrpcDataStreamSender::Channel::WaitForRpcLocked(
+    std::unique_lock<SpinLock>* lock, int64_t* wait_time_ns) {
   DCHECK(lock != nullptr);
   DCHECK(lock->owns_lock());
 
@@ -430,6 +487,7 @@ Status KrpcDataStreamSender::Channel::WaitForRpcLocked(std::unique_lock<SpinLock
     rpc_done_cv_.wait_for(*lock, std::chrono::milliseconds(50));
   }
   int64_t elapsed_time_ns = timer.ElapsedTime();
+  if (wait_time_ns != nullptr) *wait_time_ns = elapsed_time_ns;
   if (IsSlowRpc(elapsed_time_ns)) {
     LOG(INFO) << "Long delay waiting for RPC to " << address_
               << " (fragment_instance_id=" << PrintId(fragment_instance_id_) << "): "
@@ -515,6 +573,9 @@ void KrpcDataStreamSender::Channel::TransmitDataCompleteCb() {
       int64_t network_throughput = row_batch_size * NANOS_PER_SEC / network_time;
       parent_->network_throughput_counter_->UpdateCounter(network_throughput);
       parent_->network_time_stats_->UpdateCounter(network_time);
+      if (adaptive_codec_ != nullptr) {
+        adaptive_codec_->selector.UpdateNetwork(row_batch_size, network_time);
+      }
     }
     parent_->recvr_time_stats_->UpdateCounter(resp_.receiver_latency_ns());
     if (IsSlowRpc(total_time)) LogSlowRpc("TransmitData", total_time, resp_);
@@ -582,7 +643,14 @@ Status KrpcDataStreamSender::Channel::TransmitData(
            << PrintId(fragment_instance_id_) << " dest_node=" << dest_node_id_
            << " #rows=" << outbound_batch->header()->num_rows();
   std::unique_lock<SpinLock> l(lock_);
-  RETURN_IF_ERROR(WaitForRpcLocked(&l));
+  int64_t wait_time_ns;
+  RETURN_IF_ERROR(WaitForRpcLocked(&l, &wait_time_ns));
+  if (adaptive_codec_ != nullptr) {
+    // Time blocked on the preceding RPC means that the link cannot keep up with the
+    // sender, which makes stronger compression more worthwhile.
+    adaptive_codec_->selector.UpdateBacklog(
+        RowBatch::GetSerializedSize(*outbound_batch), wait_time_ns);
+  }
   DCHECK(!rpc_in_flight_);
   DCHECK(rpc_in_flight_batch_ == nullptr);
   // If the remote receiver is closed already, there is no point in sending anything.
@@ -594,20 +662,51 @@ Status KrpcDataStreamSender::Channel::TransmitData(
   return Status::OK();
 }
 
+Status KrpcDataStreamSender::Channel::SendLocalBatch(RowBatch* batch, bool acquire) {
+  DCHECK(is_local_);
+  VLOG_ROW << "Channel::SendLocalBatch() fragment_instance_id="
+           << PrintId(fragment_instance_id_) << " dest_node=" << dest_node_id_
+           << " #rows=" << batch->num_rows();
+  // If the receiver is closed already, there is no point in sending anything.
+  if (UNLIKELY(remote_recvr_closed_)) return Status::OK();
+  TUniqueId finst_id;
+  UniqueIdPBToTUniqueId(fragment_instance_id_, &finst_id);
+  int64_t batch_size;
+  Status status;
+  {
+    SCOPED_TIMER(parent_->local_send_timer_);
+    status = ExecEnv::GetInstance()->stream_mgr()->AddLocalData(parent_->state_,
+        finst_id, dest_node_id_, parent_->sender_id_, batch, acquire, &batch_size);
+  }
+  if (status.code() == TErrorCode::DATASTREAM_RECVR_CLOSED) {
+    remote_recvr_closed_ = true;
+    return Status::OK();
+  }
+  RETURN_IF_ERROR(status);
+  COUNTER_ADD(parent_->local_bytes_sent_counter_, batch_size);
+  return Status::OK();
+}
+
 Status KrpcDataStreamSender::Channel::SerializeAndSendBatch(RowBatch* batch) {
+  if (is_local_) return SendLocalBatch(batch, false);
   OutboundRowBatch* outbound_batch = &outbound_batches_[next_batch_idx_];
   // Reads 'rpc_in_flight_batch_' without acquiring 'lock_', so reads can be racey.
   ANNOTATE_IGNORE_READS_BEGIN();
   DCHECK(outbound_batch != rpc_in_flight_batch_);
   ANNOTATE_IGNORE_READS_END();
-  RETURN_IF_ERROR(parent_->SerializeBatch(batch, outbound_batch));
+  RETURN_IF_ERROR(parent_->SerializeBatch(batch, outbound_batch, 1, adaptive_codec_));
   RETURN_IF_ERROR(TransmitData(outbound_batch));
   next_batch_idx_ = (next_batch_idx_ + 1) % NUM_OUTBOUND_BATCHES;
   return Status::OK();
 }
 
 Status KrpcDataStreamSender::Channel::SendCurrentBatch() {
-  RETURN_IF_ERROR(SerializeAndSendBatch(batch_.get()));
+  if (is_local_) {
+    // The receiver takes over the rows, so they are not copied again.
+    RETURN_IF_ERROR(SendLocalBatch(batch_.get(), true));
+  } else {
+    RETURN_IF_ERROR(SerializeAndSendBatch(batch_.get()));
+  }
   batch_->Reset();
   return Status::OK();
 }
@@ -630,6 +729,42 @@ inline Status KrpcDataStreamSender::Channel::AddRow(TupleRow* row) {
   return Status::OK();
 }
 
+Status KrpcDataStreamSender::Channel::AddRows(
+    RowBatch* batch, const int* row_idxs, int num_rows) {
+  while (num_rows > 0) {
+    if (batch_->AtCapacity()) {
+      // batch_ is full, let's send it.
+      RETURN_IF_ERROR(SendCurrentBatch());
+    }
+    // Like AddRow(), stop adding rows once the memory usage of 'batch_' reaches its
+    // limit, i.e. only copy the rows that start below the limit. Each copy adds the
+    // total byte size of the row's tuples to 'batch_', so the rows are counted up front
+    // and copied at once.
+    int64_t mem_left = RowBatch::AT_CAPACITY_MEM_USAGE - batch_->MemUsage();
+    DCHECK_GT(mem_left, 0);
+    const int max_copied = min(num_rows, batch_->capacity() - batch_->num_rows());
+    int num_copied = 0;
+    if (!row_desc_->HasVarlenSlots()) {
+      num_copied = min<int64_t>(
+          max_copied, BitUtil::Ceil(mem_left, max(row_desc_->GetRowSize(), 1)));
+    } else {
+      const vector<TupleDescriptor*>& descs = row_desc_->tuple_descriptors();
+      while (num_copied < max_copied && mem_left > 0) {
+        TupleRow* row = batch->GetRow(row_idxs[num_copied]);
+        for (int i = 0; i < descs.size(); ++i) {
+          Tuple* tuple = row->GetTuple(i);
+          if (tuple != nullptr) mem_left -= tuple->TotalByteSize(*descs[i]);
+        }
+        ++num_copied;
+      }
+    }
+    batch_->DeepCopyRowsFrom(batch, row_idxs, num_copied);
+    row_idxs += num_copied;
+    num_rows -= num_copied;
+  }
+  return Status::OK();
+}
+
 void KrpcDataStreamSender::Channel::EndDataStreamCompleteCb() {
   std::unique_lock<SpinLock> l(lock_);
   DCHECK(rpc_in_flight_);
@@ -693,13 +828,21 @@ Status KrpcDataStreamSender::Channel::SendEosAsync() {
     DCHECK(!rpc_in_flight_);
     DCHECK(rpc_status_.ok());
     if (UNLIKELY(remote_recvr_closed_)) return Status::OK();
-    VLOG_RPC << "calling EndDataStream() to terminate channel. fragment_instance_id="
-             << PrintId(fragment_instance_id_);
-    rpc_in_flight_ = true;
     COUNTER_ADD(parent_->eos_sent_counter_, 1);
-    RETURN_IF_ERROR(DoEndDataStreamRpc());
+    if (!is_local_) {
+      VLOG_RPC << "calling EndDataStream() to terminate channel. fragment_instance_id="
+               << PrintId(fragment_instance_id_);
+      rpc_in_flight_ = true;
+      RETURN_IF_ERROR(DoEndDataStreamRpc());
+      return Status::OK();
+    }
   }
-  return Status::OK();
+  // All batches of a local channel have been queued by the receiver once
+  // SendLocalBatch() returned, so the receiver can be notified right away.
+  TUniqueId finst_id;
+  UniqueIdPBToTUniqueId(fragment_instance_id_, &finst_id);
+  return ExecEnv::GetInstance()->stream_mgr()->CloseLocalSender(
+      parent_->state_, finst_id, dest_node_id_, parent_->sender_id_);
 }
 
 void KrpcDataStreamSender::Channel::Teardown(RuntimeState* state) {
@@ -750,6 +893,13 @@ KrpcDataStreamSender::KrpcDataStreamSender(TDataSinkId sink_id, int sender_id,
     random_shuffle(channels_.begin(), channels_.end());
   }
 
+  if (partition_type_ == TPartitionType::HASH_PARTITIONED
+      && sink.__isset.skew_join_side) {
+    DCHECK(sink.__isset.skew_fanout);
+    skew_join_side_ = sink.skew_join_side;
+    skew_fanout_ = max(1, min<int>(sink.skew_fanout, channels_.size()));
+  }
+
 }
 
 KrpcDataStreamSender::~KrpcDataStreamSender() {
@@ -778,9 +928,39 @@ Status KrpcDataStreamSender::Prepare(
   recvr_time_stats_ =
       ADD_SUMMARY_STATS_COUNTER(profile(), "RpcRecvrTime", TUnit::TIME_NS);
   eos_sent_counter_ = ADD_COUNTER(profile(), "EosSent", TUnit::UNIT);
+  local_bytes_sent_counter_ = ADD_COUNTER(profile(), "LocalBytesSent", TUnit::BYTES);
+  local_send_timer_ = ADD_TIMER(profile(), "LocalSendTime");
   uncompressed_bytes_counter_ =
       ADD_COUNTER(profile(), "UncompressedRowBatchSize", TUnit::BYTES);
   total_sent_rows_counter_ = ADD_COUNTER(profile(), "RowsSent", TUnit::UNIT);
+  columnar_batches_counter_ =
+      ADD_COUNTER(profile(), "ColumnarRowBatchesSent", TUnit::UNIT);
+
+  const TQueryOptions& query_options = state->query_options();
+  columnar_serialization_ = query_options.exchange_columnar_serialization;
+  if (query_options.__isset.exchange_compression_codec) {
+    const TCompressionCodec& codec = query_options.exchange_compression_codec;
+    // CompressionTypePB mirrors THdfsCompression.
+    compression_type_ = static_cast<CompressionTypePB>(codec.codec);
+    compression_level_ = codec.compression_level;
+  }
+  if (query_options.adaptive_exchange_compression) {
+    if (partition_type_ == TPartitionType::UNPARTITIONED) {
+      adaptive_codecs_.emplace_back(
+          new AdaptiveCodec(FLAGS_exchange_adaptive_zstd_level, profile()));
+      for (unique_ptr<Channel>& channel : channels_) {
+        channel->set_adaptive_codec(adaptive_codecs_.back().get());
+      }
+    } else {
+      for (unique_ptr<Channel>& channel : channels_) {
+        RuntimeProfile* channel_profile = profile()->CreateChild(
+            Substitute("Channel $0", PrintId(channel->fragment_instance_id())));
+        adaptive_codecs_.emplace_back(
+            new AdaptiveCodec(FLAGS_exchange_adaptive_zstd_level, channel_profile));
+        channel->set_adaptive_codec(adaptive_codecs_.back().get());
+      }
+    }
+  }
 
   outbound_rb_mem_tracker_.reset(
       new MemTracker(-1, "RowBatchSerialization", mem_tracker_.get()));
@@ -793,6 +973,30 @@ Status KrpcDataStreamSender::Prepare(
 
   for (int i = 0; i < channels_.size(); ++i) {
     RETURN_IF_ERROR(channels_[i]->Init(state, char_mem_tracker_allocator_));
+    if (channels_[i]->is_local()) ++num_local_channels_;
+  }
+  profile()->AddInfoString("LocalChannels", std::to_string(num_local_channels_));
+
+  if (partition_type_ == TPartitionType::HASH_PARTITIONED) {
+    partition_channel_ids_.resize(state->batch_size());
+    partition_row_idxs_.resize(state->batch_size());
+    partition_hashes_.resize(state->batch_size());
+    channel_row_offsets_.resize(channels_.size());
+  }
+  if (skew_fanout_ > 1) {
+    profile()->AddInfoString("SkewJoinSide", Substitute("$0 (fanout $1)",
+        _TSkewJoinSide_VALUES_TO_NAMES.find(skew_join_side_)->second, skew_fanout_));
+    if (skew_join_side_ == TSkewJoinSide::PROBE) {
+      skew_hot_keys_counter_ = ADD_COUNTER(profile(), "SkewHotKeys", TUnit::UNIT);
+      skew_redistributed_rows_counter_ =
+          ADD_COUNTER(profile(), "SkewRedistributedRows", TUnit::UNIT);
+      // Monitoring more keys than there are channels finds all keys with at least the
+      // share of rows of one channel.
+      skew_sketch_.reset(new SpaceSavingSketch(max<int>(64, 2 * channels_.size())));
+    } else {
+      skew_replicated_rows_counter_ =
+          ADD_COUNTER(profile(), "SkewReplicatedRows", TUnit::UNIT);
+    }
   }
   return Status::OK();
 }
@@ -983,8 +1187,100 @@ void KrpcDataStreamSenderConfig::Codegen(FragmentState* state) {
   AddCodegenStatus(codegen_status, sender_name);
 }
 
-Status KrpcDataStreamSender::AddRowToChannel(const int channel_id, TupleRow* row) {
-  return channels_[channel_id]->AddRow(row);
+Status KrpcDataStreamSender::AddRowsToChannel(
+    int channel_id, RowBatch* batch, const int* row_idxs, int num_rows) {
+  return channels_[channel_id]->AddRows(batch, row_idxs, num_rows);
+}
+
+Status KrpcDataStreamSender::AddRowsToChannels(RowBatch* batch) {
+  const int num_rows = batch->num_rows();
+  const int num_channels = channels_.size();
+  DCHECK_EQ(channel_row_offsets_.size(), num_channels);
+  const int* channel_ids = partition_channel_ids_.data();
+  int* row_idxs = partition_row_idxs_.data();
+  int* offsets = channel_row_offsets_.data();
+
+  // Count the rows of each channel and turn the counts into the offsets of the first
+  // row of each channel.
+  memset(offsets, 0, num_channels * sizeof(int));
+  for (int i = 0; i < num_rows; ++i) ++offsets[channel_ids[i]];
+  int num_preceding_rows = 0;
+  for (int i = 0; i < num_channels; ++i) {
+    int count = offsets[i];
+    offsets[i] = num_preceding_rows;
+    num_preceding_rows += count;
+  }
+  // Order the row indices by channel, preserving the order of the rows of a channel.
+  // Afterwards 'offsets' holds the offset past the last row of each channel.
+  for (int i = 0; i < num_rows; ++i) row_idxs[offsets[channel_ids[i]]++] = i;
+
+  // Add the rows to the channels one channel at a time.
+  int start = 0;
+  for (int i = 0; i < num_channels; ++i) {
+    int end = offsets[i];
+    if (end > start) {
+      RETURN_IF_ERROR(AddRowsToChannel(i, batch, row_idxs + start, end - start));
+    }
+    start = end;
+  }
+  return Status::OK();
+}
+
+Status KrpcDataStreamSender::AddSkewedRowsToChannels(RowBatch* batch) {
+  DCHECK_GT(skew_fanout_, 1);
+  const int num_rows = batch->num_rows();
+  const int num_channels = channels_.size();
+  int* channel_ids = partition_channel_ids_.data();
+  if (skew_join_side_ == TSkewJoinSide::BUILD) {
+    // Send the batch once to each of the channels that receive a key. The probe rows of
+    // a key may go to any of them.
+    for (int i = 0; i < skew_fanout_; ++i) {
+      if (i > 0) {
+        for (int j = 0; j < num_rows; ++j) {
+          channel_ids[j] = channel_ids[j] == num_channels - 1 ? 0 : channel_ids[j] + 1;
+        }
+      }
+      RETURN_IF_ERROR(AddRowsToChannels(batch));
+    }
+    COUNTER_ADD(skew_replicated_rows_counter_, num_rows * (skew_fanout_ - 1));
+    return Status::OK();
+  }
+
+  DCHECK_EQ(skew_join_side_, TSkewJoinSide::PROBE);
+  const uint64_t* hashes = partition_hashes_.data();
+  if (skew_sketch_ != nullptr) {
+    // Rows sent before the hot keys are known go to their hash partition.
+    for (int i = 0; i < num_rows; ++i) skew_sketch_->Add(hashes[i]);
+    if (skew_sketch_->num_keys() >= FLAGS_hash_join_skew_detection_rows) DetectHotKeys();
+  } else if (!hot_keys_.empty()) {
+    int num_redistributed = 0;
+    for (int i = 0; i < num_rows; ++i) {
+      if (hot_keys_.find(hashes[i]) == hot_keys_.end()) continue;
+      int offset = next_hot_key_offset_;
+      next_hot_key_offset_ = offset == skew_fanout_ - 1 ? 0 : offset + 1;
+      if (offset == 0) continue;
+      channel_ids[i] = (channel_ids[i] + offset) % num_channels;
+      ++num_redistributed;
+    }
+    COUNTER_ADD(skew_redistributed_rows_counter_, num_redistributed);
+  }
+  return AddRowsToChannels(batch);
+}
+
+void KrpcDataStreamSender::DetectHotKeys() {
+  DCHECK(skew_sketch_ != nullptr);
+  vector<SpaceSavingSketch::Entry> hot_keys = skew_sketch_->GetHeavyHitters(
+      max<int64_t>(1, skew_sketch_->num_keys() / channels_.size()));
+  for (const SpaceSavingSketch::Entry& entry : hot_keys) {
+    hot_keys_.insert(entry.key);
+    VLOG_QUERY << "Hot join key with hash " << entry.key << " in "
+               << skew_sketch_->num_keys() << " rows sent to "
+               << PrintId(state_->fragment_instance_id()) << " exchange "
+               << dest_node_id_ << ": " << entry.count - entry.error << " to "
+               << entry.count << " occurrences";
+  }
+  COUNTER_SET(skew_hot_keys_counter_, static_cast<int64_t>(hot_keys_.size()));
+  skew_sketch_.reset();
 }
 
 uint64_t KrpcDataStreamSender::HashRow(TupleRow* row, uint64_t seed) {
@@ -1007,14 +1303,26 @@ Status KrpcDataStreamSender::Send(RuntimeState* state, RowBatch* batch) {
 
   if (batch->num_rows() == 0) return Status::OK();
   if (partition_type_ == TPartitionType::UNPARTITIONED) {
+    // The batch is only serialized for the receivers in other processes. Local
+    // receivers get a copy of the rows.
+    const int num_remote_channels = channels_.size() - num_local_channels_;
     OutboundRowBatch* outbound_batch = &outbound_batches_[next_batch_idx_];
-    RETURN_IF_ERROR(SerializeBatch(batch, outbound_batch, channels_.size()));
+    if (num_remote_channels > 0) {
+      RETURN_IF_ERROR(SerializeBatch(batch, outbound_batch, num_remote_channels,
+          adaptive_codecs_.empty() ? nullptr : adaptive_codecs_[0].get()));
+    }
     // TransmitData() will block if there are still in-flight rpcs (and those will
     // reference the previously written serialized batch).
     for (int i = 0; i < channels_.size(); ++i) {
-      RETURN_IF_ERROR(channels_[i]->TransmitData(outbound_batch));
+      if (channels_[i]->is_local()) {
+        RETURN_IF_ERROR(channels_[i]->SendLocalBatch(batch, false));
+      } else {
+        RETURN_IF_ERROR(channels_[i]->TransmitData(outbound_batch));
+      }
+    }
+    if (num_remote_channels > 0) {
+      next_batch_idx_ = (next_batch_idx_ + 1) % NUM_OUTBOUND_BATCHES;
     }
-    next_batch_idx_ = (next_batch_idx_ + 1) % NUM_OUTBOUND_BATCHES;
   } else if (partition_type_ == TPartitionType::RANDOM || channels_.size() == 1) {
     // Round-robin batches among channels. Wait for the current channel to finish its
     // rpc before overwriting its batch.
@@ -1106,20 +1414,57 @@ void KrpcDataStreamSender::Close(RuntimeState* state) {
   DataSink::Close(state);
 }
 
-Status KrpcDataStreamSender::SerializeBatch(
-    RowBatch* src, OutboundRowBatch* dest, int num_receivers) {
+Status KrpcDataStreamSender::SerializeBatch(RowBatch* src, OutboundRowBatch* dest,
+    int num_receivers, AdaptiveCodec* adaptive_codec) {
   VLOG_ROW << "serializing " << src->num_rows() << " rows";
   {
     SCOPED_TIMER(serialize_batch_timer_);
-    RETURN_IF_ERROR(src->Serialize(dest));
+    CompressionTypePB compression_type = compression_type_;
+    int compression_level = compression_level_;
+    if (adaptive_codec != nullptr) {
+      compression_type = adaptive_codec->selector.NextCodec();
+      compression_level = adaptive_codec->selector.compression_level(compression_type);
+    }
+    RETURN_IF_ERROR(src->Serialize(
+        dest, columnar_serialization_, compression_type, compression_level));
     int64_t uncompressed_bytes = RowBatch::GetDeserializedSize(*dest);
     COUNTER_ADD(uncompressed_bytes_counter_, uncompressed_bytes * num_receivers);
+    if (dest->header()->columnar()) COUNTER_ADD(columnar_batches_counter_, 1);
+    if (adaptive_codec != nullptr) {
+      // The input of the compression is the columnar data if the batch is columnar.
+      const RowBatchHeaderPB* header = dest->header();
+      int64_t input_bytes =
+          header->columnar() ? header->columnar_size() : header->uncompressed_size();
+      adaptive_codec->selector.UpdateCompression(compression_type, input_bytes,
+          dest->TupleDataAsSlice().size(), dest->compression_time_ns());
+      COUNTER_ADD(adaptive_codec->compression_timer, dest->compression_time_ns());
+      adaptive_codec->UpdateProfile();
+    }
   }
   return Status::OK();
 }
 
+KrpcDataStreamSender::AdaptiveCodec::AdaptiveCodec(
+    int zstd_level, RuntimeProfile* profile)
+  : selector(zstd_level),
+    profile(profile),
+    ratio_counter(ADD_COUNTER(profile, "CompressionRatio", TUnit::DOUBLE_VALUE)),
+    compression_timer(ADD_COUNTER(profile, "CompressionTime", TUnit::TIME_NS)),
+    reported_codec(selector.current_codec()) {
+  profile->AddInfoString("CompressionCodec", CompressionTypePB_Name(reported_codec));
+}
+
+void KrpcDataStreamSender::AdaptiveCodec::UpdateProfile() {
+  CompressionTypePB codec = selector.current_codec();
+  COUNTER_SET(ratio_counter, selector.ratio(codec));
+  if (codec != reported_codec) {
+    reported_codec = codec;
+    profile->AddInfoString("CompressionCodec", CompressionTypePB_Name(codec));
+  }
+}
+
 int64_t KrpcDataStreamSender::GetNumDataBytesSent() const {
-  return bytes_sent_counter_->value();
+  return bytes_sent_counter_->value() + local_bytes_sent_counter_->value();
 }
 
 } // namespace impala
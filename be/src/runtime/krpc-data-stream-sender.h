@@ -20,6 +20,7 @@
 #define IMPALA_RUNTIME_KRPC_DATA_STREAM_SENDER_H
 
 #include <string>
+#include <unordered_set>
 #include <vector>
 
 #include "codegen/impala-ir.h"
@@ -28,9 +29,13 @@
 #include "common/status.h"
 #include "exec/data-sink.h"
 #include "exprs/scalar-expr.h"
+#include "runtime/exchange-codec-selector.h"
 #include "runtime/mem-tracker.h"
 #include "runtime/row-batch.h"
 #include "util/runtime-profile.h"
+#include "util/space-saving-sketch.h"
+
+#include "gen-cpp/DataSinks_types.h"
 
 namespace impala {
 
@@ -151,18 +156,43 @@ class KrpcDataStreamSender : public DataSink {
  protected:
   friend class DataStreamTest;
 
-  /// Returns total number of bytes sent. If batches are broadcast to multiple receivers,
-  /// they are counted once per receiver.
+  /// Returns total number of bytes sent, including the bytes handed to receivers in this
+  /// process. If batches are broadcast to multiple receivers, they are counted once per
+  /// receiver.
   int64_t GetNumDataBytesSent() const;
 
  private:
   class Channel;
 
+  /// The codec selection of a stream of row batches if ADAPTIVE_EXCHANGE_COMPRESSION is
+  /// enabled, and the profile its choices are reported in.
+  struct AdaptiveCodec {
+    AdaptiveCodec(int zstd_level, RuntimeProfile* profile);
+
+    /// Reports the current codec and its estimated compression ratio in 'profile'.
+    void UpdateProfile();
+
+    ExchangeCodecSelector selector;
+    RuntimeProfile* const profile;
+
+    /// Estimated ratio of compressed to uncompressed bytes of the current codec.
+    RuntimeProfile::Counter* ratio_counter;
+
+    /// Time spent compressing row batches.
+    RuntimeProfile::Counter* compression_timer;
+
+    /// The codec reported in the "CompressionCodec" info string of 'profile'.
+    CompressionTypePB reported_codec;
+  };
+
   /// Serializes the src batch into the serialized row batch 'dest' and updates
   /// various stat counters.
   /// 'num_receivers' is the number of receivers this batch will be sent to. Used for
   /// updating the stat counters.
-  Status SerializeBatch(RowBatch* src, OutboundRowBatch* dest, int num_receivers = 1);
+  /// If 'adaptive_codec' is not null, the batch is compressed with the codec it selects
+  /// and the selection is updated with the result.
+  Status SerializeBatch(RowBatch* src, OutboundRowBatch* dest, int num_receivers = 1,
+      AdaptiveCodec* adaptive_codec = nullptr);
 
   /// Returns 'partition_expr_evals_[i]'. Used by the codegen'd HashRow() IR function.
   ScalarExprEvaluator* GetPartitionExprEvaluator(int i);
@@ -175,14 +205,35 @@ class KrpcDataStreamSender : public DataSink {
   /// values. Returns the final hash value.
   uint64_t HashRow(TupleRow* row, uint64_t seed);
 
-  /// Used when 'partition_type_' is HASH_PARTITIONED. Call HashRow() against each row
-  /// in the input batch and adds it to the corresponding channel based on the hash value.
+  /// Used when 'partition_type_' is HASH_PARTITIONED. Partitions the input batch in two
+  /// passes: the first calls HashRow() against each row to compute the channel of each
+  /// row and orders the row indices by channel with a counting sort. The second adds
+  /// the rows of each channel to the channel in bulk, so the row batch of one channel
+  /// is written at a time instead of the row batches of all channels in turn.
   /// Cross-compiled to be patched by Codegen() at runtime. Returns error status if
-  /// insertion into the channel fails. Returns OK status otherwise.
+  /// insertion into a channel fails. Returns OK status otherwise.
   Status HashAndAddRows(RowBatch* batch);
 
-  /// Adds the given row to 'channels_[channel_id]'.
-  Status AddRowToChannel(const int channel_id, TupleRow* row);
+  /// Adds the 'num_rows' rows of 'batch' with the indices in 'row_idxs' to
+  /// 'channels_[channel_id]'.
+  Status AddRowsToChannel(
+      int channel_id, RowBatch* batch, const int* row_idxs, int num_rows);
+
+  /// Adds each row of 'batch' to the channel in 'partition_channel_ids_' at the row's
+  /// index, one channel at a time. Called by HashAndAddRows().
+  Status AddRowsToChannels(RowBatch* batch);
+
+  /// Called by HashAndAddRows() instead of AddRowsToChannels() if the sender feeds a
+  /// skew-tolerant hash join, after computing the hash partition of each row in
+  /// 'partition_channel_ids_' and the hash of each row in 'partition_hashes_'. On the
+  /// build side, adds each row to the 'skew_fanout_' channels starting at its hash
+  /// partition. On the probe side, adds the rows of hot keys to these channels in turn
+  /// and the other rows to their hash partition, detecting the hot keys in the first
+  /// rows sent.
+  Status AddSkewedRowsToChannels(RowBatch* batch);
+
+  /// Determines 'hot_keys_' from 'skew_sketch_' and frees the sketch.
+  void DetectHotKeys();
 
   /// Sender instance id, unique within a fragment.
   const int sender_id_;
@@ -216,6 +267,44 @@ class KrpcDataStreamSender : public DataSink {
   /// List of all channels. One for each destination.
   std::vector<std::unique_ptr<Channel>> channels_;
 
+  /// Scratch space of HashAndAddRows(): the channel of each row of the input batch, the
+  /// row indices ordered by channel and the offset of each channel's rows in
+  /// 'partition_row_idxs_'.
+  std::vector<int> partition_channel_ids_;
+  std::vector<int> partition_row_idxs_;
+  std::vector<int> channel_row_offsets_;
+
+  /// The side of a skew-tolerant partitioned hash join this sender feeds. Only valid if
+  /// 'skew_fanout_' is greater than 1. See the HASH_JOIN_SKEW_FANOUT query option.
+  TSkewJoinSide::type skew_join_side_ = TSkewJoinSide::PROBE;
+
+  /// Number of consecutive channels starting at the hash partition of a key that
+  /// receive the rows of the key. 1 if the sender does not feed a skew-tolerant join.
+  int skew_fanout_ = 1;
+
+  /// Scratch space of HashAndAddRows() for the hash of each row of the input batch. Only
+  /// used if 'skew_fanout_' is greater than 1.
+  std::vector<uint64_t> partition_hashes_;
+
+  /// Counts the row hashes of the probe side until enough rows have been seen to detect
+  /// the hot keys. Null on the build side and once the hot keys have been detected.
+  std::unique_ptr<SpaceSavingSketch> skew_sketch_;
+
+  /// The hashes of the hot keys of the probe side.
+  std::unordered_set<uint64_t> hot_keys_;
+
+  /// Offset from the hash partition of the channel the next row of a hot key goes to.
+  int next_hot_key_offset_ = 0;
+
+  /// Number of hot keys detected on the probe side.
+  RuntimeProfile::Counter* skew_hot_keys_counter_ = nullptr;
+
+  /// Number of probe rows sent to a channel other than their hash partition.
+  RuntimeProfile::Counter* skew_redistributed_rows_counter_ = nullptr;
+
+  /// Number of additional copies of build rows sent.
+  RuntimeProfile::Counter* skew_replicated_rows_counter_ = nullptr;
+
   /// Expressions of partition keys. It's used to compute the
   /// per-row partition values for shuffling exchange;
   const std::vector<ScalarExpr*>& partition_exprs_;
@@ -239,12 +328,40 @@ class KrpcDataStreamSender : public DataSink {
   /// Total number of EOS sent.
   RuntimeProfile::Counter* eos_sent_counter_ = nullptr;
 
+  /// Total number of bytes of row batches handed to receivers in this process.
+  RuntimeProfile::Counter* local_bytes_sent_counter_ = nullptr;
+
+  /// Time spent handing row batches to receivers in this process, including the time
+  /// blocked on their full queues.
+  RuntimeProfile::Counter* local_send_timer_ = nullptr;
+
+  /// Number of channels whose receivers run in this process. See Channel::is_local().
+  int num_local_channels_ = 0;
+
   /// Total number of bytes of row batches before compression.
   RuntimeProfile::Counter* uncompressed_bytes_counter_ = nullptr;
 
   /// Total number of rows sent.
   RuntimeProfile::Counter* total_sent_rows_counter_ = nullptr;
 
+  /// Total number of row batches serialized in the columnar layout.
+  RuntimeProfile::Counter* columnar_batches_counter_ = nullptr;
+
+  /// If true, row batches are serialized in the columnar layout of ColumnarTupleData.
+  /// Set from the EXCHANGE_COLUMNAR_SERIALIZATION query option.
+  bool columnar_serialization_ = false;
+
+  /// The codec and compression level used to compress serialized row batches. Set from
+  /// the EXCHANGE_COMPRESSION_CODEC query option.
+  CompressionTypePB compression_type_ = CompressionTypePB::LZ4;
+  int compression_level_ = 0;
+
+  /// The adaptive codec selections if the ADAPTIVE_EXCHANGE_COMPRESSION query option is
+  /// set. A single selection is shared by all channels if 'partition_type_' is
+  /// UNPARTITIONED, since every batch is serialized once for all of them. Otherwise
+  /// there is one selection per channel, as the links to the receivers may differ.
+  std::vector<std::unique_ptr<AdaptiveCodec>> adaptive_codecs_;
+
   /// Summary of network throughput for sending row batches. Network time also includes
   /// queuing time in KRPC transfer queue for transmitting the RPC requests and receiving
   /// the responses.
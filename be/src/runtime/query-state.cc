@@ -381,9 +381,12 @@ Status QueryState::InitFilterBank() {
       for (const TRuntimeFilterDesc& filter : plan_node.runtime_filters) {
         // Add filter if not already present.
         auto it = filters.emplace(filter.filter_id, FilterRegistration(filter)).first;
-        // Currently hash joins are the only filter sources. Otherwise it must be a filter
-        // consumer. 'num_producers' is computed later, so don't update that here.
-        if (!plan_node.__isset.join_node) it->second.has_consumer = true;
+        // Currently joins and Top-N sorts are the only filter sources. Otherwise it must
+        // be a filter consumer. 'num_producers' is computed later, so don't update that
+        // here.
+        if (!plan_node.__isset.join_node && !plan_node.__isset.sort_node) {
+          it->second.has_consumer = true;
+        }
       }
     }
     if (fragment.output_sink.__isset.join_build_sink) {
@@ -77,11 +77,13 @@ class RowBatchSerializeTest : public testing::Test {
   // and has the same contents as 'batch'. If serialization returns an error (e.g. if the
   // row batch is too large to serialize), this will return that error.
   Status TestRowBatchInternal(const RowDescriptor& row_desc, RowBatch* batch,
-      bool print_batches, bool full_dedup = false) {
+      bool print_batches, bool full_dedup = false, bool columnar = false,
+      CompressionTypePB compression_type = CompressionTypePB::LZ4) {
     if (print_batches) cout << PrintBatch(batch) << endl;
 
     OutboundRowBatch row_batch(char_mem_tracker_allocator_);
-    RETURN_IF_ERROR(batch->Serialize(&row_batch, full_dedup));
+    RETURN_IF_ERROR(
+        batch->Serialize(&row_batch, full_dedup, columnar, compression_type));
 
     RowBatch deserialized_batch(&row_desc, row_batch, tracker_.get());
     if (print_batches) cout << PrintBatch(&deserialized_batch) << endl;
@@ -105,8 +107,10 @@ class RowBatchSerializeTest : public testing::Test {
   // Serializes and deserializes 'batch', then checks that the deserialized batch is valid
   // and has the same contents as 'batch'. This requires that serialization succeed.
   void TestRowBatch(const RowDescriptor& row_desc, RowBatch* batch, bool print_batches,
-      bool full_dedup = false) {
-    EXPECT_OK(TestRowBatchInternal(row_desc, batch, print_batches, full_dedup));
+      bool full_dedup = false, bool columnar = false,
+      CompressionTypePB compression_type = CompressionTypePB::LZ4) {
+    EXPECT_OK(TestRowBatchInternal(
+        row_desc, batch, print_batches, full_dedup, columnar, compression_type));
   }
 
   // Construct a RowBatch with the specified size by creating a single row with
@@ -389,6 +393,8 @@ class RowBatchSerializeTest : public testing::Test {
   void TestConsecutiveNulls(bool full_dedup);
 
   void TestZeroLengthTuple(bool full_dedup);
+
+  void TestColumnar(bool full_dedup);
 };
 
 TEST_F(RowBatchSerializeTest, Basic) {
@@ -678,6 +684,91 @@ void RowBatchSerializeTest::TestZeroLengthTuple(bool full_dedup) {
   TestRowBatch(row_desc, batch, false, full_dedup);
 }
 
+TEST_F(RowBatchSerializeTest, Columnar) {
+  TestColumnar(false);
+}
+
+TEST_F(RowBatchSerializeTest, ColumnarDedup) {
+  TestColumnar(true);
+}
+
+void RowBatchSerializeTest::TestColumnar(bool full_dedup) {
+  // tuples: (int, string, int), (string, array<string>), ()
+  ColumnType array_type;
+  array_type.type = TYPE_ARRAY;
+  array_type.children.push_back(ColumnType(TYPE_STRING));
+  DescriptorTblBuilder builder(frontend(), &pool_);
+  builder.DeclareTuple() << TYPE_INT << TYPE_STRING << TYPE_INT;
+  builder.DeclareTuple() << TYPE_STRING << array_type;
+  builder.DeclareTuple();
+  DescriptorTbl* desc_tbl = builder.Build();
+  vector<bool> nullable_tuples(3, true);
+  vector<TTupleId> tuple_ids{0, 1, 2};
+  RowDescriptor row_desc(*desc_tbl, tuple_ids, nullable_tuples);
+
+  RowBatch* batch = CreateRowBatch(row_desc);
+  for (CompressionTypePB compression_type : {CompressionTypePB::NONE,
+           CompressionTypePB::LZ4, CompressionTypePB::ZSTD}) {
+    TestRowBatch(row_desc, batch, false, full_dedup, true, compression_type);
+  }
+
+  // Repeated and NULL tuples.
+  vector<vector<Tuple*>> tuples(3);
+  for (int i = 0; i < 3; ++i) {
+    CreateTuples(*row_desc.tuple_descriptors()[i], batch->tuple_data_pool(), 5, 20, 10,
+        &tuples[i]);
+    tuples[i].push_back(nullptr);
+  }
+  RowBatch* dup_batch = pool_.Add(new RowBatch(&row_desc, NUM_ROWS, tracker_.get()));
+  AddTuplesToRowBatch(NUM_ROWS, tuples, {1, 2, 3}, dup_batch);
+  for (CompressionTypePB compression_type : {CompressionTypePB::NONE,
+           CompressionTypePB::LZ4, CompressionTypePB::ZSTD}) {
+    TestRowBatch(row_desc, dup_batch, false, full_dedup, true, compression_type);
+  }
+}
+
+// Test that low-cardinality columns shrink in the columnar layout even without
+// compression.
+TEST_F(RowBatchSerializeTest, ColumnarEncoding) {
+  // tuple: (int, int)
+  DescriptorTblBuilder builder(frontend(), &pool_);
+  builder.DeclareTuple() << TYPE_INT << TYPE_INT;
+  DescriptorTbl* desc_tbl = builder.Build();
+  vector<bool> nullable_tuples(1, false);
+  vector<TTupleId> tuple_id(1, (TTupleId) 0);
+  RowDescriptor row_desc(*desc_tbl, tuple_id, nullable_tuples);
+  const TupleDescriptor* tuple_desc = row_desc.tuple_descriptors()[0];
+
+  const int num_rows = 1024;
+  RowBatch* batch = pool_.Add(new RowBatch(&row_desc, num_rows, tracker_.get()));
+  uint8_t* tuple_mem =
+      batch->tuple_data_pool()->Allocate(tuple_desc->byte_size() * num_rows);
+  memset(tuple_mem, 0, tuple_desc->byte_size() * num_rows);
+  for (int i = 0; i < num_rows; ++i) {
+    Tuple* tuple = reinterpret_cast<Tuple*>(tuple_mem);
+    // A column with few distinct values and a column with a small range.
+    int dict_val = (i % 3) * 1000000;
+    int for_val = -500 + i;
+    RawValue::Write(&dict_val, tuple, tuple_desc->slots()[0], nullptr);
+    RawValue::Write(&for_val, tuple, tuple_desc->slots()[1], nullptr);
+    if (i % 7 == 0) tuple->SetNull(tuple_desc->slots()[0]->null_indicator_offset());
+    TupleRow* row = batch->GetRow(batch->AddRow());
+    row->SetTuple(0, tuple);
+    batch->CommitLastRow();
+    tuple_mem += tuple_desc->byte_size();
+  }
+
+  OutboundRowBatch row_batch(char_mem_tracker_allocator_);
+  EXPECT_OK(batch->Serialize(&row_batch, false, true, CompressionTypePB::NONE));
+  EXPECT_TRUE(row_batch.header()->columnar());
+  EXPECT_EQ(row_batch.header()->compression_type(), CompressionTypePB::NONE);
+  EXPECT_EQ(row_batch.header()->uncompressed_size(), tuple_desc->byte_size() * num_rows);
+  // 2 bits for the dictionary column, 10 bits for the frame of reference column and
+  // one or two bits for the null indicators instead of 9 bytes per row.
+  EXPECT_LT(row_batch.TupleDataAsSlice().size(), 2 * num_rows);
+  TestRowBatch(row_desc, batch, false, false, true, CompressionTypePB::NONE);
+}
+
 // Test a pathological case for consecutive deduplication - two large alternating tuples.
 // This tests that we are capable of duplicating non-adjacent tuples to produce a compact
 // serialized batch with no duplication. It also stresses the serialization logic to
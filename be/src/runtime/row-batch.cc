@@ -21,15 +21,17 @@
 #include <memory>
 #include <boost/scoped_ptr.hpp>
 
+#include "gutil/strings/substitute.h"
+#include "runtime/columnar-tuple-data.h"
 #include "runtime/exec-env.h"
 #include "runtime/mem-tracker.h"
 #include "runtime/string-value.h"
 #include "runtime/tuple-row.h"
-#include "util/compress.h"
+#include "util/codec.h"
 #include "util/debug-util.h"
-#include "util/decompress.h"
 #include "util/fixed-size-hash-table.h"
 #include "util/scope-exit-trigger.h"
+#include "util/stopwatch.h"
 
 #include "gen-cpp/Results_types.h"
 #include "gen-cpp/row_batch.pb.h"
@@ -77,11 +79,6 @@ RowBatch::RowBatch(const RowDescriptor* row_desc, const OutboundRowBatch& input_
   DCHECK(mem_tracker_ != nullptr);
   DCHECK_EQ(num_tuples_per_row_, row_desc_->tuple_descriptors().size());
   DCHECK_GT(tuple_ptrs_size_, 0);
-  const CompressionTypePB& compression_type = input_batch.header()->compression_type();
-  DCHECK(compression_type == CompressionTypePB::NONE
-      || compression_type == CompressionTypePB::LZ4)
-      << "Unexpected compression type: " << input_batch.header()->compression_type();
-
   mem_tracker_->Consume(tuple_ptrs_size_);
   tuple_ptrs_ = reinterpret_cast<Tuple**>(malloc(tuple_ptrs_size_));
   DCHECK(tuple_ptrs_ != nullptr) << "Failed to allocate tuple pointers";
@@ -90,8 +87,9 @@ RowBatch::RowBatch(const RowDescriptor* row_desc, const OutboundRowBatch& input_
   uint8_t* tuple_data = tuple_data_pool_.Allocate(uncompressed_size);
   DCHECK(tuple_data != nullptr) << "Failed to allocate tuple data";
 
-  Deserialize(input_batch.TupleOffsetsAsSlice(), input_batch.TupleDataAsSlice(),
-      uncompressed_size, compression_type == CompressionTypePB::LZ4, tuple_data);
+  Status status = Deserialize(input_batch.TupleOffsetsAsSlice(),
+      input_batch.TupleDataAsSlice(), *input_batch.header(), tuple_data);
+  DCHECK(status.ok()) << status.GetDetail();
 }
 
 RowBatch::RowBatch(const RowDescriptor* row_desc, const RowBatchHeaderPB& header,
@@ -111,30 +109,63 @@ RowBatch::RowBatch(const RowDescriptor* row_desc, const RowBatchHeaderPB& header
   DCHECK_GT(tuple_ptrs_size_, 0);
 }
 
-void RowBatch::Deserialize(const kudu::Slice& input_tuple_offsets,
-    const kudu::Slice& input_tuple_data, int64_t uncompressed_size,
-    bool is_compressed, uint8_t* tuple_data) {
+Status RowBatch::Deserialize(const kudu::Slice& input_tuple_offsets,
+    const kudu::Slice& input_tuple_data, const RowBatchHeaderPB& header,
+    uint8_t* tuple_data) {
   DCHECK(tuple_ptrs_ != nullptr);
   DCHECK(tuple_data != nullptr);
-  if (is_compressed) {
-    // Decompress tuple data into data pool
-    const uint8_t* compressed_data = input_tuple_data.data();
-    size_t compressed_size = input_tuple_data.size();
-
-    Lz4Decompressor decompressor(nullptr, false);
-    Status status = decompressor.Init();
-    DCHECK(status.ok()) << status.GetDetail();
-    auto compressor_cleanup =
-        MakeScopeExitTrigger([&decompressor]() { decompressor.Close(); });
-
-    status = decompressor.ProcessBlock(
-        true, compressed_size, compressed_data, &uncompressed_size, &tuple_data);
-    DCHECK_NE(uncompressed_size, -1) << "RowBatch decompression failed";
-    DCHECK(status.ok()) << "RowBatch decompression failed.";
-  } else {
+  const CompressionTypePB compression_type = header.compression_type();
+  DCHECK(compression_type == CompressionTypePB::NONE
+      || compression_type == CompressionTypePB::LZ4
+      || compression_type == CompressionTypePB::ZSTD)
+      << "Unexpected compression type: " << compression_type;
+  const int64_t uncompressed_size = header.uncompressed_size();
+  const uint8_t* data = input_tuple_data.data();
+  int64_t data_len = input_tuple_data.size();
+
+  // Columnar data is decompressed into a scratch buffer and decoded from there into
+  // 'tuple_data'. Row-wise data is decompressed directly into 'tuple_data'.
+  std::unique_ptr<uint8_t[]> scratch;
+  int64_t scratch_len = 0;
+  auto scratch_cleanup = MakeScopeExitTrigger([this, &scratch_len]() {
+    mem_tracker_->Release(scratch_len);
+  });
+  if (compression_type != CompressionTypePB::NONE) {
+    uint8_t* decompressed = tuple_data;
+    int64_t decompressed_len = uncompressed_size;
+    if (header.columnar()) {
+      decompressed_len = header.columnar_size();
+      if (!mem_tracker_->TryConsume(decompressed_len)) {
+        return mem_tracker_->MemLimitExceeded(
+            nullptr, "Failed to decompress row batch", decompressed_len);
+      }
+      scratch_len = decompressed_len;
+      scratch.reset(new uint8_t[scratch_len]);
+      decompressed = scratch.get();
+    }
+    // CompressionTypePB mirrors THdfsCompression.
+    scoped_ptr<Codec> decompressor;
+    RETURN_IF_ERROR(Codec::CreateDecompressor(nullptr, false,
+        static_cast<THdfsCompression::type>(compression_type), &decompressor));
+    auto decompressor_cleanup =
+        MakeScopeExitTrigger([&decompressor]() { decompressor->Close(); });
+    RETURN_IF_ERROR(decompressor->ProcessBlock(
+        true, data_len, data, &decompressed_len, &decompressed));
+    data = decompressed;
+    data_len = decompressed_len;
+  }
+
+  if (header.columnar()) {
+    RETURN_IF_ERROR(ColumnarTupleData::Decode(*row_desc_,
+        reinterpret_cast<const int32_t*>(input_tuple_offsets.data()),
+        input_tuple_offsets.size() / sizeof(int32_t), data, data_len, tuple_data,
+        uncompressed_size));
+  } else if (compression_type == CompressionTypePB::NONE) {
     // Tuple data uncompressed, copy directly into data pool
-    DCHECK_EQ(uncompressed_size, input_tuple_data.size());
-    memcpy(tuple_data, input_tuple_data.data(), input_tuple_data.size());
+    DCHECK_EQ(uncompressed_size, data_len);
+    memcpy(tuple_data, data, data_len);
+  } else {
+    DCHECK_EQ(uncompressed_size, data_len) << "RowBatch decompression failed";
   }
 
   // Convert input_batch.tuple_offsets into pointers
@@ -152,7 +183,7 @@ void RowBatch::Deserialize(const kudu::Slice& input_tuple_offsets,
   }
 
   // Check whether we have slots that require offset-to-pointer conversion.
-  if (!row_desc_->HasVarlenSlots()) return;
+  if (!row_desc_->HasVarlenSlots()) return Status::OK();
 
   // For every unique tuple, convert string offsets contained in tuple data into
   // pointers. Tuples were serialized in the order we are deserializing them in,
@@ -170,6 +201,7 @@ void RowBatch::Deserialize(const kudu::Slice& input_tuple_offsets,
       tuple->ConvertOffsetsToPointers(*desc, tuple_data);
     }
   }
+  return Status::OK();
 }
 
 Status RowBatch::FromProtobuf(const RowDescriptor* row_desc,
@@ -195,12 +227,8 @@ Status RowBatch::FromProtobuf(const RowDescriptor* row_desc,
 
   row_batch->num_rows_ = header.num_rows();
   row_batch->capacity_ = header.num_rows();
-  const CompressionTypePB& compression_type = header.compression_type();
-  DCHECK(compression_type == CompressionTypePB::NONE ||
-      compression_type == CompressionTypePB::LZ4)
-      << "Unexpected compression type: " << compression_type;
-  row_batch->Deserialize(input_tuple_offsets, input_tuple_data, uncompressed_size,
-      compression_type == CompressionTypePB::LZ4, tuple_data);
+  RETURN_IF_ERROR(row_batch->Deserialize(
+      input_tuple_offsets, input_tuple_data, header, tuple_data));
   *row_batch_ptr = std::move(row_batch);
   return Status::OK();
 }
@@ -223,8 +251,19 @@ Status RowBatch::Serialize(OutboundRowBatch* output_batch) {
   return Serialize(output_batch, UseFullDedup());
 }
 
-Status RowBatch::Serialize(OutboundRowBatch* output_batch, bool full_dedup) {
-  bool is_compressed;
+Status RowBatch::Serialize(OutboundRowBatch* output_batch, bool columnar,
+    CompressionTypePB compression_type, int compression_level) {
+  return Serialize(
+      output_batch, UseFullDedup(), columnar, compression_type, compression_level);
+}
+
+Status RowBatch::Serialize(OutboundRowBatch* output_batch, bool full_dedup,
+    bool columnar, CompressionTypePB compression_type, int compression_level) {
+  DCHECK(compression_type == CompressionTypePB::NONE
+      || compression_type == CompressionTypePB::LZ4
+      || compression_type == CompressionTypePB::ZSTD)
+      << "Unexpected compression type: " << compression_type;
+  int64_t columnar_size = 0;
   output_batch->tuple_offsets_.clear();
 
   DedupMap distinct_tuples;
@@ -250,8 +289,8 @@ Status RowBatch::Serialize(OutboundRowBatch* output_batch, bool full_dedup) {
   }
   output_batch->tuple_data_.resize(size);
 
-  RETURN_IF_ERROR(Serialize(
-      full_dedup ? &distinct_tuples : nullptr, output_batch, &is_compressed, size));
+  RETURN_IF_ERROR(Serialize(full_dedup ? &distinct_tuples : nullptr, output_batch, size,
+      &columnar, &columnar_size, &compression_type, compression_level));
 
   // Initialize the RowBatchHeaderPB
   RowBatchHeaderPB* header = &output_batch->header_;
@@ -259,50 +298,89 @@ Status RowBatch::Serialize(OutboundRowBatch* output_batch, bool full_dedup) {
   header->set_num_rows(num_rows_);
   header->set_num_tuples_per_row(row_desc_->tuple_descriptors().size());
   header->set_uncompressed_size(size);
-  header->set_compression_type(
-      is_compressed ? CompressionTypePB::LZ4 : CompressionTypePB::NONE);
+  header->set_compression_type(compression_type);
+  if (columnar) {
+    header->set_columnar(true);
+    header->set_columnar_size(columnar_size);
+  }
   return Status::OK();
 }
 
 Status RowBatch::Serialize(DedupMap* distinct_tuples, OutboundRowBatch* output_batch,
-    bool* is_compressed, int64_t size) {
+    int64_t size, bool* columnar, int64_t* columnar_size,
+    CompressionTypePB* compression_type, int compression_level) {
   char* tuple_data = const_cast<char*>(output_batch->tuple_data_.data());
   std::vector<int32_t>* tuple_offsets = &output_batch->tuple_offsets_;
+  output_batch->compression_time_ns_ = 0;
 
   RETURN_IF_ERROR(SerializeInternal(size, distinct_tuples, tuple_offsets, tuple_data));
 
-  *is_compressed = false;
-
-  if (size > 0) {
-    // Try compressing tuple_data to compression_scratch_, swap if compressed data is
-    // smaller
-    Lz4Compressor compressor(nullptr, false);
-    RETURN_IF_ERROR(compressor.Init());
-    auto compressor_cleanup =
-        MakeScopeExitTrigger([&compressor]() { compressor.Close(); });
+  if (size == 0) {
+    *columnar = false;
+    *compression_type = CompressionTypePB::NONE;
+    return Status::OK();
+  }
 
-    // If the input size is too large for LZ4 to compress, MaxOutputLen() will return 0.
-    int64_t compressed_size = compressor.MaxOutputLen(size);
-    if (compressed_size == 0) {
-      return Status(TErrorCode::LZ4_COMPRESSION_INPUT_TOO_LARGE, size);
-    }
-    DCHECK_GT(compressed_size, 0);
-    if (output_batch->compression_scratch_.size() < compressed_size) {
-      output_batch->compression_scratch_.resize(compressed_size);
+  int64_t data_len = size;
+  if (*columnar) {
+    // Encode tuple_data to compression_scratch_, swap if the columnar data is smaller.
+    RETURN_IF_ERROR(ColumnarTupleData::Encode(*row_desc_, tuple_offsets->data(),
+        tuple_offsets->size(), reinterpret_cast<const uint8_t*>(tuple_data), size,
+        &output_batch->compression_scratch_));
+    if (LIKELY(output_batch->compression_scratch_.size() < size)) {
+      output_batch->tuple_data_.swap(output_batch->compression_scratch_);
+      data_len = output_batch->tuple_data_.size();
+      *columnar_size = data_len;
+    } else {
+      *columnar = false;
     }
+    VLOG_ROW << "row-wise size: " << size << ", columnar size: "
+             << output_batch->compression_scratch_.size();
+  }
 
-    uint8_t* input = reinterpret_cast<uint8_t*>(tuple_data);
-    uint8_t* compressed_output = const_cast<uint8_t*>(
-        reinterpret_cast<const uint8_t*>(output_batch->compression_scratch_.data()));
-    RETURN_IF_ERROR(
-        compressor.ProcessBlock(true, size, input, &compressed_size, &compressed_output));
-    if (LIKELY(compressed_size < size)) {
-      output_batch->compression_scratch_.resize(compressed_size);
-      output_batch->tuple_data_.swap(output_batch->compression_scratch_);
-      *is_compressed = true;
+  if (*compression_type == CompressionTypePB::NONE) return Status::OK();
+
+  // Try compressing tuple_data to compression_scratch_, swap if compressed data is
+  // smaller. CompressionTypePB mirrors THdfsCompression.
+  MonotonicStopWatch compression_timer;
+  compression_timer.Start();
+  scoped_ptr<Codec> compressor;
+  RETURN_IF_ERROR(Codec::CreateCompressor(nullptr, false,
+      Codec::CodecInfo(
+          static_cast<THdfsCompression::type>(*compression_type), compression_level),
+      &compressor));
+  auto compressor_cleanup =
+      MakeScopeExitTrigger([&compressor]() { compressor->Close(); });
+
+  // If the input size is too large for LZ4 to compress, MaxOutputLen() will return 0.
+  int64_t compressed_size = compressor->MaxOutputLen(data_len);
+  if (compressed_size == 0) {
+    if (*compression_type == CompressionTypePB::LZ4) {
+      return Status(TErrorCode::LZ4_COMPRESSION_INPUT_TOO_LARGE, data_len);
     }
-    VLOG_ROW << "uncompressed size: " << size << ", compressed size: " << compressed_size;
+    return Status(Substitute("Row batch of $0 bytes is too large to compress",
+        data_len));
+  }
+  DCHECK_GT(compressed_size, 0);
+  if (output_batch->compression_scratch_.size() < compressed_size) {
+    output_batch->compression_scratch_.resize(compressed_size);
+  }
+
+  uint8_t* input = const_cast<uint8_t*>(
+      reinterpret_cast<const uint8_t*>(output_batch->tuple_data_.data()));
+  uint8_t* compressed_output = const_cast<uint8_t*>(
+      reinterpret_cast<const uint8_t*>(output_batch->compression_scratch_.data()));
+  RETURN_IF_ERROR(compressor->ProcessBlock(
+      true, data_len, input, &compressed_size, &compressed_output));
+  output_batch->compression_time_ns_ = compression_timer.ElapsedTime();
+  if (LIKELY(compressed_size < data_len)) {
+    output_batch->compression_scratch_.resize(compressed_size);
+    output_batch->tuple_data_.swap(output_batch->compression_scratch_);
+  } else {
+    *compression_type = CompressionTypePB::NONE;
   }
+  VLOG_ROW << "uncompressed size: " << data_len << ", compressed size: "
+           << compressed_size;
   return Status::OK();
 }
 
@@ -480,6 +558,35 @@ void RowBatch::DeepCopyTo(RowBatch* dst) {
   dst->CommitRows(num_rows_);
 }
 
+void RowBatch::DeepCopyRowsFrom(RowBatch* src, const int* row_idxs, int num_rows) {
+  // Number of rows ahead of the copied row whose tuples are prefetched.
+  static const int PREFETCH_DISTANCE = 8;
+  DCHECK_EQ(src->num_tuples_per_row_, num_tuples_per_row_);
+  DCHECK_LE(num_rows_ + num_rows, capacity_);
+  const int dst_row_idx = AddRows(num_rows);
+  for (int j = 0; j < num_tuples_per_row_; ++j) {
+    const TupleDescriptor& desc = *row_desc_->tuple_descriptors()[j];
+    const int byte_size = desc.byte_size();
+    uint8_t* tuple_mem = tuple_data_pool_.Allocate(byte_size * num_rows);
+    for (int i = 0; i < num_rows; ++i) {
+      if (i + PREFETCH_DISTANCE < num_rows) {
+        __builtin_prefetch(
+            src->GetRow(row_idxs[i + PREFETCH_DISTANCE])->GetTuple(j), 0, 1);
+      }
+      Tuple* src_tuple = src->GetRow(row_idxs[i])->GetTuple(j);
+      TupleRow* dst_row = GetRow(dst_row_idx + i);
+      if (UNLIKELY(src_tuple == nullptr)) {
+        dst_row->SetTuple(j, nullptr);
+        continue;
+      }
+      Tuple* dst_tuple = reinterpret_cast<Tuple*>(tuple_mem + i * byte_size);
+      src_tuple->DeepCopy(dst_tuple, desc, &tuple_data_pool_);
+      dst_row->SetTuple(j, dst_tuple);
+    }
+  }
+  CommitRows(num_rows);
+}
+
 // TODO: consider computing size of batches as they are built up
 int64_t RowBatch::TotalByteSize(DedupMap* distinct_tuples) {
   DCHECK(distinct_tuples == nullptr || distinct_tuples->size() == 0);
@@ -79,6 +79,9 @@ class OutboundRowBatch {
          header_.has_compression_type();
   }
 
+  /// Returns the time spent compressing the tuple data in the last serialization.
+  int64_t compression_time_ns() const { return compression_time_ns_; }
+
  private:
   friend class RowBatch;
   friend class RowBatchSerializeBaseline;
@@ -98,6 +101,9 @@ class OutboundRowBatch {
   /// The compression_scratch_ will be swapped with tuple_data_ if the compressed data
   /// is shorter.
   TrackedString compression_scratch_;
+
+  /// Time spent compressing 'tuple_data_' in the last serialization.
+  int64_t compression_time_ns_ = 0;
 };
 
 /// A RowBatch encapsulates a batch of rows, each composed of a number of tuples.
@@ -208,8 +214,13 @@ class RowBatch {
     // MarkFlushResources().
     DCHECK((!needs_deep_copy_ && flush_mode_ == FlushMode::NO_FLUSH_RESOURCES)
         || num_rows_ == capacity_);
-    int64_t mem_usage = attached_buffer_bytes_ + tuple_data_pool_.total_reserved_bytes();
-    return num_rows_ == capacity_ || mem_usage >= AT_CAPACITY_MEM_USAGE;
+    return num_rows_ == capacity_ || MemUsage() >= AT_CAPACITY_MEM_USAGE;
+  }
+
+  /// Returns the memory accumulated by this row batch that AtCapacity() compares against
+  /// AT_CAPACITY_MEM_USAGE.
+  int64_t ALWAYS_INLINE MemUsage() {
+    return attached_buffer_bytes_ + tuple_data_pool_.total_reserved_bytes();
   }
 
   TupleRow* ALWAYS_INLINE GetRow(int row_idx) {
@@ -376,6 +387,13 @@ class RowBatch {
   /// row batch if there are duplicate tuples in this row batch.
   void DeepCopyTo(RowBatch* dst);
 
+  /// Deep copies the 'num_rows' rows of 'src' with the indices in 'row_idxs' to the end
+  /// of this row batch, using memory allocated from tuple_data_pool_. The fixed-length
+  /// parts of the copies of each tuple of the rows are allocated as one block, and the
+  /// source tuples are prefetched ahead of the copy. This batch must have the same row
+  /// descriptor as 'src' and capacity for the rows.
+  void DeepCopyRowsFrom(RowBatch* src, const int* row_idxs, int num_rows);
+
   /// Create a serialized version of this row batch in output_batch, attaching all of the
   /// data it references to output_batch.tuple_data. This function attempts to detect
   /// duplicate tuples in the row batch to reduce the serialized size.
@@ -385,6 +403,15 @@ class RowBatch {
   /// it is ignored. This function does not Reset().
   Status Serialize(OutboundRowBatch* output_batch);
 
+  /// Same as above, but stores the tuple data in the columnar layout of
+  /// ColumnarTupleData if 'columnar' is true and compresses it with 'compression_type'
+  /// instead of LZ4. 'compression_type' must be NONE, LZ4 or ZSTD. 'compression_level'
+  /// is only used by ZSTD, 0 selects the default level. The columnar layout is only
+  /// used if it is smaller than the row-wise layout. Use output_batch.header.columnar
+  /// and compression_type to determine the format.
+  Status Serialize(OutboundRowBatch* output_batch, bool columnar,
+      CompressionTypePB compression_type, int compression_level = 0);
+
   /// Utility function: returns total byte size of a batch in either serialized or
   /// deserialized form. If a row batch is compressed, its serialized size can be much
   /// less than the deserialized size.
@@ -463,7 +490,9 @@ class RowBatch {
   bool UseFullDedup();
 
   /// Overload for testing that allows the test to force the deduplication level.
-  Status Serialize(OutboundRowBatch* output_batch, bool full_dedup);
+  Status Serialize(OutboundRowBatch* output_batch, bool full_dedup, bool columnar = false,
+      CompressionTypePB compression_type = CompressionTypePB::LZ4,
+      int compression_level = 0);
 
   typedef FixedSizeHashTable<Tuple*, int> DedupMap;
 
@@ -474,20 +503,27 @@ class RowBatch {
   /// 'output_batch': output_batch's tuple_offsets and tuple_data will be modified in the
   ///                 following ways:
   ///                 - 'tuple_data': Updated to hold the serialized tuples'
-  ///                                 data. If 'is_compressed' is true, this is LZ4
-  ///                                 compressed. The tuple_data_length_ is also updated
-  ///                                 accordingly.
+  ///                                 data. If '*columnar' is true, this is in the
+  ///                                 columnar layout. If '*compression_type' is not
+  ///                                 NONE, this is compressed with it. The
+  ///                                 tuple_data_length_ is also updated accordingly.
   ///                 - 'tuple_offsets': Updated to contain offsets of all tuples into
   ///                                    'tuple_data' upon return. There are a total of
   ///                                    num_rows * num_tuples_per_row offsets. An offset
   ///                                    of -1 records a NULL.
   ///
-  /// 'is_compressed': true if compression is applied on 'tuple_data'.
   /// 'size': Expected size of serialized row batch data.
+  /// 'columnar': true if the columnar layout should be used. Set to false if the
+  ///             columnar layout was not smaller than the row-wise layout.
+  /// 'columnar_size': set to the size of the columnar data before compression.
+  /// 'compression_type': the compression codec to apply. Set to NONE if the compressed
+  ///                     data was not smaller than the uncompressed data.
+  /// 'compression_level': the compression level of 'compression_type'.
   ///
   /// Returns error status if serialization failed. Returns OK otherwise.
   Status Serialize(DedupMap* distinct_tuples, OutboundRowBatch* output_batch,
-      bool* is_compressed, int64_t size);
+      int64_t size, bool* columnar, int64_t* columnar_size,
+      CompressionTypePB* compression_type, int compression_level);
 
   /// Implementation for protobuf to deserialize a row batch.
   ///
@@ -495,16 +531,16 @@ class RowBatch {
   /// Used for populating the tuples in the row batch with actual pointers.
   ///
   /// 'input_tuple_data': contains pointer and size of tuples' data buffer.
-  /// If 'is_compressed' is true, the data is compressed.
   ///
-  /// 'uncompressed_size': the uncompressed size of 'input_tuple_data' if it's compressed.
+  /// 'header': the header of the serialized row batch. Determines whether
+  /// 'input_tuple_data' is compressed or in the columnar layout.
   ///
-  /// 'is_compressed': True if 'input_tuple_data' is compressed.
+  /// 'tuple_data': buffer of 'header.uncompressed_size' bytes for holding tuple data.
   ///
-  /// 'tuple_data': buffer of 'uncompressed_size' bytes for holding tuple data.
-  void Deserialize(const kudu::Slice& input_tuple_offsets,
-      const kudu::Slice& input_tuple_data, int64_t uncompressed_size, bool is_compressed,
-      uint8_t* tuple_data);
+  /// Returns an error if the tuple data cannot be decompressed or decoded.
+  Status Deserialize(const kudu::Slice& input_tuple_offsets,
+      const kudu::Slice& input_tuple_data, const RowBatchHeaderPB& header,
+      uint8_t* tuple_data) WARN_UNUSED_RESULT;
 
   /// The total size of all data represented in this row batch (tuples and referenced
   /// string and collection data). This is the size of the row batch after removing all
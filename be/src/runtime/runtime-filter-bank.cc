@@ -33,6 +33,7 @@
 #include "runtime/initial-reservations.h"
 #include "runtime/mem-tracker.h"
 #include "runtime/query-state.h"
+#include "runtime/raw-value.h"
 #include "runtime/runtime-filter.inline.h"
 #include "runtime/runtime-state.h"
 #include "service/data-stream-service.h"
@@ -310,6 +311,48 @@ void RuntimeFilterBank::UpdateFilterFromLocal(
   }
 }
 
+void RuntimeFilterBank::PublishTopNFilterFromLocal(
+    int32_t filter_id, MinMaxFilter* min_max_filter) {
+  DCHECK(min_max_filter != nullptr);
+  auto it = filters_.find(filter_id);
+  DCHECK(it != filters_.end()) << "Tried to update unregistered filter: " << filter_id;
+  PerFilterState* fs = it->second.get();
+  lock_guard<SpinLock> l(fs->lock);
+  if (closed_ || cancelled_) return;
+  RuntimeFilter* consumed_filter = fs->consumed_filter;
+  if (consumed_filter == nullptr) return;
+  DCHECK(consumed_filter->is_topn_filter());
+  DCHECK(consumed_filter->is_min_max_filter());
+  if (min_max_filter->AlwaysFalse()) return;
+  if (!consumed_filter->HasFilter()) {
+    VLOG(3) << "Setting Top-N filter " << filter_id;
+    consumed_filter->SetFilter(nullptr, min_max_filter, nullptr);
+    query_state_->host_profile()->AddInfoString(
+        Substitute("Filter $0 arrival", filter_id),
+        PrettyPrinter::Print(consumed_filter->arrival_delay_ms(), TUnit::TIME_MS));
+    return;
+  }
+  // Only replace the published filter if the new bound is tighter. Producers of the
+  // same filter race with each other, so the bound of a later call may be looser.
+  const MinMaxFilter* current = consumed_filter->get_min_max();
+  DCHECK(current != nullptr);
+  if (min_max_filter->AlwaysTrue()) return;
+  ColumnType type = consumed_filter->type();
+  bool tighter;
+  if (current->AlwaysTrue()) {
+    tighter = true;
+  } else if (consumed_filter->getCompareOp() == extdatasource::TComparisonOp::LE) {
+    tighter = RawValue::Compare(min_max_filter->GetMax(), current->GetMax(), type) < 0;
+  } else {
+    DCHECK_EQ(consumed_filter->getCompareOp(), extdatasource::TComparisonOp::GE);
+    tighter = RawValue::Compare(min_max_filter->GetMin(), current->GetMin(), type) > 0;
+  }
+  if (!tighter) return;
+  VLOG(3) << "Tightening Top-N filter " << filter_id << " to "
+          << min_max_filter->DebugString();
+  consumed_filter->UpdateMinMaxFilter(min_max_filter);
+}
+
 void RuntimeFilterBank::PublishGlobalFilter(
     const PublishFilterParamsPB& params, RpcContext* context) {
   VLOG(3) << "PublishGlobalFilter(filter_id=" << params.filter_id() << ")";
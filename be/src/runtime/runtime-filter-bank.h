@@ -129,6 +129,15 @@ class RuntimeFilterBank {
   void UpdateFilterFromLocal(int32_t filter_id, BloomFilter* bloom_filter,
       MinMaxFilter* min_max_filter, InListFilter* in_list_filter);
 
+  /// Publishes 'min_max_filter', which holds the current bound of a Top-N node, as the
+  /// Top-N filter 'filter_id' to the consumers on this backend. Unlike
+  /// UpdateFilterFromLocal(), this may be called any number of times by every producer:
+  /// the first call sets the filter and later calls replace it if 'min_max_filter' is
+  /// tighter than the published one. Top-N filters only have local targets, so nothing
+  /// is sent to the coordinator. 'min_max_filter' must have been allocated by
+  /// AllocateScratchMinMaxFilter().
+  void PublishTopNFilterFromLocal(int32_t filter_id, MinMaxFilter* min_max_filter);
+
   /// Makes a filter (aggregated globally from all producer fragments) available for
   /// consumption by operators that wish to use it for filtering.
   void PublishGlobalFilter(
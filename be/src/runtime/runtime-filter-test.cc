@@ -19,8 +19,11 @@
 
 #include "common/init.h"
 #include "common/object-pool.h"
+#include "runtime/runtime-filter-bank.h"
 #include "runtime/runtime-filter.h"
 #include "runtime/runtime-filter.inline.h"
+#include "runtime/runtime-state.h"
+#include "runtime/test-env.h"
 #include "testutil/gtest-util.h"
 #include "util/stopwatch.h"
 
@@ -102,4 +105,59 @@ TEST_F(RuntimeFilterTest, Arrived) {
   ASSERT_LT(sw.ElapsedTime(), (tc.injection_delay + tc.wait_for_ms) * 1000000);
 }
 
+// Test that publishing a Top-N filter only replaces the filter of the consumer if the
+// new bound is tighter, whichever order the producers publish their bounds in.
+TEST_F(RuntimeFilterTest, TopNFilterOnlyTightens) {
+  TestEnv test_env;
+  ASSERT_OK(test_env.Init());
+  RuntimeState* state;
+  ASSERT_OK(test_env.CreateQueryState(0, nullptr, &state));
+  const ColumnType type(TYPE_INT);
+  for (auto op : {extdatasource::TComparisonOp::LE, extdatasource::TComparisonOp::GE}) {
+    const bool is_le = op == extdatasource::TComparisonOp::LE;
+    TRuntimeFilterDesc desc;
+    desc.__set_filter_id(is_le ? 0 : 1);
+    desc.__set_type(TRuntimeFilterType::MIN_MAX);
+    desc.__set_is_topn_filter(true);
+    desc.__set_compareOp(op);
+    TExprNode src_node;
+    src_node.__set_type(type.ToThrift());
+    desc.src_expr.nodes.push_back(src_node);
+    FilterRegistration reg(desc);
+    reg.has_consumer = true;
+    reg.num_producers = 2;
+    unordered_map<int32_t, FilterRegistration> filters;
+    filters.emplace(desc.filter_id, reg);
+    RuntimeFilterBank bank(state->query_state(), filters, 0);
+    RuntimeFilter* consumed_filter = bank.RegisterConsumer(desc);
+    ASSERT_TRUE(bank.RegisterProducer(desc) != nullptr);
+
+    // Publishes a filter that only holds 'bound' and returns the published bound.
+    auto publish = [&](int32_t bound) {
+      MinMaxFilter* filter = bank.AllocateScratchMinMaxFilter(desc.filter_id, type);
+      filter->Insert(&bound);
+      bank.PublishTopNFilterFromLocal(desc.filter_id, filter);
+      const MinMaxFilter* published = consumed_filter->get_min_max();
+      return *reinterpret_cast<const int32_t*>(
+          is_le ? published->GetMax() : published->GetMin());
+    };
+
+    // An empty filter has no bound and is not published.
+    bank.PublishTopNFilterFromLocal(
+        desc.filter_id, bank.AllocateScratchMinMaxFilter(desc.filter_id, type));
+    EXPECT_FALSE(consumed_filter->HasFilter());
+
+    EXPECT_EQ(50, publish(50));
+    EXPECT_TRUE(consumed_filter->HasFilter());
+    // A tighter bound replaces the published one, a looser or equal one does not.
+    EXPECT_EQ(is_le ? 40 : 60, publish(is_le ? 40 : 60));
+    EXPECT_EQ(is_le ? 40 : 60, publish(50));
+    EXPECT_EQ(is_le ? 40 : 60, publish(is_le ? 40 : 60));
+    EXPECT_EQ(is_le ? 30 : 70, publish(is_le ? 30 : 70));
+    EXPECT_EQ(is_le ? 30 : 70, publish(is_le ? 100 : 0));
+    bank.Close();
+  }
+  test_env.TearDownQueries();
+}
+
 } // namespace impala
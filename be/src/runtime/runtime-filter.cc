@@ -53,6 +53,14 @@ void RuntimeFilter::SetFilter(RuntimeFilter* other) {
       is_in_list_filter() ? other->in_list_filter_.Load() : nullptr);
 }
 
+void RuntimeFilter::UpdateMinMaxFilter(MinMaxFilter* min_max_filter) {
+  DCHECK(is_topn_filter());
+  DCHECK(is_min_max_filter());
+  DCHECK(HasFilter());
+  DCHECK(min_max_filter != nullptr);
+  min_max_filter_.Store(min_max_filter);
+}
+
 void RuntimeFilter::Or(RuntimeFilter* other) {
   // Or() is a no-op for AlwaysTrue() destination filter.
   if (AlwaysTrue()) return;
@@ -69,6 +69,8 @@ class RuntimeFilter {
     return filter_desc().type == TRuntimeFilterType::IN_LIST;
   }
 
+  bool is_topn_filter() const { return filter_desc().is_topn_filter; }
+
   extdatasource::TComparisonOp::type getCompareOp() const {
     return filter_desc().compareOp;
   }
@@ -89,6 +91,11 @@ class RuntimeFilter {
   /// the other filter.
   void SetFilter(RuntimeFilter* other);
 
+  /// Replaces the min-max filter of a Top-N filter, which must already have been set
+  /// with SetFilter(), with the tighter 'min_max_filter'. Threads that loaded the
+  /// previous min-max filter may keep using it, so the caller must keep it alive.
+  void UpdateMinMaxFilter(MinMaxFilter* min_max_filter);
+
   /// Merge 'bloom_filter' or 'min_max_filter' into this filter. The caller must provide
   /// the appropriate kind of filter for this RuntimeFilter instance.
   /// Not thread-safe.
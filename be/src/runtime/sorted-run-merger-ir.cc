@@ -19,34 +19,36 @@
 #include "runtime/runtime-state.h"
 #include "util/runtime-profile-counters.h"
 #include "runtime/sorted-run-merger.h"
+#include "util/sort-key-normalizer.h"
 
 namespace impala {
 
-void SortedRunMerger::HeapifyHelper(int parent_index) {
-  int left_index = 2 * parent_index + 1;
-  int right_index = left_index + 1;
-  int least_child;
-  while (left_index < min_heap_.size()) {
-    // Find the least child of parent.
-    if (right_index >= min_heap_.size() ||
-        comparator_.Less(min_heap_[left_index]->current_row(),
-                        min_heap_[right_index]->current_row())) {
-      least_child = left_index;
-    } else {
-      least_child = right_index;
-    }
+bool IR_ALWAYS_INLINE SortedRunMerger::Less(
+    const SortedRunWrapper* lhs, const SortedRunWrapper* rhs) {
+  if (normalizer_ != nullptr) {
+    int cmp = SortKeyNormalizer::Compare(lhs->key_, rhs->key_, key_len_);
+    if (cmp != 0 || normalizer_->is_complete()) return cmp < 0;
+  }
+  return comparator_.Less(lhs->current_row(), rhs->current_row());
+}
 
-    // If the parent is out of place, swap it with the least child.
-    if (comparator_.Less(min_heap_[least_child]->current_row(),
-            min_heap_[parent_index]->current_row())) {
-      iter_swap(min_heap_.begin() + least_child, min_heap_.begin() + parent_index);
-      parent_index = least_child;
-    } else {
-      break;
-    }
-    left_index = 2 * parent_index + 1;
-    right_index = left_index + 1;
+bool IR_ALWAYS_INLINE SortedRunMerger::Beats(int lhs, int rhs) {
+  const SortedRunWrapper* lhs_run = runs_[lhs];
+  const SortedRunWrapper* rhs_run = runs_[rhs];
+  if (rhs_run->exhausted()) return !lhs_run->exhausted();
+  if (lhs_run->exhausted()) return false;
+  return Less(lhs_run, rhs_run);
+}
+
+void SortedRunMerger::ReplayHelper(int run_index) {
+  // Walk up from the leaf of the run. At each node, the winner so far plays against the
+  // loser stored at the node, and the new loser is stored at the node.
+  const int num_runs = runs_.size();
+  int winner = run_index;
+  for (int node = (run_index + num_runs) >> 1; node > 0; node >>= 1) {
+    if (Beats(tree_[node], winner)) std::swap(tree_[node], winner);
   }
+  tree_[0] = winner;
 }
 
-}
\ No newline at end of file
+}
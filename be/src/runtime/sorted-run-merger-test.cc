@@ -0,0 +1,304 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <limits>
+#include <random>
+
+#include <boost/scoped_ptr.hpp>
+
+#include "exprs/slot-ref.h"
+#include "gen-cpp/Descriptors_types.h"
+#include "runtime/descriptors.h"
+#include "runtime/mem-pool.h"
+#include "runtime/mem-tracker.h"
+#include "runtime/row-batch.h"
+#include "runtime/sorted-run-merger.h"
+#include "runtime/test-env.h"
+#include "runtime/tuple-row.h"
+#include "testutil/gtest-util.h"
+#include "testutil/rand-util.h"
+#include "util/sort-key-normalizer.h"
+#include "util/tuple-row-compare.h"
+
+#include "common/names.h"
+
+using std::mt19937;
+using std::numeric_limits;
+using std::uniform_int_distribution;
+
+namespace impala {
+
+class SortedRunMergerTest : public testing::Test {
+ public:
+  SortedRunMergerTest() : expr_perm_pool_(&tracker_), expr_results_pool_(&tracker_) {}
+
+ protected:
+  scoped_ptr<TestEnv> test_env_;
+  ObjectPool pool_;
+  MemTracker tracker_;
+  MemPool expr_perm_pool_;
+  MemPool expr_results_pool_;
+  mt19937 rng_;
+
+  DescriptorTbl* desc_tbl_ = nullptr;
+  const RowDescriptor* row_desc_ = nullptr;
+  TSortInfo sort_info_;
+  vector<ScalarExpr*> ordering_exprs_;
+  scoped_ptr<TupleRowComparatorConfig> config_;
+  scoped_ptr<TupleRowLexicalComparator> comparator_;
+
+  /// The rows consist of a single tuple with two BIGINT slots: the sort key and the
+  /// position of the row in the input, encoded as run index * ROW_ID_FACTOR + index of
+  /// the row in the run.
+  static constexpr int TUPLE_SIZE = 16;
+  static constexpr int KEY_OFFSET = 0;
+  static constexpr int ROW_ID_OFFSET = 8;
+  static constexpr int64_t ROW_ID_FACTOR = 1L << 32;
+
+  virtual void SetUp() {
+    test_env_.reset(new TestEnv());
+    ASSERT_OK(test_env_->Init());
+    RandTestUtil::SeedRng("SORTED_RUN_MERGER_TEST_SEED", &rng_);
+    CreateRowDesc();
+
+    SlotRef* key_expr = pool_.Add(new SlotRef(ColumnType(TYPE_BIGINT), KEY_OFFSET));
+    ASSERT_OK(key_expr->Init(RowDescriptor(), true, nullptr));
+    ordering_exprs_.push_back(key_expr);
+    sort_info_.sorting_order = TSortingOrder::LEXICAL;
+    sort_info_.is_asc_order.push_back(true);
+    sort_info_.nulls_first.push_back(true);
+    config_.reset(new TupleRowComparatorConfig(sort_info_, ordering_exprs_));
+    comparator_.reset(new TupleRowLexicalComparator(*config_));
+    ASSERT_OK(comparator_->Open(&pool_, nullptr, &expr_perm_pool_, &expr_results_pool_));
+  }
+
+  virtual void TearDown() {
+    comparator_->Close(nullptr);
+    ScalarExpr::Close(ordering_exprs_);
+    desc_tbl_->ReleaseResources();
+    test_env_.reset();
+    expr_perm_pool_.FreeAll();
+    expr_results_pool_.FreeAll();
+    pool_.Clear();
+  }
+
+  void CreateRowDesc() {
+    TTupleDescriptor tuple_desc;
+    tuple_desc.__set_id(0);
+    tuple_desc.__set_byteSize(TUPLE_SIZE);
+    tuple_desc.__set_numNullBytes(0);
+    TDescriptorTable thrift_desc_tbl;
+    thrift_desc_tbl.tupleDescriptors.push_back(tuple_desc);
+    for (int offset : {KEY_OFFSET, ROW_ID_OFFSET}) {
+      TSlotDescriptor slot_desc;
+      slot_desc.__set_id(thrift_desc_tbl.slotDescriptors.size());
+      slot_desc.__set_parent(0);
+      slot_desc.__set_slotType(ColumnType(TYPE_BIGINT).ToThrift());
+      slot_desc.__set_materializedPath(vector<int>(1, slot_desc.id));
+      slot_desc.__set_byteOffset(offset);
+      slot_desc.__set_nullIndicatorByte(0);
+      slot_desc.__set_nullIndicatorBit(-1);
+      slot_desc.__set_slotIdx(slot_desc.id);
+      thrift_desc_tbl.slotDescriptors.push_back(slot_desc);
+    }
+    ASSERT_OK(DescriptorTbl::CreateInternal(&pool_, thrift_desc_tbl, &desc_tbl_));
+    row_desc_ = pool_.Add(new RowDescriptor(*desc_tbl_, {0}, {false}));
+  }
+
+  static int64_t GetSlot(const TupleRow* row, int offset) {
+    int64_t val;
+    memcpy(&val, reinterpret_cast<const uint8_t*>(row->GetTuple(0)) + offset,
+        sizeof(val));
+    return val;
+  }
+
+  /// Creates the batches of run 'run_idx' with the sorted 'keys'. Each batch holds up to
+  /// 'batch_size' rows. If 'empty_batches' is true, an empty batch is added before each
+  /// batch.
+  void CreateRun(int run_idx, const vector<int64_t>& keys, int batch_size,
+      bool empty_batches, vector<unique_ptr<RowBatch>>* batches) {
+    for (int start = 0; start < keys.size(); start += batch_size) {
+      if (empty_batches) batches->emplace_back(new RowBatch(row_desc_, 1, &tracker_));
+      int num_rows = min<int>(batch_size, keys.size() - start);
+      RowBatch* batch = new RowBatch(row_desc_, num_rows, &tracker_);
+      batches->emplace_back(batch);
+      for (int i = start; i < start + num_rows; ++i) {
+        Tuple* tuple = Tuple::Create(TUPLE_SIZE, batch->tuple_data_pool());
+        int64_t row_id = run_idx * ROW_ID_FACTOR + i;
+        memcpy(tuple->GetSlot(KEY_OFFSET), &keys[i], sizeof(int64_t));
+        memcpy(tuple->GetSlot(ROW_ID_OFFSET), &row_id, sizeof(int64_t));
+        TupleRow* row = batch->GetRow(batch->AddRow());
+        row->SetTuple(0, tuple);
+        batch->CommitLastRow();
+      }
+    }
+  }
+
+  /// Merges the sorted 'runs' of keys and checks that every input row is returned
+  /// exactly once, in key order, and that the rows of each run are returned in the order
+  /// of the run, i.e. that ties are merged without reordering the runs. The input
+  /// batches hold 'input_batch_size' rows and the output batches 'output_batch_size'
+  /// rows. Returns the number of rows that were emitted as part of spans.
+  int64_t TestMerge(const vector<vector<int64_t>>& runs, int input_batch_size,
+      int output_batch_size, bool deep_copy, bool use_normalizer,
+      bool empty_batches = false) {
+    vector<vector<unique_ptr<RowBatch>>> batches(runs.size());
+    vector<int> next_batch(runs.size(), 0);
+    vector<SortedRunMerger::RunBatchSupplierFn> suppliers;
+    for (int i = 0; i < runs.size(); ++i) {
+      CreateRun(i, runs[i], input_batch_size, empty_batches, &batches[i]);
+      suppliers.push_back([&batches, &next_batch, i](RowBatch** batch) {
+        *batch = next_batch[i] < batches[i].size() ?
+            batches[i][next_batch[i]++].get() : nullptr;
+        return Status::OK();
+      });
+    }
+    const SortKeyNormalizer* normalizer = nullptr;
+    if (use_normalizer) {
+      normalizer = SortKeyNormalizer::Create(*config_, 16, false, &pool_);
+      EXPECT_TRUE(normalizer != nullptr);
+      EXPECT_TRUE(normalizer->is_complete());
+    }
+    RuntimeProfile* profile = RuntimeProfile::Create(&pool_, "SortedRunMerger");
+    CodegenFnPtr<SortedRunMerger::ReplayHelperFn> codegend_replay_helper_fn;
+    SortedRunMerger merger(*comparator_, row_desc_, profile, deep_copy,
+        codegend_replay_helper_fn, normalizer);
+    EXPECT_OK(merger.Prepare(suppliers));
+
+    RowBatch output_batch(row_desc_, output_batch_size, &tracker_);
+    vector<int64_t> last_row_idx(runs.size(), -1);
+    int64_t last_key = numeric_limits<int64_t>::min();
+    bool eos = false;
+    while (!eos) {
+      Status status = merger.GetNext(&output_batch, &eos);
+      EXPECT_OK(status);
+      if (!status.ok()) break;
+      EXPECT_LE(output_batch.num_rows(), output_batch_size);
+      for (int i = 0; i < output_batch.num_rows(); ++i) {
+        TupleRow* row = output_batch.GetRow(i);
+        int64_t key = GetSlot(row, KEY_OFFSET);
+        int64_t row_id = GetSlot(row, ROW_ID_OFFSET);
+        int run_idx = row_id / ROW_ID_FACTOR;
+        int64_t row_idx = row_id % ROW_ID_FACTOR;
+        EXPECT_LE(last_key, key);
+        EXPECT_EQ(last_row_idx[run_idx] + 1, row_idx) << "run " << run_idx;
+        EXPECT_EQ(runs[run_idx][row_idx], key);
+        last_key = key;
+        last_row_idx[run_idx] = row_idx;
+      }
+      output_batch.Reset();
+    }
+    for (int i = 0; i < runs.size(); ++i) {
+      EXPECT_EQ(static_cast<int64_t>(runs[i].size()) - 1, last_row_idx[i])
+          << "run " << i;
+    }
+    return profile->GetCounter("MergeSpanRows")->value();
+  }
+
+  /// Calls TestMerge() with small and large input and output batches, with and without
+  /// deep copying and the normalizer.
+  void TestMergeAllModes(const vector<vector<int64_t>>& runs) {
+    for (int input_batch_size : {1, 3, 1024}) {
+      for (int output_batch_size : {1, 5, 1024}) {
+        for (bool deep_copy : {false, true}) {
+          for (bool use_normalizer : {false, true}) {
+            for (bool empty_batches : {false, true}) {
+              TestMerge(runs, input_batch_size, output_batch_size, deep_copy,
+                  use_normalizer, empty_batches);
+            }
+          }
+        }
+      }
+    }
+  }
+
+  /// Returns 'num_rows' sorted random keys in [0, 'max_key'].
+  vector<int64_t> RandomRun(int num_rows, int64_t max_key) {
+    uniform_int_distribution<int64_t> dist(0, max_key);
+    vector<int64_t> keys(num_rows);
+    for (int64_t& key : keys) key = dist(rng_);
+    sort(keys.begin(), keys.end());
+    return keys;
+  }
+};
+
+// The leaves of the loser tree only form a complete binary tree if the number of runs is
+// a power of two.
+TEST_F(SortedRunMergerTest, NumRuns) {
+  uniform_int_distribution<int> num_rows_dist(0, 40);
+  for (int num_runs = 0; num_runs <= 9; ++num_runs) {
+    vector<vector<int64_t>> runs;
+    for (int i = 0; i < num_runs; ++i) runs.push_back(RandomRun(num_rows_dist(rng_), 50));
+    TestMergeAllModes(runs);
+  }
+}
+
+// Runs that are exhausted stay in the tree and must lose all comparisons.
+TEST_F(SortedRunMergerTest, RunsEndEarly) {
+  // Runs of very different lengths, including empty runs.
+  TestMergeAllModes({{5}, {}, RandomRun(100, 200), {0, 1}, {}, {300, 301, 302}});
+  // The runs with the smallest keys end first.
+  TestMergeAllModes({{0}, {1, 2}, {3, 4, 5}, {6, 7, 8, 9}, {10, 11, 12, 13, 14}});
+  // The runs with the largest keys are the shortest.
+  TestMergeAllModes({{14}, {12, 13}, {9, 10, 11}, {5, 6, 7, 8}, {0, 1, 2, 3, 4}});
+  // A single run with rows left.
+  TestMergeAllModes({{}, {}, {1, 2, 3}, {}});
+}
+
+// Once a run wins repeatedly, its rows are emitted in spans until a row sorts after the
+// best row of the other runs.
+TEST_F(SortedRunMergerTest, Spans) {
+  vector<int64_t> low, high, middle;
+  for (int i = 0; i < 100; ++i) {
+    low.push_back(i);
+    high.push_back(200 + i);
+    middle.push_back(100 + 2 * i);
+  }
+  TestMergeAllModes({low, high, middle});
+  // Spans end at the ends of the input batches, of the output batches and where the
+  // other runs win.
+  EXPECT_GT(TestMerge({low, high, middle}, 1024, 1024, false, false), 0);
+  EXPECT_GT(TestMerge({low, high, middle}, 7, 5, true, true), 0);
+  EXPECT_GT(TestMerge({low, {50}, high}, 1024, 1024, false, true), 0);
+
+  // The same run never wins twice in a row if the runs alternate.
+  vector<int64_t> even, odd;
+  for (int i = 0; i < 100; ++i) {
+    even.push_back(2 * i);
+    odd.push_back(2 * i + 1);
+  }
+  TestMergeAllModes({even, odd});
+  EXPECT_EQ(0, TestMerge({even, odd}, 1024, 1024, false, false));
+  EXPECT_EQ(0, TestMerge({even, odd}, 1024, 1024, false, true));
+}
+
+// Rows with equal keys from different runs can be returned in any order, but the rows of
+// each run must stay in order. Spans continue over rows that are equal to the best row
+// of the other runs.
+TEST_F(SortedRunMergerTest, Ties) {
+  vector<int64_t> all_equal(50, 7);
+  TestMergeAllModes({all_equal, all_equal, all_equal});
+  EXPECT_GT(TestMerge({all_equal, all_equal, all_equal}, 1024, 1024, false, true), 0);
+  TestMergeAllModes({{1, 1, 2, 2, 2, 3}, {1, 2, 3, 3}, {2, 2}, {3, 3, 3, 4}, {0, 3}});
+  for (int num_runs = 2; num_runs <= 7; ++num_runs) {
+    vector<vector<int64_t>> runs;
+    for (int i = 0; i < num_runs; ++i) runs.push_back(RandomRun(30, 3));
+    TestMergeAllModes(runs);
+  }
+}
+
+} // namespace impala
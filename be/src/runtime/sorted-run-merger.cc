@@ -18,6 +18,7 @@
 #include "runtime/sorter.h"
 #include "runtime/tuple-row.h"
 #include "util/runtime-profile-counters.h"
+#include "util/sort-key-normalizer.h"
 #include "util/tuple-row-compare.h"
 #include "runtime/fragment-state.h"
 #include "codegen/llvm-codegen.h"
@@ -50,6 +51,7 @@ Status SortedRunMerger::SortedRunWrapper::Advance(RowBatch* transfer_batch, bool
   ++input_row_batch_index_;
   if (input_row_batch_index_ < input_row_batch_->num_rows()) {
     *eos = false;
+    EncodeKey();
     return Status::OK();
   }
 
@@ -71,104 +73,185 @@ Status SortedRunMerger::SortedRunWrapper::Advance(RowBatch* transfer_batch, bool
 
   *eos = input_row_batch_ == nullptr;
   input_row_batch_index_ = 0;
+  if (!*eos) EncodeKey();
   return Status::OK();
 }
 
-void SortedRunMerger::Heapify(int parent_index) {
-  const HeapifyHelperFn heapify_helper_fn = codegend_heapify_helper_fn_.load();
+void SortedRunMerger::SortedRunWrapper::EncodeKey() {
+  if (parent_->normalizer_ == nullptr) return;
+  parent_->normalizer_->Encode(current_row()->GetTuple(0), key_);
+}
+
+void SortedRunMerger::Replay(int run_index) {
+  const ReplayHelperFn replay_helper_fn = codegend_replay_helper_fn_.load();
 
-  if (heapify_helper_fn != nullptr) {
-    heapify_helper_fn(this, parent_index);
+  if (replay_helper_fn != nullptr) {
+    replay_helper_fn(this, run_index);
   } else {
-    HeapifyHelper(parent_index);
+    ReplayHelper(run_index);
   }
 }
 
 SortedRunMerger::SortedRunMerger(const TupleRowComparator& comparator,
     const RowDescriptor* row_desc, RuntimeProfile* profile, bool deep_copy_input,
-    const CodegenFnPtr<HeapifyHelperFn>& codegend_heapify_helper_fn)
+    const CodegenFnPtr<ReplayHelperFn>& codegend_replay_helper_fn,
+    const SortKeyNormalizer* normalizer)
   : comparator_(comparator),
+    normalizer_(normalizer),
+    key_len_(normalizer == nullptr ? 0 : normalizer->key_len()),
     input_row_desc_(row_desc),
     deep_copy_input_(deep_copy_input),
-    codegend_heapify_helper_fn_(codegend_heapify_helper_fn) {
+    codegend_replay_helper_fn_(codegend_replay_helper_fn) {
   get_next_timer_ = ADD_TIMER(profile, "MergeGetNext");
   get_next_batch_timer_ = ADD_TIMER(profile, "MergeGetNextBatch");
+  span_rows_counter_ = ADD_COUNTER(profile, "MergeSpanRows", TUnit::UNIT);
+  DCHECK(normalizer_ == nullptr || row_desc->tuple_descriptors().size() == 1);
 }
 
 Status SortedRunMerger::Prepare(const vector<RunBatchSupplierFn>& input_runs) {
-  DCHECK_EQ(min_heap_.size(), 0);
-  min_heap_.reserve(input_runs.size());
-  for (const RunBatchSupplierFn& input_run: input_runs) {
-    SortedRunWrapper* new_elem = pool_.Add(new SortedRunWrapper(this, input_run));
+  DCHECK_EQ(runs_.size(), 0);
+  runs_.reserve(input_runs.size());
+  if (normalizer_ != nullptr) keys_.reset(new uint8_t[input_runs.size() * key_len_]);
+  for (int i = 0; i < input_runs.size(); ++i) {
+    SortedRunWrapper* new_elem = pool_.Add(new SortedRunWrapper(this, input_runs[i]));
     DCHECK(new_elem != nullptr);
+    if (normalizer_ != nullptr) new_elem->key_ = keys_.get() + i * key_len_;
     bool empty;
     RETURN_IF_ERROR(new_elem->Init(&empty));
-    if (!empty) min_heap_.push_back(new_elem);
+    if (!empty) runs_.push_back(new_elem);
   }
+  BuildTree();
+  return Status::OK();
+}
 
-  // Construct the min heap from the sorted runs.
-  const int last_parent = (min_heap_.size() / 2) - 1;
-  for (int i = last_parent; i >= 0; --i) {
-    Heapify(i);
+void SortedRunMerger::BuildTree() {
+  const int num_runs = runs_.size();
+  tree_.assign(num_runs, -1);
+  if (num_runs == 0) return;
+  // Play the tournament bottom-up. 'winners' holds the winner of each node, with the
+  // runs as the leaves at nodes [num_runs, 2 * num_runs).
+  vector<int> winners(2 * num_runs);
+  for (int i = 0; i < num_runs; ++i) winners[num_runs + i] = i;
+  for (int node = num_runs - 1; node > 0; --node) {
+    int left = winners[2 * node];
+    int right = winners[2 * node + 1];
+    if (Beats(right, left)) {
+      winners[node] = right;
+      tree_[node] = left;
+    } else {
+      winners[node] = left;
+      tree_[node] = right;
+    }
   }
-  return Status::OK();
+  tree_[0] = winners[1];
+  consecutive_wins_ = 0;
+}
+
+int SortedRunMerger::FindChallenger() {
+  // The losers on the path of the winner are the winners of the sibling subtrees, so
+  // the best of them is the best of all other runs.
+  const int num_runs = runs_.size();
+  int challenger = -1;
+  for (int node = (tree_[0] + num_runs) >> 1; node > 0; node >>= 1) {
+    int candidate = tree_[node];
+    if (runs_[candidate]->exhausted()) continue;
+    if (challenger == -1 || Beats(candidate, challenger)) challenger = candidate;
+  }
+  return challenger;
 }
 
 Status SortedRunMerger::GetNext(RowBatch* output_batch, bool* eos) {
   ScopedTimer<MonotonicStopWatch> timer(get_next_timer_);
 
-  while (!output_batch->AtCapacity() && !min_heap_.empty()) {
-    SortedRunWrapper* min = min_heap_[0];
-    int output_row_index = output_batch->AddRow();
-    TupleRow* output_row = output_batch->GetRow(output_row_index);
-    if (deep_copy_input_) {
-      min->current_row()->DeepCopy(output_row, input_row_desc_->tuple_descriptors(),
-          output_batch->tuple_data_pool(), false);
-    } else {
-      // Simply copy tuple pointers if deep_copy is false.
-      memcpy(output_row, min->current_row(),
-          input_row_desc_->tuple_descriptors().size() * sizeof(Tuple*));
-    }
-
-    output_batch->CommitLastRow();
-    RETURN_IF_ERROR(AdvanceMinRow(output_batch));
+  while (!output_batch->AtCapacity() && !runs_.empty()
+      && !runs_[tree_[0]]->exhausted()) {
+    RETURN_IF_ERROR(AdvanceWinner(output_batch));
   }
-  *eos = min_heap_.empty();
+  *eos = runs_.empty() || runs_[tree_[0]]->exhausted();
   return Status::OK();
 }
 
-Status SortedRunMerger::AdvanceMinRow(RowBatch* transfer_batch) {
-  SortedRunWrapper* min = min_heap_[0];
-  bool min_run_complete;
-  // Advance to the next element in min. output_batch is supplied to transfer
-  // resource ownership if the input batch in min is exhausted.
-  RETURN_IF_ERROR(min->Advance(deep_copy_input_ ? nullptr : transfer_batch,
-      &min_run_complete));
-  if (min_run_complete) {
-    // Remove the element from the heap.
-    iter_swap(min_heap_.begin(), min_heap_.end() - 1);
-    min_heap_.pop_back();
+Status SortedRunMerger::AdvanceWinner(RowBatch* output_batch) {
+  const int winner_idx = tree_[0];
+  SortedRunWrapper* winner = runs_[winner_idx];
+  const int start_idx = winner->input_row_batch_index_;
+  int end_idx = start_idx + 1;
+  const bool span_mode = consecutive_wins_ >= MIN_WINS_FOR_SPANS;
+  SortedRunWrapper* challenger = nullptr;
+  bool challenger_wins = false;
+  if (span_mode) {
+    int challenger_idx = FindChallenger();
+    if (challenger_idx != -1) challenger = runs_[challenger_idx];
+    // Extend the span over the following rows of the current input batch. The memory
+    // usage of the output batch is only checked between spans, so a deep-copied span
+    // can exceed the soft memory limit of the output batch by up to one input batch.
+    const int max_end_idx = min(winner->input_row_batch_->num_rows(),
+        start_idx + output_batch->capacity() - output_batch->num_rows());
+    while (end_idx < max_end_idx) {
+      winner->input_row_batch_index_ = end_idx;
+      winner->EncodeKey();
+      if (challenger != nullptr && Less(challenger, winner)) {
+        challenger_wins = true;
+        break;
+      }
+      ++end_idx;
+    }
+    winner->input_row_batch_index_ = end_idx - 1;
+    COUNTER_ADD(span_rows_counter_, end_idx - start_idx);
   }
-  if (!min_heap_.empty()) {
-    Heapify(0);
+  CopyRows(winner, start_idx, end_idx, output_batch);
+
+  // Advance to the row after the span. 'output_batch' is supplied to transfer resource
+  // ownership if the input batch of the winner is exhausted.
+  bool run_complete;
+  RETURN_IF_ERROR(
+      winner->Advance(deep_copy_input_ ? nullptr : output_batch, &run_complete));
+  if (span_mode && !run_complete && !challenger_wins
+      && (challenger == nullptr || !Less(challenger, winner))) {
+    // The new row of the winner does not sort after the rows of the other runs, so it
+    // still wins all of its comparisons.
+    return Status::OK();
   }
+  Replay(winner_idx);
+  consecutive_wins_ = tree_[0] == winner_idx ? consecutive_wins_ + 1 : 0;
   return Status::OK();
 }
 
+void SortedRunMerger::CopyRows(const SortedRunWrapper* run, int start_idx,
+    int end_idx, RowBatch* output_batch) {
+  DCHECK_LT(start_idx, end_idx);
+  const int num_rows = end_idx - start_idx;
+  int output_row_index = output_batch->AddRows(num_rows);
+  if (deep_copy_input_) {
+    for (int i = 0; i < num_rows; ++i) {
+      run->input_row_batch_->GetRow(start_idx + i)->DeepCopy(
+          output_batch->GetRow(output_row_index + i),
+          input_row_desc_->tuple_descriptors(), output_batch->tuple_data_pool(), false);
+    }
+  } else {
+    // Simply copy tuple pointers if deep_copy is false. The rows of a batch are
+    // contiguous, so the whole span is copied at once.
+    memcpy(output_batch->GetRow(output_row_index),
+        run->input_row_batch_->GetRow(start_idx),
+        num_rows * input_row_desc_->tuple_descriptors().size() * sizeof(Tuple*));
+  }
+  output_batch->CommitRows(num_rows);
+}
+
 const char* SortedRunMerger::LLVM_CLASS_NAME = "class.impala::SortedRunMerger";
 
 Status SortedRunMerger::Codegen(FragmentState* state, llvm::Function* compare_fn,
-      CodegenFnPtr<HeapifyHelperFn>* codegend_fn) {
+      CodegenFnPtr<ReplayHelperFn>* codegend_fn) {
   LlvmCodeGen* codegen = state->codegen();
   DCHECK(codegen != nullptr);
 
   llvm::Function* fn = codegen->GetFunction(
-      IRFunction::SORTED_RUN_MERGER_HEAPIFY_HELPER, true);
+      IRFunction::SORTED_RUN_MERGER_REPLAY_HELPER, true);
   DCHECK(fn != nullptr);
 
   int replaced =
       codegen->ReplaceCallSites(fn, compare_fn, TupleRowComparator::COMPARE_SYMBOL);
-  DCHECK_REPLACE_COUNT(replaced, 2) << LlvmCodeGen::Print(fn);
+  DCHECK_REPLACE_COUNT(replaced, 1) << LlvmCodeGen::Print(fn);
 
   fn = codegen->FinalizeFunction(fn);
   if (fn == nullptr) {
@@ -17,6 +17,7 @@
 
 #pragma once
 
+#include <memory>
 #include <mutex>
 #include <boost/scoped_ptr.hpp>
 
@@ -30,12 +31,26 @@ namespace impala {
 
 class RowBatch;
 class RowDescriptor;
+class SortKeyNormalizer;
 class TupleRowComparator;
 
 /// SortedRunMerger is used to merge multiple sorted runs of tuples. A run is a sorted
 /// sequence of row batches, which are fetched from a RunBatchSupplierFn function object.
-/// Merging is implemented using a binary min-heap that maintains the run with the next
-/// tuple in sorted order at the top of the heap.
+/// Merging is implemented using a loser tree (tournament tree): each internal node of
+/// a complete binary tree over the runs holds the run that lost the comparison of the
+/// current rows of the winners of its two subtrees, and the overall winner is kept at
+/// the root. After the winner advances, only the comparisons on the path from its leaf
+/// to the root are replayed, which takes log2(k) comparisons per row for k runs.
+///
+/// When the same run wins several times in a row, the merger looks up the smallest
+/// current row of the other runs (the challenger) and emits the following rows of the
+/// winner as one span without replaying the tournament, as long as they do not sort
+/// after the challenger. Spans only cost one comparison per row and, if the input is
+/// not deep copied, are copied into the output batch at once.
+///
+/// If the merger is given a SortKeyNormalizer, the normalized key of the current row of
+/// each run is encoded when the run advances. Comparisons then compare the keys first
+/// and only evaluate the comparator if the keys are equal and not complete.
 ///
 /// Merged batches of rows are retrieved from SortedRunMerger via calls to GetNext().
 /// The merger is constructed with a boolean flag deep_copy_input.
@@ -46,7 +61,7 @@ class TupleRowComparator;
 ///
 /// SortedRunMerger cannot handle "flushing resources" so if the RunBatchSupplierFn
 /// can return batches with FLUSH_RESOURCES set, the merger must have 'deep_copy_input'
-/// set. This is because AdvanceMinRow() gets the next batch before freeing resources
+/// set. This is because AdvanceWinner() gets the next batch before freeing resources
 /// from the previous batch.
 /// TODO: it would be nice to fix this to avoid unnecessary copies.
 class SortedRunMerger {
@@ -56,28 +71,31 @@ class SortedRunMerger {
   /// batch being returned. The returned batch can have any number of rows (including
   /// zero).
   typedef boost::function<Status (RowBatch**)> RunBatchSupplierFn;
-  typedef void (*HeapifyHelperFn)(SortedRunMerger*, int);
+  typedef void (*ReplayHelperFn)(SortedRunMerger*, int);
 
+  /// 'normalizer' is optional. If it is provided, the input rows must consist of a
+  /// single tuple.
   SortedRunMerger(const TupleRowComparator& comparator, const RowDescriptor* row_desc,
       RuntimeProfile* profile, bool deep_copy_input,
-      const CodegenFnPtr<HeapifyHelperFn>& codegend_heapify_helper_fn);
+      const CodegenFnPtr<ReplayHelperFn>& codegend_replay_helper_fn,
+      const SortKeyNormalizer* normalizer = nullptr);
 
   /// Prepare this merger to merge and return rows from the sorted runs in 'input_runs'.
-  /// Retrieves the first batch from each run and sets up the binary heap implementing
-  /// the priority queue.
+  /// Retrieves the first batch from each run and plays the initial tournament of the
+  /// loser tree.
   Status Prepare(const std::vector<RunBatchSupplierFn>& input_runs);
 
   /// Return the next batch of sorted rows from this merger.
   Status GetNext(RowBatch* output_batch, bool* eos);
 
-  /// Makes an attempt to codegen for method HeapifyHelper(). Stores the resulting
+  /// Makes an attempt to codegen for method ReplayHelper(). Stores the resulting
   /// function in codegend_fn and returns Status::OK() if codegen was successful.
   /// Otherwise, a Status("SortedRunMergerer::Codegen(): failed to finalize function")
   /// object is returned.
   /// 'compare_fn' is the pointer to the codegen version of the compare method with
   /// which to replace all non-codegen versions.
   static Status Codegen(FragmentState* state, llvm::Function* compare_fn,
-      CodegenFnPtr<HeapifyHelperFn>* codegend_fn);
+      CodegenFnPtr<ReplayHelperFn>* codegend_fn);
 
   /// Class name in LLVM IR.
   static const char* LLVM_CLASS_NAME;
@@ -85,33 +103,75 @@ class SortedRunMerger {
  private:
   class SortedRunWrapper;
 
-  /// Remove the current row from the current min RunBatchSupplierFn and try to advance to
-  /// the next row. If 'deep_copy_input_' is false, 'transfer_batch' must be supplied to
-  /// attach resources to.
-  ///
-  /// When AdvanceMinRow returns, the previous min is advanced to the next row and the
-  /// heap is reordered accordingly. The RunBatchSupplierFn is removed from the heap if
-  /// this was its last row. Any completed resources are transferred to the batch.
-  Status AdvanceMinRow(RowBatch* transfer_batch);
-
-  /// Assuming the element at parent_index is the only out of place element in the heap,
-  /// restore the heap property (i.e. swap elements so parent <= children).
-  void Heapify(int parent_index);
-
-  void HeapifyHelper(int parent_index);
-
-  /// The binary min-heap used to merge rows from the sorted input runs. Since the heap is
-  /// stored in a 0-indexed array, the 0-th element is the minimum element in the heap,
-  /// and the children of the element at index i are 2*i+1 and 2*i+2. The heap property is
-  /// that row of the parent element is <= the rows of the child elements according to the
-  /// comparator comparator_.
-  /// The SortedRunWrapper objects used in the min_heap_ are owned by this
-  /// SortedRunMerger instance.
-  std::vector<SortedRunWrapper*> min_heap_;
+  /// Emits the current row of the winner, and in span mode the following rows of the
+  /// winner that do not sort after the challenger, into 'output_batch'. Then advances
+  /// the winner past the emitted rows and replays the tournament if needed. If
+  /// 'deep_copy_input_' is false, resources of completed input batches are transferred
+  /// to 'output_batch'.
+  Status AdvanceWinner(RowBatch* output_batch);
+
+  /// Plays the initial tournament between all runs.
+  void BuildTree();
+
+  /// Replays the comparisons on the path from the leaf of 'run_index' to the root after
+  /// the current row of the run changed. Calls the codegen'd ReplayHelper() if
+  /// available.
+  void Replay(int run_index);
+
+  void ReplayHelper(int run_index);
+
+  /// Returns the index of the run with the smallest current row among the runs other
+  /// than the winner, or -1 if all other runs are exhausted.
+  int FindChallenger();
+
+  /// Returns true if the current row of run 'lhs' wins against the current row of run
+  /// 'rhs', i.e. is less than it. Exhausted runs lose against all other runs.
+  bool IR_ALWAYS_INLINE Beats(int lhs, int rhs);
+
+  /// Returns true if the current row of 'lhs' is less than the current row of 'rhs'.
+  bool IR_ALWAYS_INLINE Less(const SortedRunWrapper* lhs, const SortedRunWrapper* rhs);
+
+  /// Copies the rows in ['start_idx', 'end_idx') of the current input batch of 'run' to
+  /// 'output_batch'.
+  void CopyRows(const SortedRunWrapper* run, int start_idx, int end_idx,
+      RowBatch* output_batch);
+
+  /// Number of consecutive wins of the winner after which the merger switches to
+  /// emitting spans. Looking up the challenger costs as many comparisons as a replay, so
+  /// it is only worth it if the winner is likely to keep winning.
+  static const int MIN_WINS_FOR_SPANS = 2;
+
+  /// The input runs. Exhausted runs stay in place as leaves that lose every
+  /// comparison. The SortedRunWrapper objects are owned by this SortedRunMerger
+  /// instance.
+  std::vector<SortedRunWrapper*> runs_;
+
+  /// The loser tree over 'runs_'. Node 0 holds the index of the overall winner. For
+  /// k runs, internal node i in [1, k) holds the index of the run that lost at that
+  /// node; its children are nodes 2*i and 2*i+1, where nodes k + j are the leaves of
+  /// the runs j.
+  std::vector<int> tree_;
+
+  /// Number of consecutive times that the current winner won the replay.
+  int consecutive_wins_ = 0;
+
+  /// Number of rows that were emitted as part of spans.
+  RuntimeProfile::Counter* span_rows_counter_;
 
   /// Row comparator. Returns true if lhs < rhs.
   const TupleRowComparator& comparator_;
 
+  /// Encodes the normalized keys of the current rows of the runs. nullptr if the rows
+  /// are only compared with 'comparator_'. Not owned.
+  const SortKeyNormalizer* const normalizer_;
+
+  /// Length of the normalized keys. 0 if 'normalizer_' is nullptr.
+  const int key_len_;
+
+  /// Storage for the normalized keys of the current rows of the runs, 'key_len_' bytes
+  /// per run.
+  std::unique_ptr<uint8_t[]> keys_;
+
   /// Descriptor for the rows provided by the input runs. Owned by the exec-node through
   /// which this merger was created.
   const RowDescriptor* input_row_desc_;
@@ -128,13 +188,13 @@ class SortedRunMerger {
   /// Times calls to get the next batch of rows from the input run.
   RuntimeProfile::Counter* get_next_batch_timer_;
 
-  /// A reference to the codegened version of SortedRunMerger::HeapifyHelper() that is
+  /// A reference to the codegened version of SortedRunMerger::ReplayHelper() that is
   /// stored inside SortPlanNode and ExchangePlanNode.
-  const CodegenFnPtr<HeapifyHelperFn>& codegend_heapify_helper_fn_;
+  const CodegenFnPtr<ReplayHelperFn>& codegend_replay_helper_fn_;
 };
 
 /// SortedRunWrapper returns individual rows in a batch obtained from a sorted input run
-/// (a RunBatchSupplierFn). Used as the heap element in the min heap maintained by the
+/// (a RunBatchSupplierFn). Used as the leaves of the loser tree maintained by the
 /// merger.
 /// Advance() advances the row supplier to the next row in the input batch and retrieves
 /// the next batch from the input if the current input batch is exhausted. Transfers
@@ -155,13 +215,23 @@ class SortedRunMerger::SortedRunWrapper {
     return input_row_batch_->GetRow(input_row_batch_index_);
   }
 
+  /// True if all rows of the run were returned.
+  bool exhausted() const { return input_row_batch_ == nullptr; }
+
  private:
   friend class SortedRunMerger;
 
+  /// Encodes the normalized key of the current row into 'key_' if the merger has a
+  /// normalizer.
+  void EncodeKey();
+
+  /// The normalized key of the current row. Points into the parent's 'keys_'.
+  uint8_t* key_ = nullptr;
+
   /// The run from which this object supplies rows.
   RunBatchSupplierFn sorted_run_;
 
-  /// The current input batch being processed.
+  /// The current input batch being processed. nullptr once the run is exhausted.
   RowBatch* input_row_batch_;
 
   /// Index into input_row_batch_ of the current row being processed.
@@ -21,6 +21,7 @@
 
 #include "sorter.h"
 
+#include <functional>
 #include <random>
 
 #include "common/compiler-util.h"
@@ -424,10 +425,25 @@ class Sorter::TupleIterator {
 /// Quick sort is used for sequences of tuples larger that 16 elements, and insertion
 /// sort is used for smaller sequences. The TupleSorter is initialized with a
 /// RuntimeState instance to check for cancellation during an in-memory sort.
+///
+/// If a SortKeyNormalizer is provided, large runs are instead sorted over
+/// (normalized key, tuple index) pairs, after which the tuples are permuted into place.
+/// Keys of fixed-width values are sorted with an LSD radix sort. If the normalized key
+/// does not cover all ordering exprs, ranges of equal normalized keys are then sorted
+/// with the comparator. Keys that end with a string prefix are sorted with a
+/// comparison sort that compares the keys eight bytes at a time and only evaluates the
+/// comparator if the keys are equal. The keys of large runs are sorted and merged by
+/// several threads, which lets a single large sort, e.g. the sort for an analytic
+/// function without PARTITION BY or with a skewed partition, use more than one core.
 class Sorter::TupleSorter {
  public:
+  /// Maximum length of the normalized keys. Each byte of a fixed-width key may need a
+  /// radix sort pass over the keys.
+  static const int MAX_NORMALIZED_KEY_LEN = 24;
+
+  /// 'normalizer' may be nullptr, in which case runs are always sorted with quicksort.
   TupleSorter(Sorter* parent, const TupleRowComparator& comparator,
-        int tuple_size, RuntimeState* state);
+        const SortKeyNormalizer* normalizer, int tuple_size, RuntimeState* state);
 
   ~TupleSorter();
 
@@ -455,6 +471,13 @@ class Sorter::TupleSorter {
  private:
   static const int INSERTION_THRESHOLD = 16;
 
+  /// A normalized key and the index of its tuple in 'run_', used by PrefixSort() and
+  /// ParallelSort().
+  struct KeyEntry {
+    uint8_t key[MAX_NORMALIZED_KEY_LEN];
+    uint32_t index;
+  };
+
   Sorter* const parent_;
 
   /// Size of the tuples in memory.
@@ -466,6 +489,10 @@ class Sorter::TupleSorter {
   /// Tuple comparator with method Less() that returns true if lhs < rhs.
   const TupleRowComparator& comparator_;
 
+  /// Normalizer for the radix sort path. nullptr if the sort keys cannot be normalized
+  /// or the radix sort is disabled. Not owned.
+  const SortKeyNormalizer* const normalizer_;
+
   /// Number of times comparator_.Less() can be invoked again before
   /// comparator_. expr_results_pool_.Clear() needs to be called.
   int num_comparisons_till_free_;
@@ -488,6 +515,38 @@ class Sorter::TupleSorter {
 
   void IR_ALWAYS_INLINE FreeExprResultPoolIfNeeded();
 
+  /// Sorts 'run_' with a radix sort over the normalized keys. Sets 'sorted' to false
+  /// without modifying the run if the memory for the keys could not be allocated, in
+  /// which case the caller must fall back to quicksort. Returns an error status if the
+  /// query is cancelled.
+  Status RadixSort(bool* sorted);
+
+  /// Sorts 'run_' with a comparison sort over the normalized keys. Like RadixSort(),
+  /// sets 'sorted' to false if the memory for the keys could not be allocated.
+  Status PrefixSort(bool* sorted);
+
+  /// Sorts 'run_' like PrefixSort(), but encodes and sorts the keys in chunks that are
+  /// then merged pairwise, with the chunks and merges of each round spread over up to
+  /// --sorter_parallel_sort_threads threads. The workers only compare normalized keys;
+  /// ranges of equal keys are sorted with the comparator on the calling thread
+  /// afterwards because the comparator's evaluators cannot be shared between threads.
+  /// Sets 'sorted' to false if the memory for the keys could not be allocated.
+  Status ParallelSort(bool* sorted);
+
+  /// Runs 'task' for each index in [0, num_tasks) on the calling thread and on up to
+  /// --sorter_parallel_sort_threads - 1 additional threads, as far as thread tokens are
+  /// available. Returns once all tasks are done.
+  void RunParallelTasks(int num_tasks, const std::function<void(int)>& task);
+
+  /// Sorts the 'num_entries' radix sort entries of 'entry_len' bytes at 'entries' that
+  /// have the same normalized key with the comparator. Only the tuple indices at the
+  /// end of the entries are reordered.
+  void SortTiedEntries(uint8_t* entries, int64_t num_entries, int entry_len);
+
+  /// Moves the tuple with index 'perm'[i] to index i for all tuples of 'run_'. Uses
+  /// 'perm' as scratch space.
+  void PermuteTuples(uint32_t* perm);
+
   /// Wrapper around comparator_.Less(). Also call expr_results_pool_.Clear()
   /// on every 'state_->batch_size()' invocations of comparator_.Less(). Returns true
   /// if 'lhs' is less than 'rhs'.
@@ -21,27 +21,51 @@
 #include <gutil/strings/substitute.h>
 
 #include "codegen/llvm-codegen.h"
+#include "common/atomic.h"
 #include "exprs/scalar-expr-evaluator.h"
 #include "runtime/bufferpool/reservation-tracker.h"
 #include "runtime/bufferpool/reservation-util.h"
 #include "runtime/exec-env.h"
+#include "runtime/fragment-instance-state.h"
 #include "runtime/fragment-state.h"
 #include "runtime/mem-tracker.h"
 #include "runtime/query-state.h"
 #include "runtime/runtime-state.h"
 #include "runtime/sorted-run-merger.h"
+#include "runtime/thread-resource-mgr.h"
+#include "util/debug-util.h"
 #include "util/pretty-printer.h"
+#include "util/scope-exit-trigger.h"
+#include "util/sort-key-normalizer.h"
+#include "util/thread.h"
 #include "util/ubsan.h"
 
 #include "common/names.h"
 
+DEFINE_bool(enable_sorter_radix_sort, true, "(Advanced) If true, in-memory runs of at "
+    "least --sorter_radix_sort_min_tuples tuples are sorted with a radix sort over "
+    "normalized sort keys if the leading sort keys are slots of fixed-width types.");
+DEFINE_bool(enable_sort_key_prefix, true, "(Advanced) If true, sort keys that start "
+    "with string slots are encoded into normalized key prefixes. In-memory runs of at "
+    "least --sorter_radix_sort_min_tuples tuples are sorted by comparing the prefixes "
+    "and merges of sorted runs compare the prefixes before evaluating the sort keys.");
+DEFINE_int64(sorter_radix_sort_min_tuples, 4096, "(Advanced) Minimum number of tuples "
+    "in a run for --enable_sorter_radix_sort or --enable_sort_key_prefix to apply.");
+DEFINE_int32(sorter_parallel_sort_threads, 4, "(Advanced) Maximum number of threads "
+    "that sort an in-memory run of at least --sorter_parallel_sort_min_tuples tuples "
+    "with normalized sort keys. Threads beyond the fragment instance's own thread are "
+    "only started if thread tokens are available. A value of 1 disables parallel "
+    "sorting of runs.");
+DEFINE_int64(sorter_parallel_sort_min_tuples, 1024 * 1024, "(Advanced) Minimum number "
+    "of tuples in a run for --sorter_parallel_sort_threads to apply.");
+
 using namespace strings;
 
 namespace impala {
 
 // Number of pinned pages required for a merge with fixed-length data only.
 const int MIN_BUFFERS_PER_MERGE = 3;
-const CodegenFnPtr<SortedRunMerger::HeapifyHelperFn> Sorter::default_heapify_helper_fn_{};
+const CodegenFnPtr<SortedRunMerger::ReplayHelperFn> Sorter::default_replay_helper_fn_{};
 
 Status Sorter::Page::Init(Sorter* sorter) {
   const BufferPool::BufferHandle* page_buffer;
@@ -735,10 +759,11 @@ Sorter::TupleIterator::TupleIterator(Sorter::Run* run, int64_t index)
 }
 
 Sorter::TupleSorter::TupleSorter(Sorter* parent, const TupleRowComparator& comp,
-    int tuple_size, RuntimeState* state)
+    const SortKeyNormalizer* normalizer, int tuple_size, RuntimeState* state)
   : parent_(parent),
     tuple_size_(tuple_size),
     comparator_(comp),
+    normalizer_(normalizer),
     num_comparisons_till_free_(state->batch_size()),
     state_(state) {
   temp_tuple_buffer_ = new uint8_t[tuple_size];
@@ -754,24 +779,318 @@ Status Sorter::TupleSorter::Sort(Run* run) {
   DCHECK(run->is_finalized());
   DCHECK(!run->is_sorted());
   run_ = run;
-  const SortHelperFn sort_helper_fn = parent_->codegend_sort_helper_fn_.load();
-  if (sort_helper_fn != nullptr) {
-    RETURN_IF_ERROR(
-        sort_helper_fn(this, TupleIterator::Begin(run_), TupleIterator::End(run_)));
-  } else {
-    RETURN_IF_ERROR(SortHelper(TupleIterator::Begin(run_), TupleIterator::End(run_)));
+  bool sorted = false;
+  if (normalizer_ != nullptr && run_->num_tuples() >= FLAGS_sorter_radix_sort_min_tuples
+      && run_->num_tuples() <= numeric_limits<uint32_t>::max()) {
+    if (FLAGS_sorter_parallel_sort_threads > 1
+        && run_->num_tuples() >= FLAGS_sorter_parallel_sort_min_tuples) {
+      RETURN_IF_ERROR(ParallelSort(&sorted));
+      if (sorted) COUNTER_ADD(parent_->parallel_sorted_runs_counter_, 1);
+    }
+    if (sorted) {
+      // Already sorted by ParallelSort().
+    } else if (FLAGS_enable_sorter_radix_sort && !normalizer_->has_string_prefix()) {
+      RETURN_IF_ERROR(RadixSort(&sorted));
+      if (sorted) COUNTER_ADD(parent_->radix_sorted_runs_counter_, 1);
+    } else if (FLAGS_enable_sort_key_prefix) {
+      RETURN_IF_ERROR(PrefixSort(&sorted));
+      if (sorted) COUNTER_ADD(parent_->prefix_sorted_runs_counter_, 1);
+    }
+  }
+  if (!sorted) {
+    const SortHelperFn sort_helper_fn = parent_->codegend_sort_helper_fn_.load();
+    if (sort_helper_fn != nullptr) {
+      RETURN_IF_ERROR(
+          sort_helper_fn(this, TupleIterator::Begin(run_), TupleIterator::End(run_)));
+    } else {
+      RETURN_IF_ERROR(SortHelper(TupleIterator::Begin(run_), TupleIterator::End(run_)));
+    }
   }
   run_->set_sorted();
   return Status::OK();
 }
 
+Status Sorter::TupleSorter::RadixSort(bool* sorted) {
+  *sorted = false;
+  const int64_t num_tuples = run_->num_tuples();
+  const int key_len = normalizer_->key_len();
+  // Each entry is the normalized key followed by the index of the tuple in the run.
+  const int entry_len = key_len + sizeof(uint32_t);
+  // The entries are scattered back and forth between two buffers in the LSD passes.
+  const int64_t entries_bytes = num_tuples * entry_len;
+  const int64_t mem_bytes = 2 * entries_bytes + num_tuples * sizeof(uint32_t);
+  if (!parent_->mem_tracker_->TryConsume(mem_bytes)) return Status::OK();
+  const auto release_mem = MakeScopeExitTrigger(
+      [this, mem_bytes]() { parent_->mem_tracker_->Release(mem_bytes); });
+  unique_ptr<uint8_t[]> entries(new (nothrow) uint8_t[entries_bytes]);
+  unique_ptr<uint8_t[]> scratch(new (nothrow) uint8_t[entries_bytes]);
+  unique_ptr<uint32_t[]> perm(new (nothrow) uint32_t[num_tuples]);
+  if (entries == nullptr || scratch == nullptr || perm == nullptr) return Status::OK();
+
+  // Encode the keys and count the occurrences of each byte value at each key position.
+  vector<uint32_t> histograms(key_len * 256, 0);
+  TupleIterator it = TupleIterator::Begin(run_);
+  for (uint32_t i = 0; i < num_tuples; ++i) {
+    uint8_t* entry = entries.get() + i * entry_len;
+    normalizer_->Encode(it.tuple(), entry);
+    memcpy(entry + key_len, &i, sizeof(i));
+    for (int b = 0; b < key_len; ++b) ++histograms[b * 256 + entry[b]];
+    it.Next(run_, tuple_size_);
+  }
+
+  // LSD passes from the last to the first key byte. Bytes with the same value in all
+  // keys do not change the order and are skipped.
+  uint8_t* src = entries.get();
+  uint8_t* dst = scratch.get();
+  int64_t offsets[256];
+  for (int b = key_len - 1; b >= 0; --b) {
+    const uint32_t* hist = histograms.data() + b * 256;
+    if (hist[src[b]] == num_tuples) continue;
+    RETURN_IF_CANCELLED(state_);
+    int64_t offset = 0;
+    for (int v = 0; v < 256; ++v) {
+      offsets[v] = offset;
+      offset += hist[v];
+    }
+    for (int64_t i = 0; i < num_tuples; ++i) {
+      const uint8_t* entry = src + i * entry_len;
+      memcpy(dst + offsets[entry[b]]++ * entry_len, entry, entry_len);
+    }
+    std::swap(src, dst);
+  }
+
+  if (!normalizer_->is_complete()) {
+    // Break the ties between equal normalized keys with the comparator.
+    int64_t range_start = 0;
+    for (int64_t i = 1; i <= num_tuples; ++i) {
+      if (i < num_tuples
+          && memcmp(src + range_start * entry_len, src + i * entry_len, key_len) == 0) {
+        continue;
+      }
+      if (i - range_start > 1) {
+        SortTiedEntries(src + range_start * entry_len, i - range_start, entry_len);
+        RETURN_IF_CANCELLED(state_);
+      }
+      range_start = i;
+    }
+  }
+
+  for (int64_t i = 0; i < num_tuples; ++i) {
+    memcpy(&perm[i], src + i * entry_len + key_len, sizeof(uint32_t));
+  }
+  entries.reset();
+  scratch.reset();
+  PermuteTuples(perm.get());
+  *sorted = true;
+  return Status::OK();
+}
+
+Status Sorter::TupleSorter::PrefixSort(bool* sorted) {
+  *sorted = false;
+  const int64_t num_tuples = run_->num_tuples();
+  const int key_len = normalizer_->key_len();
+  DCHECK_LE(key_len, MAX_NORMALIZED_KEY_LEN);
+  const int64_t mem_bytes = num_tuples * (sizeof(KeyEntry) + sizeof(uint32_t));
+  if (!parent_->mem_tracker_->TryConsume(mem_bytes)) return Status::OK();
+  const auto release_mem = MakeScopeExitTrigger(
+      [this, mem_bytes]() { parent_->mem_tracker_->Release(mem_bytes); });
+  unique_ptr<KeyEntry[]> entries(new (nothrow) KeyEntry[num_tuples]);
+  unique_ptr<uint32_t[]> perm(new (nothrow) uint32_t[num_tuples]);
+  if (entries == nullptr || perm == nullptr) return Status::OK();
+
+  TupleIterator it = TupleIterator::Begin(run_);
+  for (uint32_t i = 0; i < num_tuples; ++i) {
+    normalizer_->Encode(it.tuple(), entries[i].key);
+    entries[i].index = i;
+    it.Next(run_, tuple_size_);
+  }
+  RETURN_IF_CANCELLED(state_);
+
+  const bool is_complete = normalizer_->is_complete();
+  std::sort(entries.get(), entries.get() + num_tuples,
+      [this, key_len, is_complete](const KeyEntry& lhs, const KeyEntry& rhs) {
+        int cmp = SortKeyNormalizer::Compare(lhs.key, rhs.key, key_len);
+        if (cmp != 0 || is_complete) return cmp < 0;
+        TupleIterator lhs_it(run_, lhs.index);
+        TupleIterator rhs_it(run_, rhs.index);
+        return Less(lhs_it.row(), rhs_it.row());
+      });
+  RETURN_IF_CANCELLED(state_);
+
+  for (int64_t i = 0; i < num_tuples; ++i) perm[i] = entries[i].index;
+  entries.reset();
+  PermuteTuples(perm.get());
+  *sorted = true;
+  return Status::OK();
+}
+
+Status Sorter::TupleSorter::ParallelSort(bool* sorted) {
+  *sorted = false;
+  const int64_t num_tuples = run_->num_tuples();
+  const int key_len = normalizer_->key_len();
+  DCHECK_LE(key_len, MAX_NORMALIZED_KEY_LEN);
+  // The entries are merged back and forth between two buffers.
+  const int64_t mem_bytes = num_tuples * (2 * sizeof(KeyEntry) + sizeof(uint32_t));
+  if (!parent_->mem_tracker_->TryConsume(mem_bytes)) return Status::OK();
+  const auto release_mem = MakeScopeExitTrigger(
+      [this, mem_bytes]() { parent_->mem_tracker_->Release(mem_bytes); });
+  unique_ptr<KeyEntry[]> entries(new (nothrow) KeyEntry[num_tuples]);
+  unique_ptr<KeyEntry[]> scratch(new (nothrow) KeyEntry[num_tuples]);
+  unique_ptr<uint32_t[]> perm(new (nothrow) uint32_t[num_tuples]);
+  if (entries == nullptr || scratch == nullptr || perm == nullptr) return Status::OK();
+
+  auto key_less = [key_len](const KeyEntry& lhs, const KeyEntry& rhs) {
+    return SortKeyNormalizer::Compare(lhs.key, rhs.key, key_len) < 0;
+  };
+
+  // Encode and sort the keys of each chunk. 'bounds' holds the boundaries of the sorted
+  // sequences of entries in 'src'.
+  const int num_chunks = FLAGS_sorter_parallel_sort_threads;
+  vector<int64_t> bounds;
+  for (int i = 0; i <= num_chunks; ++i) bounds.push_back(num_tuples * i / num_chunks);
+  KeyEntry* src = entries.get();
+  KeyEntry* dst = scratch.get();
+  RunParallelTasks(num_chunks, [&](int chunk) {
+    TupleIterator it(run_, bounds[chunk]);
+    for (int64_t i = bounds[chunk]; i < bounds[chunk + 1]; ++i) {
+      normalizer_->Encode(it.tuple(), src[i].key);
+      src[i].index = i;
+      it.Next(run_, tuple_size_);
+    }
+    std::sort(src + bounds[chunk], src + bounds[chunk + 1], key_less);
+  });
+  RETURN_IF_CANCELLED(state_);
+
+  // Merge pairs of adjacent sequences from 'src' into 'dst' until one is left. The last
+  // sequence is copied if it has no partner.
+  while (bounds.size() > 2) {
+    const int num_seqs = bounds.size() - 1;
+    vector<int64_t> next_bounds;
+    for (int i = 0; i <= num_seqs; i += 2) next_bounds.push_back(bounds[i]);
+    if (next_bounds.back() != num_tuples) next_bounds.push_back(num_tuples);
+    RunParallelTasks(next_bounds.size() - 1, [&](int merge) {
+      const int64_t begin = bounds[2 * merge];
+      const int64_t mid = bounds[2 * merge + 1];
+      if (2 * merge + 1 == num_seqs) {
+        std::copy(src + begin, src + mid, dst + begin);
+      } else {
+        std::merge(src + begin, src + mid, src + mid, src + bounds[2 * merge + 2],
+            dst + begin, key_less);
+      }
+    });
+    std::swap(src, dst);
+    bounds.swap(next_bounds);
+    RETURN_IF_CANCELLED(state_);
+  }
+
+  if (!normalizer_->is_complete()) {
+    // Break the ties between equal normalized keys with the comparator.
+    int64_t range_start = 0;
+    for (int64_t i = 1; i <= num_tuples; ++i) {
+      if (i < num_tuples && SortKeyNormalizer::Compare(
+              src[range_start].key, src[i].key, key_len) == 0) {
+        continue;
+      }
+      if (i - range_start > 1) {
+        std::sort(src + range_start, src + i,
+            [this](const KeyEntry& lhs, const KeyEntry& rhs) {
+              TupleIterator lhs_it(run_, lhs.index);
+              TupleIterator rhs_it(run_, rhs.index);
+              return Less(lhs_it.row(), rhs_it.row());
+            });
+        RETURN_IF_CANCELLED(state_);
+      }
+      range_start = i;
+    }
+  }
+
+  for (int64_t i = 0; i < num_tuples; ++i) perm[i] = src[i].index;
+  entries.reset();
+  scratch.reset();
+  PermuteTuples(perm.get());
+  *sorted = true;
+  return Status::OK();
+}
+
+void Sorter::TupleSorter::RunParallelTasks(
+    int num_tasks, const std::function<void(int)>& task) {
+  AtomicInt32 next_task(0);
+  auto run_worker = [&]() {
+    for (int i = next_task.Add(1) - 1; i < num_tasks; i = next_task.Add(1) - 1) {
+      task(i);
+    }
+  };
+
+  vector<unique_ptr<Thread>> workers;
+  const int num_workers = min(FLAGS_sorter_parallel_sort_threads, num_tasks);
+  for (int i = 1; i < num_workers; ++i) {
+    if (!state_->resource_pool()->TryAcquireThreadToken()) break;
+    string thread_name = Substitute("sort-worker (finst:$0, $1)",
+        PrintId(state_->fragment_instance_id()), parent_->node_label_);
+    unique_ptr<Thread> worker;
+    Status thread_status = Thread::Create(FragmentInstanceState::FINST_THREAD_GROUP_NAME,
+        thread_name, run_worker, &worker, true);
+    if (!thread_status.ok()) {
+      // Not fatal: the calling thread runs the remaining tasks.
+      VLOG(2) << "Could not start sort worker: " << thread_status.GetDetail();
+      state_->resource_pool()->ReleaseThreadToken(false);
+      break;
+    }
+    workers.push_back(move(worker));
+  }
+  COUNTER_ADD(parent_->parallel_sort_workers_counter_, workers.size());
+  run_worker();
+  for (unique_ptr<Thread>& worker : workers) {
+    worker->Join();
+    state_->resource_pool()->ReleaseThreadToken(false);
+  }
+}
+
+void Sorter::TupleSorter::SortTiedEntries(
+    uint8_t* entries, int64_t num_entries, int entry_len) {
+  const int index_offset = entry_len - sizeof(uint32_t);
+  vector<uint32_t> indices(num_entries);
+  for (int64_t i = 0; i < num_entries; ++i) {
+    memcpy(&indices[i], entries + i * entry_len + index_offset, sizeof(uint32_t));
+  }
+  std::sort(indices.begin(), indices.end(), [this](uint32_t lhs, uint32_t rhs) {
+    TupleIterator lhs_it(run_, lhs);
+    TupleIterator rhs_it(run_, rhs);
+    return Less(lhs_it.row(), rhs_it.row());
+  });
+  for (int64_t i = 0; i < num_entries; ++i) {
+    memcpy(entries + i * entry_len + index_offset, &indices[i], sizeof(uint32_t));
+  }
+}
+
+void Sorter::TupleSorter::PermuteTuples(uint32_t* perm) {
+  const int64_t num_tuples = run_->num_tuples();
+  for (int64_t start = 0; start < num_tuples; ++start) {
+    if (perm[start] == start) continue;
+    // Rotate the cycle starting at 'start': each tuple is replaced by the tuple at the
+    // index that 'perm' gives for it. Processed indices are marked as fixed points.
+    Tuple* start_tuple = TupleIterator(run_, start).tuple();
+    memcpy(temp_tuple_buffer_, start_tuple, tuple_size_);
+    int64_t dst = start;
+    while (perm[dst] != start) {
+      int64_t src = perm[dst];
+      memcpy(TupleIterator(run_, dst).tuple(), TupleIterator(run_, src).tuple(),
+          tuple_size_);
+      perm[dst] = dst;
+      dst = src;
+    }
+    memcpy(TupleIterator(run_, dst).tuple(), temp_tuple_buffer_, tuple_size_);
+    perm[dst] = dst;
+  }
+}
+
 Sorter::Sorter(const TupleRowComparatorConfig& tuple_row_comparator_config,
     const vector<ScalarExpr*>& sort_tuple_exprs, RowDescriptor* output_row_desc,
     MemTracker* mem_tracker, BufferPool::ClientHandle* buffer_pool_client,
     int64_t page_len, RuntimeProfile* profile, RuntimeState* state,
     const string& node_label, bool enable_spilling,
     const CodegenFnPtr<SortHelperFn>& codegend_sort_helper_fn,
-    const CodegenFnPtr<SortedRunMerger::HeapifyHelperFn>& codegend_heapify_helper_fn,
+    const CodegenFnPtr<SortedRunMerger::ReplayHelperFn>& codegend_replay_helper_fn,
     int64_t estimated_input_size)
   : node_label_(node_label),
     state_(state),
@@ -780,7 +1099,7 @@ Sorter::Sorter(const TupleRowComparatorConfig& tuple_row_comparator_config,
     compare_less_than_(nullptr),
     in_mem_tuple_sorter_(nullptr),
     codegend_sort_helper_fn_(codegend_sort_helper_fn),
-    codegend_heapify_helper_fn_(codegend_heapify_helper_fn),
+    codegend_replay_helper_fn_(codegend_replay_helper_fn),
     buffer_pool_client_(buffer_pool_client),
     page_len_(page_len),
     has_var_len_slots_(false),
@@ -807,6 +1126,10 @@ Sorter::Sorter(const TupleRowComparatorConfig& tuple_row_comparator_config,
     default:
       DCHECK(false);
   }
+  if (FLAGS_enable_sorter_radix_sort || FLAGS_enable_sort_key_prefix) {
+    sort_key_normalizer_ = SortKeyNormalizer::Create(tuple_row_comparator_config,
+        TupleSorter::MAX_NORMALIZED_KEY_LEN, FLAGS_enable_sort_key_prefix, &obj_pool_);
+  }
 
   if (estimated_input_size > 0) ComputeSpillEstimate(estimated_input_size);
 }
@@ -851,8 +1174,8 @@ Status Sorter::Prepare(ObjectPool* obj_pool) {
         PrettyPrinter::Print(state_->query_options().max_row_size, TUnit::BYTES));
   }
   has_var_len_slots_ = sort_tuple_desc->HasVarlenSlots();
-  in_mem_tuple_sorter_.reset(
-      new TupleSorter(this, *compare_less_than_, sort_tuple_desc->byte_size(), state_));
+  in_mem_tuple_sorter_.reset(new TupleSorter(this, *compare_less_than_,
+      sort_key_normalizer_, sort_tuple_desc->byte_size(), state_));
 
   if (enable_spilling_) {
     initial_runs_counter_ = ADD_COUNTER(profile_, "InitialRunsCreated", TUnit::UNIT);
@@ -862,6 +1185,15 @@ Status Sorter::Prepare(ObjectPool* obj_pool) {
     initial_runs_counter_ = ADD_COUNTER(profile_, "RunsCreated", TUnit::UNIT);
   }
   in_mem_sort_timer_ = ADD_TIMER(profile_, "InMemorySortTime");
+  if (sort_key_normalizer_ != nullptr) {
+    radix_sorted_runs_counter_ = ADD_COUNTER(profile_, "NumRadixSortedRuns", TUnit::UNIT);
+    prefix_sorted_runs_counter_ =
+        ADD_COUNTER(profile_, "NumPrefixSortedRuns", TUnit::UNIT);
+    parallel_sorted_runs_counter_ =
+        ADD_COUNTER(profile_, "NumParallelSortedRuns", TUnit::UNIT);
+    parallel_sort_workers_counter_ =
+        ADD_COUNTER(profile_, "NumParallelSortWorkerThreads", TUnit::UNIT);
+  }
   sorted_data_size_ = ADD_COUNTER(profile_, "SortDataSize", TUnit::BYTES);
   run_sizes_ = ADD_SUMMARY_STATS_COUNTER(profile_, "NumRowsPerRun", TUnit::UNIT);
 
@@ -1159,7 +1491,8 @@ Status Sorter::CreateMerger(int num_runs) {
   // correctly transfer resources.
   merger_.reset(
       new SortedRunMerger(*compare_less_than_, output_row_desc_, profile_, true,
-          codegend_heapify_helper_fn_));
+          codegend_replay_helper_fn_,
+          FLAGS_enable_sort_key_prefix ? sort_key_normalizer_ : nullptr));
 
   vector<function<Status (RowBatch**)>> merge_runs;
   merge_runs.reserve(num_runs);
@@ -28,6 +28,7 @@
 namespace impala {
 
 class SortedRunMerger;
+class SortKeyNormalizer;
 class RowBatch;
 
 /// Sorter contains the external sort implementation. Its purpose is to sort arbitrarily
@@ -120,8 +121,8 @@ class Sorter {
       RuntimeProfile* profile, RuntimeState* state, const std::string& node_label,
       bool enable_spilling,
       const CodegenFnPtr<SortHelperFn>& codegend_sort_helper_fn,
-      const CodegenFnPtr<SortedRunMerger::HeapifyHelperFn>& codegend_heapify_helper_fn =
-            default_heapify_helper_fn_,
+      const CodegenFnPtr<SortedRunMerger::ReplayHelperFn>& codegend_replay_helper_fn =
+            default_replay_helper_fn_,
       int64_t estimated_input_size = -1);
   ~Sorter();
 
@@ -257,18 +258,23 @@ class Sorter {
   boost::scoped_ptr<TupleRowComparator> compare_less_than_;
   boost::scoped_ptr<TupleSorter> in_mem_tuple_sorter_;
 
+  /// Encodes the leading sort keys into normalized keys for the normalized key sorts of
+  /// 'in_mem_tuple_sorter_' and the prefix comparisons of 'merger_'. nullptr if both
+  /// are disabled or the first sort key cannot be normalized. Owned by 'obj_pool_'.
+  SortKeyNormalizer* sort_key_normalizer_ = nullptr;
+
   /// A reference to the codegened version of TupleSorter::SortHelper() that is stored
   /// inside SortPlanNode, PartialSortPlanNode and TopNPlanNode.
   const CodegenFnPtr<SortHelperFn>& codegend_sort_helper_fn_;
 
-  /// A reference to the codegened version of SortedRunMerger::HeapifyHelper() that is
+  /// A reference to the codegened version of SortedRunMerger::ReplayHelper() that is
   /// stored inside SortPlanNode and ExchangePlanNode.
-  const CodegenFnPtr<SortedRunMerger::HeapifyHelperFn>& codegend_heapify_helper_fn_;
+  const CodegenFnPtr<SortedRunMerger::ReplayHelperFn>& codegend_replay_helper_fn_;
 
   /// A default codegened function pointer storing nullptr, which is used when the
   /// merger is not needed. Used as a default value in constructor, when the CodegenFnPtr
   /// is not provided.
-  static const CodegenFnPtr<SortedRunMerger::HeapifyHelperFn> default_heapify_helper_fn_;
+  static const CodegenFnPtr<SortedRunMerger::ReplayHelperFn> default_replay_helper_fn_;
 
   /// Client used to allocate pages from the buffer pool. Not owned.
   BufferPool::ClientHandle* const buffer_pool_client_;
@@ -345,6 +351,20 @@ class Sorter {
   /// Time spent sorting initial runs in memory.
   RuntimeProfile::Counter* in_mem_sort_timer_;
 
+  /// Number of runs that were sorted with the radix sort over normalized keys.
+  RuntimeProfile::Counter* radix_sorted_runs_counter_ = nullptr;
+
+  /// Number of runs that were sorted by comparing normalized key prefixes.
+  RuntimeProfile::Counter* prefix_sorted_runs_counter_ = nullptr;
+
+  /// Number of runs whose normalized keys were sorted in chunks that were then merged,
+  /// by several threads if thread tokens were available.
+  RuntimeProfile::Counter* parallel_sorted_runs_counter_ = nullptr;
+
+  /// Number of threads that were started in addition to the fragment instance thread to
+  /// sort or merge chunks of runs.
+  RuntimeProfile::Counter* parallel_sort_workers_counter_ = nullptr;
+
   /// Total size of the initial runs in bytes.
   RuntimeProfile::Counter* sorted_data_size_;
 
@@ -216,7 +216,8 @@ TEST(QueryOptions, SetEnumOptions) {
     MAKE_OPTIONDEF(key), {ENTRIES(enumtype, BOOST_PP_TUPLE_TO_SEQ(enums))}}
 
   TQueryOptions options;
-  TestEnumCase(options, CASE(prefetch_mode, TPrefetchMode, (NONE, HT_BUCKET)), true);
+  TestEnumCase(options,
+      CASE(prefetch_mode, TPrefetchMode, (NONE, HT_BUCKET, HT_BUCKET_AND_ROW)), true);
   TestEnumCase(options, CASE(default_join_distribution_mode, TJoinDistributionMode,
       (BROADCAST, SHUFFLE)), true);
   TestEnumCase(options, CASE(explain_level, TExplainLevel,
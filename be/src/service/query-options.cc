@@ -1076,6 +1076,59 @@ Status impala::SetQueryOption(const string& key, const string& value,
         query_options->__set_processing_cost_min_threads(min_num);
         break;
       }
+      case TImpalaQueryOptions::HASH_TABLE_TAGGED_PROBING: {
+        query_options->__set_hash_table_tagged_probing(IsTrue(value));
+        break;
+      }
+      case TImpalaQueryOptions::HASH_JOIN_PARALLEL_BUILD: {
+        query_options->__set_hash_join_parallel_build(IsTrue(value));
+        break;
+      }
+      case TImpalaQueryOptions::GROUPING_AGG_BATCH_UPDATE: {
+        query_options->__set_grouping_agg_batch_update(IsTrue(value));
+        break;
+      }
+      case TImpalaQueryOptions::ADAPTIVE_STREAMING_PREAGGREGATION: {
+        query_options->__set_adaptive_streaming_preaggregation(IsTrue(value));
+        break;
+      }
+      case TImpalaQueryOptions::EXCHANGE_COLUMNAR_SERIALIZATION: {
+        query_options->__set_exchange_columnar_serialization(IsTrue(value));
+        break;
+      }
+      case TImpalaQueryOptions::EXCHANGE_COMPRESSION_CODEC: {
+        THdfsCompression::type enum_type;
+        int compression_level;
+        RETURN_IF_ERROR(
+            ParseUtil::ParseCompressionCodec(value, &enum_type, &compression_level));
+        if (enum_type != THdfsCompression::NONE && enum_type != THdfsCompression::LZ4
+            && enum_type != THdfsCompression::ZSTD) {
+          return Status(Substitute("Invalid exchange compression codec: '$0'. Valid "
+              "values are NONE, LZ4 and ZSTD.", value));
+        }
+        TCompressionCodec compression_codec;
+        compression_codec.__set_codec(enum_type);
+        if (enum_type == THdfsCompression::ZSTD) {
+          compression_codec.__set_compression_level(compression_level);
+        }
+        query_options->__set_exchange_compression_codec(compression_codec);
+        break;
+      }
+      case TImpalaQueryOptions::ADAPTIVE_EXCHANGE_COMPRESSION: {
+        query_options->__set_adaptive_exchange_compression(IsTrue(value));
+        break;
+      }
+      case TImpalaQueryOptions::HASH_JOIN_SKEW_FANOUT: {
+        int32_t int32_t_val = 0;
+        RETURN_IF_ERROR(QueryOptionParser::ParseAndCheckInclusiveRange<int32_t>(
+            option, value, 0, 16, &int32_t_val));
+        query_options->__set_hash_join_skew_fanout(int32_t_val);
+        break;
+      }
+      case TImpalaQueryOptions::TOPN_RUNTIME_FILTER: {
+        query_options->__set_topn_runtime_filter(IsTrue(value));
+        break;
+      }
       default:
         if (IsRemovedQueryOption(key)) {
           LOG(WARNING) << "Ignoring attempt to set removed query option '" << key << "'";
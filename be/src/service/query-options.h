@@ -50,7 +50,7 @@ typedef std::unordered_map<string, beeswax::TQueryOptionLevel::type>
 // time we add or remove a query option to/from the enum TImpalaQueryOptions.
 #define QUERY_OPTS_TABLE                                                                 \
   DCHECK_EQ(_TImpalaQueryOptions_VALUES_TO_NAMES.size(),                                 \
-      TImpalaQueryOptions::PROCESSING_COST_MIN_THREADS + 1);                             \
+      TImpalaQueryOptions::TOPN_RUNTIME_FILTER + 1);                                     \
   REMOVED_QUERY_OPT_FN(abort_on_default_limit_exceeded, ABORT_ON_DEFAULT_LIMIT_EXCEEDED) \
   QUERY_OPT_FN(abort_on_error, ABORT_ON_ERROR, TQueryOptionLevel::REGULAR)               \
   REMOVED_QUERY_OPT_FN(allow_unsupported_formats, ALLOW_UNSUPPORTED_FORMATS)             \
@@ -287,7 +287,24 @@ typedef std::unordered_map<string, beeswax::TQueryOptionLevel::type>
   QUERY_OPT_FN(                                                                          \
       compute_processing_cost, COMPUTE_PROCESSING_COST, TQueryOptionLevel::ADVANCED)     \
   QUERY_OPT_FN(processing_cost_min_threads, PROCESSING_COST_MIN_THREADS,                 \
-      TQueryOptionLevel::ADVANCED);
+      TQueryOptionLevel::ADVANCED)                                                       \
+  QUERY_OPT_FN(                                                                          \
+      hash_table_tagged_probing, HASH_TABLE_TAGGED_PROBING, TQueryOptionLevel::ADVANCED) \
+  QUERY_OPT_FN(                                                                          \
+      hash_join_parallel_build, HASH_JOIN_PARALLEL_BUILD, TQueryOptionLevel::ADVANCED)   \
+  QUERY_OPT_FN(                                                                          \
+      grouping_agg_batch_update, GROUPING_AGG_BATCH_UPDATE, TQueryOptionLevel::ADVANCED) \
+  QUERY_OPT_FN(adaptive_streaming_preaggregation, ADAPTIVE_STREAMING_PREAGGREGATION,     \
+      TQueryOptionLevel::ADVANCED)                                                       \
+  QUERY_OPT_FN(exchange_columnar_serialization, EXCHANGE_COLUMNAR_SERIALIZATION,         \
+      TQueryOptionLevel::ADVANCED)                                                       \
+  QUERY_OPT_FN(exchange_compression_codec, EXCHANGE_COMPRESSION_CODEC,                   \
+      TQueryOptionLevel::ADVANCED)                                                       \
+  QUERY_OPT_FN(adaptive_exchange_compression, ADAPTIVE_EXCHANGE_COMPRESSION,             \
+      TQueryOptionLevel::ADVANCED)                                                       \
+  QUERY_OPT_FN(                                                                          \
+      hash_join_skew_fanout, HASH_JOIN_SKEW_FANOUT, TQueryOptionLevel::ADVANCED)         \
+  QUERY_OPT_FN(topn_runtime_filter, TOPN_RUNTIME_FILTER, TQueryOptionLevel::ADVANCED);
 
 /// Enforce practical limits on some query options to avoid undesired query state.
 static const int64_t SPILLABLE_BUFFER_LIMIT = 1LL << 40; // 1 TB
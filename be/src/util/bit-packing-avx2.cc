@@ -0,0 +1,211 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+// This file is conditionally compiled with -mavx2 if the compiler supports AVX2. The
+// kernels are only called if CpuInfo reports AVX2 support at run-time.
+
+#include "util/bit-packing-simd.h"
+
+#include <immintrin.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include "common/compiler-util.h"
+
+namespace impala {
+
+template <typename OutType>
+static inline void ALWAYS_INLINE StoreValuesAVX2(__m256i values, OutType* out);
+
+template <>
+inline void ALWAYS_INLINE StoreValuesAVX2(__m256i values, uint32_t* out) {
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), values);
+}
+
+template <>
+inline void ALWAYS_INLINE StoreValuesAVX2(__m256i values, uint64_t* out) {
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(out),
+      _mm256_cvtepu32_epi64(_mm256_castsi256_si128(values)));
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 4),
+      _mm256_cvtepu32_epi64(_mm256_extracti128_si256(values, 1)));
+}
+
+// Unpacks 'num_batches' * 32 values in groups of 8, one group per iteration. See
+// SimdUnpackTable for a description of the algorithm.
+template <typename OutType>
+static const uint8_t* UnpackBatchesAVX2Impl(int bit_width,
+    const uint8_t* __restrict__ in, int64_t num_batches, OutType* __restrict__ out) {
+  const SimdUnpackTable& table = GetSimdUnpackTable(bit_width);
+  const __m256i shuffle_lo =
+      _mm256_load_si256(reinterpret_cast<const __m256i*>(table.shuffle_lo));
+  const __m256i shuffle_hi =
+      _mm256_load_si256(reinterpret_cast<const __m256i*>(table.shuffle_hi));
+  const __m256i shift_right =
+      _mm256_load_si256(reinterpret_cast<const __m256i*>(table.shift_right));
+  const __m256i shift_left =
+      _mm256_load_si256(reinterpret_cast<const __m256i*>(table.shift_left));
+  const __m256i mask = _mm256_set1_epi32(table.mask);
+  const int lane1_offset = table.lane_offset[1];
+
+  const int64_t num_groups = num_batches * 4;
+  for (int64_t i = 0; i < num_groups; ++i) {
+    const __m256i data = _mm256_inserti128_si256(
+        _mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in))),
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + lane1_offset)), 1);
+    const __m256i lo =
+        _mm256_srlv_epi32(_mm256_shuffle_epi8(data, shuffle_lo), shift_right);
+    const __m256i hi =
+        _mm256_sllv_epi32(_mm256_shuffle_epi8(data, shuffle_hi), shift_left);
+    StoreValuesAVX2(_mm256_and_si256(_mm256_or_si256(lo, hi), mask), out);
+    in += bit_width;
+    out += 8;
+  }
+  // For SSE compatibility, unset the high bits of each YMM register so SSE instructions
+  // dont have to save them off before using XMM registers.
+  _mm256_zeroupper();
+  return in;
+}
+
+const uint8_t* UnpackBatchesAVX2(int bit_width,
+    const uint8_t* __restrict__ in, int64_t num_batches, uint32_t* __restrict__ out) {
+  return UnpackBatchesAVX2Impl(bit_width, in, num_batches, out);
+}
+
+const uint8_t* UnpackBatchesAVX2(int bit_width,
+    const uint8_t* __restrict__ in, int64_t num_batches, uint64_t* __restrict__ out) {
+  return UnpackBatchesAVX2Impl(bit_width, in, num_batches, out);
+}
+
+// Returns true if all 32-bit lanes of 'indices' are <= 'max_index'.
+static inline bool ALWAYS_INLINE IndicesInRange(__m256i indices, __m256i max_index) {
+  const __m256i in_range = _mm256_cmpeq_epi32(_mm256_max_epu32(indices, max_index),
+      max_index);
+  return _mm256_movemask_epi8(in_range) == -1;
+}
+
+// Stores the 'NUM_VALUES' values of 'values' to 'out' with 'stride' bytes between them.
+template <typename T, int NUM_VALUES>
+static inline void ALWAYS_INLINE StoreStrided(__m256i values, uint8_t* out,
+    int64_t stride) {
+  if (stride == sizeof(T)) {
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), values);
+    return;
+  }
+  T tmp[NUM_VALUES] __attribute__((aligned(32)));
+  _mm256_store_si256(reinterpret_cast<__m256i*>(tmp), values);
+  for (int i = 0; i < NUM_VALUES; ++i) memcpy(out + i * stride, &tmp[i], sizeof(T));
+}
+
+// Decodes the indices that do not fill a vector one at a time.
+template <typename T>
+static bool DecodeIndicesScalar(const uint32_t* __restrict__ indices, int64_t num_indices,
+    const T* __restrict__ dict, int64_t dict_len, uint8_t* __restrict__ out,
+    int64_t stride) {
+  for (int64_t i = 0; i < num_indices; ++i) {
+    if (UNLIKELY(indices[i] >= dict_len)) return false;
+    memcpy(out + i * stride, &dict[indices[i]], sizeof(T));
+  }
+  return true;
+}
+
+bool DecodeIndicesAVX2(const uint32_t* __restrict__ indices, int64_t num_indices,
+    const uint32_t* __restrict__ dict, int64_t dict_len, uint8_t* __restrict__ out,
+    int64_t stride) {
+  if (dict_len == 0) return num_indices == 0;
+  const __m256i max_index =
+      _mm256_set1_epi32(static_cast<uint32_t>(std::min<int64_t>(dict_len - 1, ~0U)));
+  int64_t i = 0;
+  if (dict_len <= 8) {
+    // The whole dictionary fits in one register.
+    uint32_t padded_dict[8] __attribute__((aligned(32))) = {0};
+    memcpy(padded_dict, dict, dict_len * sizeof(uint32_t));
+    const __m256i dict_vec =
+        _mm256_load_si256(reinterpret_cast<const __m256i*>(padded_dict));
+    for (; i + 8 <= num_indices; i += 8) {
+      const __m256i idx =
+          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(indices + i));
+      if (UNLIKELY(!IndicesInRange(idx, max_index))) return false;
+      StoreStrided<uint32_t, 8>(
+          _mm256_permutevar8x32_epi32(dict_vec, idx), out + i * stride, stride);
+    }
+  } else {
+    const int* gather_base = reinterpret_cast<const int*>(dict);
+    for (; i + 8 <= num_indices; i += 8) {
+      const __m256i idx =
+          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(indices + i));
+      if (UNLIKELY(!IndicesInRange(idx, max_index))) return false;
+      StoreStrided<uint32_t, 8>(
+          _mm256_i32gather_epi32(gather_base, idx, 4), out + i * stride, stride);
+    }
+  }
+  _mm256_zeroupper();
+  return DecodeIndicesScalar(
+      indices + i, num_indices - i, dict, dict_len, out + i * stride, stride);
+}
+
+bool DecodeIndicesAVX2(const uint32_t* __restrict__ indices, int64_t num_indices,
+    const uint64_t* __restrict__ dict, int64_t dict_len, uint8_t* __restrict__ out,
+    int64_t stride) {
+  if (dict_len == 0) return num_indices == 0;
+  const __m256i max_index =
+      _mm256_set1_epi32(static_cast<uint32_t>(std::min<int64_t>(dict_len - 1, ~0U)));
+  int64_t i = 0;
+  if (dict_len <= 4) {
+    // The whole dictionary fits in one register. Each 64-bit value is permuted as a
+    // pair of 32-bit words with indices 2 * index and 2 * index + 1.
+    uint64_t padded_dict[4] __attribute__((aligned(32))) = {0};
+    memcpy(padded_dict, dict, dict_len * sizeof(uint64_t));
+    const __m256i dict_vec =
+        _mm256_load_si256(reinterpret_cast<const __m256i*>(padded_dict));
+    const __m256i word_offsets = _mm256_setr_epi32(0, 1, 0, 1, 0, 1, 0, 1);
+    for (; i + 8 <= num_indices; i += 8) {
+      const __m256i idx =
+          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(indices + i));
+      if (UNLIKELY(!IndicesInRange(idx, max_index))) return false;
+      // Duplicate each index into a pair of 32-bit words, then turn the pair into the
+      // word indices of the 64-bit value.
+      const __m256i doubled = _mm256_add_epi32(idx, idx);
+      const __m256i lo = _mm256_add_epi32(word_offsets, _mm256_permutevar8x32_epi32(
+          doubled, _mm256_setr_epi32(0, 0, 1, 1, 2, 2, 3, 3)));
+      const __m256i hi = _mm256_add_epi32(word_offsets, _mm256_permutevar8x32_epi32(
+          doubled, _mm256_setr_epi32(4, 4, 5, 5, 6, 6, 7, 7)));
+      StoreStrided<uint64_t, 4>(
+          _mm256_permutevar8x32_epi32(dict_vec, lo), out + i * stride, stride);
+      StoreStrided<uint64_t, 4>(
+          _mm256_permutevar8x32_epi32(dict_vec, hi), out + (i + 4) * stride, stride);
+    }
+  } else {
+    const long long* gather_base = reinterpret_cast<const long long*>(dict);
+    for (; i + 8 <= num_indices; i += 8) {
+      const __m256i idx =
+          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(indices + i));
+      if (UNLIKELY(!IndicesInRange(idx, max_index))) return false;
+      StoreStrided<uint64_t, 4>(
+          _mm256_i32gather_epi64(gather_base, _mm256_castsi256_si128(idx), 8),
+          out + i * stride, stride);
+      StoreStrided<uint64_t, 4>(
+          _mm256_i32gather_epi64(gather_base, _mm256_extracti128_si256(idx, 1), 8),
+          out + (i + 4) * stride, stride);
+    }
+  }
+  _mm256_zeroupper();
+  return DecodeIndicesScalar(
+      indices + i, num_indices - i, dict, dict_len, out + i * stride, stride);
+}
+
+} // namespace impala
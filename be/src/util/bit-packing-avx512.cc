@@ -0,0 +1,94 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+// This file is conditionally compiled with -mavx512f -mavx512bw if the compiler supports
+// AVX-512. The kernels are only called if CpuInfo reports AVX512F and AVX512BW support
+// at run-time.
+
+#include "util/bit-packing-simd.h"
+
+#include <immintrin.h>
+
+#include "common/compiler-util.h"
+
+namespace impala {
+
+template <typename OutType>
+static inline void ALWAYS_INLINE StoreValuesAVX512(__m512i values, OutType* out);
+
+template <>
+inline void ALWAYS_INLINE StoreValuesAVX512(__m512i values, uint32_t* out) {
+  _mm512_storeu_si512(out, values);
+}
+
+template <>
+inline void ALWAYS_INLINE StoreValuesAVX512(__m512i values, uint64_t* out) {
+  _mm512_storeu_si512(out, _mm512_cvtepu32_epi64(_mm512_castsi512_si256(values)));
+  _mm512_storeu_si512(
+      out + 8, _mm512_cvtepu32_epi64(_mm512_extracti64x4_epi64(values, 1)));
+}
+
+static inline __m128i ALWAYS_INLINE LoadLane(const uint8_t* in) {
+  return _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+}
+
+// Unpacks 'num_batches' * 32 values in groups of 16, one group per iteration. See
+// SimdUnpackTable for a description of the algorithm.
+template <typename OutType>
+static const uint8_t* UnpackBatchesAVX512Impl(int bit_width,
+    const uint8_t* __restrict__ in, int64_t num_batches, OutType* __restrict__ out) {
+  const SimdUnpackTable& table = GetSimdUnpackTable(bit_width);
+  const __m512i shuffle_lo = _mm512_load_si512(table.shuffle_lo);
+  const __m512i shuffle_hi = _mm512_load_si512(table.shuffle_hi);
+  const __m512i shift_right = _mm512_load_si512(table.shift_right);
+  const __m512i shift_left = _mm512_load_si512(table.shift_left);
+  const __m512i mask = _mm512_set1_epi32(table.mask);
+  const int lane1_offset = table.lane_offset[1];
+  const int lane2_offset = table.lane_offset[2];
+  const int lane3_offset = table.lane_offset[3];
+  // A group of 16 values spans two groups of 8 values, i.e. 2 * 'bit_width' bytes.
+  const int group_bytes = 2 * bit_width;
+
+  const int64_t num_groups = num_batches * 2;
+  for (int64_t i = 0; i < num_groups; ++i) {
+    __m512i data = _mm512_castsi128_si512(LoadLane(in));
+    data = _mm512_inserti32x4(data, LoadLane(in + lane1_offset), 1);
+    data = _mm512_inserti32x4(data, LoadLane(in + lane2_offset), 2);
+    data = _mm512_inserti32x4(data, LoadLane(in + lane3_offset), 3);
+    const __m512i lo =
+        _mm512_srlv_epi32(_mm512_shuffle_epi8(data, shuffle_lo), shift_right);
+    const __m512i hi =
+        _mm512_sllv_epi32(_mm512_shuffle_epi8(data, shuffle_hi), shift_left);
+    StoreValuesAVX512(_mm512_and_si512(_mm512_or_si512(lo, hi), mask), out);
+    in += group_bytes;
+    out += 16;
+  }
+  _mm256_zeroupper();
+  return in;
+}
+
+const uint8_t* UnpackBatchesAVX512(int bit_width,
+    const uint8_t* __restrict__ in, int64_t num_batches, uint32_t* __restrict__ out) {
+  return UnpackBatchesAVX512Impl(bit_width, in, num_batches, out);
+}
+
+const uint8_t* UnpackBatchesAVX512(int bit_width,
+    const uint8_t* __restrict__ in, int64_t num_batches, uint64_t* __restrict__ out) {
+  return UnpackBatchesAVX512Impl(bit_width, in, num_batches, out);
+}
+
+} // namespace impala
@@ -0,0 +1,87 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <cstdint>
+
+/// Shared state of the vectorized bit unpacking kernels in bit-packing-avx2.cc and
+/// bit-packing-avx512.cc. Only meant to be included by the bit-packing sources.
+namespace impala {
+
+/// The kernels unpack groups of 8 (AVX2) or 16 (AVX-512) values. A group of 8 values
+/// always starts on a byte boundary and spans exactly 'bit_width' bytes. Each 128-bit
+/// lane of a vector register unpacks 4 consecutive values: the lane is loaded with the
+/// 16 input bytes starting at the byte that holds the first bit of its first value,
+/// which is enough to hold every bit of all 4 values for bit widths up to 32.
+///
+/// Within a lane, the 32-bit output word for value 'i' is assembled from two byte
+/// shuffles: 'shuffle_lo' gathers the 4 bytes starting at the first byte of the value and
+/// 'shuffle_hi' the 4 bytes after that. The value is then
+///   ((lo >> shift_right) | (hi << shift_left)) & mask
+/// where 'shift_right' is the bit offset of the value in its first byte. Shuffle indices
+/// that fall outside of the lane are set to 0x80 (which zeroes the byte): they are never
+/// needed for the value bits.
+struct SimdUnpackTable {
+  static constexpr int VALUES_PER_TABLE = 16;
+  static constexpr int LANES = VALUES_PER_TABLE / 4;
+
+  uint8_t shuffle_lo[VALUES_PER_TABLE * 4] __attribute__((aligned(64)));
+  uint8_t shuffle_hi[VALUES_PER_TABLE * 4] __attribute__((aligned(64)));
+  uint32_t shift_right[VALUES_PER_TABLE] __attribute__((aligned(64)));
+  uint32_t shift_left[VALUES_PER_TABLE] __attribute__((aligned(64)));
+
+  /// Byte offset of the first input byte of each lane relative to the start of the group.
+  int lane_offset[LANES];
+
+  /// Mask of the low 'bit_width' bits.
+  uint32_t mask;
+};
+
+/// Number of bytes past the end of the last batch that the kernels may load.
+static constexpr int SIMD_UNPACK_READ_PADDING = 16;
+
+/// Returns the table for 'bit_width', which must be between 1 and 32. The tables are
+/// computed once and never freed.
+const SimdUnpackTable& GetSimdUnpackTable(int bit_width);
+
+/// The vectorized kernels. Unpack 'num_batches' full batches of 32 values with
+/// 1 <= 'bit_width' <= 32 and return a pointer to the byte after the last batch. May
+/// read up to SIMD_UNPACK_READ_PADDING bytes past the last batch. Only defined if the
+/// compiler supports the instruction set.
+const uint8_t* UnpackBatchesAVX2(int bit_width, const uint8_t* __restrict__ in,
+    int64_t num_batches, uint32_t* __restrict__ out);
+const uint8_t* UnpackBatchesAVX2(int bit_width, const uint8_t* __restrict__ in,
+    int64_t num_batches, uint64_t* __restrict__ out);
+const uint8_t* UnpackBatchesAVX512(int bit_width, const uint8_t* __restrict__ in,
+    int64_t num_batches, uint32_t* __restrict__ out);
+const uint8_t* UnpackBatchesAVX512(int bit_width, const uint8_t* __restrict__ in,
+    int64_t num_batches, uint64_t* __restrict__ out);
+
+/// Vectorized dictionary decoding with AVX2. Writes 'dict'['indices'[i]] for
+/// 0 <= i < 'num_indices' to 'out' + i * 'stride'. Dictionaries that fit in a single
+/// vector register are decoded with a permute, larger ones with gathers. Returns false
+/// without decoding the rest of the values as soon as an index >= 'dict_len' is found.
+/// Only defined if the compiler supports AVX2.
+bool DecodeIndicesAVX2(const uint32_t* __restrict__ indices, int64_t num_indices,
+    const uint32_t* __restrict__ dict, int64_t dict_len, uint8_t* __restrict__ out,
+    int64_t stride);
+bool DecodeIndicesAVX2(const uint32_t* __restrict__ indices, int64_t num_indices,
+    const uint64_t* __restrict__ dict, int64_t dict_len, uint8_t* __restrict__ out,
+    int64_t stride);
+
+} // namespace impala
@@ -18,6 +18,7 @@
 #include <algorithm>
 #include <cstdio>
 #include <cstdlib>
+#include <numeric>
 #include <random>
 #include <unordered_map>
 
@@ -26,6 +27,7 @@
 #include "testutil/mem-util.h"
 #include "util/bit-packing.h"
 #include "util/bit-stream-utils.inline.h"
+#include "util/cpu-info.h"
 
 #include "common/names.h"
 
@@ -201,6 +203,24 @@ TEST(BitPackingTest, RandomUnpack64) {
   RandomUnpackTest<uint64_t>();
 }
 
+// The tests above use the vectorized kernels if the CPU supports them. Also test the
+// AVX2 kernels on AVX-512 capable CPUs and the scalar code on all CPUs.
+TEST(BitPackingTest, RandomUnpackAVX2) {
+  CpuInfo::TempDisable disable_avx512(CpuInfo::AVX512BW);
+  RandomUnpackTest<uint32_t>();
+  RandomUnpackTest<uint64_t>();
+}
+
+TEST(BitPackingTest, RandomUnpackScalar) {
+  CpuInfo::TempDisable disable_avx512(CpuInfo::AVX512BW);
+  CpuInfo::TempDisable disable_avx2(CpuInfo::AVX2);
+  for (int bit_width = 1; bit_width <= BitPacking::MAX_DICT_BITWIDTH; ++bit_width) {
+    EXPECT_FALSE(BitPacking::SupportsSimdUnpacking(bit_width));
+  }
+  RandomUnpackTest<uint32_t>();
+  RandomUnpackTest<uint64_t>();
+}
+
 // This is not the full dictionary encoding, only a big bit-packed literal run, no RLE is
 // used.
 template <typename T>
@@ -319,4 +339,45 @@ TEST(BitPackingTest, RandomUnpackAndDecode64) {
   RandomUnpackAndDecodeTest<uint64_t>();
 }
 
+// Test that an out-of-range index in the middle of a long literal run is detected, both
+// for dictionaries that fit in a vector register and for larger ones.
+template <typename UINT_T>
+void UnpackAndDecodeOutOfRangeTest() {
+  constexpr int BIT_WIDTH = 5;
+  constexpr int NUM_VALUES = 1000;
+  for (const int dict_len : {3, 20}) {
+    std::vector<UINT_T> dict(dict_len);
+    std::iota(dict.begin(), dict.end(), 1);
+    std::vector<uint8_t> data(BitUtil::RoundUpNumBytes(NUM_VALUES * BIT_WIDTH));
+    BitWriter writer(data.data(), data.size());
+    for (int i = 0; i < NUM_VALUES; ++i) {
+      ASSERT_TRUE(writer.PutValue(i == NUM_VALUES / 2 ? dict_len : i % dict_len,
+          BIT_WIDTH));
+    }
+    writer.Flush();
+    std::vector<UINT_T> out(NUM_VALUES);
+    bool decode_error = false;
+    BitPacking::UnpackAndDecodeValues<UINT_T>(BIT_WIDTH, data.data(), data.size(),
+        dict.data(), dict.size(), NUM_VALUES, out.data(), sizeof(UINT_T),
+        &decode_error);
+    EXPECT_TRUE(decode_error) << "dict_len: " << dict_len;
+  }
+}
+
+TEST(BitPackingTest, UnpackAndDecodeOutOfRange) {
+  UnpackAndDecodeOutOfRangeTest<uint32_t>();
+  UnpackAndDecodeOutOfRangeTest<uint64_t>();
+  CpuInfo::TempDisable disable_avx512(CpuInfo::AVX512BW);
+  CpuInfo::TempDisable disable_avx2(CpuInfo::AVX2);
+  UnpackAndDecodeOutOfRangeTest<uint32_t>();
+  UnpackAndDecodeOutOfRangeTest<uint64_t>();
+}
+
+TEST(BitPackingTest, RandomUnpackAndDecodeScalar) {
+  CpuInfo::TempDisable disable_avx512(CpuInfo::AVX512BW);
+  CpuInfo::TempDisable disable_avx2(CpuInfo::AVX2);
+  RandomUnpackAndDecodeTest<uint32_t>();
+  RandomUnpackAndDecodeTest<uint64_t>();
+}
+
 }
@@ -21,9 +21,129 @@
 #include "runtime/decimal-value.h"
 #include "runtime/string-value.h"
 #include "runtime/timestamp-value.h"
+#include "util/bit-packing-simd.h"
+#include "util/cpu-info.h"
 
 namespace impala {
 
+static SimdUnpackTable* ComputeSimdUnpackTables() {
+  // Index 0 is unused since there is nothing to unpack for bit width 0.
+  SimdUnpackTable* tables = new SimdUnpackTable[BitPacking::MAX_DICT_BITWIDTH + 1];
+  for (int bit_width = 1; bit_width <= BitPacking::MAX_DICT_BITWIDTH; ++bit_width) {
+    SimdUnpackTable* table = &tables[bit_width];
+    for (int lane = 0; lane < SimdUnpackTable::LANES; ++lane) {
+      table->lane_offset[lane] = (lane * 4 * bit_width) / CHAR_BIT;
+    }
+    for (int i = 0; i < SimdUnpackTable::VALUES_PER_TABLE; ++i) {
+      const int lane = i / 4;
+      const int first_bit = i * bit_width;
+      const int first_byte = first_bit / CHAR_BIT - table->lane_offset[lane];
+      for (int j = 0; j < 4; ++j) {
+        const int lo_byte = first_byte + j;
+        const int hi_byte = first_byte + 4 + j;
+        table->shuffle_lo[i * 4 + j] = lo_byte < 16 ? lo_byte : 0x80;
+        table->shuffle_hi[i * 4 + j] = hi_byte < 16 ? hi_byte : 0x80;
+      }
+      table->shift_right[i] = first_bit % CHAR_BIT;
+      table->shift_left[i] = 32 - table->shift_right[i];
+    }
+    table->mask = bit_width == 32 ? ~0U : (1U << bit_width) - 1;
+  }
+  return tables;
+}
+
+const SimdUnpackTable& GetSimdUnpackTable(int bit_width) {
+  DCHECK_GE(bit_width, 1);
+  DCHECK_LE(bit_width, BitPacking::MAX_DICT_BITWIDTH);
+  static const SimdUnpackTable* tables = ComputeSimdUnpackTables();
+  return tables[bit_width];
+}
+
+#ifdef USE_AVX512
+static bool HasAvx512() {
+  return CpuInfo::IsSupported(CpuInfo::AVX512F)
+      && CpuInfo::IsSupported(CpuInfo::AVX512BW);
+}
+#endif
+
+bool BitPacking::SupportsSimdUnpacking(int bit_width) {
+  if (bit_width < 1 || bit_width > MAX_DICT_BITWIDTH) return false;
+#ifdef USE_AVX512
+  if (HasAvx512()) return true;
+#endif
+#ifdef USE_AVX2
+  if (CpuInfo::IsSupported(CpuInfo::AVX2)) return true;
+#endif
+  return false;
+}
+
+template <typename OutType>
+static std::pair<const uint8_t*, int64_t> UnpackValuesSimdImpl(int bit_width,
+    const uint8_t* __restrict__ in, int64_t in_bytes, int64_t num_values,
+    OutType* __restrict__ out) {
+  if (!BitPacking::SupportsSimdUnpacking(bit_width)
+      || in_bytes < SIMD_UNPACK_READ_PADDING) {
+    return std::make_pair(in, 0);
+  }
+  // A batch of 32 values is 4 * 'bit_width' bytes.
+  const int64_t num_batches = std::min(
+      num_values / 32, (in_bytes - SIMD_UNPACK_READ_PADDING) / (4 * bit_width));
+  if (num_batches == 0) return std::make_pair(in, 0);
+#ifdef USE_AVX512
+  if (HasAvx512()) {
+    return std::make_pair(
+        UnpackBatchesAVX512(bit_width, in, num_batches, out), num_batches * 32);
+  }
+#endif
+#ifdef USE_AVX2
+  return std::make_pair(
+      UnpackBatchesAVX2(bit_width, in, num_batches, out), num_batches * 32);
+#else
+  DCHECK(false) << "No vectorized kernel for bit width " << bit_width;
+  return std::make_pair(in, 0);
+#endif
+}
+
+std::pair<const uint8_t*, int64_t> BitPacking::UnpackValuesSimd(int bit_width,
+    const uint8_t* __restrict__ in, int64_t in_bytes, int64_t num_values,
+    uint32_t* __restrict__ out) {
+  return UnpackValuesSimdImpl(bit_width, in, in_bytes, num_values, out);
+}
+
+std::pair<const uint8_t*, int64_t> BitPacking::UnpackValuesSimd(int bit_width,
+    const uint8_t* __restrict__ in, int64_t in_bytes, int64_t num_values,
+    uint64_t* __restrict__ out) {
+  return UnpackValuesSimdImpl(bit_width, in, in_bytes, num_values, out);
+}
+
+bool BitPacking::DecodeIndicesSimd(const uint32_t* __restrict__ indices,
+    int64_t num_indices, const uint32_t* __restrict__ dict, int64_t dict_len,
+    uint8_t* __restrict__ out, int64_t stride, bool* __restrict__ decode_error) {
+#ifdef USE_AVX2
+  if (CpuInfo::IsSupported(CpuInfo::AVX2)) {
+    if (!DecodeIndicesAVX2(indices, num_indices, dict, dict_len, out, stride)) {
+      *decode_error = true;
+    }
+    return true;
+  }
+#endif
+  return false;
+}
+
+bool BitPacking::DecodeIndicesSimd(const uint32_t* __restrict__ indices,
+    int64_t num_indices, const uint64_t* __restrict__ dict, int64_t dict_len,
+    uint8_t* __restrict__ out, int64_t stride, bool* __restrict__ decode_error) {
+#ifdef USE_AVX2
+  if (CpuInfo::IsSupported(CpuInfo::AVX2)) {
+    if (!DecodeIndicesAVX2(indices, num_indices, dict, dict_len, out, stride)) {
+      *decode_error = true;
+    }
+    return true;
+  }
+#endif
+  return false;
+}
+
 // Instantiate all of the templated functions needed by the rest of Impala.
 #define INSTANTIATE_UNPACK_VALUES(OUT_TYPE)                                       \
   template std::pair<const uint8_t*, int64_t> BitPacking::UnpackValues<OUT_TYPE>( \
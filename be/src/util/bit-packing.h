@@ -44,6 +44,12 @@ namespace impala {
 /// The batched unpacking functions operate on batches of 32 values. This batch size
 /// is convenient because for every supported bit width, the end of a 32 value batch
 /// falls on a byte boundary. It is also large enough to amortise loop overheads.
+///
+/// For bit widths from 1 to 32 and 32 or 64-bit outputs, UnpackValues() and
+/// UnpackAndDecodeValues() unpack full batches with AVX2 or AVX-512 kernels if the CPU
+/// supports them (see bit-packing-simd.h). The scalar template code handles everything
+/// else, including the trailing bytes of the input that the vector loads cannot reach
+/// without reading past the end of the buffer.
 class BitPacking {
  public:
   static constexpr int MAX_BITWIDTH = sizeof(uint64_t) * 8;
@@ -127,7 +133,61 @@ class BitPacking {
       int64_t in_bytes, OutType* __restrict__ dict, int64_t dict_len, int num_values,
       OutType* __restrict__ out, int64_t stride, bool* __restrict__ decode_error);
 
+  /// Returns true if the vectorized kernels can unpack values of 'bit_width' on this
+  /// CPU. Respects features disabled through CpuInfo::TempDisable.
+  static bool SupportsSimdUnpacking(int bit_width);
+
  private:
+  /// Unpacks as many full batches of 32 values as possible with the vectorized kernels,
+  /// if SupportsSimdUnpacking(bit_width). Never reads past 'in' + 'in_bytes', so it may
+  /// stop before unpacking all values that the input holds. Returns a pointer to the
+  /// byte after the last byte that was read and the number of values that were
+  /// unpacked, which is a multiple of 32 and possibly zero. The scalar code must unpack
+  /// the rest.
+  static std::pair<const uint8_t*, int64_t> UnpackValuesSimd(int bit_width,
+      const uint8_t* __restrict__ in, int64_t in_bytes, int64_t num_values,
+      uint32_t* __restrict__ out);
+  static std::pair<const uint8_t*, int64_t> UnpackValuesSimd(int bit_width,
+      const uint8_t* __restrict__ in, int64_t in_bytes, int64_t num_values,
+      uint64_t* __restrict__ out);
+
+  /// There are no vectorized kernels for narrower output types.
+  template <typename OutType>
+  static std::pair<const uint8_t*, int64_t> UnpackValuesSimd(int bit_width,
+      const uint8_t* __restrict__ in, int64_t in_bytes, int64_t num_values,
+      OutType* __restrict__ out) {
+    return std::make_pair(in, 0);
+  }
+
+  /// Same as UnpackAndDecodeValues() but first unpacks the dictionary indices of full
+  /// batches into a temporary buffer with UnpackValuesSimd(). Returns the same as
+  /// UnpackValuesSimd().
+  template <typename OutType>
+  static std::pair<const uint8_t*, int64_t> UnpackAndDecodeValuesSimd(int bit_width,
+      const uint8_t* __restrict__ in, int64_t in_bytes, OutType* __restrict__ dict,
+      int64_t dict_len, int64_t num_values, OutType* __restrict__ out, int64_t stride,
+      bool* __restrict__ decode_error);
+
+  /// Decodes 'num_indices' unpacked dictionary indices into 'out' with a stride of
+  /// 'stride' bytes using the vectorized AVX2 kernels, which handle dictionaries of
+  /// 32 and 64-bit values. Returns false if the CPU does not support them, leaving
+  /// 'out' untouched. Otherwise returns true and sets 'decode_error' to true if one of
+  /// the indices was out of range.
+  static bool DecodeIndicesSimd(const uint32_t* __restrict__ indices,
+      int64_t num_indices, const uint32_t* __restrict__ dict, int64_t dict_len,
+      uint8_t* __restrict__ out, int64_t stride, bool* __restrict__ decode_error);
+  static bool DecodeIndicesSimd(const uint32_t* __restrict__ indices,
+      int64_t num_indices, const uint64_t* __restrict__ dict, int64_t dict_len,
+      uint8_t* __restrict__ out, int64_t stride, bool* __restrict__ decode_error);
+
+  /// Decodes 'num_indices' unpacked dictionary indices into 'out' with a stride of
+  /// 'stride' bytes, using DecodeIndicesSimd() for types that can be copied as a 32 or
+  /// 64-bit word.
+  template <typename OutType>
+  static void DecodeIndices(const uint32_t* __restrict__ indices, int64_t num_indices,
+      const OutType* __restrict__ dict, int64_t dict_len, uint8_t* __restrict__ out,
+      int64_t stride, bool* __restrict__ decode_error);
+
   /// Compute the number of values with the given bit width that can be unpacked from
   /// an input buffer of 'in_bytes' into an output buffer with space for 'num_values'.
   static int64_t NumValuesToUnpack(int bit_width, int64_t in_bytes, int64_t num_values);
@@ -63,10 +63,24 @@ std::pair<const uint8_t*, int64_t> BitPacking::UnpackValues(int bit_width,
   static_assert(IsSupportedUnpackingType<OutType>(),
       "Only unsigned integers are supported.");
 
+  // Unpack the bulk of the values with the vectorized kernels if possible and leave the
+  // rest to the scalar code.
+  const std::pair<const uint8_t*, int64_t> simd_result =
+      UnpackValuesSimd(bit_width, in, in_bytes, num_values, out);
+  const int64_t simd_values = simd_result.second;
+  if (simd_values > 0) {
+    in_bytes -= simd_result.first - in;
+    in = simd_result.first;
+    num_values -= simd_values;
+    out += simd_values;
+  }
+
+  std::pair<const uint8_t*, int64_t> result;
 #pragma push_macro("UNPACK_VALUES_CASE")
-#define UNPACK_VALUES_CASE(ignore1, i, ignore2) \
-  case i:                                       \
-    return UnpackValues<OutType, i>(in, in_bytes, num_values, out);
+#define UNPACK_VALUES_CASE(ignore1, i, ignore2)                      \
+  case i:                                                            \
+    result = UnpackValues<OutType, i>(in, in_bytes, num_values, out); \
+    break;
 
   switch (bit_width) {
     // Expand cases from 0 to 64.
@@ -76,6 +90,8 @@ std::pair<const uint8_t*, int64_t> BitPacking::UnpackValues(int bit_width,
       return std::make_pair(nullptr, -1);
   }
 #pragma pop_macro("UNPACK_VALUES_CASE")
+  result.second += simd_values;
+  return result;
 }
 
 template <typename OutType, int BIT_WIDTH>
@@ -112,11 +128,24 @@ std::pair<const uint8_t*, int64_t> BitPacking::UnpackAndDecodeValues(int bit_wid
     const uint8_t* __restrict__ in, int64_t in_bytes, OutType* __restrict__ dict,
     int64_t dict_len, int64_t num_values, OutType* __restrict__ out, int64_t stride,
     bool* __restrict__ decode_error) {
+  const std::pair<const uint8_t*, int64_t> simd_result = UnpackAndDecodeValuesSimd(
+      bit_width, in, in_bytes, dict, dict_len, num_values, out, stride, decode_error);
+  const int64_t simd_values = simd_result.second;
+  if (simd_values > 0) {
+    in_bytes -= simd_result.first - in;
+    in = simd_result.first;
+    num_values -= simd_values;
+    out = reinterpret_cast<OutType*>(reinterpret_cast<uint8_t*>(out)
+        + simd_values * stride);
+  }
+
+  std::pair<const uint8_t*, int64_t> result;
 #pragma push_macro("UNPACK_VALUES_CASE")
-#define UNPACK_VALUES_CASE(ignore1, i, ignore2) \
-  case i:                                       \
-    return UnpackAndDecodeValues<OutType, i>(   \
-        in, in_bytes, dict, dict_len, num_values, out, stride, decode_error);
+#define UNPACK_VALUES_CASE(ignore1, i, ignore2)                                   \
+  case i:                                                                         \
+    result = UnpackAndDecodeValues<OutType, i>(                                   \
+        in, in_bytes, dict, dict_len, num_values, out, stride, decode_error);    \
+    break;
 
   switch (bit_width) {
     // Expand cases from 0 to MAX_DICT_BITWIDTH.
@@ -126,7 +155,10 @@ std::pair<const uint8_t*, int64_t> BitPacking::UnpackAndDecodeValues(int bit_wid
       return std::make_pair(nullptr, -1);
   }
 #pragma pop_macro("UNPACK_VALUES_CASE")
+  result.second += simd_values;
+  return result;
 }
+
 template <typename OutType, int BIT_WIDTH>
 std::pair<const uint8_t*, int64_t> BitPacking::UnpackAndDecodeValues(
     const uint8_t* __restrict__ in, int64_t in_bytes, OutType* __restrict__ dict,
@@ -240,6 +272,52 @@ inline void ALWAYS_INLINE DecodeValue(OutType* __restrict__ dict, int64_t dict_l
   }
 }
 
+template <typename OutType>
+void BitPacking::DecodeIndices(const uint32_t* __restrict__ indices,
+    int64_t num_indices, const OutType* __restrict__ dict, int64_t dict_len,
+    uint8_t* __restrict__ out, int64_t stride, bool* __restrict__ decode_error) {
+  // Values that are plain 32 or 64-bit words can be decoded with the vectorized
+  // kernels.
+  constexpr bool IS_WORD = std::is_trivially_copyable<OutType>::value
+      && (sizeof(OutType) == sizeof(uint32_t) || sizeof(OutType) == sizeof(uint64_t));
+  using WordType = typename std::conditional<sizeof(OutType) == sizeof(uint32_t),
+      uint32_t, uint64_t>::type;
+  if (IS_WORD && DecodeIndicesSimd(indices, num_indices,
+          reinterpret_cast<const WordType*>(dict), dict_len, out, stride,
+          decode_error)) {
+    return;
+  }
+  for (int64_t i = 0; i < num_indices; ++i) {
+    DecodeValue(const_cast<OutType*>(dict), dict_len, indices[i],
+        reinterpret_cast<OutType*>(out + i * stride), decode_error);
+  }
+}
+
+template <typename OutType>
+std::pair<const uint8_t*, int64_t> BitPacking::UnpackAndDecodeValuesSimd(int bit_width,
+    const uint8_t* __restrict__ in, int64_t in_bytes, OutType* __restrict__ dict,
+    int64_t dict_len, int64_t num_values, OutType* __restrict__ out, int64_t stride,
+    bool* __restrict__ decode_error) {
+  if (num_values < 32 || !SupportsSimdUnpacking(bit_width)) return std::make_pair(in, 0);
+  // Unpack the indices in chunks that fit comfortably in L1 cache.
+  constexpr int64_t MAX_CHUNK_SIZE = 256;
+  uint32_t indices[MAX_CHUNK_SIZE];
+  const uint8_t* in_pos = in;
+  uint8_t* out_pos = reinterpret_cast<uint8_t*>(out);
+  int64_t values_decoded = 0;
+  while (num_values - values_decoded >= 32) {
+    const int64_t chunk_size = std::min(MAX_CHUNK_SIZE, num_values - values_decoded);
+    const std::pair<const uint8_t*, int64_t> chunk = UnpackValuesSimd(
+        bit_width, in_pos, in_bytes - (in_pos - in), chunk_size, indices);
+    if (chunk.second == 0) break;
+    DecodeIndices(indices, chunk.second, dict, dict_len, out_pos, stride, decode_error);
+    out_pos += chunk.second * stride;
+    in_pos = chunk.first;
+    values_decoded += chunk.second;
+  }
+  return std::make_pair(in_pos, values_decoded);
+}
+
 template <typename OutType, int BIT_WIDTH>
 const uint8_t* BitPacking::Unpack32Values(
     const uint8_t* __restrict__ in, int64_t in_bytes, OutType* __restrict__ out) {
@@ -375,6 +375,8 @@ class DictDecoder : public DictDecoderBase {
   /// Batched version of GetNextValue(). Reads the next 'count' values into
   /// 'first_values'. Returns false if the data was invalid and 'count' values could not
   /// be successfully read. 'stride' is the stride in bytes between each subsequent value.
+  /// Literal runs of 32 and 64-bit values are decoded with vectorized gathers or, for
+  /// small dictionaries, register permutes if the CPU supports AVX2 (see BitPacking).
   bool GetNextValues(T* first_value, int64_t stride, int count) WARN_UNUSED_RESULT;
 
   /// This function returns the size in bytes of the dictionary vector.
@@ -128,6 +128,18 @@ class ImpaladMetricKeys {
   /// buffer size limit.
   static const char* IO_MGR_REMOTE_DATA_CACHE_ASYNC_WRITES_DROPPED_ENTRIES;
 
+  /// Total number of bytes not inserted in the remote data cache because the admission
+  /// policy rejected them.
+  static const char* IO_MGR_REMOTE_DATA_CACHE_ADMISSION_REJECTED_BYTES;
+
+  /// Total number of entries not inserted in the remote data cache because the admission
+  /// policy rejected them.
+  static const char* IO_MGR_REMOTE_DATA_CACHE_ADMISSION_REJECTED_ENTRIES;
+
+  /// Total number of bytes of evicted entries in the remote data cache whose space has
+  /// not been reclaimed from the backing files yet.
+  static const char* IO_MGR_REMOTE_DATA_CACHE_PENDING_EVICTION_BYTES;
+
   /// Total number of bytes written to disk by the io mgr (for spilling)
   static const char* IO_MGR_BYTES_WRITTEN;
 
@@ -292,6 +304,8 @@ class ImpaladMetrics {
   static IntCounter* IO_MGR_REMOTE_DATA_CACHE_NUM_ASYNC_WRITES_SUBMITTED;
   static IntCounter* IO_MGR_REMOTE_DATA_CACHE_ASYNC_WRITES_DROPPED_BYTES;
   static IntCounter* IO_MGR_REMOTE_DATA_CACHE_ASYNC_WRITES_DROPPED_ENTRIES;
+  static IntCounter* IO_MGR_REMOTE_DATA_CACHE_ADMISSION_REJECTED_BYTES;
+  static IntCounter* IO_MGR_REMOTE_DATA_CACHE_ADMISSION_REJECTED_ENTRIES;
   static IntCounter* IO_MGR_SHORT_CIRCUIT_BYTES_READ;
   static IntCounter* IO_MGR_BYTES_WRITTEN;
   static IntCounter* IO_MGR_CACHED_FILE_HANDLES_REOPENED;
@@ -329,6 +343,7 @@ class ImpaladMetrics {
   static IntGauge* IO_MGR_CACHED_FILE_HANDLES_MISS_COUNT;
   static IntGauge* IO_MGR_REMOTE_DATA_CACHE_TOTAL_BYTES;
   static IntGauge* IO_MGR_REMOTE_DATA_CACHE_NUM_ENTRIES;
+  static IntGauge* IO_MGR_REMOTE_DATA_CACHE_PENDING_EVICTION_BYTES;
   static IntGauge* NUM_FILES_OPEN_FOR_INSERT;
   static IntGauge* NUM_QUERIES_REGISTERED;
   static IntGauge* RESULTSET_CACHE_TOTAL_NUM_ROWS;
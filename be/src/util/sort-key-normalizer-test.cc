@@ -0,0 +1,324 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <cmath>
+#include <limits>
+#include <random>
+
+#include <boost/scoped_ptr.hpp>
+
+#include "exprs/slot-ref.h"
+#include "runtime/mem-pool.h"
+#include "runtime/mem-tracker.h"
+#include "runtime/string-value.h"
+#include "runtime/test-env.h"
+#include "runtime/timestamp-value.h"
+#include "runtime/tuple-row.h"
+#include "runtime/types.h"
+#include "testutil/gtest-util.h"
+#include "util/sort-key-normalizer.h"
+#include "util/tuple-row-compare.h"
+
+#include "common/names.h"
+
+namespace impala {
+
+class SortKeyNormalizerTest : public testing::Test {
+ public:
+  SortKeyNormalizerTest() : expr_perm_pool_(&tracker_), expr_results_pool_(&tracker_) {}
+
+ protected:
+  scoped_ptr<TestEnv> test_env_;
+  RowDescriptor desc_;
+  ObjectPool pool_;
+  MemTracker tracker_;
+  MemPool expr_perm_pool_;
+  MemPool expr_results_pool_;
+
+  TSortInfo sort_info_;
+  vector<ScalarExpr*> ordering_exprs_;
+  scoped_ptr<TupleRowComparatorConfig> config_;
+  scoped_ptr<TupleRowLexicalComparator> comparator_;
+  SortKeyNormalizer* normalizer_ = nullptr;
+
+  /// Size of the tuples created by CreateTuple(). The null indicator byte is at offset
+  /// 0, slots start at offset 1.
+  static const int TUPLE_SIZE = 64;
+
+  virtual void SetUp() {
+    test_env_.reset(new TestEnv());
+    ASSERT_OK(test_env_->Init());
+  }
+
+  virtual void TearDown() {
+    if (comparator_ != nullptr) comparator_->Close(nullptr);
+    ScalarExpr::Close(ordering_exprs_);
+    test_env_.reset();
+    expr_perm_pool_.FreeAll();
+    expr_results_pool_.FreeAll();
+    pool_.Clear();
+  }
+
+  /// Adds an ordering expr over the slot at 'offset'. A nullable slot uses the null
+  /// bit 'offset' of the first byte of the tuple, so 'offset' must be less than 8.
+  void AddKey(const ColumnType& type, int offset, bool nullable, bool is_asc,
+      bool nulls_first) {
+    DCHECK(!nullable || offset < 8);
+    SlotRef* expr = pool_.Add(new SlotRef(type, offset, nullable));
+    ASSERT_OK(expr->Init(desc_, true, nullptr));
+    ordering_exprs_.push_back(expr);
+    sort_info_.is_asc_order.push_back(is_asc);
+    sort_info_.nulls_first.push_back(nulls_first);
+  }
+
+  /// Creates the comparator and the normalizer for the keys added with AddKey().
+  void CreateNormalizer(int max_key_len, bool encode_strings = false) {
+    sort_info_.sorting_order = TSortingOrder::LEXICAL;
+    config_.reset(new TupleRowComparatorConfig(sort_info_, ordering_exprs_));
+    comparator_.reset(new TupleRowLexicalComparator(*config_));
+    ASSERT_OK(comparator_->Open(&pool_, nullptr, &expr_perm_pool_, &expr_results_pool_));
+    normalizer_ = SortKeyNormalizer::Create(
+        *config_, max_key_len, encode_strings, &pool_);
+  }
+
+  Tuple* CreateTuple() {
+    Tuple* tuple = Tuple::Create(TUPLE_SIZE, &expr_perm_pool_);
+    memset(tuple, 0, TUPLE_SIZE);
+    return tuple;
+  }
+
+  template <typename T>
+  void SetSlot(Tuple* tuple, int offset, const T& val) {
+    memcpy(reinterpret_cast<uint8_t*>(tuple) + offset, &val, sizeof(T));
+  }
+
+  /// Checks that the normalized keys of all pairs of 'tuples' are ordered consistently
+  /// with the comparator. If the keys are complete, rows compare as equal iff their
+  /// keys are equal. Otherwise rows that differ only in the columns that are not encoded
+  /// may have equal keys.
+  void CheckOrder(const vector<Tuple*>& tuples) {
+    ASSERT_TRUE(normalizer_ != nullptr);
+    const int key_len = normalizer_->key_len();
+    const bool complete = normalizer_->is_complete();
+    vector<vector<uint8_t>> keys(tuples.size(), vector<uint8_t>(key_len));
+    for (int i = 0; i < tuples.size(); ++i) {
+      normalizer_->Encode(tuples[i], keys[i].data());
+    }
+    for (int i = 0; i < tuples.size(); ++i) {
+      for (int j = 0; j < tuples.size(); ++j) {
+        int key_cmp = memcmp(keys[i].data(), keys[j].data(), key_len);
+        int word_cmp =
+            SortKeyNormalizer::Compare(keys[i].data(), keys[j].data(), key_len);
+        EXPECT_EQ(key_cmp < 0, word_cmp < 0) << i << " " << j;
+        EXPECT_EQ(key_cmp > 0, word_cmp > 0) << i << " " << j;
+        int cmp = comparator_->Compare(tuples[i], tuples[j]);
+        if (cmp < 0) {
+          if (complete) {
+            EXPECT_LT(key_cmp, 0) << i << " " << j;
+          } else {
+            EXPECT_LE(key_cmp, 0) << i << " " << j;
+          }
+        } else if (cmp > 0) {
+          if (complete) {
+            EXPECT_GT(key_cmp, 0) << i << " " << j;
+          } else {
+            EXPECT_GE(key_cmp, 0) << i << " " << j;
+          }
+        }
+        if (complete) EXPECT_EQ(key_cmp == 0, cmp == 0) << i << " " << j;
+      }
+    }
+  }
+};
+
+/// Checks a nullable BIGINT key in all four combinations of sort direction and null
+/// placement.
+TEST_F(SortKeyNormalizerTest, BigInt) {
+  for (bool is_asc : {true, false}) {
+    for (bool nulls_first : {true, false}) {
+      TearDown();
+      SetUp();
+      ordering_exprs_.clear();
+      sort_info_ = TSortInfo();
+      AddKey(ColumnType(TYPE_BIGINT), 1, true, is_asc, nulls_first);
+      CreateNormalizer(16);
+      ASSERT_TRUE(normalizer_ != nullptr);
+      EXPECT_EQ(9, normalizer_->key_len());
+      EXPECT_TRUE(normalizer_->is_complete());
+
+      vector<Tuple*> tuples;
+      for (int64_t val : {numeric_limits<int64_t>::min(), -1000000000000L, -1L, 0L, 1L,
+               255L, 256L, 1000000000000L, numeric_limits<int64_t>::max()}) {
+        Tuple* tuple = CreateTuple();
+        SetSlot(tuple, 1, val);
+        tuples.push_back(tuple);
+      }
+      Tuple* null_tuple = CreateTuple();
+      null_tuple->SetNull(NullIndicatorOffset(0, 1));
+      tuples.push_back(null_tuple);
+      CheckOrder(tuples);
+    }
+  }
+}
+
+TEST_F(SortKeyNormalizerTest, FloatingPoint) {
+  AddKey(ColumnType(TYPE_DOUBLE), 1, false, true, true);
+  AddKey(ColumnType(TYPE_FLOAT), 9, false, false, true);
+  CreateNormalizer(16);
+  ASSERT_TRUE(normalizer_ != nullptr);
+  EXPECT_EQ(12, normalizer_->key_len());
+
+  const double inf = numeric_limits<double>::infinity();
+  const double nan = numeric_limits<double>::quiet_NaN();
+  vector<Tuple*> tuples;
+  for (double d : {-inf, -1e300, -1.5, -0.0, 0.0, 1e-300, 1.5, 1e300, inf, nan, -nan}) {
+    for (float f : {-1.5f, 0.0f, 2.5f, static_cast<float>(nan)}) {
+      Tuple* tuple = CreateTuple();
+      SetSlot(tuple, 1, d);
+      SetSlot(tuple, 9, f);
+      tuples.push_back(tuple);
+    }
+  }
+  CheckOrder(tuples);
+
+  // -0.0 and 0.0 are equal, so the second column decides the order.
+  Tuple* neg_zero = CreateTuple();
+  SetSlot(neg_zero, 1, -0.0);
+  SetSlot(neg_zero, 9, -1.5f);
+  Tuple* pos_zero = CreateTuple();
+  SetSlot(pos_zero, 1, 0.0);
+  SetSlot(pos_zero, 9, 2.5f);
+  vector<uint8_t> neg_zero_key(normalizer_->key_len());
+  vector<uint8_t> pos_zero_key(normalizer_->key_len());
+  normalizer_->Encode(neg_zero, neg_zero_key.data());
+  normalizer_->Encode(pos_zero, pos_zero_key.data());
+  // The FLOAT column is descending.
+  EXPECT_GT(comparator_->Compare(neg_zero, pos_zero), 0);
+  EXPECT_GT(memcmp(neg_zero_key.data(), pos_zero_key.data(), neg_zero_key.size()), 0);
+  // NaNs with different bit patterns have equal keys.
+  Tuple* nan1 = CreateTuple();
+  SetSlot(nan1, 1, nan);
+  Tuple* nan2 = CreateTuple();
+  SetSlot(nan2, 1, -nan);
+  vector<uint8_t> nan1_key(normalizer_->key_len());
+  vector<uint8_t> nan2_key(normalizer_->key_len());
+  normalizer_->Encode(nan1, nan1_key.data());
+  normalizer_->Encode(nan2, nan2_key.data());
+  EXPECT_EQ(0, memcmp(nan1_key.data(), nan2_key.data(), nan1_key.size()));
+}
+
+TEST_F(SortKeyNormalizerTest, MixedTypes) {
+  AddKey(ColumnType(TYPE_INT), 1, false, true, true);
+  AddKey(ColumnType(TYPE_TIMESTAMP), 5, false, false, true);
+  AddKey(ColumnType::CreateDecimalType(38, 2), 17, false, true, true);
+  AddKey(ColumnType(TYPE_SMALLINT), 33, false, true, true);
+  CreateNormalizer(32);
+  ASSERT_TRUE(normalizer_ != nullptr);
+  EXPECT_EQ(4 + 12 + 16, normalizer_->key_len());
+  // The SMALLINT does not fit.
+  EXPECT_FALSE(normalizer_->is_complete());
+
+  std::mt19937 rng(1234);
+  vector<Tuple*> tuples;
+  for (int i = 0; i < 100; ++i) {
+    Tuple* tuple = CreateTuple();
+    SetSlot<int32_t>(tuple, 1, static_cast<int32_t>(rng() % 5) - 2);
+    TimestampValue ts = TimestampValue::FromUnixTime(
+        static_cast<int64_t>(rng() % 2000000) - 1000000, UTCPTR);
+    SetSlot(tuple, 5, ts);
+    __int128_t dec = static_cast<__int128_t>(static_cast<int64_t>(rng() % 7) - 3) << 70;
+    dec += static_cast<int64_t>(rng() % 5) - 2;
+    SetSlot(tuple, 17, dec);
+    SetSlot<int16_t>(tuple, 33, static_cast<int16_t>(rng() % 3));
+    tuples.push_back(tuple);
+  }
+  CheckOrder(tuples);
+}
+
+/// Only the leading keys with fixed-width types are normalized if strings are not
+/// encoded.
+TEST_F(SortKeyNormalizerTest, Prefix) {
+  AddKey(ColumnType(TYPE_STRING), 1, false, true, true);
+  AddKey(ColumnType(TYPE_INT), 17, false, true, true);
+  CreateNormalizer(16);
+  EXPECT_TRUE(normalizer_ == nullptr);
+
+  TearDown();
+  SetUp();
+  ordering_exprs_.clear();
+  sort_info_ = TSortInfo();
+  AddKey(ColumnType(TYPE_INT), 1, true, true, false);
+  AddKey(ColumnType(TYPE_STRING), 5, false, true, true);
+  AddKey(ColumnType(TYPE_INT), 21, false, true, true);
+  CreateNormalizer(16);
+  ASSERT_TRUE(normalizer_ != nullptr);
+  EXPECT_EQ(5, normalizer_->key_len());
+  EXPECT_FALSE(normalizer_->is_complete());
+  EXPECT_FALSE(normalizer_->has_string_prefix());
+}
+
+/// Strings are encoded as a prefix that takes up the rest of the key.
+TEST_F(SortKeyNormalizerTest, StringPrefix) {
+  for (bool is_asc : {true, false}) {
+    TearDown();
+    SetUp();
+    ordering_exprs_.clear();
+    sort_info_ = TSortInfo();
+    AddKey(ColumnType(TYPE_INT), 1, false, true, true);
+    AddKey(ColumnType(TYPE_STRING), 5, true, is_asc, false);
+    AddKey(ColumnType(TYPE_INT), 21, false, true, true);
+    CreateNormalizer(12, true);
+    ASSERT_TRUE(normalizer_ != nullptr);
+    EXPECT_EQ(12, normalizer_->key_len());
+    EXPECT_TRUE(normalizer_->has_string_prefix());
+    EXPECT_FALSE(normalizer_->is_complete());
+
+    vector<string> strings = {"", string("\0", 1), "a", string("a\0", 2), "ab",
+        "abcdefg", "abcdefgh", "abcdefgi", "b", "\xff\xff"};
+    vector<Tuple*> tuples;
+    for (int prefix : {-1, 1}) {
+      for (string& str : strings) {
+        for (int suffix : {0, 1}) {
+          Tuple* tuple = CreateTuple();
+          SetSlot<int32_t>(tuple, 1, prefix);
+          SetSlot(tuple, 5, StringValue(const_cast<char*>(str.data()), str.size()));
+          SetSlot<int32_t>(tuple, 21, suffix);
+          tuples.push_back(tuple);
+        }
+      }
+      Tuple* null_tuple = CreateTuple();
+      SetSlot<int32_t>(null_tuple, 1, prefix);
+      null_tuple->SetNull(NullIndicatorOffset(0, 5));
+      tuples.push_back(null_tuple);
+    }
+    CheckOrder(tuples);
+  }
+
+  // Without space for at least one byte of the string, it is not encoded.
+  TearDown();
+  SetUp();
+  ordering_exprs_.clear();
+  sort_info_ = TSortInfo();
+  AddKey(ColumnType(TYPE_INT), 1, false, true, true);
+  AddKey(ColumnType(TYPE_STRING), 5, true, true, false);
+  CreateNormalizer(5, true);
+  ASSERT_TRUE(normalizer_ != nullptr);
+  EXPECT_EQ(4, normalizer_->key_len());
+  EXPECT_FALSE(normalizer_->has_string_prefix());
+}
+
+} // namespace impala
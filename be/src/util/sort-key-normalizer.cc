@@ -0,0 +1,233 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "util/sort-key-normalizer.h"
+
+#include <cmath>
+#include <cstring>
+
+#include "common/object-pool.h"
+#include "exprs/slot-ref.h"
+#include "runtime/date-value.h"
+#include "runtime/string-value.h"
+#include "runtime/timestamp-value.h"
+#include "runtime/tuple.h"
+#include "util/bit-util.h"
+#include "util/tuple-row-compare.h"
+
+#include "common/names.h"
+
+namespace impala {
+
+/// Stores 'val' at 'dst' in big-endian byte order.
+template <typename T>
+static inline void StoreBigEndian(T val, uint8_t* dst) {
+  val = BitUtil::ByteSwap(val);
+  memcpy(dst, &val, sizeof(T));
+}
+
+SortKeyNormalizer* SortKeyNormalizer::Create(const TupleRowComparatorConfig& config,
+    int max_key_len, bool encode_strings, ObjectPool* pool) {
+  if (config.sorting_order_ != TSortingOrder::LEXICAL) return nullptr;
+  const vector<ScalarExpr*>& ordering_exprs = config.ordering_exprs_;
+  SortKeyNormalizer normalizer;
+  for (int i = 0; i < ordering_exprs.size(); ++i) {
+    const ScalarExpr* expr = ordering_exprs[i];
+    if (!expr->IsSlotRef()) break;
+    const SlotRef* slot_ref = static_cast<const SlotRef*>(expr);
+    Column col;
+    col.type = expr->type();
+    col.slot_offset = slot_ref->GetSlotOffset();
+    col.null_offset = slot_ref->GetNullIndicatorOffset();
+    col.is_asc = config.is_asc_[i];
+    col.nulls_first = config.nulls_first_[i] < 0;
+    const int null_len = col.null_offset.bit_mask != 0 ? 1 : 0;
+    const bool is_string = col.type.type == TYPE_STRING || col.type.type == TYPE_VARCHAR;
+    if (is_string) {
+      if (!encode_strings) break;
+      // The string prefix takes up the rest of the key.
+      col.value_len = max_key_len - normalizer.key_len_ - null_len;
+      if (col.value_len <= 0) break;
+    } else {
+      col.value_len = EncodedValueLen(col.type);
+      if (col.value_len == 0) break;
+    }
+    int col_len = col.value_len + null_len;
+    if (normalizer.key_len_ + col_len > max_key_len) break;
+    normalizer.columns_.push_back(col);
+    normalizer.key_len_ += col_len;
+    if (is_string) break;
+  }
+  if (normalizer.columns_.empty()) return nullptr;
+  normalizer.is_complete_ = normalizer.columns_.size() == ordering_exprs.size()
+      && !normalizer.has_string_prefix();
+  return pool->Add(new SortKeyNormalizer(normalizer));
+}
+
+int SortKeyNormalizer::EncodedValueLen(const ColumnType& type) {
+  switch (type.type) {
+    case TYPE_BOOLEAN:
+    case TYPE_TINYINT:
+      return 1;
+    case TYPE_SMALLINT:
+      return 2;
+    case TYPE_INT:
+    case TYPE_DATE:
+    case TYPE_FLOAT:
+      return 4;
+    case TYPE_BIGINT:
+    case TYPE_DOUBLE:
+      return 8;
+    case TYPE_TIMESTAMP:
+      // The day number of the date followed by the time of day.
+      return sizeof(uint32_t) + sizeof(int64_t);
+    case TYPE_DECIMAL:
+      return type.GetByteSize();
+    default:
+      return 0;
+  }
+}
+
+void SortKeyNormalizer::EncodeValue(
+    const Column& col, const uint8_t* value, uint8_t* dst) {
+  switch (col.type.type) {
+    case TYPE_BOOLEAN:
+      *dst = *reinterpret_cast<const bool*>(value) ? 1 : 0;
+      break;
+    case TYPE_TINYINT:
+      *dst = *value ^ 0x80;
+      break;
+    case TYPE_SMALLINT: {
+      uint16_t v;
+      memcpy(&v, value, sizeof(v));
+      StoreBigEndian<uint16_t>(v ^ 0x8000, dst);
+      break;
+    }
+    case TYPE_INT:
+    case TYPE_DATE: {
+      uint32_t v;
+      memcpy(&v, value, sizeof(v));
+      StoreBigEndian<uint32_t>(v ^ 0x80000000U, dst);
+      break;
+    }
+    case TYPE_BIGINT: {
+      uint64_t v;
+      memcpy(&v, value, sizeof(v));
+      StoreBigEndian<uint64_t>(v ^ (1ULL << 63), dst);
+      break;
+    }
+    case TYPE_FLOAT: {
+      // RawValue::Compare() treats all NaNs as equal and smaller than all other values,
+      // and -0.0 as equal to 0.0. So all NaNs get the smallest key and -0.0 is encoded
+      // as 0.0. Negative values have all bits flipped so that larger magnitudes sort
+      // first, positive values only have the sign bit flipped.
+      float f;
+      memcpy(&f, value, sizeof(f));
+      uint32_t v;
+      if (std::isnan(f)) {
+        v = 0;
+      } else {
+        if (f == 0) f = 0.0f;
+        memcpy(&v, &f, sizeof(v));
+        v = (v & 0x80000000U) ? ~v : v | 0x80000000U;
+      }
+      StoreBigEndian(v, dst);
+      break;
+    }
+    case TYPE_DOUBLE: {
+      // Same as TYPE_FLOAT.
+      double d;
+      memcpy(&d, value, sizeof(d));
+      uint64_t v;
+      if (std::isnan(d)) {
+        v = 0;
+      } else {
+        if (d == 0) d = 0.0;
+        memcpy(&v, &d, sizeof(v));
+        v = (v & (1ULL << 63)) ? ~v : v | (1ULL << 63);
+      }
+      StoreBigEndian(v, dst);
+      break;
+    }
+    case TYPE_TIMESTAMP: {
+      const TimestampValue* ts = reinterpret_cast<const TimestampValue*>(value);
+      StoreBigEndian<uint32_t>(ts->date().day_number(), dst);
+      uint64_t ticks = static_cast<uint64_t>(ts->time().ticks());
+      StoreBigEndian<uint64_t>(ticks ^ (1ULL << 63), dst + sizeof(uint32_t));
+      break;
+    }
+    case TYPE_STRING:
+    case TYPE_VARCHAR: {
+      const StringValue* sv = reinterpret_cast<const StringValue*>(value);
+      int prefix_len = min(sv->len, col.value_len);
+      if (prefix_len > 0) memcpy(dst, sv->ptr, prefix_len);
+      memset(dst + prefix_len, 0, col.value_len - prefix_len);
+      break;
+    }
+    case TYPE_DECIMAL:
+      switch (col.value_len) {
+        case 4: {
+          uint32_t v;
+          memcpy(&v, value, sizeof(v));
+          StoreBigEndian<uint32_t>(v ^ 0x80000000U, dst);
+          break;
+        }
+        case 8: {
+          uint64_t v;
+          memcpy(&v, value, sizeof(v));
+          StoreBigEndian<uint64_t>(v ^ (1ULL << 63), dst);
+          break;
+        }
+        case 16: {
+          // Little-endian: the low half is stored first.
+          uint64_t halves[2];
+          memcpy(halves, value, sizeof(halves));
+          StoreBigEndian<uint64_t>(halves[1] ^ (1ULL << 63), dst);
+          StoreBigEndian<uint64_t>(halves[0], dst + sizeof(uint64_t));
+          break;
+        }
+        default:
+          DCHECK(false) << col.type;
+      }
+      break;
+    default:
+      DCHECK(false) << col.type;
+  }
+}
+
+void SortKeyNormalizer::Encode(const Tuple* tuple, uint8_t* key) const {
+  const uint8_t* tuple_mem = reinterpret_cast<const uint8_t*>(tuple);
+  for (const Column& col : columns_) {
+    if (col.null_offset.bit_mask != 0) {
+      // The placement of NULLs is independent of the sort direction.
+      bool is_null = tuple->IsNull(col.null_offset);
+      *key++ = is_null == col.nulls_first ? 0 : 1;
+      if (is_null) {
+        memset(key, 0, col.value_len);
+        key += col.value_len;
+        continue;
+      }
+    }
+    EncodeValue(col, tuple_mem + col.slot_offset, key);
+    if (!col.is_asc) {
+      for (int i = 0; i < col.value_len; ++i) key[i] = ~key[i];
+    }
+    key += col.value_len;
+  }
+}
+
+} // namespace impala
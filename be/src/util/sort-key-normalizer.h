@@ -0,0 +1,117 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "runtime/descriptors.h"
+#include "runtime/types.h"
+#include "util/bit-util.h"
+
+namespace impala {
+
+class ObjectPool;
+class Tuple;
+class TupleRowComparatorConfig;
+
+/// Encodes the values of the leading ordering exprs of a lexical sort into fixed-length
+/// normalized keys. Comparing two normalized keys with memcmp() gives the same order
+/// as TupleRowLexicalComparator gives for the encoded exprs, taking ascending and
+/// descending order and the placement of NULLs into account.
+///
+/// Each encoded expr is written as an optional null byte followed by its value in a
+/// big-endian, sign-flipped representation, with all value bits inverted for
+/// descending order. Only SlotRefs of fixed-width types and, if requested, STRING and
+/// VARCHAR SlotRefs are encoded. The exprs are encoded in order until the first expr
+/// that cannot be encoded or does not fit into the maximum key length.
+///
+/// A string is encoded as its first bytes, padded with zero bytes, and takes up the
+/// remaining bytes of the key. It is always the last encoded expr and the keys are
+/// never complete: strings with equal prefixes, including strings that only differ in
+/// trailing zero bytes, must be compared with the full comparator.
+///
+/// The ordering exprs must be evaluated over rows with a single tuple, like the rows
+/// sorted by the Sorter.
+class SortKeyNormalizer {
+ public:
+  /// Returns a normalizer owned by 'pool' for the longest prefix of the ordering exprs
+  /// in 'config' whose normalized keys fit into 'max_key_len' bytes, or nullptr if not
+  /// even the first ordering expr can be encoded or 'config' is not a lexical sort.
+  /// String prefixes are only encoded if 'encode_strings' is true.
+  static SortKeyNormalizer* Create(const TupleRowComparatorConfig& config,
+      int max_key_len, bool encode_strings, ObjectPool* pool);
+
+  /// Writes the normalized key of 'tuple' to the key_len() bytes at 'key'.
+  void Encode(const Tuple* tuple, uint8_t* key) const;
+
+  /// Compares the normalized keys of 'len' bytes at 'lhs' and 'rhs' like memcmp(), but
+  /// eight bytes at a time.
+  static inline int Compare(const uint8_t* lhs, const uint8_t* rhs, int len) {
+    for (; len >= 8; len -= 8) {
+      uint64_t l, r;
+      memcpy(&l, lhs, sizeof(l));
+      memcpy(&r, rhs, sizeof(r));
+      if (l != r) return BitUtil::ByteSwap(l) < BitUtil::ByteSwap(r) ? -1 : 1;
+      lhs += 8;
+      rhs += 8;
+    }
+    return len == 0 ? 0 : memcmp(lhs, rhs, len);
+  }
+
+  int key_len() const { return key_len_; }
+
+  /// True if the key ends with a string prefix.
+  bool has_string_prefix() const {
+    return !columns_.empty() && columns_.back().type.IsStringType();
+  }
+
+  /// True if all ordering exprs are encoded, i.e. rows with equal normalized keys
+  /// compare as equal. Otherwise ties must be broken with the full comparator.
+  bool is_complete() const { return is_complete_; }
+
+ private:
+  /// An encoded ordering expr.
+  struct Column {
+    ColumnType type;
+    int slot_offset;
+    /// 'bit_mask' is 0 if the slot is not nullable, in which case the key has no null
+    /// byte for the column.
+    NullIndicatorOffset null_offset;
+    bool is_asc;
+    bool nulls_first;
+    /// Number of bytes of the encoded value, excluding the null byte.
+    int value_len;
+  };
+
+  SortKeyNormalizer() {}
+
+  /// Returns the number of bytes needed to encode a value of 'type', or 0 if values of
+  /// 'type' cannot be encoded.
+  static int EncodedValueLen(const ColumnType& type);
+
+  /// Writes the ascending encoding of the non-NULL value at 'value' to 'dst'.
+  static void EncodeValue(const Column& col, const uint8_t* value, uint8_t* dst);
+
+  std::vector<Column> columns_;
+  int key_len_ = 0;
+  bool is_complete_ = false;
+};
+
+} // namespace impala
@@ -0,0 +1,102 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include <random>
+#include <unordered_map>
+
+#include "testutil/gtest-util.h"
+#include "util/space-saving-sketch.h"
+
+#include "common/names.h"
+
+namespace impala {
+
+// With fewer distinct keys than counters, the counts are exact.
+TEST(SpaceSavingSketchTest, Exact) {
+  SpaceSavingSketch sketch(8);
+  for (int i = 0; i < 5; ++i) {
+    for (int j = 0; j <= i; ++j) sketch.Add(i);
+  }
+  EXPECT_EQ(15, sketch.num_keys());
+  vector<SpaceSavingSketch::Entry> hitters = sketch.GetHeavyHitters(1);
+  ASSERT_EQ(5, hitters.size());
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_EQ(4 - i, hitters[i].key);
+    EXPECT_EQ(5 - i, hitters[i].count);
+    EXPECT_EQ(0, hitters[i].error);
+  }
+  hitters = sketch.GetHeavyHitters(4);
+  ASSERT_EQ(2, hitters.size());
+  EXPECT_EQ(4, hitters[0].key);
+  EXPECT_EQ(3, hitters[1].key);
+}
+
+// A replaced key's count is inherited and recorded as error.
+TEST(SpaceSavingSketchTest, Replacement) {
+  SpaceSavingSketch sketch(2);
+  sketch.Add(1);
+  sketch.Add(1);
+  sketch.Add(1);
+  sketch.Add(2);
+  sketch.Add(3);
+  vector<SpaceSavingSketch::Entry> hitters = sketch.GetHeavyHitters(0);
+  ASSERT_EQ(2, hitters.size());
+  EXPECT_EQ(1, hitters[0].key);
+  EXPECT_EQ(3, hitters[0].count);
+  EXPECT_EQ(0, hitters[0].error);
+  EXPECT_EQ(3, hitters[1].key);
+  EXPECT_EQ(2, hitters[1].count);
+  EXPECT_EQ(1, hitters[1].error);
+  // Key 3 is not guaranteed to have occurred twice.
+  EXPECT_EQ(1, sketch.GetHeavyHitters(2).size());
+}
+
+// Keys that make up a large fraction of a long stream of mostly distinct keys are
+// found, and their counts are bounded by the guarantees of the algorithm.
+TEST(SpaceSavingSketchTest, HeavyHitters) {
+  const int CAPACITY = 64;
+  const int NUM_KEYS = 100000;
+  SpaceSavingSketch sketch(CAPACITY);
+  unordered_map<uint64_t, int64_t> frequencies;
+  mt19937 rng(0);
+  for (int i = 0; i < NUM_KEYS; ++i) {
+    uint64_t key;
+    uint32_t r = rng() % 100;
+    if (r < 20) {
+      key = 0;
+    } else if (r < 30) {
+      key = 1;
+    } else if (r < 35) {
+      key = 2;
+    } else {
+      key = 1000 + rng() % 1000000;
+    }
+    ++frequencies[key];
+    sketch.Add(key);
+  }
+  vector<SpaceSavingSketch::Entry> hitters = sketch.GetHeavyHitters(NUM_KEYS / 50);
+  ASSERT_EQ(3, hitters.size());
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(i, hitters[i].key);
+    int64_t frequency = frequencies[hitters[i].key];
+    EXPECT_GE(hitters[i].count, frequency);
+    EXPECT_LE(hitters[i].count - hitters[i].error, frequency);
+    EXPECT_LE(hitters[i].error, NUM_KEYS / CAPACITY);
+  }
+}
+
+} // namespace impala
@@ -0,0 +1,98 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#include "util/space-saving-sketch.h"
+
+#include <algorithm>
+
+#include "common/logging.h"
+
+#include "common/names.h"
+
+namespace impala {
+
+SpaceSavingSketch::SpaceSavingSketch(int capacity) : capacity_(capacity) {
+  DCHECK_GT(capacity, 0);
+  heap_.reserve(capacity);
+  positions_.reserve(capacity);
+}
+
+void SpaceSavingSketch::Add(uint64_t key) {
+  ++num_keys_;
+  auto it = positions_.find(key);
+  if (it != positions_.end()) {
+    int pos = it->second;
+    ++heap_[pos].count;
+    SiftDown(pos);
+    return;
+  }
+  if (heap_.size() < capacity_) {
+    // All counts are at least 1, so the new entry is a valid root of its subtree.
+    // Move it up to keep the heap property above it.
+    int pos = heap_.size();
+    heap_.push_back({key, 1, 0});
+    positions_[key] = pos;
+    while (pos > 0) {
+      int parent = (pos - 1) / 2;
+      if (heap_[parent].count <= heap_[pos].count) break;
+      Swap(parent, pos);
+      pos = parent;
+    }
+    return;
+  }
+  // Replace the key with the smallest count.
+  Entry* min_entry = &heap_[0];
+  positions_.erase(min_entry->key);
+  min_entry->key = key;
+  min_entry->error = min_entry->count;
+  ++min_entry->count;
+  positions_[key] = 0;
+  SiftDown(0);
+}
+
+void SpaceSavingSketch::SiftDown(int pos) {
+  const int size = heap_.size();
+  while (true) {
+    int smallest = pos;
+    int left = 2 * pos + 1;
+    int right = left + 1;
+    if (left < size && heap_[left].count < heap_[smallest].count) smallest = left;
+    if (right < size && heap_[right].count < heap_[smallest].count) smallest = right;
+    if (smallest == pos) return;
+    Swap(pos, smallest);
+    pos = smallest;
+  }
+}
+
+void SpaceSavingSketch::Swap(int a, int b) {
+  std::swap(heap_[a], heap_[b]);
+  positions_[heap_[a].key] = a;
+  positions_[heap_[b].key] = b;
+}
+
+vector<SpaceSavingSketch::Entry> SpaceSavingSketch::GetHeavyHitters(
+    int64_t min_count) const {
+  vector<Entry> result;
+  for (const Entry& entry : heap_) {
+    if (entry.count - entry.error >= min_count) result.push_back(entry);
+  }
+  sort(result.begin(), result.end(),
+      [](const Entry& a, const Entry& b) { return a.count > b.count; });
+  return result;
+}
+
+} // namespace impala
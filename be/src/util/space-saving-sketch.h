@@ -0,0 +1,74 @@
+// Licensed to the Apache Software Foundation (ASF) under one
+// or more contributor license agreements.  See the NOTICE file
+// distributed with this work for additional information
+// regarding copyright ownership.  The ASF licenses this file
+// to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance
+// with the License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing,
+// software distributed under the License is distributed on an
+// "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+// KIND, either express or implied.  See the License for the
+// specific language governing permissions and limitations
+// under the License.
+
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace impala {
+
+/// Finds the heavy hitters of a stream of 64-bit keys with the Space-Saving algorithm
+/// of Metwally et al., "Efficient Computation of Frequent and Top-k Elements in Data
+/// Streams". The sketch monitors at most 'capacity' keys with a counter each. A key
+/// that is not monitored replaces the key with the smallest counter and inherits its
+/// count, which is recorded as the error of the new key's count.
+///
+/// The count of a monitored key overestimates its frequency by at most its error, and
+/// every key whose frequency is larger than num_keys() / capacity is monitored. Adding
+/// a key takes O(log capacity) time.
+class SpaceSavingSketch {
+ public:
+  /// A monitored key with its estimated count and the maximum overestimation of it.
+  struct Entry {
+    uint64_t key;
+    int64_t count;
+    int64_t error;
+  };
+
+  SpaceSavingSketch(int capacity);
+
+  /// Adds an occurrence of 'key'.
+  void Add(uint64_t key);
+
+  /// Returns the monitored keys whose frequency is guaranteed to be at least
+  /// 'min_count', i.e. whose count minus error is at least 'min_count', in descending
+  /// order of their counts.
+  std::vector<Entry> GetHeavyHitters(int64_t min_count) const;
+
+  /// Number of keys added.
+  int64_t num_keys() const { return num_keys_; }
+
+ private:
+  /// Restores the heap property of 'heap_' below 'pos' after the count at 'pos' grew.
+  void SiftDown(int pos);
+
+  /// Swaps the heap entries at 'a' and 'b' and updates 'positions_'.
+  void Swap(int a, int b);
+
+  const int capacity_;
+  int64_t num_keys_ = 0;
+
+  /// The monitored keys as a binary min-heap on their counts.
+  std::vector<Entry> heap_;
+
+  /// The position of each monitored key in 'heap_'.
+  std::unordered_map<uint64_t, int> positions_;
+};
+
+} // namespace impala
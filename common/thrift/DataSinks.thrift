@@ -47,6 +47,15 @@ enum TTableSinkType {
   KUDU = 2
 }
 
+// The side of a skew-tolerant partitioned hash join a hash-partitioned data stream
+// sink feeds. See the HASH_JOIN_SKEW_FANOUT query option.
+enum TSkewJoinSide {
+  // Rows of heavy-hitter keys are spread over the receivers of their keys.
+  PROBE = 0
+  // Every row is replicated to all receivers of its key.
+  BUILD = 1
+}
+
 // Sink which forwards data to a remote plan fragment,
 // according to the given output partition specification
 // (ie, the m:1 part of an m:n data stream)
@@ -58,6 +67,12 @@ struct TDataStreamSink {
   // If the partitioning type is UNPARTITIONED, the output is broadcast
   // to each destination host.
   2: required Partitions.TDataPartition output_partition
+
+  // Set if the sink feeds a side of a skew-tolerant partitioned hash join. The
+  // receivers of a key are the 'skew_fanout' consecutive receivers starting at the
+  // key's hash partition.
+  3: optional TSkewJoinSide skew_join_side
+  4: optional i32 skew_fanout
 }
 
 // Creates a new Hdfs files according to the evaluation of the partitionKeyExprs,
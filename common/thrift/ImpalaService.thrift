@@ -768,6 +768,62 @@ enum TImpalaQueryOptions {
   // cost algorithm. It is recommend to not set it with value more than number of
   // physical cores in executor node. Valid values are in [1, 128]. Default to 1.
   PROCESSING_COST_MIN_THREADS = 154;
+
+  // If true, the hash tables of hash joins and grouping aggregations are laid out in
+  // groups of 16 buckets with a one byte hash tag per bucket, and probes compare the
+  // tags of a whole group with SIMD instructions before touching the buckets. Uses an
+  // extra byte of memory per bucket. Default to false.
+  HASH_TABLE_TAGGED_PROBING = 155;
+
+  // If true, a hash join build that is shared by multiple fragment instances with
+  // mt_dop > 1 builds the hash tables of its partitions in parallel, using up to one
+  // thread per fragment instance that shares the build. Default to true.
+  HASH_JOIN_PARALLEL_BUILD = 156;
+
+  // If true, non-streaming grouping aggregations first resolve the group of every row
+  // in a batch and then update the aggregate functions one function at a time over the
+  // resolved rows, instead of updating all functions row by row. Default to false.
+  GROUPING_AGG_BATCH_UPDATE = 157;
+
+  // If true, the partitions of streaming preaggregations switch between aggregating
+  // and passing through rows over the lifetime of the query, based on the reduction
+  // each partition achieves and the measured per-row processing cost. Partitions that
+  // pass through rows are periodically sampled and switch back to aggregating if their
+  // reduction recovers. Default to false.
+  ADAPTIVE_STREAMING_PREAGGREGATION = 158;
+
+  // If true, row batches sent by exchanges are transposed into a columnar layout in
+  // which every column is stored with a dictionary, frame-of-reference or plain
+  // encoding before the batch is compressed. Receivers always accept both layouts.
+  // Default to false.
+  EXCHANGE_COLUMNAR_SERIALIZATION = 159;
+
+  // The codec used to compress row batches sent by exchanges. Valid values are NONE,
+  // LZ4 and ZSTD, with an optional compression level for ZSTD, e.g. "ZSTD:3".
+  // Default to LZ4.
+  EXCHANGE_COMPRESSION_CODEC = 160;
+
+  // If true, exchanges choose the codec of each row batch out of NONE, LZ4 and ZSTD
+  // based on the measured compression ratio and speed of the codecs and the measured
+  // network time of each channel, instead of using EXCHANGE_COMPRESSION_CODEC.
+  // Default to false.
+  ADAPTIVE_EXCHANGE_COMPRESSION = 161;
+
+  // If greater than 1, partitioned hash joins whose inputs are both repartitioned and
+  // whose join type does not output unmatched build rows are planned to tolerate skewed
+  // join keys: every build row is replicated to this many consecutive join instances
+  // starting at its hash partition, and the probe-side exchanges spread the rows of
+  // join keys they detect as heavy hitters over those instances. The output of such
+  // joins is not partitioned on the join keys. Valid values are 0 to 16.
+  // Default to 0, i.e. disabled.
+  HASH_JOIN_SKEW_FANOUT = 162;
+
+  // If true, unpartitioned Top-N nodes publish the bound of their heap on the first
+  // ordering expression as a min/max runtime filter to the scans in the same fragment.
+  // The filter is republished whenever the bound tightens, so that Parquet scans can
+  // skip row groups and pages that cannot make it into the result. Only applies to
+  // orderings with NULLS LAST on keys that are not FLOAT or DOUBLE. Default to false.
+  TOPN_RUNTIME_FILTER = 163;
 }
 
 // The summary of a DML statement.
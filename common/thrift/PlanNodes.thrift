@@ -184,6 +184,11 @@ struct TRuntimeFilterDesc {
 
   // The ID of the plan node that produces this filter.
   13: optional Types.TPlanNodeId src_node_id
+
+  // True if this filter is produced by a Top-N node from the bound of its heap. Such
+  // filters are min/max filters that are republished with tighter bounds while the
+  // Top-N node consumes its input, and scans do not wait for their arrival.
+  14: optional bool is_topn_filter
 }
 
 // The information contained in subclasses of ScanNode captured in two separate
@@ -624,6 +624,33 @@ struct TQueryOptions {
 
   // See comment in ImpalaService.thrift
   155: optional i32 processing_cost_min_threads = 1;
+
+  // See comment in ImpalaService.thrift
+  156: optional bool hash_table_tagged_probing = false;
+
+  // See comment in ImpalaService.thrift
+  157: optional bool hash_join_parallel_build = true;
+
+  // See comment in ImpalaService.thrift
+  158: optional bool grouping_agg_batch_update = false;
+
+  // See comment in ImpalaService.thrift
+  159: optional bool adaptive_streaming_preaggregation = false;
+
+  // See comment in ImpalaService.thrift
+  160: optional bool exchange_columnar_serialization = false;
+
+  // See comment in ImpalaService.thrift
+  161: optional CatalogObjects.TCompressionCodec exchange_compression_codec;
+
+  // See comment in ImpalaService.thrift
+  162: optional bool adaptive_exchange_compression = false;
+
+  // See comment in ImpalaService.thrift
+  163: optional i32 hash_join_skew_fanout = 0;
+
+  // See comment in ImpalaService.thrift
+  164: optional bool topn_runtime_filter = false;
 }
 
 // Impala currently has three types of sessions: Beeswax, HiveServer2 and external
@@ -137,6 +137,11 @@ enum TPrefetchMode {
 
   // Prefetch the hash table buckets.
   HT_BUCKET = 1
+
+  // Prefetch the hash table buckets and, in a second pass over the rows of a prefetch
+  // group, the build rows they reference before probing the hash table. Only used by
+  // the probe side of hash joins, everything else treats it like HT_BUCKET.
+  HT_BUCKET_AND_ROW = 2
 }
 
 // A TNetworkAddress is the standard host, port representation of a
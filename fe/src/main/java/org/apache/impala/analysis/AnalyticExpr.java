@@ -83,8 +83,6 @@ public class AnalyticExpr extends Expr {
   private static String LAST_VALUE = "last_value";
   private static String FIRST_VALUE_IGNORE_NULLS = "first_value_ignore_nulls";
   private static String LAST_VALUE_IGNORE_NULLS = "last_value_ignore_nulls";
-  private static String MIN = "min";
-  private static String MAX = "max";
   private static String PERCENT_RANK = "percent_rank";
   private static String CUME_DIST = "cume_dist";
   private static String NTILE = "ntile";
@@ -215,10 +213,6 @@ public class AnalyticExpr extends Expr {
     return isAnalyticFn(fn, LEAD) || isAnalyticFn(fn, LAG);
   }
 
-  public static boolean isMinMax(Function fn) {
-    return isAnalyticFn(fn, MIN) || isAnalyticFn(fn, MAX);
-  }
-
   public static boolean isRankingFn(Function fn) {
     return isAnalyticFn(fn, RANK) || isAnalyticFn(fn, DENSERANK) ||
         isAnalyticFn(fn, ROWNUMBER);
@@ -531,15 +525,6 @@ public class AnalyticExpr extends Expr {
 
     standardize(analyzer);
 
-    // min/max is not currently supported on sliding windows (i.e. start bound is not
-    // unbounded).
-    if (window_ != null && isMinMax(fn) &&
-        window_.getLeftBoundary().getType() != BoundaryType.UNBOUNDED_PRECEDING) {
-      throw new AnalysisException(
-          "'" + getFnCall().toSql() + "' is only supported with an "
-            + "UNBOUNDED PRECEDING start bound.");
-    }
-
     setChildren();
   }
 
@@ -102,6 +102,10 @@ public class DataStreamSink extends DataSink {
   protected void toThriftImpl(TDataSink tsink) {
     TDataStreamSink tStreamSink =
         new TDataStreamSink(exchNode_.getId().asInt(), outputPartition_.toThrift());
+    if (exchNode_.getSkewJoinSide() != null) {
+      tStreamSink.setSkew_join_side(exchNode_.getSkewJoinSide());
+      tStreamSink.setSkew_fanout(exchNode_.getSkewFanout());
+    }
     tsink.setStream_sink(tStreamSink);
   }
 
@@ -33,6 +33,7 @@ import org.apache.impala.common.ImpalaException;
 import org.apache.impala.common.InternalException;
 import org.apache.impala.planner.JoinNode.DistributionMode;
 import org.apache.impala.thrift.TPartitionType;
+import org.apache.impala.thrift.TSkewJoinSide;
 import org.apache.impala.util.KuduUtil;
 import org.slf4j.Logger;
 import org.slf4j.LoggerFactory;
@@ -351,6 +352,16 @@ public class DistributedPlanner {
     return leftChildFragment;
   }
 
+  /**
+   * Returns true if a partitioned hash join with 'joinOp' can replicate build rows
+   * to several join instances, i.e. if it does not output unmatched build rows and
+   * does not need to see all build rows to process a probe row with a NULL key.
+   */
+  private static boolean isSkewTolerantJoinOp(JoinOperator joinOp) {
+    return joinOp == JoinOperator.INNER_JOIN || joinOp == JoinOperator.LEFT_OUTER_JOIN
+        || joinOp == JoinOperator.LEFT_SEMI_JOIN || joinOp == JoinOperator.LEFT_ANTI_JOIN;
+  }
+
   /**
    * Helper function to produce a partitioning hash-join fragment
    */
@@ -441,6 +452,16 @@ public class DistributedPlanner {
     rhsExchange.computeStats(ctx_.getRootAnalyzer());
     node.setChild(1, rhsExchange);
 
+    // With both inputs repartitioned, the join can be made tolerant of skewed join keys
+    // by assigning every key several join instances. This is only correct if the join
+    // does not output unmatched build rows, which the instances would output repeatedly.
+    int skewFanout = ctx_.getQueryOptions().getHash_join_skew_fanout();
+    boolean isSkewTolerant = skewFanout > 1 && isSkewTolerantJoinOp(node.getJoinOp());
+    if (isSkewTolerant) {
+      lhsExchange.setSkewJoinSide(TSkewJoinSide.PROBE, skewFanout);
+      rhsExchange.setSkewJoinSide(TSkewJoinSide.BUILD, skewFanout);
+    }
+
     // Connect the child fragments in a new fragment, and set the data partition
     // of the new fragment and its child fragments.
     DataPartition outputPartition;
@@ -457,9 +478,10 @@ public class DistributedPlanner {
       case RIGHT_OUTER_JOIN:
         outputPartition = rhsJoinPartition;
         break;
-      // Otherwise we're good to use the lhs partition.
+      // Otherwise we're good to use the lhs partition, unless the rows of a key are
+      // spread over several instances.
       default:
-        outputPartition = lhsJoinPartition;
+        outputPartition = isSkewTolerant ? DataPartition.RANDOM : lhsJoinPartition;
     }
     PlanFragment joinFragment =
         new PlanFragment(ctx_.getNextFragmentId(), node, outputPartition);
@@ -28,6 +28,7 @@ import org.apache.impala.thrift.TExplainLevel;
 import org.apache.impala.thrift.TPlanNode;
 import org.apache.impala.thrift.TPlanNodeType;
 import org.apache.impala.thrift.TQueryOptions;
+import org.apache.impala.thrift.TSkewJoinSide;
 import org.apache.impala.thrift.TSortInfo;
 import org.apache.impala.util.ExprUtil;
 
@@ -63,6 +64,14 @@ public class ExchangeNode extends PlanNode {
   // only if mergeInfo_ is non-null, i.e. this is a merging exchange node.
   private long offset_;
 
+  // The side of a skew-tolerant partitioned hash join this exchange feeds, see
+  // setSkewJoinSide(). Null if the join is not skew-tolerant.
+  private TSkewJoinSide skewJoinSide_;
+
+  // Number of consecutive join instances that receive the rows of a join key if
+  // 'skewJoinSide_' is set.
+  private int skewFanout_;
+
   private boolean isMergingExchange() {
     return mergeInfo_ != null;
   }
@@ -123,6 +132,21 @@ public class ExchangeNode extends PlanNode {
     displayName_ = "MERGING-EXCHANGE";
   }
 
+  /**
+   * Marks this exchange as the input of 'side' of a skew-tolerant partitioned hash
+   * join. The rows of a join key are sent to the 'fanout' consecutive join instances
+   * starting at the key's hash partition: build rows are replicated to all of them and
+   * probe rows of heavy-hitter keys are spread over them.
+   */
+  public void setSkewJoinSide(TSkewJoinSide side, int fanout) {
+    Preconditions.checkState(fanout > 1);
+    skewJoinSide_ = side;
+    skewFanout_ = fanout;
+  }
+
+  public TSkewJoinSide getSkewJoinSide() { return skewJoinSide_; }
+  public int getSkewFanout() { return skewFanout_; }
+
   @Override
   protected String getNodeExplainString(String prefix, String detailPrefix,
       TExplainLevel detailLevel) {
@@ -166,7 +190,10 @@ public class ExchangeNode extends PlanNode {
     } else {
       Preconditions.checkState(sink instanceof DataStreamSink);
       DataStreamSink streamSink = (DataStreamSink) sink;
-      return streamSink.getOutputPartition().getExplainString();
+      String partition = streamSink.getOutputPartition().getExplainString();
+      if (skewJoinSide_ == null) return partition;
+      return String.format(
+          "%s SKEW %s FANOUT=%d", partition, skewJoinSide_.name(), skewFanout_);
     }
   }
 
@@ -36,6 +36,7 @@ import org.apache.impala.thrift.THashJoinNode;
 import org.apache.impala.thrift.TPlanNode;
 import org.apache.impala.thrift.TPlanNodeType;
 import org.apache.impala.thrift.TQueryOptions;
+import org.apache.impala.thrift.TSkewJoinSide;
 import org.apache.impala.util.BitUtil;
 import org.apache.impala.util.ExprUtil;
 
@@ -254,9 +255,12 @@ public class HashJoinNode extends JoinNode {
         perBuildInstanceDataBytes += (rhsCard - rhsNdv) *
             PlannerContext.SIZE_OF_DUPLICATENODE;
       }
-      // Assume the rows are evenly divided among instances.
+      // Assume the rows are evenly divided among instances. A skew-tolerant join
+      // replicates every build row to 'fanout' instances.
       if (distrMode_ == DistributionMode.PARTITIONED) {
-        perBuildInstanceDataBytes /= numInstances;
+        int fanout = Math.min(getBuildSkewFanout(), numInstances);
+        perBuildInstanceDataBytes =
+            checkedMultiply(perBuildInstanceDataBytes, fanout) / numInstances;
       }
       perBuildInstanceMemEstimate = perBuildInstanceDataBytes;
     }
@@ -316,6 +320,17 @@ public class HashJoinNode extends JoinNode {
     return Pair.create(probeProfile, buildProfile);
   }
 
+  /**
+   * Returns the number of join instances that each build row is sent to. This is larger
+   * than 1 for skew-tolerant partitioned joins, see ExchangeNode.setSkewJoinSide().
+   */
+  private int getBuildSkewFanout() {
+    if (!(getChild(1) instanceof ExchangeNode)) return 1;
+    ExchangeNode buildExchange = (ExchangeNode) getChild(1);
+    if (buildExchange.getSkewJoinSide() != TSkewJoinSide.BUILD) return 1;
+    return buildExchange.getSkewFanout();
+  }
+
   @Override
   public Pair<ProcessingCost, ProcessingCost> computeJoinProcessingCost() {
     // TODO: The cost should consider conjuncts_ as well.
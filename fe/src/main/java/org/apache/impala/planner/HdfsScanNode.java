@@ -884,7 +884,11 @@ public class HdfsScanNode extends ScanNode {
 
     Column column = slotRefInScan.getDesc().getColumn();
     FeTable table = slotRefInScan.getDesc().getParent().getTable();
-    if (!allowMinMaxFilter(
+    // Top-N filters are enabled by their own query option and are useful regardless of
+    // how the table is sorted, since their bound keeps tightening during the scan.
+    if (filter.isTopNFilter()) {
+      if (column == null) return false;
+    } else if (!allowMinMaxFilter(
             table, column, analyzer.getQueryOptions(), isBoundByPartitionColumns)) {
       return false;
     }
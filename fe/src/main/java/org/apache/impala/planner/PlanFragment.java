@@ -452,7 +452,7 @@ public class PlanFragment extends TreeNode<PlanFragment> {
     }
     for (PlanNode node : collectPlanNodes()) {
       node.computeNodeResourceProfile(analyzer.getQueryOptions());
-      boolean isFilterProducer = node instanceof JoinNode;
+      boolean isFilterProducer = node instanceof JoinNode || node instanceof SortNode;
       for (RuntimeFilter filter : node.getRuntimeFilters()) {
         if (isFilterProducer) {
           producedFilters.put(filter.getFilterId(), filter);
@@ -36,12 +36,14 @@ import org.apache.impala.analysis.Expr;
 import org.apache.impala.analysis.ExprSubstitutionMap;
 import org.apache.impala.analysis.FunctionCallExpr;
 import org.apache.impala.analysis.IsNullPredicate;
+import org.apache.impala.analysis.JoinOperator;
 import org.apache.impala.analysis.LiteralExpr;
 import org.apache.impala.analysis.NullLiteral;
 import org.apache.impala.analysis.Predicate;
 import org.apache.impala.analysis.SlotDescriptor;
 import org.apache.impala.analysis.SlotId;
 import org.apache.impala.analysis.SlotRef;
+import org.apache.impala.analysis.SortInfo;
 import org.apache.impala.analysis.TupleDescriptor;
 import org.apache.impala.analysis.TupleId;
 import org.apache.impala.analysis.TupleIsNullPredicate;
@@ -66,6 +68,7 @@ import org.apache.impala.thrift.TRuntimeFilterDesc;
 import org.apache.impala.thrift.TRuntimeFilterMode;
 import org.apache.impala.thrift.TRuntimeFilterTargetDesc;
 import org.apache.impala.thrift.TRuntimeFilterType;
+import org.apache.impala.thrift.TSortingOrder;
 import org.apache.impala.util.BitUtil;
 import org.apache.impala.util.TColumnValueUtil;
 import org.slf4j.Logger;
@@ -127,6 +130,10 @@ public final class RuntimeFilterGenerator {
   private final IdGenerator<RuntimeFilterId> filterIdGenerator =
       RuntimeFilterId.createGenerator();
 
+  // Top-N filters whose source node is an ancestor of the node currently visited by
+  // generateFilters() and that can still be assigned to scan nodes.
+  private final List<RuntimeFilter> openTopNFilters_ = new ArrayList<>();
+
   /**
    * Internal class that encapsulates the max, min and default sizes used for creating
    * bloom filter objects, and entry limit for in-list filters.
@@ -193,8 +200,8 @@ public final class RuntimeFilterGenerator {
   public static class RuntimeFilter {
     // Identifier of the filter (unique within a query)
     private final RuntimeFilterId id_;
-    // Join node that builds the filter
-    private final JoinNode src_;
+    // Join node that builds the filter, or the Top-N node for Top-N filters
+    private final PlanNode src_;
     // Expr (rhs of join predicate) on which the filter is built
     private final Expr srcExpr_;
     // Expr (lhs of join predicate) from which the targetExprs_ are generated.
@@ -232,6 +239,9 @@ public final class RuntimeFilterGenerator {
     // If set, indicates that the filter is targeted for Kudu scan node with source
     // timestamp truncation.
     private boolean isTimestampTruncation_ = false;
+    // If set, the filter is built by a Top-N node from the bound of its heap on the
+    // first ordering expression rather than by a join.
+    private final boolean isTopNFilter_;
 
     /**
      * Internal representation of a runtime filter target.
@@ -320,10 +330,11 @@ public final class RuntimeFilterGenerator {
       }
     }
 
-    private RuntimeFilter(RuntimeFilterId filterId, JoinNode filterSrcNode, Expr srcExpr,
+    private RuntimeFilter(RuntimeFilterId filterId, PlanNode filterSrcNode, Expr srcExpr,
         Expr origTargetExpr, Operator exprCmpOp, Map<TupleId, List<SlotId>> targetSlots,
         TRuntimeFilterType type, FilterSizeLimits filterSizeLimits,
-        boolean isTimestampTruncation) {
+        boolean isTimestampTruncation, boolean isTopNFilter) {
+      Preconditions.checkState(isTopNFilter || filterSrcNode instanceof JoinNode);
       id_ = filterId;
       src_ = filterSrcNode;
       srcExpr_ = srcExpr;
@@ -332,6 +343,7 @@ public final class RuntimeFilterGenerator {
       targetSlotsByTid_ = targetSlots;
       type_ = type;
       isTimestampTruncation_ = isTimestampTruncation;
+      isTopNFilter_ = isTopNFilter;
       computeNdvEstimate();
       calculateFilterSize(filterSizeLimits);
     }
@@ -372,6 +384,7 @@ public final class RuntimeFilterGenerator {
       tFilter.setApplied_on_partition_columns(appliedOnPartitionColumns);
       tFilter.setType(type_);
       tFilter.setFilter_size_bytes(filterSizeBytes_);
+      tFilter.setIs_topn_filter(isTopNFilter_);
       return tFilter;
     }
 
@@ -518,7 +531,52 @@ public final class RuntimeFilterGenerator {
       }
       return new RuntimeFilter(idGen.getNextId(), filterSrcNode, srcExpr, targetExpr,
           normalizedJoinConjunct.getOp(), targetSlots, type, filterSizeLimits,
-          isTimestampTruncation);
+          isTimestampTruncation, /* isTopNFilter */ false);
+    }
+
+    /**
+     * Static function to create a Top-N filter on the first ordering expression of the
+     * Top-N node 'sortNode'. The filter is a min/max filter holding the bound of the
+     * heap of 'sortNode', so that input rows that cannot make it into the result can be
+     * rejected by the scans below it. Returns null if no such filter can be generated.
+     */
+    public static RuntimeFilter createForTopN(IdGenerator<RuntimeFilterId> idGen,
+        Analyzer analyzer, SortNode sortNode, FilterSizeLimits filterSizeLimits) {
+      Preconditions.checkNotNull(idGen);
+      Preconditions.checkNotNull(sortNode);
+      if (!sortNode.isTypeTopN() || sortNode.isIncludeTies()) return null;
+      SortInfo sortInfo = sortNode.getSortInfo();
+      if (sortInfo.getSortingOrder() != TSortingOrder.LEXICAL) return null;
+      // Scans drop all-NULL row groups and pages when evaluating min/max filters, which
+      // is only correct if NULLs sort after the bound.
+      if (sortInfo.getNullsFirst().get(0)) return null;
+      Expr srcExpr = sortInfo.getSortExprs().get(0);
+      Type srcType = srcExpr.getType();
+      if (srcType.isBoolean()) return null;
+      // NaN sorts before all other values, but Parquet excludes it from the min/max
+      // statistics, so row groups and pages with NaNs could be skipped wrongly.
+      if (srcType.isFloatingPointType()) return null;
+      // MinMaxFilter can't handle range predicates with decimals stored in __int128_t.
+      if (srcType.isDecimal()
+          && ((ScalarType) srcType).storageBytesForDecimal() == 16) {
+        return null;
+      }
+      Expr resolvedExpr = sortNode.getResolvedTupleExpr(srcExpr);
+      if (resolvedExpr == null) return null;
+      // Ensure that the target expr does not contain TupleIsNull predicates as these
+      // can't be evaluated at a scan node.
+      Expr targetExpr = TupleIsNullPredicate.unwrapExpr(resolvedExpr.clone());
+      Map<TupleId, List<SlotId>> targetSlots = getTargetSlots(analyzer, targetExpr);
+      Preconditions.checkNotNull(targetSlots);
+      if (targetSlots.isEmpty()) return null;
+      // The filter admits target values that compare to the bound with 'op'.
+      Operator op = sortInfo.getIsAscOrder().get(0) ? Operator.LE : Operator.GE;
+      if (LOG.isTraceEnabled()) {
+        LOG.trace("Generating Top-N runtime filter on " + targetExpr.toSql());
+      }
+      return new RuntimeFilter(idGen.getNextId(), sortNode, srcExpr, targetExpr, op,
+          targetSlots, TRuntimeFilterType.MIN_MAX, filterSizeLimits,
+          /* isTimestampTruncation */ false, /* isTopNFilter */ true);
     }
 
     /**
@@ -626,6 +684,7 @@ public final class RuntimeFilterGenerator {
     public Operator getExprCompOp() { return exprCmpOp_; }
     public long getFilterSize() { return filterSizeBytes_; }
     public boolean isTimestampTruncation() { return isTimestampTruncation_; }
+    public boolean isTopNFilter() { return isTopNFilter_; }
 
     /**
      * Return TIMESTAMP if the isTimestampTruncation_ is set as true so that
@@ -643,10 +702,11 @@ public final class RuntimeFilterGenerator {
     /**
      * Estimates the selectivity of a runtime filter as the cardinality of the
      * associated source join node over the cardinality of that join node's left
-     * child.
+     * child. Top-N filters have no estimate.
      */
     public double getSelectivity() {
-      if (src_.getCardinality() == -1
+      if (isTopNFilter_
+          || src_.getCardinality() == -1
           || src_.getChild(0).getCardinality() == -1
           || src_.getChild(0).getCardinality() == 0) {
         return -1;
@@ -658,7 +718,10 @@ public final class RuntimeFilterGenerator {
 
     public void setIsBroadcast(boolean isBroadcast) { isBroadcastJoin_ = isBroadcast; }
 
-    public void computeNdvEstimate() { ndvEstimate_ = src_.getChild(1).getCardinality(); }
+    public void computeNdvEstimate() {
+      if (isTopNFilter_) return;
+      ndvEstimate_ = src_.getChild(1).getCardinality();
+    }
 
     public void computeHasLocalTargets() {
       Preconditions.checkNotNull(src_.getFragment());
@@ -757,7 +820,16 @@ public final class RuntimeFilterGenerator {
         if (numBloomFilters >= maxNumBloomFilters) continue;
         ++numBloomFilters;
       }
-      DistributionMode distMode = filter.src_.getDistributionMode();
+      if (filter.isTopNFilter()) {
+        // Top-N filters only have targets in the fragment of their source, so every
+        // instance of the Top-N node produces a complete filter for its own scans.
+        filter.setIsBroadcast(true);
+        filter.computeHasLocalTargets();
+        if (LOG.isTraceEnabled()) LOG.trace("Runtime filter: " + filter.debugString());
+        filter.assignToPlanNodes();
+        continue;
+      }
+      DistributionMode distMode = ((JoinNode) filter.src_).getDistributionMode();
       filter.setIsBroadcast(distMode == DistributionMode.BROADCAST);
       if (filter.getType() == TRuntimeFilterType.IN_LIST
           && distMode == DistributionMode.PARTITIONED) {
@@ -805,11 +877,17 @@ public final class RuntimeFilterGenerator {
   /**
    * Generates the runtime filters for a query by recursively traversing the distributed
    * plan tree rooted at 'root'. In the top-down traversal of the plan tree, candidate
-   * runtime filters are generated from equi-join predicates assigned to hash-join nodes.
+   * runtime filters are generated from equi-join predicates assigned to hash-join nodes
+   * and, if enabled, from the ordering of Top-N nodes.
    * In the bottom-up traversal of the plan tree, the filters are assigned to destination
    * (scan) nodes. Filters that cannot be assigned to a scan node are discarded.
    */
   private void generateFilters(PlannerContext ctx, PlanNode root) {
+    // A Top-N filter may only be applied below nodes that neither combine nor drop rows
+    // of their input, otherwise rows rejected by the bound could change the result.
+    if (!openTopNFilters_.isEmpty() && !isTransparentForTopNFilters(root)) {
+      finalizeTopNFilters();
+    }
     if (root instanceof HashJoinNode || root instanceof NestedLoopJoinNode) {
       JoinNode joinNode = (JoinNode) root;
       List<Expr> joinConjuncts = new ArrayList<>();
@@ -853,12 +931,28 @@ public final class RuntimeFilterGenerator {
           }
         }
       }
+      // Rejecting rows on the side of an anti join that is probed for matches would
+      // add rows to its output.
+      if (joinNode.getJoinOp() == JoinOperator.RIGHT_ANTI_JOIN) finalizeTopNFilters();
       generateFilters(ctx, root.getChild(0));
       // Finalize every runtime filter of that join. This is to ensure that we don't
       // assign a filter to a scan node from the right subtree of joinNode or ancestor
       // join nodes in case we don't find a destination node in the left subtree.
       for (RuntimeFilter runtimeFilter: filters) finalizeRuntimeFilter(runtimeFilter);
+      if (joinNode.getJoinOp().isAntiJoin()) finalizeTopNFilters();
       generateFilters(ctx, root.getChild(1));
+    } else if (root instanceof SortNode && ((SortNode) root).isTypeTopN()
+        && ctx.getQueryOptions().isTopn_runtime_filter()
+        && ctx.getQueryOptions().getEnabled_runtime_filter_types().contains(
+            TRuntimeFilterType.MIN_MAX)) {
+      RuntimeFilter filter = RuntimeFilter.createForTopN(filterIdGenerator,
+          ctx.getRootAnalyzer(), (SortNode) root, filterSizeLimits_);
+      if (filter != null) {
+        registerRuntimeFilter(filter);
+        openTopNFilters_.add(filter);
+      }
+      generateFilters(ctx, root.getChild(0));
+      finalizeTopNFilters();
     } else if (root instanceof ScanNode) {
       assignRuntimeFilters(ctx, (ScanNode) root);
     } else {
@@ -868,6 +962,25 @@ public final class RuntimeFilterGenerator {
     }
   }
 
+  /**
+   * Returns true if the open Top-N filters may be assigned to scan nodes in the subtree
+   * rooted at 'node'.
+   */
+  private static boolean isTransparentForTopNFilters(PlanNode node) {
+    if (node.hasLimit()) return false;
+    return node instanceof ScanNode || node instanceof SelectNode
+        || node instanceof HashJoinNode || node instanceof NestedLoopJoinNode;
+  }
+
+  /**
+   * Finalizes all open Top-N filters, so that they are not assigned to scan nodes
+   * below the node currently visited by generateFilters().
+   */
+  private void finalizeTopNFilters() {
+    for (RuntimeFilter filter: openTopNFilters_) finalizeRuntimeFilter(filter);
+    openTopNFilters_.clear();
+  }
+
   /**
    * Registers a runtime filter with the tuple id of every scan node that is a candidate
    * destination node for that filter.
@@ -916,7 +1029,8 @@ public final class RuntimeFilterGenerator {
     return queryOptions.parquet_read_statistics
         && ((queryOptions.isMinmax_filter_sorted_columns()
                 || queryOptions.getMinmax_filter_threshold() > 0.0)
-            || queryOptions.isMinmax_filter_partition_columns());
+            || queryOptions.isMinmax_filter_partition_columns()
+            || queryOptions.isTopn_runtime_filter());
   }
 
   /**
@@ -968,6 +1082,12 @@ public final class RuntimeFilterGenerator {
           isBoundByPartitionColumns);
       boolean isLocalTarget = isLocalTarget(filter, scanNode);
       if (runtimeFilterMode == TRuntimeFilterMode.LOCAL && !isLocalTarget) continue;
+      // Top-N filters are republished whenever their bound tightens, which is only
+      // supported for HDFS scans in the fragment of the Top-N node.
+      if (filter.isTopNFilter()
+          && (!(scanNode instanceof HdfsScanNode) || !isLocalTarget)) {
+        continue;
+      }
 
       // Check that the scan node supports applying filters of this type and targetExpr.
       if (scanNode instanceof HdfsScanNode) {
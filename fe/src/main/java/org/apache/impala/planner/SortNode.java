@@ -194,6 +194,24 @@ public class SortNode extends PlanNode {
   }
 
   public SortInfo getSortInfo() { return info_; }
+
+  /**
+   * Returns the expr over the input of this node that is materialized into the slot of
+   * the sort tuple referenced by 'sortExpr', or null if 'sortExpr' is not a SlotRef into
+   * the sort tuple. Only valid after init().
+   */
+  public Expr getResolvedTupleExpr(Expr sortExpr) {
+    Preconditions.checkNotNull(resolvedTupleExprs_);
+    if (!(sortExpr instanceof SlotRef)) return null;
+    SlotDescriptor slotDesc = ((SlotRef) sortExpr).getDesc();
+    int exprIdx = 0;
+    for (SlotDescriptor sortTupleSlot: info_.getSortTupleDescriptor().getSlots()) {
+      if (!sortTupleSlot.isMaterialized()) continue;
+      if (sortTupleSlot == slotDesc) return resolvedTupleExprs_.get(exprIdx);
+      ++exprIdx;
+    }
+    return null;
+  }
   public void setInputPartition(DataPartition inputPartition) {
     inputPartition_ = inputPartition;
   }
@@ -418,6 +436,10 @@ public class SortNode extends PlanNode {
         output.append(detailPrefix + "source expr: " +
                 limitSrcPred_.toSql(ToSqlOptions.SHOW_IMPLICIT_CASTS) + "\n");
       }
+      if (!runtimeFilters_.isEmpty()) {
+        output.append(detailPrefix + "runtime filters: ");
+        output.append(getRuntimeFilterExplainString(true, detailLevel));
+      }
     }
 
     if (detailLevel.ordinal() >= TExplainLevel.EXTENDED.ordinal()) {
@@ -999,20 +999,17 @@ public class AnalyzeExprsTest extends AnalyzerTest {
         "RANGE is only supported with both the lower and upper bounds UNBOUNDED or one "
             + "UNBOUNDED and the other CURRENT ROW.");
 
-    // Min/max do not support start bounds with offsets
-    AnalysisError("select max(int_col) over (partition by id order by tinyint_col "
-        + "rows 2 preceding) from functional.alltypes",
-        "'max(int_col)' is only supported with an UNBOUNDED PRECEDING start bound.");
+    // Min/max support start bounds with offsets.
+    AnalyzesOk("select max(int_col) over (partition by id order by tinyint_col "
+        + "rows 2 preceding) from functional.alltypes");
+    AnalyzesOk("select min(string_col) over (order by id "
+        + "rows between 3 preceding and 1 following) from functional.alltypes");
     // If the query can be re-written so that the start is unbounded, it should
     // be supported (IMPALA-1433).
     AnalyzesOk("select max(id) over (order by id rows between current row and "
         + "unbounded following) from functional.alltypes");
     AnalyzesOk("select min(int_col) over (partition by id order by tinyint_col "
         + "rows between 2 preceding and unbounded following) from functional.alltypes");
-    // TODO: Enable after RANGE windows with offset boundaries are supported
-    //AnalysisError("select max(int_col) over (partition by id order by tinyint_col "
-    //    + "range 2 preceding) from functional.alltypes",
-    //    "'max(int_col)' is only supported with an UNBOUNDED PRECEDING start bound.");
 
     // missing grouping expr
     AnalysisError(
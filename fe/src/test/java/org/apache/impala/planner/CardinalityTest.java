@@ -997,6 +997,24 @@ public class CardinalityTest extends PlannerTestBase {
         "FUNCTIONAL.ALLTYPES B1) B ON A.ID = B.ID AND A.IDB=B.IDB",
         53290000L*(4L+8L+4L+8L)+134217728L*12L+(53290000L-5372800L)*16L, false, false,
         ImmutableSet.of(), pathToJoinNodeSg, HashJoinNode.class);
+
+    // With HASH_JOIN_SKEW_FANOUT=2 every build row of the partitioned join is sent to
+    // two instances, which doubles the memory estimate of the build.
+    TQueryOptions skewOptions = new TQueryOptions();
+    skewOptions.setHash_join_skew_fanout(2);
+    verifyApproxMemoryEstimate("SELECT A.ID FROM (SELECT A1.ID,B1.DATE_STRING_COL " +
+        "IDB FROM FUNCTIONAL.ALLTYPES A1 , FUNCTIONAL.ALLTYPES B1) A JOIN " +
+        "(SELECT A1.ID,B1.DATE_STRING_COL IDB FROM FUNCTIONAL.ALLTYPES A1," +
+        "FUNCTIONAL.ALLTYPES B1) B ON A.ID = B.ID AND A.IDB=B.IDB",
+        2L*(53290000L*(4L+8L+4L+8L)+134217728L*12L+(53290000L-5372800L)*16L), true,
+        true, ImmutableSet.of(), skewOptions, pathToJoinNode, HashJoinNode.class);
+    // The fanout does not apply to the single node plan.
+    verifyApproxMemoryEstimate("SELECT A.ID FROM (SELECT A1.ID,B1.DATE_STRING_COL " +
+        "IDB FROM FUNCTIONAL.ALLTYPES A1 , FUNCTIONAL.ALLTYPES B1) A JOIN " +
+        "(SELECT A1.ID,B1.DATE_STRING_COL IDB FROM FUNCTIONAL.ALLTYPES A1," +
+        "FUNCTIONAL.ALLTYPES B1) B ON A.ID = B.ID AND A.IDB=B.IDB",
+        53290000L*(4L+8L+4L+8L)+134217728L*12L+(53290000L-5372800L)*16L, false, false,
+        ImmutableSet.of(), skewOptions, pathToJoinNodeSg, HashJoinNode.class);
   }
 
   @Test
@@ -1158,8 +1176,17 @@ public class CardinalityTest extends PlannerTestBase {
 
   private List<PlanFragment> getPlan(String query,
       boolean isDistributedPlan, Set<PlannerTestOption> testOptions) {
+    return getPlan(query, isDistributedPlan, testOptions, new TQueryOptions());
+  }
+
+  /**
+   * Same as above, but plans the query with 'queryOptions', on top of which the
+   * options for 'isDistributedPlan' and 'testOptions' are set.
+   */
+  private List<PlanFragment> getPlan(String query, boolean isDistributedPlan,
+      Set<PlannerTestOption> testOptions, TQueryOptions queryOptions) {
     TQueryCtx queryCtx = TestUtils.createQueryContext(
-        "default", System.getProperty("user.name"));
+        "default", System.getProperty("user.name"), queryOptions.deepCopy());
     queryCtx.client_request.setStmt(query);
 
     // Disable the attempt to compute an estimated number of rows in an
@@ -1201,7 +1228,18 @@ public class CardinalityTest extends PlannerTestBase {
   */
   protected PlanNode getPlanNode(String query, boolean isDistributedPlan,
       Set<PlannerTestOption> testOptions, List<Integer> path, Class<?> cl) {
-    List<PlanFragment> plan = getPlan(query, isDistributedPlan, testOptions);
+    return getPlanNode(query, isDistributedPlan, testOptions, new TQueryOptions(), path,
+        cl);
+  }
+
+  /**
+   * Same as above, but plans the query with 'queryOptions'.
+   */
+  protected PlanNode getPlanNode(String query, boolean isDistributedPlan,
+      Set<PlannerTestOption> testOptions, TQueryOptions queryOptions, List<Integer> path,
+      Class<?> cl) {
+    List<PlanFragment> plan =
+        getPlan(query, isDistributedPlan, testOptions, queryOptions);
     // We use the last element on the List of PlanFragment
     // because this PlanFragment encloses all the PlanNode's
     // in the query plan (either the single node plan or
@@ -1232,7 +1270,19 @@ public class CardinalityTest extends PlannerTestBase {
   protected void verifyApproxMemoryEstimate(String query, long expected,
       boolean isDistributedPlan, boolean isMultiNodes,
       Set<PlannerTestOption> testOptions, List<Integer> path, Class<?> cl) {
-    PlanNode pNode = getPlanNode(query, isDistributedPlan, testOptions, path, cl);
+    verifyApproxMemoryEstimate(query, expected, isDistributedPlan, isMultiNodes,
+        testOptions, new TQueryOptions(), path, cl);
+  }
+
+  /**
+   * Same as above, but plans the query with 'queryOptions'.
+   */
+  protected void verifyApproxMemoryEstimate(String query, long expected,
+      boolean isDistributedPlan, boolean isMultiNodes,
+      Set<PlannerTestOption> testOptions, TQueryOptions queryOptions,
+      List<Integer> path, Class<?> cl) {
+    PlanNode pNode =
+        getPlanNode(query, isDistributedPlan, testOptions, queryOptions, path, cl);
     long result = pNode.getNodeResourceProfile().getMemEstimateBytes();
     if (isMultiNodes) {
       result = (long)Math.ceil(result * pNode.getFragment().getNumInstances());
@@ -1003,6 +1003,14 @@ public class PlannerTest extends PlannerTestBase {
         options);
   }
 
+  @Test
+  public void testHashJoinSkewFanout() {
+    TQueryOptions options = defaultQueryOptions();
+    options.setHash_join_skew_fanout(4);
+    options.setDisable_hdfs_num_rows_estimate(true);
+    runPlannerTestFile("hash-join-skew-fanout", options);
+  }
+
   @Test
   public void testPartitionPruning() {
     runPlannerTestFile("partition-pruning",
@@ -1052,6 +1060,15 @@ public class PlannerTest extends PlannerTestBase {
     runPlannerTestFile("min-max-runtime-filters", options);
   }
 
+  @Test
+  public void testTopNRuntimeFilters() {
+    TQueryOptions options = defaultQueryOptions();
+    options.setTopn_runtime_filter(true);
+    options.unsetEnabled_runtime_filter_types();
+    options.addToEnabled_runtime_filter_types(TRuntimeFilterType.MIN_MAX);
+    runPlannerTestFile("topn-runtime-filters", options);
+  }
+
   @Test
   public void testCardinalityOverflow() throws ImpalaException {
     String tblName = "tpch.cardinality_overflow";
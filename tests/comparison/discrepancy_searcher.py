@@ -135,11 +135,6 @@ class QueryResultComparator(object):
         elif 'GROUP BY expression must not contain aggregate functions' in error_message \
             or 'select list expression not produced by aggregation output' in error_message:
           known_error = KnownError('IMPALA-1423')
-        elif ('max(' in error_message or 'min(' in error_message) \
-            and 'only supported with an UNBOUNDED PRECEDING start bound' in error_message:
-          # This analytic isn't supported and ignoring this here is much easier than not
-          # generating the query...
-          known_error = KnownError('MAX UNBOUNDED PRECISION')
         elif 'IN and/or EXISTS subquery predicates are not supported in binary predicates' \
             in error_message:
           known_error = KnownError('IMPALA-1418')
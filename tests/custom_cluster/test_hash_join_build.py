@@ -0,0 +1,52 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+from __future__ import absolute_import, division, print_function
+import pytest
+
+from tests.common.custom_cluster_test_suite import CustomClusterTestSuite
+
+
+class TestRadixOrderedHashTableBuild(CustomClusterTestSuite):
+  """Runs joins with the radix-ordered hash table build forced on for every hash table.
+  By default it only kicks in for bucket directories that are too large for the test
+  datasets."""
+
+  @classmethod
+  def get_workload(self):
+    return 'functional-query'
+
+  @pytest.mark.execute_serially
+  @CustomClusterTestSuite.with_args("--radix_hash_table_build_min_bytes=0")
+  def test_joins(self, vector):
+    self.run_test_case('QueryTest/joins', vector)
+    self.run_test_case('QueryTest/outer-joins', vector)
+
+  @pytest.mark.execute_serially
+  @CustomClusterTestSuite.with_args("--radix_hash_table_build_min_bytes=0")
+  def test_spilling_joins(self, vector):
+    """Repartitioned partitions are built with the level-specific hash function."""
+    self.run_test_case('QueryTest/spilling', vector)
+
+  @pytest.mark.execute_serially
+  @CustomClusterTestSuite.with_args("--radix_hash_table_build_min_bytes=0")
+  def test_profile_counter(self, vector):
+    result = self.execute_query(
+        "select count(*) from tpch.lineitem l join tpch.orders o "
+        "on l.l_orderkey = o.o_orderkey")
+    assert result.data == ['6001215']
+    assert "NumRadixOrderedHashTableBuilds: 0 " not in result.runtime_profile
@@ -0,0 +1,139 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+from __future__ import absolute_import, division, print_function
+import pytest
+import re
+
+from tests.common.custom_cluster_test_suite import CustomClusterTestSuite
+from tests.common.file_utils import create_table_from_parquet
+from tests.common.skip import SkipIfNotHdfsMinicluster
+
+HITS = 'impala.parquet-metadata-cache.hits'
+MISSES = 'impala.parquet-metadata-cache.misses'
+EVICTED = 'impala.parquet-metadata-cache.entries-evicted'
+IN_USE = 'impala.parquet-metadata-cache.entries-in-use'
+
+# Size of the footer range that is read for files whose metadata is cached: the 4-byte
+# metadata length and the 4-byte magic number.
+CACHED_FOOTER_RANGE_SIZE = 8
+
+
+@SkipIfNotHdfsMinicluster.scheduling
+class TestParquetMetadataCache(CustomClusterTestSuite):
+  """Tests the executor-wide cache of Parquet footers and page indexes that is enabled by
+  --parquet_metadata_cache_capacity. Runs with a single impalad so that all scans of a
+  query hit the cache of the same daemon and the metrics and profiles are deterministic.
+  """
+  @classmethod
+  def get_workload(cls):
+    return 'functional-query'
+
+  def __get_counters(self, counter_name, runtime_profile):
+    """Returns the values of all counters named 'counter_name' in 'runtime_profile'
+    except for the averaged one of the fragment."""
+    values = re.findall(r'- %s: .*?\((\d+)\)|- %s: (\d+)\s*$'
+        % (counter_name, counter_name), runtime_profile, re.MULTILINE)
+    return [int(v[0] or v[1]) for v in values][1:]
+
+  def __num_files(self, table):
+    return len(self.client.execute("show files in %s" % table).data)
+
+  @pytest.mark.execute_serially
+  @CustomClusterTestSuite.with_args(
+      impalad_args="--parquet_metadata_cache_capacity=256MB", cluster_size=1)
+  def test_footer_cache(self, vector):
+    """Scans the same table twice and checks that the second scan only reads the end of
+    each file and reuses the cached footers."""
+    table = "functional_parquet.alltypes"
+    num_files = self.__num_files(table)
+    query = "select count(*), sum(id) from %s" % table
+
+    result = self.execute_query(query)
+    assert result.data == ['7300\t26641350']
+    assert self.get_metric(HITS) == 0
+    assert self.get_metric(MISSES) == num_files
+    assert self.get_metric(IN_USE) == num_files
+    first_bytes_read = sum(self.__get_counters("BytesRead", result.runtime_profile))
+    assert first_bytes_read > CACHED_FOOTER_RANGE_SIZE * num_files
+
+    result = self.execute_query(query)
+    assert result.data == ['7300\t26641350']
+    assert self.get_metric(HITS) == num_files
+    assert self.get_metric(MISSES) == num_files
+    assert self.get_metric(EVICTED) == 0
+
+    # count(*) only needs the footers, so with all of them cached only the metadata
+    # length and magic number of each file are read.
+    result = self.execute_query("select count(*) from %s" % table)
+    assert result.data == ['7300']
+    assert self.get_metric(HITS) == 2 * num_files
+    assert sum(self.__get_counters("BytesRead", result.runtime_profile)) == \
+        CACHED_FOOTER_RANGE_SIZE * num_files
+
+  @pytest.mark.execute_serially
+  @CustomClusterTestSuite.with_args(
+      impalad_args="--parquet_metadata_cache_capacity=256MB", cluster_size=1)
+  def test_page_index_cache(self, vector, unique_database):
+    """Checks that the page indexes of a file are served from the cache on the second
+    scan and that page filtering still returns the same rows."""
+    create_table_from_parquet(self.client, unique_database, 'alltypes_tiny_pages')
+    table = "%s.alltypes_tiny_pages" % unique_database
+    query = "select id, int_col from %s where id < 100 order by id" % table
+    options = {'parquet_read_page_index': True}
+
+    first = self.execute_query(query, options)
+    assert sum(self.__get_counters("NumRowGroupsWithPageIndex",
+        first.runtime_profile)) > 0
+    assert self.get_metric(HITS) == 0
+    misses = self.get_metric(MISSES)
+    # One miss for the footer and at least one for a page index.
+    assert misses >= 2
+
+    second = self.execute_query(query, options)
+    assert second.data == first.data
+    assert sum(self.__get_counters("NumStatsFilteredPages", second.runtime_profile)) == \
+        sum(self.__get_counters("NumStatsFilteredPages", first.runtime_profile))
+    # The footer and all page indexes are hits now.
+    assert self.get_metric(HITS) == misses
+    assert self.get_metric(MISSES) == misses
+
+    # Reading without the page index returns the same rows.
+    no_page_index = self.execute_query(query, {'parquet_read_page_index': False})
+    assert no_page_index.data == first.data
+
+  @pytest.mark.execute_serially
+  @CustomClusterTestSuite.with_args(
+      impalad_args="--parquet_metadata_cache_capacity=32KB --cache_force_single_shard",
+      cluster_size=1)
+  def test_eviction(self, vector):
+    """Runs with a cache that holds only a few footers, so entries are evicted while the
+    table is scanned. Scanners whose footer is evicted between issuing the footer range
+    and processing it only read the end of the file and fall back to reading and
+    deserializing the full footer, so the results must not change."""
+    table = "functional_parquet.alltypes"
+    num_files = self.__num_files(table)
+    query = "select count(*), sum(id), max(string_col) from %s" % table
+    num_runs = 3
+    for _ in range(num_runs):
+      result = self.execute_query(query)
+      assert result.data == ['7300\t26641350\t9']
+    assert self.get_metric(EVICTED) > 0
+    assert self.get_metric(IN_USE) < num_files
+    assert self.get_metric(MISSES) > num_files
+    # Every footer lookup is either a hit or a miss.
+    assert self.get_metric(HITS) + self.get_metric(MISSES) == num_runs * num_files
@@ -19,7 +19,9 @@
 #
 from __future__ import absolute_import, division, print_function
 from builtins import range
+from copy import deepcopy
 import pytest
+import re
 
 from testdata.common import widetable
 from tests.common.impala_test_suite import ImpalaTestSuite
@@ -497,8 +499,54 @@ class TestTPCHAggregationQueries(ImpalaTestSuite):
   def test_tpch_passthrough_aggregations(self, vector):
     self.run_test_case('tpch-passthrough-aggregations', vector)
 
+  def test_tpch_adaptive_preaggregations(self, vector):
+    """Runs the preaggregation tests with partitions switching between aggregating
+    and passing through rows."""
+    new_vector = deepcopy(vector)
+    new_vector.get_value('exec_option')['adaptive_streaming_preaggregation'] = True
+    self.run_test_case('tpch-aggregations', new_vector)
+    self.run_test_case('tpch-passthrough-aggregations', new_vector)
+
+    # The group by keys are nearly unique, so partitions should stop aggregating.
+    result = self.execute_query(
+        "select l_orderkey, l_partkey, count(*) from tpch_parquet.lineitem "
+        "group by 1, 2 order by 1, 2 limit 1", new_vector.get_value('exec_option'))
+    assert result.data == ['1\t2132\t1']
+    assert "Adaptive Streaming Preaggregation" in result.runtime_profile
+    switches = re.findall(r'- PartitionsSwitchedToPassThrough: .*?\((\d+)\)|'
+        r'- PartitionsSwitchedToPassThrough: (\d+)\s*$', result.runtime_profile,
+        re.MULTILINE)
+    assert len(switches) > 0
+    assert all(int(v[0] or v[1]) > 0 for v in switches), switches
+
   def test_tpch_stress(self, vector):
     self.run_test_case('tpch-stress-aggregations', vector)
 
   def test_min_multiple_distinct(self, vector, unique_database):
     self.run_test_case('min-multiple-distinct-aggs', vector)
+
+
+class TestBatchUpdateAggregation(ImpalaTestSuite):
+  """Runs the aggregation tests with GROUPING_AGG_BATCH_UPDATE enabled, with and without
+  codegen."""
+  @classmethod
+  def get_workload(self):
+    return 'functional-query'
+
+  @classmethod
+  def add_test_dimensions(cls):
+    super(TestBatchUpdateAggregation, cls).add_test_dimensions()
+
+    cls.ImpalaTestMatrix.add_dimension(
+      create_exec_option_dimension_from_dict({
+        'disable_codegen': [False, True],
+        'grouping_agg_batch_update': [True]
+      }))
+    cls.ImpalaTestMatrix.add_constraint(
+      lambda v: v.get_value('table_format').file_format == 'parquet')
+
+  def test_aggregation(self, vector):
+    self.run_test_case('QueryTest/aggregation', vector)
+
+  def test_distinct(self, vector):
+    self.run_test_case('QueryTest/distinct', vector)
@@ -65,6 +65,47 @@ class TestJoinQueries(ImpalaTestSuite):
     new_vector.get_value('exec_option')['mt_dop'] = vector.get_value('mt_dop')
     self.run_test_case('QueryTest/joins', new_vector)
 
+  def test_basic_joins_prefetch_build_rows(self, vector):
+    """Runs the join tests with the staged probe that also prefetches build rows."""
+    new_vector = deepcopy(vector)
+    new_vector.get_value('exec_option')['batch_size'] = vector.get_value('batch_size')
+    new_vector.get_value('exec_option')['mt_dop'] = vector.get_value('mt_dop')
+    new_vector.get_value('exec_option')['prefetch_mode'] = 'HT_BUCKET_AND_ROW'
+    self.run_test_case('QueryTest/joins', new_vector)
+    self.run_test_case('QueryTest/outer-joins', new_vector)
+
+  @pytest.mark.parametrize("codec", ["NONE", "LZ4", "ZSTD"])
+  def test_basic_joins_columnar_exchange(self, vector, codec):
+    """Runs the join tests with row batches sent through exchanges in the columnar
+    layout, compressed with 'codec'."""
+    new_vector = deepcopy(vector)
+    new_vector.get_value('exec_option')['batch_size'] = vector.get_value('batch_size')
+    new_vector.get_value('exec_option')['mt_dop'] = vector.get_value('mt_dop')
+    new_vector.get_value('exec_option')['exchange_columnar_serialization'] = True
+    new_vector.get_value('exec_option')['exchange_compression_codec'] = codec
+    self.run_test_case('QueryTest/joins', new_vector)
+
+  @pytest.mark.parametrize("columnar", [False, True])
+  def test_basic_joins_adaptive_exchange_compression(self, vector, columnar):
+    """Runs the join tests with the codec of the row batches sent through exchanges
+    chosen per channel."""
+    new_vector = deepcopy(vector)
+    new_vector.get_value('exec_option')['batch_size'] = vector.get_value('batch_size')
+    new_vector.get_value('exec_option')['mt_dop'] = vector.get_value('mt_dop')
+    new_vector.get_value('exec_option')['exchange_columnar_serialization'] = columnar
+    new_vector.get_value('exec_option')['adaptive_exchange_compression'] = True
+    self.run_test_case('QueryTest/joins', new_vector)
+
+  def test_basic_joins_skew_fanout(self, vector):
+    """Runs the join tests with the probe rows of hot join keys of partitioned joins
+    spread over several join instances."""
+    new_vector = deepcopy(vector)
+    new_vector.get_value('exec_option')['batch_size'] = vector.get_value('batch_size')
+    new_vector.get_value('exec_option')['mt_dop'] = vector.get_value('mt_dop')
+    new_vector.get_value('exec_option')['hash_join_skew_fanout'] = 2
+    self.run_test_case('QueryTest/joins', new_vector)
+    self.run_test_case('QueryTest/outer-joins', new_vector)
+
   def test_single_node_joins_with_limits_exhaustive(self, vector):
     if self.exploration_strategy() != 'exhaustive': pytest.skip()
     new_vector = deepcopy(vector)
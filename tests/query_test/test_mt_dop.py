@@ -151,6 +151,19 @@ class TestMtDopParquet(ImpalaTestSuite):
     self.run_test_case('QueryTest/joins_mt_dop', vector,
        test_file_vars={'$RUNTIME_FILTER_WAIT_TIME_MS': str(WAIT_TIME_MS)})
 
+  def test_mt_dop_only_joins_serial_build(self, vector, unique_database):
+    """Runs the MT_DOP join tests with the hash tables of shared join builds built by a
+    single thread instead of in parallel."""
+    mt_dop = vector.get_value('mt_dop')
+    if mt_dop == 0:
+      pytest.skip("Test requires mt_dop > 0")
+    vector = deepcopy(vector)
+    # Allow test to override num_nodes.
+    del vector.get_value('exec_option')['num_nodes']
+    vector.get_value('exec_option')['hash_join_parallel_build'] = 'false'
+    self.run_test_case('QueryTest/joins_mt_dop', vector,
+       test_file_vars={'$RUNTIME_FILTER_WAIT_TIME_MS': str(WAIT_TIME_MS)})
+
 
 class TestMtDopKudu(KuduTestSuite):
   @classmethod
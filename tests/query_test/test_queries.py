@@ -408,6 +408,34 @@ class TestTopNReclaimQuery(ImpalaTestSuite):
       assert int(n) > 0
 
 
+class TestTopNKeyThreshold(ImpalaTestSuite):
+  """Test class to validate that full TopN heaps reject rows by their normalized keys
+  before invoking the comparator."""
+
+  @classmethod
+  def get_workload(self):
+    return 'tpch'
+
+  @classmethod
+  def add_test_dimensions(cls):
+    super(TestTopNKeyThreshold, cls).add_test_dimensions()
+    cls.ImpalaTestMatrix.add_dimension(
+      create_uncompressed_text_dimension(cls.get_workload()))
+
+  @pytest.mark.parametrize("query", [
+      "select l_orderkey from tpch.lineitem order by l_orderkey limit 10",
+      "select l_comment from tpch.lineitem order by l_comment desc limit 10",
+      "select * from (select l_orderkey, rank() over (partition by l_returnflag "
+      "order by l_orderkey) rnk from tpch.lineitem) v where rnk <= 5"])
+  def test_top_n_key_threshold(self, vector, query):
+    result = self.execute_query(query, vector.get_value('exec_option'))
+    runtime_profile = str(result.runtime_profile)
+    num_rows_rejected = re.findall(
+      'RowsRejectedByKeyThreshold: [0-9.A-Z]* \\(([0-9]*)\\)', runtime_profile)
+    assert len(num_rows_rejected) > 0
+    assert sum(int(n) for n in num_rows_rejected) > 0
+
+
 class TestAnalyticFnsTpch(ImpalaTestSuite):
 
   @classmethod
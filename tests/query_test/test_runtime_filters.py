@@ -342,6 +342,48 @@ class TestOverlapMinMaxFilters(ImpalaTestSuite):
     self.execute_query("select * from {0}.{1} t1, {0}.{1} t2 where t1.d=t2.d and t2.i=2".
         format(unique_database, tbl_name))
 
+  @pytest.mark.parametrize("query", [
+      "select id, string_col from functional_parquet.alltypes "
+      "order by id limit 5",
+      "select id, string_col from functional_parquet.alltypes "
+      "order by id desc nulls last limit 5 offset 3",
+      "select string_col, id from functional_parquet.alltypes "
+      "order by string_col, id limit 5"])
+  def test_topn_runtime_filters(self, vector, query):
+    """Test that Top-N nodes publish their bound to the scans below them and that the
+    results do not change."""
+    expected = self.execute_query(query, {'topn_runtime_filter': 'false'})
+    result = self.execute_query(query, {'topn_runtime_filter': 'true'})
+    assert result.data == expected.data
+    num_updates = re.findall(
+        'TopNFilterUpdates: [0-9.A-Z]* \\(([0-9]*)\\)', str(result.runtime_profile))
+    assert len(num_updates) > 0
+    assert sum(int(n) for n in num_updates) > 0
+
+  def test_topn_runtime_filters_skip_pages(self, vector, unique_database):
+    """Test that Parquet scans skip the pages that the bound of a Top-N filter rules
+    out. Every file holds a low and a high range of ids in separate pages. The scan
+    and the Top-N node run in the same thread, so the bound published after the first
+    file always rules out the high pages of the other files."""
+    tbl_name = "%s.topn_skip_pages" % unique_database
+    self.execute_query(
+        "create table %s (id int) sort by (id) stored as parquet" % tbl_name)
+    for i in range(3):
+      self.execute_query(
+          "insert into {0} select id from functional.alltypes "
+          "where id between {1} and {1} + 99 or id between 5000 + {1} and 5099 + {1}"
+          .format(tbl_name, i * 100),
+          {'num_nodes': 1, 'parquet_page_row_count_limit': 20})
+    query = "select id from %s order by id limit 5" % tbl_name
+    result = self.execute_query(query,
+        {'topn_runtime_filter': 'true', 'mt_dop': 1, 'num_nodes': 1})
+    assert result.data == ['0', '1', '2', '3', '4']
+    profile = str(result.runtime_profile)
+    num_skipped = re.findall(
+        'NumRuntimeFiltered(?:Pages|RowGroups): [0-9.A-Z]* \\(([0-9]*)\\)', profile)
+    assert len(num_skipped) > 0
+    assert sum(int(n) for n in num_skipped) > 0
+
 
 class TestInListFilters(ImpalaTestSuite):
   @classmethod
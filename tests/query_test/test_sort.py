@@ -191,6 +191,100 @@ class TestQueryFullSort(ImpalaTestSuite):
     numeric_results = [int(val) for val in result[0]]
     assert(numeric_results == sorted(numeric_results))
 
+  def test_radix_sort(self, vector):
+    """The leading BIGINT sort key is radix sorted, ties are broken by the string key."""
+    query = """select l_orderkey, l_comment from lineitem
+    order by l_orderkey desc, l_comment limit 100000"""
+
+    exec_option = copy(vector.get_value('exec_option'))
+    exec_option['disable_outermost_topn'] = 1
+    exec_option['num_nodes'] = 1
+    table_format = vector.get_value('table_format')
+
+    query_result = self.execute_query(query, exec_option, table_format=table_format)
+    assert "NumRadixSortedRuns: 0 " not in query_result.runtime_profile
+    result = transpose_results(query_result.data)
+    keys = [(-int(orderkey), comment) for orderkey, comment in zip(*result)]
+    assert(keys == sorted(keys))
+
+  def test_parallel_sort(self, vector):
+    """The analytic sort over all of lineitem is a single large run whose normalized keys
+    are sorted by several threads. The leading key is zero with either sign, so the
+    order is decided by the following keys."""
+    query = """select l_orderkey, l_linenumber, rn from (
+      select l_orderkey, l_linenumber,
+        row_number() over (order by
+          if(l_linenumber % 2 = 0, cast("-0" as double), cast("0" as double)),
+          l_orderkey desc, l_linenumber) rn
+      from lineitem) v
+    order by rn limit 100000"""
+
+    exec_option = copy(vector.get_value('exec_option'))
+    exec_option['num_nodes'] = 1
+    table_format = vector.get_value('table_format')
+
+    query_result = self.execute_query(query, exec_option, table_format=table_format)
+    num_parallel_sorted_runs = re.findall(
+      'NumParallelSortedRuns: [0-9.A-Z]* \\(([0-9]*)\\)', query_result.runtime_profile)
+    assert len(num_parallel_sorted_runs) > 0
+    assert sum(int(n) for n in num_parallel_sorted_runs) > 0
+    # Worker threads are only started while thread tokens are available, which they
+    # are for this single query.
+    num_worker_threads = re.findall(
+      'NumParallelSortWorkerThreads: [0-9.A-Z]* \\(([0-9]*)\\)',
+      query_result.runtime_profile)
+    assert sum(int(n) for n in num_worker_threads) > 0
+    result = transpose_results(query_result.data)
+    keys = [(-int(orderkey), int(linenumber)) for orderkey, linenumber, _ in zip(*result)]
+    assert(keys == sorted(keys))
+    assert([int(rn) for rn in result[2]] == list(range(1, len(keys) + 1)))
+
+  def test_sort_key_prefix(self, vector):
+    """The leading string sort key is sorted and merged by its normalized prefix. Many
+    comments share a prefix, so ties are broken by the full comparator."""
+    query = """select l_comment, l_orderkey, l_linenumber from lineitem
+    order by l_comment, l_orderkey, l_linenumber limit 100000"""
+
+    exec_option = copy(vector.get_value('exec_option'))
+    exec_option['disable_outermost_topn'] = 1
+    exec_option['num_nodes'] = 1
+    table_format = vector.get_value('table_format')
+
+    for buffer_pool_limit in ['-1', '130m']:
+      exec_option['buffer_pool_limit'] = buffer_pool_limit
+      query_result = self.execute_query(query, exec_option, table_format=table_format)
+      assert "NumPrefixSortedRuns: 0 " not in query_result.runtime_profile
+      result = transpose_results(query_result.data)
+      keys = [(comment, int(orderkey), int(linenumber))
+              for comment, orderkey, linenumber in zip(*result)]
+      assert(keys == sorted(keys))
+
+  def test_sort_signed_zeros(self, vector):
+    """-0.0 and 0.0 are equal, so rows with zero keys of either sign are ordered by the
+    following keys, both within the in-memory runs and when spilled runs are merged."""
+    query = """select d, l_orderkey, l_linenumber from (
+      select case l_linenumber % 3
+          when 0 then cast("-0" as double)
+          when 1 then cast("0" as double)
+          else cast(l_linenumber as double) end d,
+        l_orderkey, l_linenumber
+      from lineitem) v
+    order by d, l_orderkey, l_linenumber limit 100000"""
+
+    exec_option = copy(vector.get_value('exec_option'))
+    exec_option['disable_outermost_topn'] = 1
+    exec_option['num_nodes'] = 1
+    table_format = vector.get_value('table_format')
+
+    for buffer_pool_limit in ['-1', '130m']:
+      exec_option['buffer_pool_limit'] = buffer_pool_limit
+      query_result = self.execute_query(query, exec_option, table_format=table_format)
+      result = transpose_results(query_result.data)
+      keys = [(float(d), int(orderkey), int(linenumber))
+              for d, orderkey, linenumber in zip(*result)]
+      assert(keys == sorted(keys))
+      assert(all(key[0] == 0 for key in keys))
+
   def test_spill_empty_strings(self, vector):
     """Test corner case of spilling sort with only empty strings. Spilling with var len
     slots typically means the sort must reorder blocks and convert pointers, but this case
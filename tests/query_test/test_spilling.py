@@ -78,6 +78,13 @@ class TestSpillingDebugActionDimensions(ImpalaTestSuite):
   def test_spilling_aggs(self, vector):
     self.run_test_case('QueryTest/spilling-aggs', vector)
 
+  def test_spilling_aggs_batch_update(self, vector):
+    """Spilling invalidates the intermediate tuples of deferred aggregate updates, so
+    they must be applied before any partition is spilled."""
+    new_vector = deepcopy(vector)
+    new_vector.get_value('exec_option')['grouping_agg_batch_update'] = True
+    self.run_test_case('QueryTest/spilling-aggs', new_vector)
+
   def test_spilling_large_rows(self, vector, unique_database):
     """Test that we can process large rows in spilling operators, with or without
        spilling to disk"""